@@ -0,0 +1,487 @@
+// spin-snow 微基准测试
+// 用法: spin-snow-bench [--out result.json] [--filter name]
+// 需要在仓库根目录下运行（与主程序相同，资源以相对路径加载）
+// opengl
+#include <glad/glad.h>
+// gldw
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <stb_image.h>
+// cpp std lib
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// c std lib
+#include <cstdint>
+// project header
+#include "camera.h"
+#include "mesh.h"
+#include "model.h"
+#include "scene_bvh.h"
+#include "shader.h"
+#include "snowflakes.h"
+#include "utils.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ns(Clock::time_point since) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - since).count();
+}
+
+// 一项测试的统计结果，items 为每次迭代处理的元素数
+struct BenchResult {
+  std::string name;
+  uint64_t iterations = 0;
+  uint64_t items = 1;
+  double mean_ns = 0;
+  double median_ns = 0;
+  double min_ns = 0;
+  double max_ns = 0;
+};
+
+class BenchSuite {
+public:
+  explicit BenchSuite(std::string filter) : filter(std::move(filter)) {}
+
+  bool enabled(const std::string &name) const { return filter.empty() || name.find(filter) != std::string::npos; }
+
+  // 记录一组采样（单位 ns，每个采样对应一次迭代）
+  void report(const std::string &name, std::vector<double> samples, uint64_t items = 1) {
+    if (samples.empty()) {
+      return;
+    }
+    std::sort(samples.begin(), samples.end());
+    BenchResult res;
+    res.name = name;
+    res.iterations = samples.size();
+    res.items = items;
+    double sum = 0;
+    for (double s : samples) {
+      sum += s;
+    }
+    res.mean_ns = sum / samples.size();
+    res.median_ns = samples[samples.size() / 2];
+    res.min_ns = samples.front();
+    res.max_ns = samples.back();
+    std::cerr << "[BENCH] " << name << ": median " << res.median_ns / 1e6 << " ms (" << res.iterations << " iters)" << std::endl;
+    results.push_back(res);
+  }
+
+  // 计时 fn 的 iterations 次调用
+  template <typename F>
+  void run(const std::string &name, uint32_t iterations, uint64_t items, F &&fn) {
+    if (!enabled(name)) {
+      return;
+    }
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (uint32_t i = 0; i < iterations; ++i) {
+      auto start = Clock::now();
+      fn();
+      samples.push_back(elapsed_ns(start));
+    }
+    report(name, std::move(samples), items);
+  }
+
+  void write_json(std::ostream &os) const {
+    os << "{\n";
+    os << "  \"context\": {\n";
+    os << "    \"renderer\": \"" << escape(gl_string(GL_RENDERER)) << "\",\n";
+    os << "    \"version\": \"" << escape(gl_string(GL_VERSION)) << "\",\n";
+    os << "    \"vendor\": \"" << escape(gl_string(GL_VENDOR)) << "\"\n";
+    os << "  },\n";
+    os << "  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+      const BenchResult &r = results[i];
+      os << (i == 0 ? "\n" : ",\n");
+      os << "    {\"name\": \"" << escape(r.name) << "\", \"iterations\": " << r.iterations << ", \"items\": " << r.items
+         << ", \"mean_ns\": " << r.mean_ns << ", \"median_ns\": " << r.median_ns << ", \"min_ns\": " << r.min_ns
+         << ", \"max_ns\": " << r.max_ns << ", \"ns_per_item\": " << r.median_ns / r.items << "}";
+    }
+    os << "\n  ]\n}\n";
+  }
+
+private:
+  static std::string gl_string(GLenum name) {
+    const GLubyte *str = glGetString(name);
+    return str == nullptr ? std::string() : std::string(reinterpret_cast<const char *>(str));
+  }
+
+  // JSON 字符串转义，驱动返回的字符串可能含有换行等控制字符
+  static std::string escape(const std::string &str) {
+    static const char HEX[] = "0123456789abcdef";
+    std::string res;
+    for (char c : str) {
+      unsigned char byte = c;
+      if (c == '"' || c == '\\') {
+        res += '\\';
+        res += c;
+      } else if (c == '\n') {
+        res += "\\n";
+      } else if (c == '\t') {
+        res += "\\t";
+      } else if (byte < 0x20) {
+        res += "\\u00";
+        res += HEX[byte >> 4];
+        res += HEX[byte & 0xF];
+      } else {
+        res += c;
+      }
+    }
+    return res;
+  }
+
+private:
+  std::string filter;
+  std::vector<BenchResult> results;
+};
+
+// 防止编译器优化掉无副作用的计算
+volatile float bench_sink = 0;
+
+void bench_model_load(BenchSuite &suite) {
+  const std::vector<std::string> assets = {
+    "assets/Snowman.obj",
+    "assets/snowmanfirstperson.obj",
+    "assets/icehouse/icehouse.obj",
+    "assets/snowflakes.obj",
+    "assets/sl/神里绫华.pmx",
+  };
+  for (const auto &asset : assets) {
+    const std::string prefix = "Model::load/" + asset;
+    if (!suite.enabled(prefix)) {
+      continue;
+    }
+    std::vector<double> total, import, process, texture, bvh;
+    for (uint32_t i = 0; i < 3; ++i) {
+      auto start = Clock::now();
+      Model model(asset);
+      glFinish();
+      total.push_back(elapsed_ns(start));
+      const Model::LoadStats &stats = model.get_load_stats();
+      import.push_back(stats.import_ms * 1e6);
+      process.push_back(stats.process_ms * 1e6);
+      texture.push_back(stats.texture_ms * 1e6);
+      bvh.push_back(stats.bvh_ms * 1e6);
+    }
+    suite.report(prefix + "/total", total);
+    suite.report(prefix + "/import", import);
+    suite.report(prefix + "/processMesh", process);
+    suite.report(prefix + "/texture", texture);
+    suite.report(prefix + "/bvh", bvh);
+  }
+}
+
+void bench_mesh_setup(BenchSuite &suite) {
+  for (uint32_t layers : {1u, 2u}) {
+    const uint32_t side = 256;
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    for (uint32_t z = 0; z < side; ++z) {
+      for (uint32_t x = 0; x < side; ++x) {
+        Vertex vertex({(float)x, 0, (float)z}, {0, 1, 0}, {(float)x / side, (float)z / side});
+        for (uint32_t l = 1; l < layers; ++l) {
+          vertex.TexCoords.push_back({(float)z / side, (float)x / side});
+        }
+        vertices.push_back(vertex);
+      }
+    }
+    for (uint32_t z = 0; z + 1 < side; ++z) {
+      for (uint32_t x = 0; x + 1 < side; ++x) {
+        GLuint i = z * side + x;
+        indices.insert(indices.end(), {i, i + 1, i + side, i + side, i + 1, i + side + 1});
+      }
+    }
+
+    const std::string name = "Mesh::setup/" + std::to_string(vertices.size()) + "v/" + std::to_string(layers) + "uv";
+    if (!suite.enabled(name)) {
+      continue;
+    }
+    std::vector<double> samples;
+    for (uint32_t i = 0; i < 10; ++i) {
+      Mesh mesh;
+      mesh.vertices = vertices;
+      mesh.indices = indices;
+      auto start = Clock::now();
+      mesh.setup();
+      glFinish();
+      samples.push_back(elapsed_ns(start));
+    }
+    suite.report(name, samples, vertices.size());
+  }
+}
+
+void bench_texture(BenchSuite &suite) {
+  const std::vector<std::string> images = {
+    "assets/Snowman_diffuse.jpg",
+    "assets/ice.jpg",
+    "assets/nya.png",
+    "assets/sl/skin.bmp",
+  };
+  for (const auto &image : images) {
+    const std::string prefix = "Texture2DFromFile/" + image;
+    if (!suite.enabled(prefix)) {
+      continue;
+    }
+    std::vector<double> decode, upload, total;
+    for (uint32_t i = 0; i < 5; ++i) {
+      int32_t width, height, nrChannels;
+      auto start = Clock::now();
+      unsigned char *data = stbi_load(image.c_str(), &width, &height, &nrChannels, 0);
+      decode.push_back(elapsed_ns(start));
+      if (data == nullptr) {
+        std::cerr << "[BENCH] failed to decode " << image << std::endl;
+        break;
+      }
+      GLenum format = nrChannels == 1 ? GL_RED : (nrChannels == 3 ? GL_RGB : GL_RGBA);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      start = Clock::now();
+      GLuint texture_id = Texture2DFromUChar(data, width, height, format);
+      glFinish();
+      upload.push_back(elapsed_ns(start));
+      glDeleteTextures(1, &texture_id);
+      stbi_image_free(data);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+      start = Clock::now();
+      texture_id = Texture2DFromFile(image);
+      glFinish();
+      total.push_back(elapsed_ns(start));
+      glDeleteTextures(1, &texture_id);
+    }
+    suite.report(prefix + "/decode", decode);
+    suite.report(prefix + "/upload", upload);
+    suite.report(prefix + "/total", total);
+  }
+}
+
+void bench_camera(BenchSuite &suite) {
+  const uint32_t calls = 100000;
+  Camera camera;
+  camera.position = {0, 30, 50};
+  suite.run("Camera::getViewMatrix", 20, calls, [&]() {
+    for (uint32_t i = 0; i < calls; ++i) {
+      camera.yaw += 0.001f;
+      bench_sink = bench_sink + camera.getViewMatrix()[0][0];
+    }
+  });
+  suite.run("Camera::getProjectionMatrix", 20, calls, [&]() {
+    for (uint32_t i = 0; i < calls; ++i) {
+      camera.fovy = 70.0f + (i & 0xF);
+      bench_sink = bench_sink + camera.getProjectionMatrix()[0][0];
+    }
+  });
+}
+
+void bench_snowflakes(BenchSuite &suite) {
+  std::ranlux48 random_engine(42);
+  for (uint64_t count : {64ull, 10000ull, 1000000ull}) {
+    const std::string name = "anmineSnowflakes/" + std::to_string(count);
+    if (!suite.enabled(name)) {
+      continue;
+    }
+    // 只关心变换更新，不需要网格数据
+    std::vector<Transform> snowflakes(count);
+    std::uniform_real_distribution<float> dist(-50, 50);
+    for (auto &flake : snowflakes) {
+      flake.translate = glm::vec3(dist(random_engine), 50 + dist(random_engine), dist(random_engine));
+    }
+    uint32_t iterations = count >= 1000000 ? 10 : 200;
+    suite.run(name, iterations, count, [&]() { anmineSnowflakes(snowflakes, random_engine, 1.0f / 60); });
+  }
+}
+
+// 启动时的着色器程序创建：source 为源码编译，binary 为命中程序二进制缓存
+void bench_shader_setup(BenchSuite &suite) {
+  if (!suite.enabled("ShaderProgram::setup")) {
+    return;
+  }
+  struct ProgramSource {
+    std::string vertex;
+    std::string fragment;
+    std::vector<std::string> defines;
+  };
+  const std::vector<ProgramSource> programs = {
+    {"shaders/default.vert", "shaders/lit.frag", {"RECEIVE_SHADOW", "CLUSTERED_LIGHTS"}},
+    {"shaders/default.vert", "shaders/lit.frag", {"ALPHA_TEST", "RECEIVE_SHADOW", "CLUSTERED_LIGHTS"}},
+    {"shaders/default.vert", "shaders/dot_light.frag", {}},
+    {"shaders/shadow.vert", "shaders/shadow.frag", {}},
+    {"shaders/skybox.vert", "shaders/skybox.frag", {}},
+    {"shaders/deferred.vert", "shaders/deferred.frag", {}},
+  };
+  auto setup = [&]() {
+    std::vector<ShaderProgram::Ptr> created;
+    for (const auto &source : programs) {
+      created.push_back(std::make_shared<ShaderProgram>(source.vertex, source.fragment, source.defines));
+    }
+    for (auto program : created) {
+      program->use();
+    }
+    glFinish();
+  };
+  ShaderProgram::set_binary_cache_dir("");
+  suite.run("ShaderProgram::setup/source", 5, programs.size(), setup);
+  ShaderProgram::set_binary_cache_dir("shader_cache");
+  setup();  // 预热缓存
+  suite.run("ShaderProgram::setup/binary", 5, programs.size(), setup);
+}
+
+void bench_set_uniform(BenchSuite &suite) {
+  if (!suite.enabled("ShaderProgram::set_uniform")) {
+    return;
+  }
+  ShaderProgram program("shaders/default.vert", "shaders/lit.frag", {"RECEIVE_SHADOW", "CLUSTERED_LIGHTS"});
+  const uint32_t calls = 10000;
+  glm::mat4 matrix(1.0f);
+  glm::vec3 vector(1.0f);
+  suite.run("ShaderProgram::set_uniform/mat4", 20, calls, [&]() {
+    for (uint32_t i = 0; i < calls; ++i) {
+      matrix[3][0] = (float)i;
+      program.set_uniform("model", matrix);
+    }
+    glFinish();
+  });
+  suite.run("ShaderProgram::set_uniform/vec3", 20, calls, [&]() {
+    for (uint32_t i = 0; i < calls; ++i) {
+      vector.x = (float)i;
+      program.set_uniform("cameraPos", vector);
+    }
+    glFinish();
+  });
+  suite.run("ShaderProgram::set_uniform/float", 20, calls, [&]() {
+    for (uint32_t i = 0; i < calls; ++i) {
+      program.set_uniform("shadow_zFar", (GLfloat)i);
+    }
+    glFinish();
+  });
+}
+
+// 三角形 BVH 的构建与查询，查询从包围盒外随机一点射向包围盒内随机一点
+void bench_bvh(BenchSuite &suite) {
+  const std::vector<std::string> assets = {
+    "assets/Snowman.obj",
+    "assets/icehouse/icehouse.obj",
+    "assets/sl/神里绫华.pmx",
+  };
+  const uint32_t queries = 1000;
+  for (const auto &asset : assets) {
+    const std::string prefix = "Bvh/" + asset;
+    if (!suite.enabled(prefix)) {
+      continue;
+    }
+    Model model(asset);
+    uint64_t triangles = model.get_triangle_count();
+    suite.run(prefix + "/build", 5, triangles, [&]() {
+      for (const auto &mesh : model.get_meshes()) {
+        std::vector<glm::vec3> positions;
+        for (const auto &vertex : mesh.vertices) {
+          positions.push_back(vertex.Position);
+        }
+        MeshBvh bvh(positions, mesh.indices);
+        bench_sink = bench_sink + bvh.get_node_count();
+      }
+    });
+
+    SceneBvh scene;
+    scene.add(model);
+    scene.build();
+    glm::vec3 min, max;
+    model.get_bounds(min, max);
+    glm::vec3 center = (min + max) * 0.5f;
+    float extent = glm::length(max - min);
+    std::ranlux48 random_engine(42);
+    std::uniform_real_distribution<float> unit(0, 1);
+    std::vector<glm::vec3> origins, targets;
+    for (uint32_t i = 0; i < queries; ++i) {
+      glm::vec3 dir = glm::normalize(glm::vec3(unit(random_engine), unit(random_engine), unit(random_engine)) - 0.5f);
+      origins.push_back(center + dir * extent);
+      targets.push_back(min + (max - min) * glm::vec3(unit(random_engine), unit(random_engine), unit(random_engine)));
+    }
+    suite.run(prefix + "/raycast", 20, queries, [&]() {
+      for (uint32_t i = 0; i < queries; ++i) {
+        SceneBvh::Hit hit;
+        bench_sink = bench_sink + scene.raycast(origins[i], targets[i] - origins[i], 1.0f, hit);
+      }
+    });
+    suite.run(prefix + "/sweep_sphere", 20, queries, [&]() {
+      for (uint32_t i = 0; i < queries; ++i) {
+        SceneBvh::Hit hit;
+        bench_sink = bench_sink + scene.sweep_sphere(origins[i], targets[i] - origins[i], extent * 0.02f, 1.0f, hit);
+      }
+    });
+    suite.run(prefix + "/closest_point", 20, queries, [&]() {
+      for (uint32_t i = 0; i < queries; ++i) {
+        SceneBvh::Hit hit;
+        bench_sink = bench_sink + scene.closest_point(targets[i], extent, hit);
+      }
+    });
+  }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  std::string out_path;
+  std::string filter;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--out" && i + 1 < argc) {
+      out_path = argv[++i];
+    } else if (arg == "--filter" && i + 1 < argc) {
+      filter = argv[++i];
+    } else {
+      std::cerr << "usage: " << argv[0] << " [--out result.json] [--filter name]" << std::endl;
+      return -1;
+    }
+  }
+
+  // 使用隐藏窗口创建 GL 上下文，不需要显示
+  glfwInit();
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+  GLFWwindow *window = glfwCreateWindow(64, 64, "Snow Bench", nullptr, nullptr);
+  if (window == nullptr) {
+    std::cout << "Failed to initialize GLFW Window" << std::endl;
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    std::cout << "Failed to initialize GLAD" << std::endl;
+    return -1;
+  }
+
+  ShaderProgram::enable_parallel_compile();
+
+  BenchSuite suite(filter);
+  bench_model_load(suite);
+  bench_mesh_setup(suite);
+  bench_texture(suite);
+  bench_camera(suite);
+  bench_snowflakes(suite);
+  bench_shader_setup(suite);
+  bench_set_uniform(suite);
+  bench_bvh(suite);
+
+  if (out_path.empty()) {
+    suite.write_json(std::cout);
+  } else {
+    std::ofstream fd(out_path);
+    suite.write_json(fd);
+  }
+
+  glfwTerminate();
+  return 0;
+}
@@ -0,0 +1,57 @@
+// 分簇点光源/聚光灯的查找与累加，由 lit.frag (CLUSTERED_LIGHTS 变体) 与 deferred.frag #include
+// 依赖包含它的着色器已声明的 Material 结构体
+// 见 ClusteredLighting
+uniform samplerBuffer lightData;
+uniform usamplerBuffer lightClusters;
+uniform usamplerBuffer lightIndices;
+uniform int clusterGridX;
+uniform int clusterGridY;
+uniform int clusterGridZ;
+uniform float clusterSliceNear;
+uniform float clusterSliceScale;
+uniform vec2 screenSize;
+
+const int LIGHT_POINT = 1;
+
+vec3 local_light(int idx, vec3 worldPos, vec3 N, vec3 V, Material material) {
+  vec4 position_range = texelFetch(lightData, idx * 4 + 0);
+  vec4 diffuse_type = texelFetch(lightData, idx * 4 + 1);
+  vec4 direction_inner = texelFetch(lightData, idx * 4 + 2);
+  vec4 specular_outer = texelFetch(lightData, idx * 4 + 3);
+
+  vec3 L = position_range.xyz - worldPos;
+  float dist = length(L);
+  if (dist >= position_range.w) {
+    return vec3(0);
+  }
+  L /= dist;
+  float ratio = dist / position_range.w;
+  float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+  float attenuation = window * window / (1.0 + dist * dist);
+  if (int(diffuse_type.w) != LIGHT_POINT) {
+    attenuation *= smoothstep(specular_outer.w, direction_inner.w, dot(-L, direction_inner.xyz));
+  }
+
+  vec3 H = normalize(L + V);
+  vec3 diffuse = max(dot(L, N), 0.0f) * diffuse_type.rgb * material.diffuse;
+  vec3 specular = pow(max(dot(N, H), 0.0f), material.shininess) * specular_outer.rgb * material.specular;
+  return attenuation * (diffuse + specular);
+}
+
+vec3 clustered_lights(vec3 worldPos, float viewDepth, vec3 cameraPos, vec3 normal, Material material) {
+  ivec2 tile = ivec2(gl_FragCoord.xy / screenSize * vec2(clusterGridX, clusterGridY));
+  tile = clamp(tile, ivec2(0), ivec2(clusterGridX - 1, clusterGridY - 1));
+  int slice = int(max(log(viewDepth / clusterSliceNear) * clusterSliceScale, 0.0));
+  slice = min(slice, clusterGridZ - 1);
+  int cluster = (slice * clusterGridY + tile.y) * clusterGridX + tile.x;
+  uvec2 offset_count = texelFetch(lightClusters, cluster).rg;
+
+  vec3 N = normalize(normal);
+  vec3 V = normalize(cameraPos - worldPos);
+  vec3 color = vec3(0);
+  for (uint i = 0u; i < offset_count.y; ++i) {
+    int idx = int(texelFetch(lightIndices, int(offset_count.x + i)).r);
+    color += local_light(idx, worldPos, N, V, material);
+  }
+  return color;
+}
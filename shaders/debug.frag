@@ -8,15 +8,14 @@ struct Texture {
 // texture map
   sampler2D diffuse0;
   sampler2D specular0;
-  sampler2D shadow0;
-  sampler2D alpha0;
 };
 
 uniform Texture textures;
+uniform sampler2D shadowAlpha;
 
 void main() {
   // f_color = vec4(vec3(texture(textures.alpha0, f_texcoord0).r *0.5 + 0.5), 1);
   // f_color = vec4(0.0, texture(textures.alpha0, f_texcoord0).g, 0.0, 1.0);
   // f_color = vec4(texture(textures.alpha0, f_texcoord0).r, 0.0, 0.0, 1.0);
-  f_color = vec4(texture(textures.alpha0, f_texcoord0).r, 0.0, 0.0, 1.0);
+  f_color = vec4(texture(shadowAlpha, f_texcoord0).r, 0.0, 0.0, 1.0);
 }
@@ -6,16 +6,64 @@ in vec3 normal;
 out vec2 texcoordOut0;
 out vec3 worldPos;
 out vec3 normalOut;
+out float viewDepth;
 
+#ifdef TERRAIN
+#include "terrain.glsl"
+uniform float terrainTexScale;
+
+// 由四周的高度求法线
+vec3 terrain_normal(ivec2 grid) {
+  float dx = terrain_height(grid - ivec2(1, 0)) - terrain_height(grid + ivec2(1, 0));
+  float dz = terrain_height(grid - ivec2(0, 1)) - terrain_height(grid + ivec2(0, 1));
+  return normalize(vec3(dx, 2.0 * terrainSpacing, dz));
+}
+#endif
+
+#ifdef SKINNED
+#include "skinning.glsl"
+#endif
+
+#ifdef INSTANCED
+// 逐实例的模型矩阵，只用于等比缩放的物体，法线直接用其左上 3x3 变换
+in mat4 instanceModel;
+#else
 uniform mat4 model;
+uniform mat4 NormalMatrix;
+#endif
 uniform mat4 view;
 uniform mat4 projection;
-uniform mat4 NormalMatrix;
+
+// 与深度预处理 (depth.vert) 保证深度逐位一致，才能使用 GL_EQUAL
+invariant gl_Position;
 
 
 void main() {
-  gl_Position = projection * view * model * vec4(position, 1.0);
+#ifdef TERRAIN
+  ivec2 grid;
+  worldPos = terrain_position(grid);
+  gl_Position = projection * view * vec4(worldPos, 1.0);
+  texcoordOut0 = worldPos.xz * terrainTexScale;
+  normalOut = terrain_normal(grid);
+  viewDepth = -(view * vec4(worldPos, 1.0)).z;
+#else
+#ifdef INSTANCED
+  mat4 model = instanceModel;
+  mat4 NormalMatrix = instanceModel;
+#endif
+#ifdef SKINNED
+  // 蒙皮矩阵只含旋转与等比缩放，法线直接用其左上 3x3 变换
+  mat3x4 skin = skin_matrix();
+  vec3 localPos = vec4(position, 1.0) * skin;
+  vec3 localNormal = vec4(normal, 0.0) * skin;
+#else
+  vec3 localPos = position;
+  vec3 localNormal = normal;
+#endif
+  gl_Position = projection * view * model * vec4(localPos, 1.0);
   texcoordOut0 = texcoord0;
-  worldPos = (model * vec4(position, 1.0)).xyz;
-  normalOut = normalize(NormalMatrix * vec4(normal, 0.0f)).xyz;
+  worldPos = (model * vec4(localPos, 1.0)).xyz;
+  normalOut = normalize(NormalMatrix * vec4(localNormal, 0.0f)).xyz;
+  viewDepth = -(view * model * vec4(localPos, 1.0)).z;
+#endif
 }
@@ -0,0 +1,92 @@
+#version 330 core
+in vec2 f_texcoord0;
+
+out vec4 fColor;
+
+uniform vec3 cameraPos;
+
+struct Material {
+  vec3 ambient;
+  vec3 diffuse;
+  vec3 specular;
+  float shininess;
+};
+
+struct Light {
+  int type;
+  vec3 position;
+  vec3 direction;
+  
+  float inner_cutoff;
+  float outer_cutoff;
+  
+  vec3 ambient;
+  vec3 diffuse;
+  vec3 specular;
+};
+
+uniform Light light;
+
+// g-buffer, see GBuffer
+uniform sampler2D gAlbedoSpec;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+
+uniform mat4 view;
+uniform mat4 inverseViewProjection;
+
+uniform sampler2DShadow shadowMap;
+uniform sampler2D shadowAlpha;
+uniform mat4 shadowVP;
+
+vec3 decode_normal(vec2 f) {
+  vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+  float t = clamp(-n.z, 0.0, 1.0);
+  n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+  return normalize(n);
+}
+
+vec3 blinn_phong(vec3 worldPos, vec3 cameraPos, vec3 normal,
+           Material material, Light light, float shadow) {
+  vec3 N = normalize(normal);
+  vec3 L = normalize(light.position - worldPos);
+  vec3 V = normalize(cameraPos - worldPos);
+  vec3 H = normalize(L + V);
+  vec3 ambient;
+  vec3 diffuse;
+  vec3 specular;
+
+  ambient = light.ambient * material.ambient;
+  diffuse = max(dot(L, N), 0.0f) * light.diffuse * material.diffuse;
+  specular = pow(max(dot(N, H), 0.0f), material.shininess) * light.specular * material.specular;
+
+  return ambient + (1 -shadow) * (diffuse + specular);
+}
+
+#include "clustered_lights.glsl"
+
+#include "shadow_filter.glsl"
+
+void main() {
+  float depth = texture(gDepth, f_texcoord0).r;
+  if (depth == 1.0) {
+    // background, keep the skybox
+    discard;
+  }
+  vec4 world = inverseViewProjection * vec4(vec3(f_texcoord0, depth) * 2.0 - 1.0, 1.0);
+  vec3 worldPos = world.xyz / world.w;
+  vec3 normal = decode_normal(texture(gNormal, f_texcoord0).rg);
+  vec4 albedo_spec = texture(gAlbedoSpec, f_texcoord0);
+
+  Material material;
+  material.ambient = albedo_spec.rgb;
+  material.diffuse = albedo_spec.rgb;
+  material.specular = vec3(albedo_spec.a);
+  material.shininess = 32;
+
+  float shadow = shadowMapping(shadowMap, shadowVP, vec4(worldPos, 1.0f), normal, shadowAlpha);
+  shadow = min(shadow, 0.75);
+  fColor = vec4(blinn_phong(worldPos, cameraPos, normal, material, light, shadow), 1.0);
+  float viewDepth = -(view * vec4(worldPos, 1.0)).z;
+  fColor.rgb += clustered_lights(worldPos, viewDepth, cameraPos, normal, material);
+}
@@ -0,0 +1,39 @@
+#version 330 core
+in vec3 position;
+
+#ifdef TERRAIN
+#include "terrain.glsl"
+#endif
+
+#ifdef SKINNED
+#include "skinning.glsl"
+#endif
+
+#ifdef INSTANCED
+in mat4 instanceModel;
+#else
+uniform mat4 model;
+#endif
+uniform mat4 view;
+uniform mat4 projection;
+
+// 与 default.vert 保证深度逐位一致
+invariant gl_Position;
+
+void main() {
+#ifdef TERRAIN
+  ivec2 grid;
+  gl_Position = projection * view * vec4(terrain_position(grid), 1.0);
+#else
+#ifdef INSTANCED
+  mat4 model = instanceModel;
+#endif
+#ifdef SKINNED
+  mat3x4 skin = skin_matrix();
+  vec3 localPos = vec4(position, 1.0) * skin;
+#else
+  vec3 localPos = position;
+#endif
+  gl_Position = projection * view * model * vec4(localPos, 1.0);
+#endif
+}
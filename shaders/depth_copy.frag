@@ -0,0 +1,9 @@
+#version 330 core
+in vec2 f_texcoord0;
+
+// 见 GBuffer::blit_depth：目标深度格式与 G-buffer 不同时，逐像素写回 G-buffer 的深度
+uniform sampler2D gDepth;
+
+void main() {
+  gl_FragDepth = texture(gDepth, f_texcoord0).r;
+}
@@ -0,0 +1,27 @@
+#version 330 core
+
+in vec2 texcoordOut0;
+out vec4 f_moments;
+
+struct Texture {
+// texture map
+  sampler2D diffuse0;
+  sampler2D specular0;
+  sampler2D shadow0;
+  sampler2D alpha0;
+};
+
+uniform Texture textures;
+// 见 VarianceShadowMap
+uniform vec2 evsmExponents;
+
+void main() {
+  // 矩无法表示半透明的遮挡，按 alpha 测试处理
+  if (texture(textures.diffuse0, texcoordOut0).a < 0.5) {
+    discard;
+  }
+  float depth = gl_FragCoord.z * 2.0 - 1.0;
+  float pos = exp(evsmExponents.x * depth);
+  float neg = -exp(-evsmExponents.y * depth);
+  f_moments = vec4(pos, pos * pos, neg, neg * neg);
+}
@@ -0,0 +1,20 @@
+#version 330 core
+
+in vec2 f_texcoord0;
+out vec4 f_color;
+
+uniform sampler2D source;
+// 一个纹素在模糊方向上的偏移
+uniform vec2 direction;
+
+// 9 个纹素的高斯核，利用双线性过滤合并为 5 次采样
+const float OFFSETS[3] = float[](0.0, 1.3846153846, 3.2307692308);
+const float WEIGHTS[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
+
+void main() {
+  f_color = textureLod(source, f_texcoord0, 0.0) * WEIGHTS[0];
+  for (int i = 1; i < 3; ++i) {
+    f_color += textureLod(source, f_texcoord0 + direction * OFFSETS[i], 0.0) * WEIGHTS[i];
+    f_color += textureLod(source, f_texcoord0 - direction * OFFSETS[i], 0.0) * WEIGHTS[i];
+  }
+}
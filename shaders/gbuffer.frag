@@ -0,0 +1,31 @@
+#version 330 core
+in vec2 texcoordOut0;
+in vec3 worldPos;
+in vec3 normalOut;
+
+layout(location = 0) out vec4 gAlbedoSpec;
+layout(location = 1) out vec2 gNormal;
+
+struct Texture {
+// texture map
+  sampler2D diffuse0;
+  sampler2D specular0;
+};
+
+uniform Texture textures;
+
+// octahedral normal encoding, [-1, 1]^2
+vec2 oct_wrap(vec2 v) {
+  return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 encode_normal(vec3 n) {
+  n /= abs(n.x) + abs(n.y) + abs(n.z);
+  return n.z >= 0.0 ? n.xy : oct_wrap(n.xy);
+}
+
+void main() {
+  gAlbedoSpec.rgb = texture(textures.diffuse0, texcoordOut0).rgb;
+  gAlbedoSpec.a = dot(texture(textures.specular0, texcoordOut0).rgb, vec3(0.299, 0.587, 0.114));
+  gNormal = encode_normal(normalize(normalOut));
+}
@@ -1,9 +1,20 @@
 #version 330 core
+// 受光照物体的着色器族，由 ShaderVariants 按需插入以下宏生成变体：
+//   ALPHA_TEST        丢弃 alpha < 0.1 的片元
+//   RECEIVE_SHADOW    接收主光源阴影，过滤等级见 shadowMapping
+//   CLUSTERED_LIGHTS  叠加分簇的点光源/聚光灯
+//   OIT_OUTPUT        输出到加权混合 OIT 的累积目标，见 OitBuffer
 in vec2 texcoordOut0;
 in vec3 worldPos;
 in vec3 normalOut;
+in float viewDepth;
 
+#ifdef OIT_OUTPUT
+layout(location = 0) out vec4 accum;
+layout(location = 1) out float revealage;
+#else
 out vec4 fColor;
+#endif
 
 uniform vec3 cameraPos;
 
@@ -11,8 +22,6 @@ struct Texture {
 // texture map
   sampler2D diffuse0;
   sampler2D specular0;
-  sampler2D shadow0;
-  sampler2D alpha0;
 };
 
 struct Material {
@@ -40,6 +49,9 @@ uniform Texture textures;
 uniform Light light;
 
 uniform mat4 shadowVP;
+// 阴影深度与透明度由帧图每帧分配，在读取它们的 pass 中绑定
+uniform sampler2DShadow shadowMap;
+uniform sampler2D shadowAlpha;
 
 uniform float shadow_zNear;
 uniform float shadow_zFar;
@@ -67,6 +79,10 @@ vec3 blinn_phong(vec3 worldPos, vec3 cameraPos, vec3 normal,
   return ambient + (1 -shadow) * (diffuse + specular);
 }
 
+#ifdef CLUSTERED_LIGHTS
+#include "clustered_lights.glsl"
+#endif
+
 Material convert_from_texture(Texture textures, vec2 texcoord, float shininess) {
   Material res;
   res.ambient = texture(textures.diffuse0, texcoord).rgb;
@@ -76,44 +92,40 @@ Material convert_from_texture(Texture textures, vec2 texcoord, float shininess)
   return res;
 }
 
-float shadowMapping(sampler2D tex, mat4 shadowVP, vec4 worldPos, sampler2D alphaTex) {
-  vec4 light_view_pos = shadowVP * worldPos;
-  light_view_pos = vec4(light_view_pos.xyz/light_view_pos.w, 1.0f);
-  light_view_pos = light_view_pos * 0.5 + 0.5;
-
-  float closetDepth = texture(tex, light_view_pos.xy).r;
-  float currentDepth = light_view_pos.z;
-  vec3 lightDir = light.position - worldPos.xyz;
-  float bias = max(0.05 * (1.0 - dot(normalOut, lightDir)), 0.005);
-
+#ifdef RECEIVE_SHADOW
+#include "shadow_filter.glsl"
+#endif
 
-  float shadow = 0;
-  vec2 texelSize = 1.0 / textureSize(tex, 0);
-  
-  for(int x = -1; x <= 1; ++x)
-    {
-      for(int y = -1; y <= 1; ++y)
-        {
-          float pcfDepth = texture(tex, light_view_pos.xy + vec2(x, y) * texelSize).r; 
-          shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;        
-        }    
-    }
-  shadow /= 9.0; 
-
-  float alpha = texture(alphaTex, light_view_pos.xy).r;
-  shadow *= alpha * alpha * alpha * alpha;
-  if (light_view_pos.z > 1) {
-    shadow = 0.0;
-  }
-  return shadow;
+#ifdef OIT_OUTPUT
+// 距离越近权重越大 (McGuire & Bavoil 2013, eq. 7)
+float oit_weight(float depth, float alpha) {
+  return alpha * clamp(0.03 / (1e-5 + pow(depth / 200.0, 4.0)), 1e-2, 3e3);
 }
+#endif
 
 void main() {
-  fColor = texture(textures.diffuse0, texcoordOut0);
-  if(fColor.a < 0.1){
+  vec4 color = texture(textures.diffuse0, texcoordOut0);
+#ifdef ALPHA_TEST
+  if(color.a < 0.1){
     discard;
   }
-  float shadow = shadowMapping(textures.shadow0, shadowVP, vec4(worldPos, 1.0f), textures.alpha0);
+#endif
+  float shadow = 0.0;
+#ifdef RECEIVE_SHADOW
+  shadow = shadowMapping(shadowMap, shadowVP, vec4(worldPos, 1.0f), normalOut, shadowAlpha);
   shadow = min(shadow, 0.75);
-  fColor.rgb = blinn_phong(worldPos, cameraPos, normalOut, convert_from_texture(textures, texcoordOut0, 32), light, shadow);
-}
\ No newline at end of file
+#endif
+  Material material = convert_from_texture(textures, texcoordOut0, 32);
+  color.rgb = blinn_phong(worldPos, cameraPos, normalOut, material, light, shadow);
+#ifdef CLUSTERED_LIGHTS
+  color.rgb += clustered_lights(worldPos, viewDepth, cameraPos, normalOut, material);
+#endif
+
+#ifdef OIT_OUTPUT
+  float alpha = min(color.a, 0.999);
+  accum = vec4(color.rgb * alpha, alpha) * oit_weight(viewDepth, alpha);
+  revealage = -log2(1.0 - alpha);
+#else
+  fColor = color;
+#endif
+}
@@ -0,0 +1,20 @@
+#version 330 core
+in vec2 texcoordOut0;
+
+struct Texture {
+// texture map
+  sampler2D diffuse0;
+  sampler2D specular0;
+  sampler2D shadow0;
+  sampler2D alpha0;
+};
+
+uniform Texture textures;
+
+// 透明物体上完全不透明的部分先写入深度，
+// 使其后方的透明片元被正确遮挡
+void main() {
+  if (texture(textures.diffuse0, texcoordOut0).a < 0.999) {
+    discard;
+  }
+}
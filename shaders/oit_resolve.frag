@@ -0,0 +1,23 @@
+#version 330 core
+in vec2 f_texcoord0;
+
+out vec4 fColor;
+
+// 见 OitBuffer
+uniform sampler2D oitAccum;
+uniform sampler2D oitRevealage;
+
+void main() {
+  // Π(1 - alpha)，即背景透过所有透明层后剩余的比例
+  float revealage = exp2(-texture(oitRevealage, f_texcoord0).r);
+  if (revealage >= 0.999) {
+    discard;
+  }
+  vec4 accum = texture(oitAccum, f_texcoord0);
+  // 防止 16 位浮点溢出
+  if (isinf(max(max(abs(accum.r), abs(accum.g)), abs(accum.b)))) {
+    accum.rgb = vec3(accum.a);
+  }
+  vec3 average = accum.rgb / max(accum.a, 1e-5);
+  fColor = vec4(average, 1.0 - revealage);
+}
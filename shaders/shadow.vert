@@ -5,11 +5,39 @@ in vec2 texcoord0;
 
 out vec2 texcoordOut0;
 
+#ifdef TERRAIN
+#include "terrain.glsl"
+uniform float terrainTexScale;
+#endif
+
+#ifdef SKINNED
+#include "skinning.glsl"
+#endif
+
+#ifdef INSTANCED
+in mat4 instanceModel;
+#else
 uniform mat4 model;
+#endif
 uniform mat4 view;
 uniform mat4 projection;
 
 void main() {
-  gl_Position = projection * view * model * vec4(position, 1.0);
+#ifdef TERRAIN
+  ivec2 grid;
+  vec3 world = terrain_position(grid);
+  gl_Position = projection * view * vec4(world, 1.0);
+  texcoordOut0 = world.xz * terrainTexScale;
+#else
+#ifdef INSTANCED
+  mat4 model = instanceModel;
+#endif
+#ifdef SKINNED
+  vec3 localPos = vec4(position, 1.0) * skin_matrix();
+#else
+  vec3 localPos = position;
+#endif
+  gl_Position = projection * view * model * vec4(localPos, 1.0);
   texcoordOut0 = texcoord0;
+#endif
 }
@@ -0,0 +1,124 @@
+// 主光源阴影的过滤，由 lit.frag (RECEIVE_SHADOW 变体) 与 deferred.frag #include
+// 依赖包含它的着色器已声明的 light 主光源
+// 阴影过滤等级，见 ShadowFilter：
+//   默认            1 次硬件 PCF (sampler2DShadow 双线性比较)
+//   SHADOW_POISSON  16 次旋转泊松盘硬件 PCF
+//   SHADOW_PCSS     搜索遮挡物估计半影宽度的软阴影 (PCSS)
+//   SHADOW_EVSM     指数方差阴影，一次过滤采样
+// 不带比较的同一张深度图，PCSS 搜索遮挡物时使用
+uniform sampler2D shadowDepth;
+// 单位深度差对应的半影宽度 (纹理坐标)
+uniform float shadowPenumbraScale;
+
+const vec2 POISSON_DISK[16] = vec2[](
+  vec2(-0.94201624, -0.39906216), vec2(0.94558609, -0.76890725),
+  vec2(-0.09418410, -0.92938870), vec2(0.34495938, 0.29387760),
+  vec2(-0.91588581, 0.45771432), vec2(-0.81544232, -0.87912464),
+  vec2(-0.38277543, 0.27676845), vec2(0.97484398, 0.75648379),
+  vec2(0.44323325, -0.97511554), vec2(0.53742981, -0.47373420),
+  vec2(-0.26496911, -0.41893023), vec2(0.79197514, 0.19090188),
+  vec2(-0.24188840, 0.99706507), vec2(-0.81409955, 0.91437590),
+  vec2(0.19984126, 0.78641367), vec2(0.14383161, -0.14100790)
+);
+
+// 逐像素旋转泊松盘，把带状走样变成高频噪声
+mat2 poisson_rotation() {
+  float angle = 6.2831853 * fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+  float s = sin(angle);
+  float c = cos(angle);
+  return mat2(c, s, -s, c);
+}
+
+// 返回被照亮的比例
+float poisson_pcf(sampler2DShadow tex, vec3 coord, vec2 radius) {
+  mat2 rotation = poisson_rotation();
+  float lit = 0.0;
+  for (int i = 0; i < 16; ++i) {
+    lit += texture(tex, vec3(coord.xy + rotation * POISSON_DISK[i] * radius, coord.z));
+  }
+  return lit / 16.0;
+}
+
+float pcss(sampler2DShadow tex, vec3 coord, vec2 texelSize) {
+  // 在可能产生半影的范围内搜索遮挡物的平均深度
+  vec2 search_radius = clamp(vec2(shadowPenumbraScale * coord.z), texelSize, texelSize * 32.0);
+  mat2 rotation = poisson_rotation();
+  float blocker_depth = 0.0;
+  float blockers = 0.0;
+  for (int i = 0; i < 16; ++i) {
+    float depth = texture(shadowDepth, coord.xy + rotation * POISSON_DISK[i] * search_radius).r;
+    if (depth < coord.z) {
+      blocker_depth += depth;
+      blockers += 1.0;
+    }
+  }
+  if (blockers == 0.0) {
+    return 1.0;
+  }
+  blocker_depth /= blockers;
+  // 平行光：半影宽度与接收面到遮挡物的距离成正比
+  vec2 radius = clamp(vec2((coord.z - blocker_depth) * shadowPenumbraScale), texelSize, texelSize * 32.0);
+  return poisson_pcf(tex, coord, radius);
+}
+
+#ifdef SHADOW_EVSM
+// 见 VarianceShadowMap
+uniform sampler2D shadowMoments;
+uniform vec2 evsmExponents;
+uniform float evsmBleedReduction;
+
+float chebyshev_upper_bound(vec2 moments, float mean, float min_variance) {
+  if (mean <= moments.x) {
+    return 1.0;
+  }
+  float variance = max(moments.y - moments.x * moments.x, min_variance);
+  float d = mean - moments.x;
+  float p_max = variance / (variance + d * d);
+  // 漏光抑制：把 [bleed, 1] 重新映射到 [0, 1]
+  return clamp((p_max - evsmBleedReduction) / (1.0 - evsmBleedReduction), 0.0, 1.0);
+}
+
+// 返回被照亮的比例
+float evsm_lit(vec2 uv, float depth) {
+  vec4 moments = texture(shadowMoments, uv);
+  depth = depth * 2.0 - 1.0;
+  float pos = exp(evsmExponents.x * depth);
+  float neg = -exp(-evsmExponents.y * depth);
+  // 方差下限随指数缩放，避免平面上的自阴影
+  vec2 depth_scale = 0.0001 * evsmExponents * vec2(pos, neg);
+  float lit_pos = chebyshev_upper_bound(moments.xy, pos, depth_scale.x * depth_scale.x);
+  float lit_neg = chebyshev_upper_bound(moments.zw, neg, depth_scale.y * depth_scale.y);
+  return min(lit_pos, lit_neg);
+}
+#endif
+
+float shadowMapping(sampler2DShadow tex, mat4 shadowVP, vec4 worldPos, vec3 normal, sampler2D alphaTex) {
+  vec4 light_view_pos = shadowVP * worldPos;
+  light_view_pos = vec4(light_view_pos.xyz/light_view_pos.w, 1.0f);
+  light_view_pos = light_view_pos * 0.5 + 0.5;
+  if (light_view_pos.z > 1) {
+    return 0.0;
+  }
+
+  float currentDepth = light_view_pos.z;
+  vec3 lightDir = light.position - worldPos.xyz;
+  float bias = max(0.05 * (1.0 - dot(normal, lightDir)), 0.005);
+  vec3 coord = vec3(light_view_pos.xy, currentDepth - bias);
+  vec2 texelSize = 1.0 / textureSize(tex, 0);
+
+#if defined(SHADOW_EVSM)
+  float shadow = 1.0 - evsm_lit(light_view_pos.xy, currentDepth);
+#elif defined(SHADOW_PCSS)
+  float shadow = 1.0 - pcss(tex, coord, texelSize);
+#elif defined(SHADOW_POISSON)
+  float shadow = 1.0 - poisson_pcf(tex, coord, texelSize * 1.5);
+#else
+  float shadow = 1.0 - texture(tex, coord);
+#endif
+  // EVSM 的矩在阴影阶段已按 alpha 测试处理遮挡，不再乘透明度
+#ifndef SHADOW_EVSM
+  float alpha = texture(alphaTex, light_view_pos.xy).r;
+  shadow *= alpha * alpha * alpha * alpha;
+#endif
+  return shadow;
+}
@@ -0,0 +1,22 @@
+// 蒙皮的公共代码，由 default.vert、depth.vert、shadow.vert 在 SKINNED 变体中 #include
+// 见 BonePalette：每根骨骼占 3 个纹素，依次为蒙皮矩阵 (3x4) 的三行
+in uvec4 boneIndices;
+in vec4 boneWeights;
+uniform samplerBuffer bonePalette;
+uniform int boneOffset;  // 本实例第一根骨骼的纹素，为负表示本帧没有调色板 (见 BonePalette::update)
+
+// 按权重混合的蒙皮矩阵，vec4(p, 1.0) * skin_matrix() 得到变换后的位置
+// 没有调色板时返回单位矩阵，即按绑定姿态绘制，而不是读取调色板之外的纹素
+mat3x4 skin_matrix() {
+  if (boneOffset < 0) {
+    return mat3x4(vec4(1.0, 0.0, 0.0, 0.0), vec4(0.0, 1.0, 0.0, 0.0), vec4(0.0, 0.0, 1.0, 0.0));
+  }
+  mat3x4 skin = mat3x4(0.0);
+  for (int i = 0; i < 4; ++i) {
+    int base = boneOffset + int(boneIndices[i]) * 3;
+    skin[0] += texelFetch(bonePalette, base) * boneWeights[i];
+    skin[1] += texelFetch(bonePalette, base + 1) * boneWeights[i];
+    skin[2] += texelFetch(bonePalette, base + 2) * boneWeights[i];
+  }
+  return skin;
+}
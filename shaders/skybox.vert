@@ -9,6 +9,7 @@ uniform mat4 view;
 uniform mat4 projection;
 
 void main() {
-  gl_Position = projection * view * model * vec4(position, 1.0f);
+  // z = w，透视除法后深度恒为 1，在不透明物体之后以 GL_LEQUAL 绘制
+  gl_Position = (projection * view * model * vec4(position, 1.0f)).xyww;
   f_texcoord = position;
 }
@@ -0,0 +1,38 @@
+// 地形顶点的公共代码，由 default.vert、depth.vert、shadow.vert 在 TERRAIN 变体中 #include，见 Terrain
+// position.xz 为块内网格点的整数坐标，高度取自高度纹理数组的 terrainLayer 层
+// 依赖包含它的着色器已声明的 in vec3 position
+uniform sampler2DArray terrainHeights;
+uniform int terrainLayer;
+uniform vec2 terrainOrigin;
+uniform float terrainSpacing;
+uniform int terrainResolution;
+uniform vec4 terrainStitch;  // -x, +x, -z, +z 方向相邻块的网格步长，不比本块粗时为 1
+
+float terrain_height(ivec2 grid) {
+  return texelFetch(terrainHeights, ivec3(grid + 1, terrainLayer), 0).r;
+}
+
+// 与较粗的相邻块共边的顶点，高度取粗网格上两端顶点的线性插值
+float terrain_stitched_height(ivec2 grid) {
+  int step = 1;
+  ivec2 along = ivec2(0);
+  if (grid.x == 0 || grid.x == terrainResolution) {
+    step = int(grid.x == 0 ? terrainStitch.x : terrainStitch.y);
+    along = ivec2(0, 1);
+  } else if (grid.y == 0 || grid.y == terrainResolution) {
+    step = int(grid.y == 0 ? terrainStitch.z : terrainStitch.w);
+    along = ivec2(1, 0);
+  }
+  int offset = (grid.x * along.x + grid.y * along.y) % step;
+  if (offset == 0) {
+    return terrain_height(grid);
+  }
+  ivec2 start = grid - along * offset;
+  return mix(terrain_height(start), terrain_height(start + along * step), float(offset) / float(step));
+}
+
+vec3 terrain_position(out ivec2 grid) {
+  grid = ivec2(position.xz + 0.5);
+  return vec3(terrainOrigin.x + grid.x * terrainSpacing, terrain_stitched_height(grid),
+              terrainOrigin.y + grid.y * terrainSpacing);
+}
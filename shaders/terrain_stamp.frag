@@ -0,0 +1,22 @@
+#version 330 core
+
+out vec4 f_height;
+
+// 见 Terrain::deform，目标为高度纹理数组的一层，以 GL_MIN 混合
+uniform vec2 terrainOrigin;
+uniform float terrainSpacing;
+uniform vec3 stampBottom;
+uniform float stampRadius;
+
+void main() {
+  // 纹素 (i, j) 对应网格点 (i - 1, j - 1)
+  vec2 world = terrainOrigin + (gl_FragCoord.xy - 1.5) * terrainSpacing;
+  vec2 offset = world - stampBottom.xz;
+  float distance2 = dot(offset, offset);
+  float radius2 = stampRadius * stampRadius;
+  if (distance2 >= radius2) {
+    discard;
+  }
+  // 最低点在 stampBottom 的球的下半球面
+  f_height = vec4(stampBottom.y + stampRadius - sqrt(radius2 - distance2));
+}
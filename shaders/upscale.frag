@@ -0,0 +1,32 @@
+#version 330 core
+in vec2 f_texcoord0;
+
+out vec4 fColor;
+
+// 缩小分辨率渲染的场景颜色，线性过滤
+uniform sampler2D sceneColor;
+// 锐化强度 [0, 1]，0 时只做双线性放大
+uniform float sharpness;
+
+void main() {
+  // 双线性放大，再以源纹素为间距取上下左右四个邻居做对比度自适应锐化 (类似 RCAS)
+  vec2 texel = 1.0 / vec2(textureSize(sceneColor, 0));
+  vec3 c = texture(sceneColor, f_texcoord0).rgb;
+  if (sharpness <= 0.0) {
+    fColor = vec4(c, 1.0);
+    return;
+  }
+  vec3 n = texture(sceneColor, f_texcoord0 + vec2(0.0, texel.y)).rgb;
+  vec3 s = texture(sceneColor, f_texcoord0 - vec2(0.0, texel.y)).rgb;
+  vec3 e = texture(sceneColor, f_texcoord0 + vec2(texel.x, 0.0)).rgb;
+  vec3 w = texture(sceneColor, f_texcoord0 - vec2(texel.x, 0.0)).rgb;
+
+  // 邻域越接近 0 或 1 的边界，锐化越弱，避免边缘过冲产生光晕
+  vec3 lo = min(c, min(min(n, s), min(e, w)));
+  vec3 hi = max(c, max(max(n, s), max(e, w)));
+  vec3 amount = sqrt(clamp(min(lo, 1.0 - hi) / max(hi, vec3(1e-4)), 0.0, 1.0));
+  // 负的邻居权重即拉普拉斯锐化，权重之和归一化
+  vec3 weight = -amount * sharpness * 0.2;
+  vec3 color = (c + (n + s + e + w) * weight) / (1.0 + 4.0 * weight);
+  fColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
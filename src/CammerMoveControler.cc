@@ -1,14 +1,14 @@
 #include"CammerMoveControler.h"
 
 void CammerMoveControler::move_right(float sen, float myDeltaTime, Camera::Ptr camera, Model::Ptr model, Model::Ptr firstPersonal){
-    camera->position += sen * myDeltaTime * glm::normalize(glm::cross(camera->direction, camera->up));
+    camera->position = move_sphere(camera->position, sen * myDeltaTime * glm::normalize(glm::cross(camera->direction, camera->up)), CAMERA_RADIUS);
 }
 void CammerMoveControler::move_left(float sen, float myDeltaTime, Camera::Ptr camera, Model::Ptr model, Model::Ptr firstPersonal){
-    camera->position -= sen * myDeltaTime * glm::normalize(glm::cross(camera->direction, camera->up));
+    camera->position = move_sphere(camera->position, -sen * myDeltaTime * glm::normalize(glm::cross(camera->direction, camera->up)), CAMERA_RADIUS);
 }
 void CammerMoveControler::move_ahead(float sen, float myDeltaTime, Camera::Ptr camera, Model::Ptr model, Model::Ptr firstPersonal){
-    camera->position += sen * myDeltaTime * camera->direction;
+    camera->position = move_sphere(camera->position, sen * myDeltaTime * camera->direction, CAMERA_RADIUS);
 }
 void CammerMoveControler::move_back(float sen, float myDeltaTime, Camera::Ptr camera, Model::Ptr model, Model::Ptr firstPersonal){
-    camera->position -= sen * myDeltaTime * camera->direction;
+    camera->position = move_sphere(camera->position, -sen * myDeltaTime * camera->direction, CAMERA_RADIUS);
 }
\ No newline at end of file
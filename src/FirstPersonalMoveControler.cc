@@ -18,22 +18,22 @@ glm::vec3 FirstPersonalMoveControler::get_model_direction(Model::Ptr model){
 
 void FirstPersonalMoveControler::move_ahead(float sen, float myDeltaTime, Camera::Ptr camera, Model::Ptr model, Model::Ptr firstPersonal){
     glm::vec3 direction = get_model_direction(firstPersonal);
-    firstPersonal->translate += sen * myDeltaTime * direction;
+    move_snowman(firstPersonal, sen * myDeltaTime * direction);
     camera->position = firstPersonal->translate + first_personal_camera_y + get_model_direction(firstPersonal);
 
 }
 void FirstPersonalMoveControler::move_back(float sen, float myDeltaTime, Camera::Ptr camera, Model::Ptr model, Model::Ptr firstPersonal){
     glm::vec3 direction = get_model_direction(firstPersonal);
-    firstPersonal->translate -= sen * myDeltaTime * direction;
+    move_snowman(firstPersonal, -sen * myDeltaTime * direction);
     camera->position = firstPersonal->translate + first_personal_camera_y + get_model_direction(firstPersonal);
 }
 void FirstPersonalMoveControler::move_left(float sen, float myDeltaTime, Camera::Ptr camera, Model::Ptr model, Model::Ptr firstPersonal){
     glm::vec3 direction = get_model_direction(firstPersonal);
-    firstPersonal->translate -= sen * myDeltaTime * glm::normalize(glm::cross(direction, glm::vec3(0, 1, 0)));
+    move_snowman(firstPersonal, -sen * myDeltaTime * glm::normalize(glm::cross(direction, glm::vec3(0, 1, 0))));
     camera->position = firstPersonal->translate + first_personal_camera_y + get_model_direction(firstPersonal);
 }
 void FirstPersonalMoveControler::move_right(float sen, float myDeltaTime, Camera::Ptr camera, Model::Ptr model, Model::Ptr firstPersonal){
     glm::vec3 direction = get_model_direction(firstPersonal);
-    firstPersonal->translate += sen * myDeltaTime * glm::normalize(glm::cross(direction, glm::vec3(0, 1, 0)));
+    move_snowman(firstPersonal, sen * myDeltaTime * glm::normalize(glm::cross(direction, glm::vec3(0, 1, 0))));
     camera->position = firstPersonal->translate + first_personal_camera_y + get_model_direction(firstPersonal);
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include "camera.h"
 #include "light.h"
 #include "model.h"
+#include "scene_bvh.h"
 #include "shader.h"
 #include "utils.h"
 
@@ -22,4 +23,31 @@ public:
     void virtual move_left(float sen, float myDeltaTime, Camera::Ptr camera, Model::Ptr model, Model::Ptr firstPersonal)=0;
     void virtual move_ahead(float sen, float myDeltaTime, Camera::Ptr camera, Model::Ptr model, Model::Ptr firstPersonal)=0;
     void virtual move_back(float sen, float myDeltaTime, Camera::Ptr camera, Model::Ptr model, Model::Ptr firstPersonal)=0;
+
+    // 设置后移动会被场景中的静态物体阻挡，为空时自由移动
+    static void set_collision_scene(SceneBvh::Ptr scene){ collision_scene = scene; }
+    // 自由相机的碰撞球半径
+    static constexpr float CAMERA_RADIUS = 0.5f;
+    // 半径为 radius 的球从 position 移动 delta，沿碰到的表面滑动
+    static glm::vec3 move_sphere(const glm::vec3 &position, const glm::vec3 &delta, float radius){
+        if(collision_scene == nullptr){
+            return position + delta;
+        }
+        return collision_scene->slide_sphere(position, delta, radius);
+    }
+
+protected:
+    // 雪人身体的碰撞球，球心抬高 SNOWMAN_STEP，可以越过低矮的台阶
+    static constexpr float SNOWMAN_RADIUS = 2.0f;
+    static constexpr float SNOWMAN_STEP = 0.5f;
+    // 雪人在地面上水平移动，碰撞只改变水平位置
+    static void move_snowman(Model::Ptr snowman, const glm::vec3 &delta){
+        glm::vec3 center_offset(0, SNOWMAN_RADIUS + SNOWMAN_STEP, 0);
+        glm::vec3 center = move_sphere(snowman->translate + center_offset, glm::vec3(delta.x, 0, delta.z), SNOWMAN_RADIUS);
+        snowman->translate.x = center.x;
+        snowman->translate.z = center.z;
+    }
+
+private:
+    inline static SceneBvh::Ptr collision_scene = nullptr;
 };
\ No newline at end of file
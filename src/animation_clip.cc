@@ -0,0 +1,187 @@
+#include "animation_clip.h"
+
+#include <assimp/scene.h>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ANIMATION_USE_SSE2
+#endif
+
+AnimationClip::AnimationClip(const std::string &name, const Skeleton &skeleton, float duration) : name(name) {
+  this->duration = std::max(duration, 1.0f / SAMPLE_RATE);
+  frame_count = std::max<uint32_t>((uint32_t)std::ceil(this->duration * SAMPLE_RATE) + 1, 2);
+  const Pose &rest = skeleton.get_rest_pose();
+  stride = rest.stride;
+  frames.reserve(rest.data.size() * frame_count);
+  for (uint32_t i = 0; i < frame_count; ++i) {
+    frames.insert(frames.end(), rest.data.begin(), rest.data.end());
+  }
+}
+
+// time 之前的最后一个关键帧及到下一个关键帧的插值系数，超出范围时取两端
+template <typename Key> static uint32_t locate(const Key *keys, uint32_t count, double time, float &alpha) noexcept {
+  const Key *next = std::upper_bound(keys, keys + count, time, [](double t, const Key &key) { return t < key.mTime; });
+  alpha = 0.0f;
+  if (next == keys) {
+    return 0;
+  }
+  if (next == keys + count) {
+    return count - 1;
+  }
+  uint32_t index = next - keys - 1;
+  double span = keys[index + 1].mTime - keys[index].mTime;
+  alpha = span > 0 ? (float)((time - keys[index].mTime) / span) : 0.0f;
+  return index;
+}
+
+static glm::vec3 sample_vector(const aiVectorKey *keys, uint32_t count, double time, const glm::vec3 &fallback) noexcept {
+  if (count == 0) {
+    return fallback;
+  }
+  float alpha;
+  uint32_t index = locate(keys, count, time, alpha);
+  const aiVector3D &a = keys[index].mValue;
+  const aiVector3D &b = keys[std::min(index + 1, count - 1)].mValue;
+  return glm::mix(glm::vec3(a.x, a.y, a.z), glm::vec3(b.x, b.y, b.z), alpha);
+}
+
+static glm::quat sample_rotation(const aiQuatKey *keys, uint32_t count, double time, const glm::quat &fallback) noexcept {
+  if (count == 0) {
+    return fallback;
+  }
+  float alpha;
+  uint32_t index = locate(keys, count, time, alpha);
+  const aiQuaternion &a = keys[index].mValue;
+  const aiQuaternion &b = keys[std::min(index + 1, count - 1)].mValue;
+  return glm::normalize(glm::slerp(glm::quat(a.w, a.x, a.y, a.z), glm::quat(b.w, b.x, b.y, b.z), alpha));
+}
+
+AnimationClip::Ptr AnimationClip::from_assimp(const aiAnimation *animation, const Skeleton &skeleton) noexcept {
+  double ticks_per_second = animation->mTicksPerSecond > 0 ? animation->mTicksPerSecond : 25.0;
+  auto clip =
+    std::make_shared<AnimationClip>(animation->mName.C_Str(), skeleton, (float)(animation->mDuration / ticks_per_second));
+  for (uint32_t i = 0; i < animation->mNumChannels; ++i) {
+    const aiNodeAnim *channel = animation->mChannels[i];
+    int32_t bone = skeleton.find(channel->mNodeName.C_Str());
+    if (bone == Skeleton::NO_PARENT) {
+      continue;
+    }
+    const Skeleton::Bone &rest = skeleton.get_bones()[bone];
+    for (uint32_t frame = 0; frame < clip->frame_count; ++frame) {
+      double time = clip->get_frame_time(frame) * ticks_per_second;
+      glm::vec3 translation =
+        sample_vector(channel->mPositionKeys, channel->mNumPositionKeys, time, rest.rest_translation);
+      glm::quat rotation = sample_rotation(channel->mRotationKeys, channel->mNumRotationKeys, time, rest.rest_rotation);
+      glm::vec3 scale = sample_vector(channel->mScalingKeys, channel->mNumScalingKeys, time, rest.rest_scale);
+      const float values[Pose::CHANNELS] = {translation.x, translation.y, translation.z, rotation.x, rotation.y,
+                                            rotation.z,    rotation.w,    scale.x,       scale.y,    scale.z};
+      for (uint32_t c = 0; c < Pose::CHANNELS; ++c) {
+        clip->frame_channel(frame, c)[bone] = values[c];
+      }
+    }
+  }
+  return clip;
+}
+
+AnimationClip::Ptr AnimationClip::oscillate(const std::string &name, const Skeleton &skeleton, float duration,
+                                            const std::vector<Oscillation> &oscillations) noexcept {
+  auto clip = std::make_shared<AnimationClip>(name, skeleton, duration);
+  for (const auto &oscillation : oscillations) {
+    int32_t bone = skeleton.find(oscillation.bone);
+    if (bone == Skeleton::NO_PARENT) {
+      continue;
+    }
+    glm::vec3 axis = glm::normalize(oscillation.axis);
+    for (uint32_t frame = 0; frame < clip->frame_count; ++frame) {
+      float angle = glm::radians(360.0f) * oscillation.cycles * frame / (clip->frame_count - 1) + oscillation.phase;
+      float value = oscillation.amplitude * std::sin(angle);
+      if (oscillation.translate) {
+        for (uint32_t c = 0; c < 3; ++c) {
+          clip->frame_channel(frame, Pose::TX + c)[bone] += axis[c] * value;
+        }
+        continue;
+      }
+      // 在父骨骼空间中叠加旋转
+      float *q[4] = {clip->frame_channel(frame, Pose::QX), clip->frame_channel(frame, Pose::QY),
+                     clip->frame_channel(frame, Pose::QZ), clip->frame_channel(frame, Pose::QW)};
+      glm::quat rotation = glm::angleAxis(value, axis) * glm::quat(q[3][bone], q[0][bone], q[1][bone], q[2][bone]);
+      q[0][bone] = rotation.x;
+      q[1][bone] = rotation.y;
+      q[2][bone] = rotation.z;
+      q[3][bone] = rotation.w;
+    }
+  }
+  return clip;
+}
+
+void AnimationClip::sample(float time, float weight, Pose &accum) const noexcept {
+  float local = std::fmod(time, duration);
+  if (local < 0) {
+    local += duration;
+  }
+  float position = local / duration * (frame_count - 1);
+  uint32_t frame = std::min((uint32_t)position, frame_count - 2);
+  float alpha = std::min(position - frame, 1.0f);
+  const float *a = frames.data() + (size_t)frame * Pose::CHANNELS * stride;
+  const float *b = a + (size_t)Pose::CHANNELS * stride;
+  const uint32_t linear[6] = {Pose::TX, Pose::TY, Pose::TZ, Pose::SX, Pose::SY, Pose::SZ};
+  const uint32_t quat[4] = {Pose::QX, Pose::QY, Pose::QZ, Pose::QW};
+
+#ifdef ANIMATION_USE_SSE2
+  const __m128 t = _mm_set1_ps(alpha), w = _mm_set1_ps(weight);
+  const __m128 zero = _mm_setzero_ps(), sign = _mm_set1_ps(-0.0f);
+  for (uint32_t i = 0; i < stride; i += Pose::LANES) {
+    for (uint32_t c : linear) {
+      __m128 from = _mm_loadu_ps(a + c * stride + i), to = _mm_loadu_ps(b + c * stride + i);
+      __m128 value = _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(to, from), t));
+      float *target = accum.channel(c) + i;
+      _mm_storeu_ps(target, _mm_add_ps(_mm_loadu_ps(target), _mm_mul_ps(value, w)));
+    }
+    // nlerp：两帧不在同一半球时翻转后一帧，走较短的弧
+    __m128 from[4], to[4], acc[4];
+    __m128 d = zero, d_acc = zero;
+    for (uint32_t c = 0; c < 4; ++c) {
+      from[c] = _mm_loadu_ps(a + quat[c] * stride + i);
+      to[c] = _mm_loadu_ps(b + quat[c] * stride + i);
+      d = _mm_add_ps(d, _mm_mul_ps(from[c], to[c]));
+    }
+    __m128 flip = _mm_and_ps(_mm_cmplt_ps(d, zero), sign);
+    for (uint32_t c = 0; c < 4; ++c) {
+      to[c] = _mm_xor_ps(to[c], flip);
+      from[c] = _mm_add_ps(from[c], _mm_mul_ps(_mm_sub_ps(to[c], from[c]), t));
+      acc[c] = _mm_loadu_ps(accum.channel(quat[c]) + i);
+      d_acc = _mm_add_ps(d_acc, _mm_mul_ps(acc[c], from[c]));
+    }
+    // 与已累加的结果同半球后再加权累加
+    __m128 signed_weight = _mm_xor_ps(w, _mm_and_ps(_mm_cmplt_ps(d_acc, zero), sign));
+    for (uint32_t c = 0; c < 4; ++c) {
+      _mm_storeu_ps(accum.channel(quat[c]) + i, _mm_add_ps(acc[c], _mm_mul_ps(from[c], signed_weight)));
+    }
+  }
+#else
+  for (uint32_t i = 0; i < stride; ++i) {
+    for (uint32_t c : linear) {
+      float from = a[c * stride + i], to = b[c * stride + i];
+      accum.channel(c)[i] += (from + (to - from) * alpha) * weight;
+    }
+    float from[4], to[4], d = 0.0f, d_acc = 0.0f;
+    for (uint32_t c = 0; c < 4; ++c) {
+      from[c] = a[quat[c] * stride + i];
+      to[c] = b[quat[c] * stride + i];
+      d += from[c] * to[c];
+    }
+    for (uint32_t c = 0; c < 4; ++c) {
+      from[c] += ((d < 0 ? -to[c] : to[c]) - from[c]) * alpha;
+      d_acc += accum.channel(quat[c])[i] * from[c];
+    }
+    float signed_weight = d_acc < 0 ? -weight : weight;
+    for (uint32_t c = 0; c < 4; ++c) {
+      accum.channel(quat[c])[i] += from[c] * signed_weight;
+    }
+  }
+#endif
+}
@@ -0,0 +1,67 @@
+#ifndef __ANIMATION_CLIP_H__
+#define __ANIMATION_CLIP_H__
+
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "skeleton.h"
+
+struct aiAnimation;
+
+/** 骨骼动画片段
+ * 导入时按 SAMPLE_RATE 重采样为均匀的帧，每帧是骨架全部骨骼的一份 SoA 姿态 (见 Pose)，
+ * 没有关键帧的骨骼取静止姿态。采样时只需定位相邻两帧，SIMD 一次对 4 根骨骼做线性插值
+ * (四元数为 nlerp)，并按权重累加到混合结果中，不再逐骨骼查找关键帧
+ */
+class AnimationClip {
+public:
+  typedef std::shared_ptr<AnimationClip> Ptr;
+
+  static constexpr float SAMPLE_RATE = 30.0f;
+
+  // 程序化的周期动作：骨骼在静止姿态上绕 axis 按正弦摆动，或沿 axis 平移
+  struct Oscillation {
+    std::string bone;
+    glm::vec3 axis;
+    float amplitude;     // 弧度，translate 为 true 时为距离
+    uint32_t cycles;     // 片段内的周期数，为整数保证循环时首尾相接
+    float phase = 0.0f;  // 弧度
+    bool translate = false;
+  };
+
+  // 通道按节点名对应到骨骼，找不到的通道被忽略
+  static Ptr from_assimp(const aiAnimation *animation, const Skeleton &skeleton) noexcept;
+  // 骨架中不存在的骨骼被忽略
+  static Ptr oscillate(const std::string &name, const Skeleton &skeleton, float duration,
+                       const std::vector<Oscillation> &oscillations) noexcept;
+
+  // 时长为 duration 秒，各帧初始化为静止姿态
+  AnimationClip(const std::string &name, const Skeleton &skeleton, float duration);
+
+  // 循环地在 time 秒处采样，以 weight 累加到 accum；accum 由 Pose::clear 开始，全部层累加后 Pose::normalize
+  void sample(float time, float weight, Pose &accum) const noexcept;
+
+  const std::string &get_name() const noexcept { return name; }
+  float get_duration() const noexcept { return duration; }
+  uint32_t get_frame_count() const noexcept { return frame_count; }
+  // 第 frame 帧的时刻
+  float get_frame_time(uint32_t frame) const noexcept { return duration * frame / (frame_count - 1); }
+  // 构建时写入第 frame 帧的分量，布局与 Pose::channel 相同
+  float *frame_channel(uint32_t frame, uint32_t channel) noexcept {
+    return frames.data() + ((size_t)frame * Pose::CHANNELS + channel) * stride;
+  }
+
+private:
+  std::string name;
+  float duration;
+  uint32_t frame_count;
+  uint32_t stride;
+  std::vector<float> frames;
+};
+
+#endif  // !__ANIMATION_CLIP_H__
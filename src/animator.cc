@@ -0,0 +1,51 @@
+#include "animator.h"
+
+#include <cmath>
+
+uint32_t Animator::add_clip(AnimationClip::Ptr clip) noexcept {
+  clips.push_back(clip);
+  return clips.size() - 1;
+}
+
+int32_t Animator::find_clip(const std::string &name) const noexcept {
+  for (uint32_t i = 0; i < clips.size(); ++i) {
+    if (clips[i]->get_name() == name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void Animator::play(uint32_t clip, float weight, float speed, float time) noexcept {
+  if (clip >= clips.size()) {
+    return;
+  }
+  Layer layer;
+  layer.clip = clip;
+  layer.weight = weight;
+  layer.speed = speed;
+  layer.time = time;
+  layers.push_back(layer);
+}
+
+void Animator::advance(float dt) noexcept {
+  for (auto &layer : layers) {
+    // 片段循环播放，时间保持在一个周期内以免浮点精度随运行时间下降
+    float duration = clips[layer.clip]->get_duration();
+    layer.time = std::fmod(layer.time + dt * layer.speed, duration);
+  }
+}
+
+void Animator::evaluate(float *palette) noexcept {
+  pose.clear();
+  float total_weight = 0.0f;
+  for (const auto &layer : layers) {
+    if (layer.weight <= 0.0f) {
+      continue;
+    }
+    clips[layer.clip]->sample(layer.time, layer.weight, pose);
+    total_weight += layer.weight;
+  }
+  pose.normalize(total_weight, skeleton->get_rest_pose());
+  skeleton->compute_palette(pose, scratch, palette);
+}
@@ -0,0 +1,60 @@
+#ifndef __ANIMATOR_H__
+#define __ANIMATOR_H__
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "animation_clip.h"
+#include "skeleton.h"
+
+/** 一个角色实例的动画状态
+ * 骨架与动画片段在同一模型的所有副本间共享，每个副本只持有自己的播放层与临时姿态。
+ * 各层同时播放，evaluate 时按权重混合成一个姿态，再求出蒙皮矩阵
+ */
+class Animator {
+public:
+  typedef std::shared_ptr<Animator> Ptr;
+
+  struct Layer {
+    uint32_t clip = 0;
+    float time = 0.0f;   // 秒
+    float speed = 1.0f;  // 播放速率
+    float weight = 1.0f;
+  };
+
+  explicit Animator(Skeleton::Ptr skeleton) : skeleton(skeleton), pose(skeleton->get_bone_count()) {}
+
+  // 返回片段的下标
+  uint32_t add_clip(AnimationClip::Ptr clip) noexcept;
+  // 不存在时返回 -1
+  int32_t find_clip(const std::string &name) const noexcept;
+  const std::vector<AnimationClip::Ptr> &get_clips() const noexcept { return clips; }
+
+  // 增加一个播放层
+  void play(uint32_t clip, float weight = 1.0f, float speed = 1.0f, float time = 0.0f) noexcept;
+  std::vector<Layer> &get_layers() noexcept { return layers; }
+
+  // 各层按自身速率推进 dt 秒
+  void advance(float dt) noexcept;
+  // 采样并混合各层，把每根骨骼的蒙皮矩阵 (3 个 vec4) 写入 palette；没有权重不为 0 的层时为静止姿态
+  void evaluate(float *palette) noexcept;
+
+  const Skeleton::Ptr &get_skeleton() const noexcept { return skeleton; }
+  uint32_t get_bone_count() const noexcept { return skeleton->get_bone_count(); }
+  // 本帧蒙皮矩阵在调色板中的起始纹素，见 BonePalette；为负时着色器按绑定姿态绘制
+  int32_t get_palette_offset() const noexcept { return palette_offset; }
+  void set_palette_offset(int32_t offset) noexcept { palette_offset = offset; }
+
+private:
+  Skeleton::Ptr skeleton;
+  std::vector<AnimationClip::Ptr> clips;
+  std::vector<Layer> layers;
+  Pose pose;
+  std::vector<Affine> scratch;
+  int32_t palette_offset = -1;
+};
+
+#endif  // !__ANIMATOR_H__
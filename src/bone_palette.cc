@@ -0,0 +1,111 @@
+#include "bone_palette.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+BonePalette::BonePalette(WorkerPool::Ptr pool) : pool(pool) { glGenTextures(1, &texture); }
+
+BonePalette::~BonePalette() { glDeleteTextures(1, &texture); }
+
+void BonePalette::add(Animator::Ptr animator) noexcept {
+  if (animator == nullptr) {
+    return;
+  }
+  animators.push_back(animator);
+}
+
+bool BonePalette::reserve(GLsizeiptr frame_size) noexcept {
+  GLint max_texels = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+  // 按 texture buffer 中的纹素寻址，整个环形缓冲都必须在上限之内
+  if (frame_size / 16 * StreamBuffer::FRAMES_IN_FLIGHT > max_texels) {
+    return false;
+  }
+  if (stream != nullptr && frame_size <= capacity) {
+    return true;
+  }
+  // 按 2 倍增长，避免角色逐个增加时反复重建
+  capacity = std::max<GLsizeiptr>(frame_size, capacity * 2);
+  capacity = std::min<GLsizeiptr>(capacity, (GLsizeiptr)max_texels / StreamBuffer::FRAMES_IN_FLIGHT * 16);
+  stream = std::make_shared<StreamBuffer>(GL_TEXTURE_BUFFER, capacity);
+  glBindTexture(GL_TEXTURE_BUFFER, texture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, stream->get_id());
+  glBindTexture(GL_TEXTURE_BUFFER, GL_ZERO);
+  return true;
+}
+
+void BonePalette::fall_back_to_bind_pose(float dt, const char *reason) noexcept {
+  if (!warned_bind_pose) {
+    std::cout << "[WARN::BonePalette] " << reason << ", skinned meshes are drawn in bind pose" << std::endl;
+    warned_bind_pose = true;
+  }
+  // 负偏移让 skinning.glsl 返回单位矩阵；姿态仍然推进，恢复后动画不会跳变
+  for (auto &animator : animators) {
+    animator->advance(dt);
+    animator->set_palette_offset(-1);
+  }
+}
+
+void BonePalette::update(float dt) noexcept {
+  auto start = std::chrono::steady_clock::now();
+  stats = Stats();
+  stats.animators = animators.size();
+  if (animators.empty()) {
+    return;
+  }
+
+  // 各 Animator 在本帧分配中的位置
+  offsets.resize(animators.size());
+  GLsizeiptr size = 0;
+  for (uint32_t i = 0; i < animators.size(); ++i) {
+    offsets[i] = size;
+    size += (GLsizeiptr)animators[i]->get_bone_count() * TEXELS_PER_BONE * 16;
+    stats.bones += animators[i]->get_bone_count();
+  }
+  if (!reserve(size)) {
+    fall_back_to_bind_pose(dt, "palette exceeds GL_MAX_TEXTURE_BUFFER_SIZE");
+    return;
+  }
+
+  stream->begin_frame();
+  in_frame = true;
+  StreamBuffer::Allocation allocation = stream->allocate(size);
+  if (allocation.data == nullptr) {
+    fall_back_to_bind_pose(dt, "palette stream allocation failed");
+    return;
+  }
+
+  auto evaluate = [&](uint32_t i) {
+    Animator &animator = *animators[i];
+    animator.advance(dt);
+    animator.set_palette_offset((allocation.offset + offsets[i]) / 16);
+    animator.evaluate((float *)((uint8_t *)allocation.data + offsets[i]));
+  };
+  if (pool == nullptr || animators.size() == 1) {
+    for (uint32_t i = 0; i < animators.size(); ++i) {
+      evaluate(i);
+    }
+  } else {
+    pool->run(animators.size(), evaluate);
+  }
+  stream->commit(allocation);
+
+  stats.uploaded_bytes = size;
+  stats.evaluate_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BonePalette::end_frame() noexcept {
+  if (!in_frame) {
+    return;
+  }
+  stream->end_frame();
+  in_frame = false;
+}
+
+void BonePalette::bind(ShaderProgram::Ptr shader) const noexcept {
+  glActiveTexture(GL_TEXTURE0 + PALETTE_UNIT);
+  glBindTexture(GL_TEXTURE_BUFFER, texture);
+  glActiveTexture(GL_TEXTURE0);
+  shader->set_uniform("bonePalette", PALETTE_UNIT);
+}
@@ -0,0 +1,73 @@
+#ifndef __BONE_PALETTE_H__
+#define __BONE_PALETTE_H__
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "animator.h"
+#include "shader.h"
+#include "stream_buffer.h"
+#include "worker_pool.h"
+
+/** 所有蒙皮角色共用的骨骼矩阵调色板
+ * 每帧在线程池上并行推进并求值各 Animator 的姿态，蒙皮矩阵直接写入流式缓冲中本帧的区域，
+ * 整帧只有这一次上传，CPU 上的开销只有姿态求值。缓冲以 RGBA32F 的 texture buffer 供顶点着色器读取：
+ * 每根骨骼 TEXELS_PER_BONE 个纹素 (3x4 矩阵的三行)，绘制时 boneOffset 指向该实例的第一个纹素。
+ * 流式缓冲的空间在角色增加时按需重新分配。
+ * 本帧的调色板无法写入时 (超出 GL_MAX_TEXTURE_BUFFER_SIZE 或流式缓冲分配失败)，所有 Animator 的
+ * 偏移置为 -1，skinning.glsl 对负偏移返回单位矩阵，角色按绑定姿态绘制，不会读取调色板之外的数据
+ */
+class BonePalette {
+public:
+  typedef std::shared_ptr<BonePalette> Ptr;
+
+  // 着色器中使用的纹理单元
+  static constexpr GLint PALETTE_UNIT = 17;
+  static constexpr uint32_t TEXELS_PER_BONE = 3;
+
+  struct Stats {
+    uint32_t animators = 0;
+    uint32_t bones = 0;           // 本帧求值的骨骼总数
+    uint64_t uploaded_bytes = 0;  // 本帧写入的蒙皮矩阵
+    double evaluate_ms = 0;       // 推进与求值所有姿态的耗时
+  };
+
+  // pool 为空时在调用线程上逐个求值
+  explicit BonePalette(WorkerPool::Ptr pool);
+  BonePalette(const BonePalette &oth) = delete;
+  BonePalette &operator=(const BonePalette &oth) = delete;
+  ~BonePalette();
+
+  void add(Animator::Ptr animator) noexcept;
+  // 推进 dt 秒并写入本帧的调色板，在绘制任何蒙皮网格之前调用一次；失败时本帧按绑定姿态绘制
+  void update(float dt) noexcept;
+  // 帧结束时为本帧区域插入 fence
+  void end_frame() noexcept;
+  // 绑定调色板并设置 shader 的采样器
+  void bind(ShaderProgram::Ptr shader) const noexcept;
+
+  const Stats &get_stats() const noexcept { return stats; }
+
+private:
+  // 本帧的调色板超出纹理缓冲的上限时返回 false
+  bool reserve(GLsizeiptr frame_size) noexcept;
+  // 本帧不写调色板，所有角色回退到绑定姿态
+  void fall_back_to_bind_pose(float dt, const char *reason) noexcept;
+
+private:
+  WorkerPool::Ptr pool;
+  std::vector<Animator::Ptr> animators;
+  std::vector<GLintptr> offsets;  // 各 Animator 在本帧分配中的字节偏移
+  StreamBuffer::Ptr stream = nullptr;
+  GLsizeiptr capacity = 0;
+  GLuint texture = GL_ZERO;
+  bool in_frame = false;
+  bool warned_bind_pose = false;
+  Stats stats;
+};
+
+#endif  // !__BONE_PALETTE_H__
@@ -0,0 +1,547 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BVH_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr uint32_t BIN_COUNT = 16;
+// 遍历一个节点相对于测试一个图元的代价
+constexpr float TRAVERSAL_COST = 1.0f;
+
+struct BinaryNode {
+  Bvh::Aabb box;
+  uint32_t left = 0, right = 0;
+  uint32_t first = 0, count = 0;  // count > 0 为叶子
+};
+
+class Builder {
+public:
+  Builder(const std::vector<Bvh::Aabb> &bounds, uint32_t max_leaf, std::vector<uint32_t> &order)
+      : bounds(bounds), max_leaf(max_leaf), order(order) {
+    centers.reserve(bounds.size());
+    for (const auto &box : bounds) {
+      centers.push_back(box.center());
+    }
+  }
+
+  uint32_t build(uint32_t first, uint32_t count, uint32_t depth) {
+    Bvh::Aabb box, center_box;
+    for (uint32_t i = first; i < first + count; ++i) {
+      box.grow(bounds[order[i]]);
+      center_box.grow(centers[order[i]]);
+    }
+    uint32_t index = nodes.size();
+    nodes.emplace_back();
+    nodes[index].box = box;
+
+    uint32_t mid = first;
+    if (count > 1 && depth < Bvh::MAX_SAH_DEPTH) {
+      mid = sah_split(first, count, box, center_box);
+    }
+    if (mid == first) {
+      if (count <= max_leaf) {
+        nodes[index].first = first;
+        nodes[index].count = count;
+        return index;
+      }
+      // 质心重合或树过深，按数量对半划分
+      mid = first + count / 2;
+    }
+    uint32_t left = build(first, mid - first, depth + 1);
+    uint32_t right = build(mid, first + count - mid, depth + 1);
+    nodes[index].left = left;
+    nodes[index].right = right;
+    return index;
+  }
+
+  std::vector<BinaryNode> nodes;
+
+private:
+  // 分桶 SAH，返回划分位置，作为叶子更划算或无法划分时返回 first
+  uint32_t sah_split(uint32_t first, uint32_t count, const Bvh::Aabb &box, const Bvh::Aabb &center_box) {
+    struct Bin {
+      Bvh::Aabb box;
+      uint32_t count = 0;
+    };
+    float best_cost = std::numeric_limits<float>::max();
+    int32_t best_axis = -1;
+    uint32_t best_split = 0;
+    for (int32_t axis = 0; axis < 3; ++axis) {
+      float lo = center_box.min[axis];
+      float extent = center_box.max[axis] - lo;
+      if (extent <= 0) {
+        continue;
+      }
+      float scale = BIN_COUNT / extent;
+      Bin bins[BIN_COUNT];
+      for (uint32_t i = first; i < first + count; ++i) {
+        uint32_t bin = std::min(BIN_COUNT - 1, (uint32_t)((centers[order[i]][axis] - lo) * scale));
+        bins[bin].box.grow(bounds[order[i]]);
+        ++bins[bin].count;
+      }
+      // 从右向左累计右侧的面积与数量
+      float right_area[BIN_COUNT];
+      Bvh::Aabb right_box;
+      uint32_t right_count = 0;
+      uint32_t right_counts[BIN_COUNT];
+      for (uint32_t i = BIN_COUNT - 1; i > 0; --i) {
+        right_box.grow(bins[i].box);
+        right_count += bins[i].count;
+        right_area[i] = right_box.half_area();
+        right_counts[i] = right_count;
+      }
+      Bvh::Aabb left_box;
+      uint32_t left_count = 0;
+      for (uint32_t i = 0; i < BIN_COUNT - 1; ++i) {
+        left_box.grow(bins[i].box);
+        left_count += bins[i].count;
+        if (left_count == 0 || right_counts[i + 1] == 0) {
+          continue;
+        }
+        float cost = left_box.half_area() * left_count + right_area[i + 1] * right_counts[i + 1];
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_axis = axis;
+          best_split = i + 1;
+        }
+      }
+    }
+    if (best_axis < 0) {
+      return first;
+    }
+    float area = box.half_area();
+    float split_cost = TRAVERSAL_COST + (area > 0 ? best_cost / area : count);
+    if (count <= max_leaf && split_cost >= count) {
+      return first;
+    }
+    float lo = center_box.min[best_axis];
+    float scale = BIN_COUNT / (center_box.max[best_axis] - lo);
+    auto it = std::partition(order.begin() + first, order.begin() + first + count, [&](uint32_t primitive) {
+      return std::min(BIN_COUNT - 1, (uint32_t)((centers[primitive][best_axis] - lo) * scale)) < best_split;
+    });
+    uint32_t mid = it - order.begin();
+    return mid == first + count ? first : mid;
+  }
+
+private:
+  const std::vector<Bvh::Aabb> &bounds;
+  uint32_t max_leaf;
+  std::vector<uint32_t> &order;
+  std::vector<glm::vec3> centers;
+};
+
+void set_slot(Bvh::Node &node, uint32_t slot, const Bvh::Aabb &box, uint32_t child, uint32_t count) {
+  node.min_x[slot] = box.min.x;
+  node.min_y[slot] = box.min.y;
+  node.min_z[slot] = box.min.z;
+  node.max_x[slot] = box.max.x;
+  node.max_y[slot] = box.max.y;
+  node.max_z[slot] = box.max.z;
+  node.child[slot] = child;
+  node.count[slot] = count;
+}
+
+/** 把二叉节点 index 与其后代合并为一个四叉节点，每次展开面积最大的内部子节点
+ * level 为该四叉节点所在的层 (根为 1)，height 记录整棵四叉树的层数
+ */
+uint32_t collapse(const std::vector<BinaryNode> &binary, uint32_t index, std::vector<Bvh::Node> &nodes, uint32_t level,
+                  uint32_t &height) {
+  height = std::max(height, level);
+  uint32_t result = nodes.size();
+  nodes.emplace_back();
+  Bvh::Node &node = nodes[result];
+  for (uint32_t slot = 0; slot < 4; ++slot) {
+    set_slot(node, slot, Bvh::Aabb(), Bvh::Node::EMPTY, 0);
+  }
+
+  uint32_t children[4];
+  uint32_t child_count = 0;
+  if (binary[index].count > 0) {
+    children[child_count++] = index;
+  } else {
+    children[child_count++] = binary[index].left;
+    children[child_count++] = binary[index].right;
+  }
+  while (child_count < 4) {
+    int32_t widest = -1;
+    float widest_area = -1;
+    for (uint32_t i = 0; i < child_count; ++i) {
+      const BinaryNode &child = binary[children[i]];
+      if (child.count == 0 && child.box.half_area() > widest_area) {
+        widest = i;
+        widest_area = child.box.half_area();
+      }
+    }
+    if (widest < 0) {
+      break;
+    }
+    const BinaryNode &open = binary[children[widest]];
+    children[widest] = open.left;
+    children[child_count++] = open.right;
+  }
+
+  for (uint32_t slot = 0; slot < child_count; ++slot) {
+    const BinaryNode &child = binary[children[slot]];
+    if (child.count > 0) {
+      set_slot(nodes[result], slot, child.box, child.first, child.count);
+    } else {
+      // 递归会使 nodes 重新分配，不能持有引用
+      uint32_t child_index = collapse(binary, children[slot], nodes, level + 1, height);
+      set_slot(nodes[result], slot, child.box, child_index, 0);
+    }
+  }
+  return result;
+}
+
+// 三角形上距 p 最近的点 [Ericson, Real-Time Collision Detection 5.1.5]
+glm::vec3 closest_on_triangle(const glm::vec3 &p, const glm::vec3 &a, const glm::vec3 &ab, const glm::vec3 &ac) {
+  glm::vec3 ap = p - a;
+  float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+  if (d1 <= 0 && d2 <= 0) {
+    return a;
+  }
+  glm::vec3 bp = ap - ab;
+  float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+  if (d3 >= 0 && d4 <= d3) {
+    return a + ab;
+  }
+  float vc = d1 * d4 - d3 * d2;
+  if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+    return a + ab * (d1 / (d1 - d3));
+  }
+  glm::vec3 cp = ap - ac;
+  float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+  if (d6 >= 0 && d5 <= d6) {
+    return a + ac;
+  }
+  float vb = d5 * d2 - d1 * d6;
+  if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+    return a + ac * (d2 / (d2 - d6));
+  }
+  float va = d3 * d6 - d5 * d4;
+  if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+    return a + ab + (ac - ab) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+  }
+  float denom = 1.0f / (va + vb + vc);
+  return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+// 朝向 side 一侧的单位面法线，退化三角形返回 fallback
+glm::vec3 facing_normal(const glm::vec3 &e1, const glm::vec3 &e2, const glm::vec3 &side, const glm::vec3 &fallback) {
+  glm::vec3 n = glm::cross(e1, e2);
+  float length = glm::length(n);
+  if (length <= 0) {
+    return fallback;
+  }
+  n /= length;
+  return glm::dot(n, side) < 0 ? -n : n;
+}
+
+// 射线与以 a、b 为轴、半径为 r 的无限长圆柱相交，只接受投影落在线段内的解
+bool sweep_edge(const glm::vec3 &c, const glm::vec3 &d, float r, const glm::vec3 &a, const glm::vec3 &b, float &t,
+                glm::vec3 &axis_point) {
+  glm::vec3 ba = b - a, oa = c - a;
+  float baba = glm::dot(ba, ba), bard = glm::dot(ba, d), baoa = glm::dot(ba, oa);
+  float k2 = baba * glm::dot(d, d) - bard * bard;
+  if (k2 <= 1e-12f * baba) {
+    return false;
+  }
+  float k1 = baba * glm::dot(d, oa) - baoa * bard;
+  float k0 = baba * glm::dot(oa, oa) - baoa * baoa - r * r * baba;
+  float h = k1 * k1 - k2 * k0;
+  if (h < 0) {
+    return false;
+  }
+  float root = (-k1 - std::sqrt(h)) / k2;
+  float y = baoa + root * bard;
+  if (root < 0 || root >= t || y <= 0 || y >= baba) {
+    return false;
+  }
+  t = root;
+  axis_point = a + ba * (y / baba);
+  return true;
+}
+
+// 射线与以 v 为球心、半径为 r 的球相交
+bool sweep_vertex(const glm::vec3 &c, const glm::vec3 &d, float r, const glm::vec3 &v, float &t) {
+  glm::vec3 oc = c - v;
+  float dd = glm::dot(d, d);
+  float b = glm::dot(oc, d);
+  float h = b * b - dd * (glm::dot(oc, oc) - r * r);
+  if (dd <= 0 || h < 0) {
+    return false;
+  }
+  float root = (-b - std::sqrt(h)) / dd;
+  if (root < 0 || root >= t) {
+    return false;
+  }
+  t = root;
+  return true;
+}
+
+}  // namespace
+
+namespace Bvh {
+
+Aabb Node::bounds(uint32_t slot) const noexcept {
+  Aabb box;
+  box.min = glm::vec3(min_x[slot], min_y[slot], min_z[slot]);
+  box.max = glm::vec3(max_x[slot], max_y[slot], max_z[slot]);
+  return box;
+}
+
+Ray::Ray(const glm::vec3 &origin, const glm::vec3 &dir) noexcept : origin(origin), dir(dir) {
+  for (int32_t axis = 0; axis < 3; ++axis) {
+    float d = dir[axis];
+    if (std::fabs(d) < 1e-20f) {
+      d = d < 0 ? -1e-20f : 1e-20f;
+    }
+    inv_dir[axis] = 1.0f / d;
+  }
+  near_x = inv_dir.x < 0;
+  near_y = inv_dir.y < 0;
+  near_z = inv_dir.z < 0;
+}
+
+void build(const std::vector<Aabb> &bounds, uint32_t max_leaf, std::vector<Node> &nodes, std::vector<uint32_t> &order) {
+  nodes.clear();
+  order.resize(bounds.size());
+  for (uint32_t i = 0; i < bounds.size(); ++i) {
+    order[i] = i;
+  }
+  if (bounds.empty()) {
+    return;
+  }
+  Builder builder(bounds, std::max(max_leaf, 1u), order);
+  builder.build(0, bounds.size(), 0);
+  nodes.reserve(builder.nodes.size() / 2 + 1);
+  uint32_t height = 0;
+  collapse(builder.nodes, 0, nodes, 1, height);
+  // 遍历栈按 MAX_HEIGHT 分配
+  assert(height <= MAX_HEIGHT);
+}
+
+uint32_t intersect_ray(const Node &node, const Ray &ray, float max_t, float expand, float tnear[4]) noexcept {
+  // 扩张后的近平面为 near - expand * sign，换算到参数空间即减去 expand * |inv_dir|
+  glm::vec3 pad = glm::abs(ray.inv_dir) * expand;
+  const float *near_x = ray.near_x ? node.max_x : node.min_x;
+  const float *far_x = ray.near_x ? node.min_x : node.max_x;
+  const float *near_y = ray.near_y ? node.max_y : node.min_y;
+  const float *far_y = ray.near_y ? node.min_y : node.max_y;
+  const float *near_z = ray.near_z ? node.max_z : node.min_z;
+  const float *far_z = ray.near_z ? node.min_z : node.max_z;
+#ifdef BVH_SSE
+  __m128 ox = _mm_set1_ps(ray.origin.x), oy = _mm_set1_ps(ray.origin.y), oz = _mm_set1_ps(ray.origin.z);
+  __m128 ix = _mm_set1_ps(ray.inv_dir.x), iy = _mm_set1_ps(ray.inv_dir.y), iz = _mm_set1_ps(ray.inv_dir.z);
+  __m128 px = _mm_set1_ps(pad.x), py = _mm_set1_ps(pad.y), pz = _mm_set1_ps(pad.z);
+  __m128 tx0 = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(near_x), ox), ix), px);
+  __m128 ty0 = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(near_y), oy), iy), py);
+  __m128 tz0 = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(near_z), oz), iz), pz);
+  __m128 tx1 = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(far_x), ox), ix), px);
+  __m128 ty1 = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(far_y), oy), iy), py);
+  __m128 tz1 = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(far_z), oz), iz), pz);
+  __m128 t0 = _mm_max_ps(_mm_max_ps(tx0, ty0), _mm_max_ps(tz0, _mm_setzero_ps()));
+  __m128 t1 = _mm_min_ps(_mm_min_ps(tx1, ty1), _mm_min_ps(tz1, _mm_set1_ps(max_t)));
+  _mm_storeu_ps(tnear, t0);
+  return _mm_movemask_ps(_mm_cmple_ps(t0, t1));
+#else
+  uint32_t mask = 0;
+  for (uint32_t i = 0; i < 4; ++i) {
+    float t0 = std::max(std::max((near_x[i] - ray.origin.x) * ray.inv_dir.x - pad.x,
+                                 (near_y[i] - ray.origin.y) * ray.inv_dir.y - pad.y),
+                        std::max((near_z[i] - ray.origin.z) * ray.inv_dir.z - pad.z, 0.0f));
+    float t1 = std::min(std::min((far_x[i] - ray.origin.x) * ray.inv_dir.x + pad.x,
+                                 (far_y[i] - ray.origin.y) * ray.inv_dir.y + pad.y),
+                        std::min((far_z[i] - ray.origin.z) * ray.inv_dir.z + pad.z, max_t));
+    tnear[i] = t0;
+    mask |= (t0 <= t1) << i;
+  }
+  return mask;
+#endif
+}
+
+uint32_t box_distance2(const Node &node, const glm::vec3 &point, float max_distance2, float distance2[4]) noexcept {
+#ifdef BVH_SSE
+  __m128 zero = _mm_setzero_ps();
+  __m128 px = _mm_set1_ps(point.x), py = _mm_set1_ps(point.y), pz = _mm_set1_ps(point.z);
+  __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node.min_x), px), _mm_sub_ps(px, _mm_loadu_ps(node.max_x))), zero);
+  __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node.min_y), py), _mm_sub_ps(py, _mm_loadu_ps(node.max_y))), zero);
+  __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node.min_z), pz), _mm_sub_ps(pz, _mm_loadu_ps(node.max_z))), zero);
+  __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+  _mm_storeu_ps(distance2, d2);
+  return _mm_movemask_ps(_mm_cmplt_ps(d2, _mm_set1_ps(max_distance2)));
+#else
+  uint32_t mask = 0;
+  for (uint32_t i = 0; i < 4; ++i) {
+    float dx = std::max(std::max(node.min_x[i] - point.x, point.x - node.max_x[i]), 0.0f);
+    float dy = std::max(std::max(node.min_y[i] - point.y, point.y - node.max_y[i]), 0.0f);
+    float dz = std::max(std::max(node.min_z[i] - point.z, point.z - node.max_z[i]), 0.0f);
+    distance2[i] = dx * dx + dy * dy + dz * dz;
+    mask |= (distance2[i] < max_distance2) << i;
+  }
+  return mask;
+#endif
+}
+
+}  // namespace Bvh
+
+MeshBvh::MeshBvh(const std::vector<glm::vec3> &positions, const std::vector<uint32_t> &indices) {
+  uint32_t triangle_count = indices.size() / 3;
+  std::vector<Bvh::Aabb> triangle_bounds(triangle_count);
+  for (uint32_t i = 0; i < triangle_count; ++i) {
+    for (uint32_t j = 0; j < 3; ++j) {
+      triangle_bounds[i].grow(positions[indices[i * 3 + j]]);
+    }
+    bounds.grow(triangle_bounds[i]);
+  }
+  std::vector<uint32_t> order;
+  Bvh::build(triangle_bounds, 4, nodes, order);
+  triangles.reserve(triangle_count);
+  for (uint32_t index : order) {
+    const glm::vec3 &v0 = positions[indices[index * 3]];
+    const glm::vec3 &v1 = positions[indices[index * 3 + 1]];
+    const glm::vec3 &v2 = positions[indices[index * 3 + 2]];
+    triangles.push_back({v0, v1 - v0, v2 - v0, index});
+  }
+}
+
+bool MeshBvh::raycast(const glm::vec3 &origin, const glm::vec3 &dir, float max_t, Hit &hit) const noexcept {
+  bool found = false;
+  Bvh::Ray ray(origin, dir);
+  Bvh::traverse_ray(nodes, ray, 0, max_t, [&](uint32_t first, uint32_t count) {
+    // Möller–Trumbore，不剔除背面
+    for (uint32_t i = first; i < first + count; ++i) {
+      const Triangle &tri = triangles[i];
+      glm::vec3 p = glm::cross(dir, tri.e2);
+      float det = glm::dot(tri.e1, p);
+      if (std::fabs(det) < 1e-12f) {
+        continue;
+      }
+      float inv_det = 1.0f / det;
+      glm::vec3 s = origin - tri.v0;
+      float u = glm::dot(s, p) * inv_det;
+      if (u < 0 || u > 1) {
+        continue;
+      }
+      glm::vec3 q = glm::cross(s, tri.e1);
+      float v = glm::dot(dir, q) * inv_det;
+      if (v < 0 || u + v > 1) {
+        continue;
+      }
+      float t = glm::dot(tri.e2, q) * inv_det;
+      if (t < 0 || t > max_t) {
+        continue;
+      }
+      max_t = t;
+      hit.t = t;
+      hit.triangle = tri.index;
+      hit.normal = facing_normal(tri.e1, tri.e2, -dir, hit.normal);
+      found = true;
+    }
+  });
+  if (found) {
+    hit.point = origin + dir * hit.t;
+  }
+  return found;
+}
+
+bool MeshBvh::sweep_sphere(
+  const glm::vec3 &origin, const glm::vec3 &dir, float radius, float max_t, Hit &hit) const noexcept {
+  bool found = false;
+  float radius2 = radius * radius;
+  Bvh::Ray ray(origin, dir);
+  Bvh::traverse_ray(nodes, ray, radius, max_t, [&](uint32_t first, uint32_t count) {
+    for (uint32_t i = first; i < first + count; ++i) {
+      const Triangle &tri = triangles[i];
+      glm::vec3 closest = closest_on_triangle(origin, tri.v0, tri.e1, tri.e2);
+      glm::vec3 offset = origin - closest;
+      float distance2 = glm::dot(offset, offset);
+      if (distance2 < radius2) {
+        // 起点已经相交：只有继续向内运动才算接触，这样可以从穿插中退出
+        glm::vec3 normal = distance2 > 1e-12f ? offset / std::sqrt(distance2) : facing_normal(tri.e1, tri.e2, -dir, -dir);
+        if (glm::dot(normal, dir) < 0) {
+          max_t = 0;
+          hit = {0, closest, normal, tri.index};
+          found = true;
+        }
+        continue;
+      }
+
+      // 先与偏移 radius 的平面相交，接触点落在三角形内时就是最早的接触
+      glm::vec3 n = facing_normal(tri.e1, tri.e2, offset, glm::vec3(0));
+      float dn = glm::dot(dir, n);
+      if (dn < 0) {
+        float t = (glm::dot(origin - tri.v0, n) - radius) / -dn;
+        if (t >= 0 && t < max_t) {
+          glm::vec3 p = origin + dir * t - n * radius - tri.v0;
+          float d00 = glm::dot(tri.e1, tri.e1), d01 = glm::dot(tri.e1, tri.e2), d11 = glm::dot(tri.e2, tri.e2);
+          float d20 = glm::dot(p, tri.e1), d21 = glm::dot(p, tri.e2);
+          float denom = d00 * d11 - d01 * d01;
+          float b1 = d11 * d20 - d01 * d21, b2 = d00 * d21 - d01 * d20;
+          if (denom > 0 && b1 >= 0 && b2 >= 0 && b1 + b2 <= denom) {
+            max_t = t;
+            hit = {t, p + tri.v0, n, tri.index};
+            found = true;
+            continue;
+          }
+        }
+      }
+
+      // 否则最早的接触在某条边或某个顶点上
+      glm::vec3 v[3] = {tri.v0, tri.v0 + tri.e1, tri.v0 + tri.e2};
+      float t = max_t;
+      glm::vec3 contact;
+      bool touched = false;
+      for (uint32_t j = 0; j < 3; ++j) {
+        glm::vec3 axis_point;
+        if (sweep_edge(origin, dir, radius, v[j], v[(j + 1) % 3], t, axis_point)) {
+          contact = axis_point;
+          touched = true;
+        }
+      }
+      for (uint32_t j = 0; j < 3; ++j) {
+        if (sweep_vertex(origin, dir, radius, v[j], t)) {
+          contact = v[j];
+          touched = true;
+        }
+      }
+      if (touched) {
+        max_t = t;
+        hit = {t, contact, glm::normalize(origin + dir * t - contact), tri.index};
+        found = true;
+      }
+    }
+  });
+  return found;
+}
+
+bool MeshBvh::closest_point(const glm::vec3 &point, float max_distance, Hit &hit) const noexcept {
+  bool found = false;
+  float max_distance2 = max_distance * max_distance;
+  Bvh::traverse_nearest(nodes, point, max_distance2, [&](uint32_t first, uint32_t count) {
+    for (uint32_t i = first; i < first + count; ++i) {
+      const Triangle &tri = triangles[i];
+      glm::vec3 closest = closest_on_triangle(point, tri.v0, tri.e1, tri.e2);
+      glm::vec3 offset = point - closest;
+      float distance2 = glm::dot(offset, offset);
+      if (distance2 >= max_distance2) {
+        continue;
+      }
+      max_distance2 = distance2;
+      hit.t = std::sqrt(distance2);
+      hit.point = closest;
+      hit.normal = hit.t > 1e-6f ? offset / hit.t : facing_normal(tri.e1, tri.e2, hit.normal, glm::vec3(0, 1, 0));
+      hit.triangle = tri.index;
+      found = true;
+    }
+  });
+  return found;
+}
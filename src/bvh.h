@@ -0,0 +1,222 @@
+#ifndef __BVH_H__
+#define __BVH_H__
+
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+/** 包围体层次结构的公共部分
+ * 以分桶 SAH 先建二叉树，再把每个节点与其孙节点合并为四叉节点；
+ * 四个子包围盒按 SoA 排列，遍历时用一次 SSE 比较同时测试四个盒子。
+ * 网格级的 MeshBvh 与场景级的 SceneBvh 共用这里的构建与盒子测试
+ */
+namespace Bvh {
+
+struct Aabb {
+  glm::vec3 min = glm::vec3(3.402823466e+38f);
+  glm::vec3 max = glm::vec3(-3.402823466e+38f);
+
+  void grow(const glm::vec3 &point) noexcept {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+  }
+  void grow(const Aabb &box) noexcept {
+    min = glm::min(min, box.min);
+    max = glm::max(max, box.max);
+  }
+  bool empty() const noexcept { return min.x > max.x; }
+  glm::vec3 center() const noexcept { return (min + max) * 0.5f; }
+  // 表面积的一半，SAH 只比较相对大小
+  float half_area() const noexcept {
+    glm::vec3 size = max - min;
+    return empty() ? 0 : size.x * size.y + size.y * size.z + size.z * size.x;
+  }
+};
+
+// 四叉节点，64 字节对齐，恰好两条缓存行
+struct alignas(64) Node {
+  static constexpr uint32_t EMPTY = 0xFFFFFFFF;
+
+  float min_x[4], min_y[4], min_z[4];
+  float max_x[4], max_y[4], max_z[4];
+  uint32_t child[4];  // count 为 0 时为子节点下标，否则为叶子第一个图元在 order 中的位置；空槽为 EMPTY
+  uint32_t count[4];  // 叶子的图元数
+
+  Aabb bounds(uint32_t slot) const noexcept;
+};
+
+// 已预处理的射线，方向分量为 0 时以极小值代替，避免 0 * inf
+struct Ray {
+  glm::vec3 origin;
+  glm::vec3 dir;
+  glm::vec3 inv_dir;
+  int32_t near_x, near_y, near_z;  // 方向为负时近平面取 max
+
+  Ray(const glm::vec3 &origin, const glm::vec3 &dir) noexcept;
+};
+
+/** 构建
+ * bounds 为每个图元的包围盒，max_leaf 为叶子最多容纳的图元数。
+ * 输出 nodes（nodes[0] 为根）与图元顺序 order，叶子引用 order 中的连续区间
+ */
+void build(const std::vector<Aabb> &bounds, uint32_t max_leaf, std::vector<Node> &nodes, std::vector<uint32_t> &order);
+
+// 射线与四个子盒（各向外扩 expand）在 [0, max_t] 内的相交，返回命中掩码，tnear 为进入距离
+uint32_t intersect_ray(const Node &node, const Ray &ray, float max_t, float expand, float tnear[4]) noexcept;
+// 点到四个子盒距离的平方，返回小于 max_distance2 的掩码
+uint32_t box_distance2(const Node &node, const glm::vec3 &point, float max_distance2, float distance2[4]) noexcept;
+
+// 二叉树超过该深度后不再做 SAH，改为按数量对半划分
+constexpr uint32_t MAX_SAH_DEPTH = 32;
+// 对半划分至多再进行 31 层就只剩一个图元 (图元数小于 2^32)，内部节点的深度因此小于 MAX_SAH_DEPTH + 32；
+// 四叉节点都来自二叉树的内部节点且每层至少消耗一层二叉节点，四叉树的层数不超过 MAX_HEIGHT，build 中断言
+constexpr uint32_t MAX_HEIGHT = MAX_SAH_DEPTH + 32;
+// 深度优先遍历时每层最多留下 3 个未访问的兄弟，再加上当前节点的 4 个子节点
+constexpr uint32_t STACK_SIZE = 3 * MAX_HEIGHT + 1;
+
+/** 沿射线由近到远访问叶子
+ * leaf(first, count) 处理一个叶子，可以缩短 max_t，之后更远的节点不再访问
+ */
+template <typename Leaf>
+void traverse_ray(const std::vector<Node> &nodes, const Ray &ray, float expand, float &max_t, Leaf &&leaf) {
+  if (nodes.empty()) {
+    return;
+  }
+  struct Entry {
+    uint32_t node;
+    float t;
+  };
+  Entry stack[STACK_SIZE];
+  uint32_t top = 0;
+  stack[top++] = {0, 0};
+  while (top > 0) {
+    Entry entry = stack[--top];
+    if (entry.t > max_t) {
+      continue;
+    }
+    const Node &node = nodes[entry.node];
+    float tnear[4];
+    uint32_t mask = intersect_ray(node, ray, max_t, expand, tnear);
+    // 命中的子节点按进入距离插入排序
+    uint32_t slots[4];
+    uint32_t hits = 0;
+    for (uint32_t i = 0; i < 4; ++i) {
+      if (mask & (1u << i)) {
+        uint32_t j = hits++;
+        for (; j > 0 && tnear[slots[j - 1]] > tnear[i]; --j) {
+          slots[j] = slots[j - 1];
+        }
+        slots[j] = i;
+      }
+    }
+    for (uint32_t i = 0; i < hits; ++i) {
+      uint32_t slot = slots[i];
+      if (node.count[slot] > 0 && tnear[slot] <= max_t) {
+        leaf(node.child[slot], node.count[slot]);
+      }
+    }
+    // 远的先入栈，近的先出栈
+    for (uint32_t i = hits; i-- > 0;) {
+      uint32_t slot = slots[i];
+      if (node.count[slot] == 0) {
+        stack[top++] = {node.child[slot], tnear[slot]};
+      }
+    }
+  }
+}
+
+/** 由近到远访问距 point 小于 sqrt(max_distance2) 的叶子
+ * leaf(first, count) 处理一个叶子，可以缩小 max_distance2
+ */
+template <typename Leaf>
+void traverse_nearest(const std::vector<Node> &nodes, const glm::vec3 &point, float &max_distance2, Leaf &&leaf) {
+  if (nodes.empty()) {
+    return;
+  }
+  struct Entry {
+    uint32_t node;
+    float distance2;
+  };
+  Entry stack[STACK_SIZE];
+  uint32_t top = 0;
+  stack[top++] = {0, 0};
+  while (top > 0) {
+    Entry entry = stack[--top];
+    if (entry.distance2 >= max_distance2) {
+      continue;
+    }
+    const Node &node = nodes[entry.node];
+    float distance2[4];
+    uint32_t mask = box_distance2(node, point, max_distance2, distance2);
+    uint32_t slots[4];
+    uint32_t hits = 0;
+    for (uint32_t i = 0; i < 4; ++i) {
+      if (mask & (1u << i)) {
+        uint32_t j = hits++;
+        for (; j > 0 && distance2[slots[j - 1]] > distance2[i]; --j) {
+          slots[j] = slots[j - 1];
+        }
+        slots[j] = i;
+      }
+    }
+    for (uint32_t i = 0; i < hits; ++i) {
+      uint32_t slot = slots[i];
+      if (node.count[slot] > 0 && distance2[slot] < max_distance2) {
+        leaf(node.child[slot], node.count[slot]);
+      }
+    }
+    for (uint32_t i = hits; i-- > 0;) {
+      uint32_t slot = slots[i];
+      if (node.count[slot] == 0) {
+        stack[top++] = {node.child[slot], distance2[slot]};
+      }
+    }
+  }
+}
+
+}  // namespace Bvh
+
+/** 单个网格的三角形 BVH
+ * 在网格的模型空间中构建，三角形按叶子顺序保存一份 (v0, e1, e2)，查询时不再访问原始顶点。
+ * 构建后只读，可以被多个线程同时查询
+ */
+class MeshBvh {
+public:
+  typedef std::shared_ptr<const MeshBvh> Ptr;
+
+  // 查询结果，均在网格的模型空间中
+  struct Hit {
+    float t = 0;                            // 射线 / 球心运动的参数，closest_point 中为距离
+    glm::vec3 point = glm::vec3(0);         // 表面上的接触点
+    glm::vec3 normal = glm::vec3(0, 1, 0);  // 单位法线，朝向查询一侧
+    uint32_t triangle = 0;                  // 三角形在 indices 中的序号
+  };
+
+  MeshBvh(const std::vector<glm::vec3> &positions, const std::vector<uint32_t> &indices);
+
+  // origin + dir * t，t 在 [0, max_t] 内的最近交点；dir 不要求单位长度，双面相交
+  bool raycast(const glm::vec3 &origin, const glm::vec3 &dir, float max_t, Hit &hit) const noexcept;
+  // 半径为 radius 的球从 origin 沿 dir 扫过 [0, max_t]，返回首次接触；起点已相交时 t 为 0
+  bool sweep_sphere(const glm::vec3 &origin, const glm::vec3 &dir, float radius, float max_t, Hit &hit) const noexcept;
+  // 距 point 不超过 max_distance 的最近表面点
+  bool closest_point(const glm::vec3 &point, float max_distance, Hit &hit) const noexcept;
+
+  const Bvh::Aabb &get_bounds() const noexcept { return bounds; }
+  uint32_t get_triangle_count() const noexcept { return triangles.size(); }
+  uint32_t get_node_count() const noexcept { return nodes.size(); }
+
+private:
+  struct Triangle {
+    glm::vec3 v0, e1, e2;
+    uint32_t index;
+  };
+
+  std::vector<Bvh::Node> nodes;
+  std::vector<Triangle> triangles;  // 按叶子顺序排列
+  Bvh::Aabb bounds;
+};
+
+#endif  // !__BVH_H__
@@ -0,0 +1,224 @@
+#include "clustered_lighting.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CLUSTER_USE_SSE2
+#endif
+
+static const GLenum texel_formats[3] = {GL_RGBA32F, GL_RG32UI, GL_R32UI};
+
+void ClusteredLighting::SliceBucket::clear() noexcept {
+  x.clear();
+  y.clear();
+  z.clear();
+  radius2.clear();
+  index.clear();
+}
+
+ClusteredLighting::ClusteredLighting() {
+  glGenBuffers(3, buffers);
+  glGenTextures(3, textures);
+  for (uint32_t i = 0; i < 3; ++i) {
+    // 预分配，避免空缓冲绑定到 texture buffer
+    upload(i, nullptr, 256);
+    glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+    glTexBuffer(GL_TEXTURE_BUFFER, texel_formats[i], buffers[i]);
+  }
+  glBindTexture(GL_TEXTURE_BUFFER, GL_ZERO);
+  cluster_texels.resize(CLUSTER_COUNT * 2, 0);
+}
+
+ClusteredLighting::~ClusteredLighting() {
+  glDeleteTextures(3, textures);
+  glDeleteBuffers(3, buffers);
+}
+
+void ClusteredLighting::upload(uint32_t slot, const void *data, size_t size) noexcept {
+  glBindBuffer(GL_TEXTURE_BUFFER, buffers[slot]);
+  if (size > capacities[slot]) {
+    capacities[slot] = std::max(size, capacities[slot] * 2);
+  }
+  // 每帧 orphan 旧存储，避免与上一帧的绘制同步
+  glBufferData(GL_TEXTURE_BUFFER, capacities[slot], nullptr, GL_STREAM_DRAW);
+  if (data != nullptr && size > 0) {
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+  }
+  glBindBuffer(GL_TEXTURE_BUFFER, GL_ZERO);
+}
+
+void ClusteredLighting::build_cluster_bounds(const Camera &camera) noexcept {
+  if (camera.fovy == bounds_fovy && camera.aspect == bounds_aspect && camera.zNear == bounds_near &&
+      camera.zFar == bounds_far && !cluster_min.empty()) {
+    return;
+  }
+  bounds_fovy = camera.fovy;
+  bounds_aspect = camera.aspect;
+  bounds_near = camera.zNear;
+  bounds_far = camera.zFar;
+
+  // 近处的切片过薄没有意义，从 slice_near 开始按指数划分，更近的片元都归入第 0 片
+  slice_near = std::max(camera.zNear, std::min(1.0f, camera.zFar * 0.01f));
+  slice_scale = GRID_Z / std::log(camera.zFar / slice_near);
+
+  cluster_min.resize(CLUSTER_COUNT);
+  cluster_max.resize(CLUSTER_COUNT);
+  float tan_y = std::tan(glm::radians(camera.fovy) / 2);
+  float tan_x = tan_y * camera.aspect;
+  for (uint32_t k = 0; k < GRID_Z; ++k) {
+    float depth_near = k == 0 ? camera.zNear : slice_near * std::exp(k / slice_scale);
+    float depth_far = slice_near * std::exp((k + 1) / slice_scale);
+    for (uint32_t y = 0; y < GRID_Y; ++y) {
+      float ndc_y0 = -1.0f + 2.0f * y / GRID_Y;
+      float ndc_y1 = -1.0f + 2.0f * (y + 1) / GRID_Y;
+      for (uint32_t x = 0; x < GRID_X; ++x) {
+        float ndc_x0 = -1.0f + 2.0f * x / GRID_X;
+        float ndc_x1 = -1.0f + 2.0f * (x + 1) / GRID_X;
+        // 瓦片四条边在 near/far 两个深度处的位置
+        float xs[4] = {
+          ndc_x0 * depth_near * tan_x, ndc_x0 * depth_far * tan_x, ndc_x1 * depth_near * tan_x, ndc_x1 * depth_far * tan_x};
+        float ys[4] = {
+          ndc_y0 * depth_near * tan_y, ndc_y0 * depth_far * tan_y, ndc_y1 * depth_near * tan_y, ndc_y1 * depth_far * tan_y};
+        uint32_t cluster = (k * GRID_Y + y) * GRID_X + x;
+        cluster_min[cluster] = glm::vec3(*std::min_element(xs, xs + 4), *std::min_element(ys, ys + 4), depth_near);
+        cluster_max[cluster] = glm::vec3(*std::max_element(xs, xs + 4), *std::max_element(ys, ys + 4), depth_far);
+      }
+    }
+  }
+}
+
+uint32_t ClusteredLighting::depth_slice(float depth) const noexcept {
+  if (depth <= slice_near) {
+    return 0;
+  }
+  float slice = std::log(depth / slice_near) * slice_scale;
+  return std::min((uint32_t)slice, GRID_Z - 1);
+}
+
+void ClusteredLighting::update(const std::vector<Light> &lights, Camera::Ptr camera, int32_t width, int32_t height) noexcept {
+  build_cluster_bounds(*camera);
+  screen_size = glm::vec2(std::max(width, 1), std::max(height, 1));
+  glm::mat4 view = camera->getViewMatrix();
+
+  for (auto &bucket : buckets) {
+    bucket.clear();
+  }
+  light_texels.clear();
+  light_indices.clear();
+  light_count = 0;
+
+  // 1. 光源变换到视空间，按深度切片分桶
+  for (const auto &light : lights) {
+    if (light.type == Light::SunLight) {
+      continue;
+    }
+    glm::vec4 view_pos = view * glm::vec4(light.position, 1.0f);
+    float depth = -view_pos.z;
+    if (depth + light.range < camera->zNear || depth - light.range > camera->zFar) {
+      continue;
+    }
+
+    uint32_t index = light_count++;
+    // smoothstep 要求外锥角余弦严格小于内锥角余弦
+    float inner = light.inner_cutoff;
+    float outer = std::min(light.outer_cutoff, inner - 1e-4f);
+    glm::vec3 direction = glm::length(light.direction) > 0 ? glm::normalize(light.direction) : glm::vec3(0, -1, 0);
+    light_texels.push_back(glm::vec4(light.position, light.range));
+    light_texels.push_back(glm::vec4(light.diffuse, (float)light.type));
+    light_texels.push_back(glm::vec4(direction, inner));
+    light_texels.push_back(glm::vec4(light.specular, outer));
+
+    uint32_t first = depth_slice(depth - light.range);
+    uint32_t last = depth_slice(depth + light.range);
+    for (uint32_t k = first; k <= last; ++k) {
+      buckets[k].x.push_back(view_pos.x);
+      buckets[k].y.push_back(view_pos.y);
+      buckets[k].z.push_back(depth);
+      buckets[k].radius2.push_back(light.range * light.range);
+      buckets[k].index.push_back(index);
+    }
+  }
+
+  // 2. 逐切片测试簇包围盒与光源影响球
+  for (uint32_t k = 0; k < GRID_Z; ++k) {
+    assign_slice(k);
+  }
+
+  // 3. 上传
+  upload(0, light_texels.data(), light_texels.size() * sizeof(glm::vec4));
+  upload(1, cluster_texels.data(), cluster_texels.size() * sizeof(GLuint));
+  upload(2, light_indices.data(), light_indices.size() * sizeof(GLuint));
+}
+
+void ClusteredLighting::assign_slice(uint32_t slice) noexcept {
+  SliceBucket &bucket = buckets[slice];
+  // 补齐到 4 的倍数，半径平方为负的光源永远不会相交
+  while (bucket.index.size() % 4 != 0) {
+    bucket.x.push_back(0);
+    bucket.y.push_back(0);
+    bucket.z.push_back(0);
+    bucket.radius2.push_back(-1);
+    bucket.index.push_back(0);
+  }
+  const size_t count = bucket.index.size();
+
+  for (uint32_t tile = 0; tile < GRID_X * GRID_Y; ++tile) {
+    uint32_t cluster = slice * GRID_X * GRID_Y + tile;
+    const glm::vec3 &bmin = cluster_min[cluster];
+    const glm::vec3 &bmax = cluster_max[cluster];
+    cluster_texels[cluster * 2] = light_indices.size();
+
+#ifdef CLUSTER_USE_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 min_x = _mm_set1_ps(bmin.x), min_y = _mm_set1_ps(bmin.y), min_z = _mm_set1_ps(bmin.z);
+    const __m128 max_x = _mm_set1_ps(bmax.x), max_y = _mm_set1_ps(bmax.y), max_z = _mm_set1_ps(bmax.z);
+    for (size_t i = 0; i < count; i += 4) {
+      __m128 cx = _mm_loadu_ps(&bucket.x[i]);
+      __m128 cy = _mm_loadu_ps(&bucket.y[i]);
+      __m128 cz = _mm_loadu_ps(&bucket.z[i]);
+      // 球心到包围盒的距离
+      __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_x, cx), _mm_sub_ps(cx, max_x)), zero);
+      __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_y, cy), _mm_sub_ps(cy, max_y)), zero);
+      __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_z, cz), _mm_sub_ps(cz, max_z)), zero);
+      __m128 dist2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+      int mask = _mm_movemask_ps(_mm_cmple_ps(dist2, _mm_loadu_ps(&bucket.radius2[i])));
+      for (int bit = 0; mask != 0; ++bit, mask >>= 1) {
+        if (mask & 0x1) {
+          light_indices.push_back(bucket.index[i + bit]);
+        }
+      }
+    }
+#else
+    for (size_t i = 0; i < count; ++i) {
+      float dx = std::max(std::max(bmin.x - bucket.x[i], bucket.x[i] - bmax.x), 0.0f);
+      float dy = std::max(std::max(bmin.y - bucket.y[i], bucket.y[i] - bmax.y), 0.0f);
+      float dz = std::max(std::max(bmin.z - bucket.z[i], bucket.z[i] - bmax.z), 0.0f);
+      if (dx * dx + dy * dy + dz * dz <= bucket.radius2[i]) {
+        light_indices.push_back(bucket.index[i]);
+      }
+    }
+#endif
+    cluster_texels[cluster * 2 + 1] = light_indices.size() - cluster_texels[cluster * 2];
+  }
+}
+
+void ClusteredLighting::bind(ShaderProgram::Ptr shader) const noexcept {
+  const GLint units[3] = {LIGHT_DATA_UNIT, LIGHT_CLUSTERS_UNIT, LIGHT_INDICES_UNIT};
+  for (uint32_t i = 0; i < 3; ++i) {
+    glActiveTexture(GL_TEXTURE0 + units[i]);
+    glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+  }
+  glActiveTexture(GL_TEXTURE0);
+
+  shader->set_uniform("lightData", units[0]);
+  shader->set_uniform("lightClusters", units[1]);
+  shader->set_uniform("lightIndices", units[2]);
+  shader->set_uniform("clusterGridX", (GLint)GRID_X);
+  shader->set_uniform("clusterGridY", (GLint)GRID_Y);
+  shader->set_uniform("clusterGridZ", (GLint)GRID_Z);
+  shader->set_uniform("clusterSliceNear", slice_near);
+  shader->set_uniform("clusterSliceScale", slice_scale);
+  shader->set_uniform("screenSize", screen_size);
+}
@@ -0,0 +1,86 @@
+#ifndef __CLUSTERED_LIGHTING_H__
+#define __CLUSTERED_LIGHTING_H__
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "camera.h"
+#include "light.h"
+#include "shader.h"
+
+/** 分簇前向渲染的光源管理
+ * 视锥按屏幕上 GRID_X × GRID_Y 个瓦片、深度上 GRID_Z 个指数分布的切片划分为簇，
+ * 每帧在 CPU 上把点光源/聚光灯分配到与其影响球相交的簇中 (SSE 一次测试 4 个光源)，
+ * 结果通过三个 texture buffer 传给片元着色器：
+ *   lightData     每个光源 4 个 RGBA32F 纹素
+ *   lightClusters 每个簇一个 RG32UI 纹素 (索引偏移, 光源数量)
+ *   lightIndices  R32UI 光源索引列表
+ * 仅支持透视投影的相机；SunLight 不参与分簇，仍作为主光源单独传入
+ */
+class ClusteredLighting {
+public:
+  typedef std::shared_ptr<ClusteredLighting> Ptr;
+
+  static constexpr uint32_t GRID_X = 16;
+  static constexpr uint32_t GRID_Y = 9;
+  static constexpr uint32_t GRID_Z = 24;
+  static constexpr uint32_t CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+
+  // 着色器中使用的纹理单元
+  static constexpr GLint LIGHT_DATA_UNIT = 20;
+  static constexpr GLint LIGHT_CLUSTERS_UNIT = 21;
+  static constexpr GLint LIGHT_INDICES_UNIT = 22;
+
+  ClusteredLighting();
+  ClusteredLighting(const ClusteredLighting &oth) = delete;
+  ClusteredLighting &operator=(const ClusteredLighting &oth) = delete;
+  ~ClusteredLighting();
+
+  // 每帧调用，width/height 为当前视口大小
+  void update(const std::vector<Light> &lights, Camera::Ptr camera, int32_t width, int32_t height) noexcept;
+  // 绑定 texture buffer 并设置 shader 的分簇参数
+  void bind(ShaderProgram::Ptr shader) const noexcept;
+
+  uint32_t get_light_count() const noexcept { return light_count; }
+  uint32_t get_index_count() const noexcept { return light_indices.size(); }
+
+private:
+  void build_cluster_bounds(const Camera &camera) noexcept;
+  uint32_t depth_slice(float depth) const noexcept;
+  void assign_slice(uint32_t slice) noexcept;
+  void upload(uint32_t slot, const void *data, size_t size) noexcept;
+
+private:
+  // 落在同一深度切片内的光源，SoA 布局便于 SIMD
+  struct SliceBucket {
+    std::vector<float> x, y, z, radius2;
+    std::vector<uint32_t> index;
+    void clear() noexcept;
+  };
+
+  // 簇在视空间中的包围盒 (x, y, 深度)，深度为到相机的正距离
+  std::vector<glm::vec3> cluster_min;
+  std::vector<glm::vec3> cluster_max;
+  float bounds_fovy = 0, bounds_aspect = 0, bounds_near = 0, bounds_far = 0;
+  float slice_near = 1, slice_scale = 0;  // 切片映射: k = log(depth / slice_near) * slice_scale
+
+  // 每帧的 CPU 数据
+  SliceBucket buckets[GRID_Z];
+  std::vector<glm::vec4> light_texels;
+  std::vector<GLuint> cluster_texels;
+  std::vector<GLuint> light_indices;
+  uint32_t light_count = 0;
+  glm::vec2 screen_size = glm::vec2(1, 1);
+
+  // GPU 对象: 0 lightData, 1 lightClusters, 2 lightIndices
+  GLuint buffers[3] = {GL_ZERO, GL_ZERO, GL_ZERO};
+  GLuint textures[3] = {GL_ZERO, GL_ZERO, GL_ZERO};
+  size_t capacities[3] = {0, 0, 0};
+};
+
+#endif  // !__CLUSTERED_LIGHTING_H__
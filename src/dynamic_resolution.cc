@@ -0,0 +1,63 @@
+#include "dynamic_resolution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+DynamicResolution::DynamicResolution(float target_ms, float min_scale, float max_scale)
+    : target_ms(target_ms), min_scale(min_scale), max_scale(max_scale), scale(max_scale), timer(GL_TIME_ELAPSED) {}
+
+void DynamicResolution::set_scale_bounds(float min_scale, float max_scale) noexcept {
+  this->min_scale = std::max(min_scale, SCALE_STEP);
+  this->max_scale = std::max(max_scale, this->min_scale);
+  scale = std::clamp(scale, this->min_scale, this->max_scale);
+}
+
+void DynamicResolution::begin_frame() noexcept { timer.begin(); }
+
+void DynamicResolution::end_frame() noexcept {
+  timer.end();
+  // 查询结果晚几帧才可用，只累计新完成的结果；两帧耗时恰好相同时结果值也相同，因此按序号判断
+  if (timer.get_sequence() == last_sequence) {
+    return;
+  }
+  last_sequence = timer.get_sequence();
+  elapsed_ns += timer.get_result();
+  if (++samples < ADJUST_INTERVAL) {
+    return;
+  }
+  gpu_ms = elapsed_ns / samples / 1e6;
+  elapsed_ns = 0;
+  samples = 0;
+
+  float ratio = target_ms / std::max(gpu_ms, 1e-3f);
+  if (std::abs(ratio - 1.0f) <= TOLERANCE) {
+    return;
+  }
+  float desired = std::clamp(scale * std::sqrt(ratio), scale - MAX_ADJUST, scale + MAX_ADJUST);
+  desired = std::clamp(std::round(desired / SCALE_STEP) * SCALE_STEP, min_scale, max_scale);
+  if (desired != scale) {
+    scale = desired;
+    std::cout << "[RENDER] dynamic resolution scale: " << scale << " (gpu " << gpu_ms << " ms)" << std::endl;
+  }
+}
+
+glm::ivec2 DynamicResolution::get_render_size(int32_t width, int32_t height) const noexcept {
+  return glm::ivec2(std::max(int32_t(std::lround(width * scale)), 1), std::max(int32_t(std::lround(height * scale)), 1));
+}
+
+float DynamicResolution::get_sharpness() const noexcept {
+  if (max_scale <= min_scale) {
+    return 0;
+  }
+  return MAX_SHARPNESS * std::clamp((1.0f - scale) / (1.0f - min_scale), 0.0f, 1.0f);
+}
+
+void DynamicResolution::bind(ShaderProgram::Ptr shader, GLuint scene_color) const noexcept {
+  glActiveTexture(GL_TEXTURE0 + SCENE_UNIT);
+  glBindTexture(GL_TEXTURE_2D, scene_color);
+  glActiveTexture(GL_TEXTURE0);
+
+  shader->set_uniform("sceneColor", SCENE_UNIT);
+  shader->set_uniform("sharpness", get_sharpness());
+}
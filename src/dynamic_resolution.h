@@ -0,0 +1,70 @@
+#ifndef __DYNAMIC_RESOLUTION_H__
+#define __DYNAMIC_RESOLUTION_H__
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+
+#include <memory>
+
+#include "gpu_query.h"
+#include "shader.h"
+
+/** 动态分辨率
+ * 场景画到宽高按 scale 缩小的离屏目标中，最后以带锐化的双线性放大合成到窗口。
+ * 每帧以 GL_TIME_ELAPSED 查询测量 GPU 时间，每 ADJUST_INTERVAL 帧取平均值调整一次 scale：
+ * 着色开销近似与像素数即 scale² 成正比，因此新的 scale = scale · sqrt(目标时间 / 测得时间)，
+ * 每次最多变化 MAX_ADJUST，偏差在 TOLERANCE 以内时不调整，scale 取 SCALE_STEP 的整数倍，
+ * 避免渲染目标的尺寸来回抖动
+ */
+class DynamicResolution {
+public:
+  typedef std::shared_ptr<DynamicResolution> Ptr;
+
+  // 放大阶段读取场景颜色使用的纹理单元
+  static constexpr GLint SCENE_UNIT = 18;
+  static constexpr uint32_t ADJUST_INTERVAL = 8;
+  static constexpr float TOLERANCE = 0.1f;
+  static constexpr float SCALE_STEP = 0.05f;
+  static constexpr float MAX_ADJUST = 0.15f;
+  // scale 为 min_scale 时的锐化强度，scale 为 1 时不锐化，中间线性过渡
+  static constexpr float MAX_SHARPNESS = 0.8f;
+
+  explicit DynamicResolution(float target_ms = 1000.0f / 60.0f, float min_scale = 0.5f, float max_scale = 1.0f);
+
+  // 包住一帧的全部 GPU 命令，end_frame 中按需调整 scale
+  void begin_frame() noexcept;
+  void end_frame() noexcept;
+
+  // 窗口为 width × height 时场景渲染目标的尺寸
+  glm::ivec2 get_render_size(int32_t width, int32_t height) const noexcept;
+  // 绑定场景颜色并设置放大 shader 的采样器与锐化强度
+  void bind(ShaderProgram::Ptr shader, GLuint scene_color) const noexcept;
+
+  void set_target_ms(float target_ms) noexcept { this->target_ms = target_ms; }
+  // 范围改变后当前 scale 立即被限制到新范围内
+  void set_scale_bounds(float min_scale, float max_scale) noexcept;
+
+  constexpr float get_scale() const noexcept { return this->scale; }
+  constexpr float get_min_scale() const noexcept { return this->min_scale; }
+  constexpr float get_max_scale() const noexcept { return this->max_scale; }
+  constexpr float get_target_ms() const noexcept { return this->target_ms; }
+  // 最近一次调整时的平均 GPU 帧时间
+  constexpr float get_gpu_ms() const noexcept { return this->gpu_ms; }
+  float get_sharpness() const noexcept;
+
+private:
+  float target_ms;
+  float min_scale;
+  float max_scale;
+  float scale;
+  float gpu_ms = 0;
+
+  GpuQuery timer;
+  uint64_t last_sequence = 0;
+  double elapsed_ns = 0;
+  uint32_t samples = 0;
+};
+
+#endif  // !__DYNAMIC_RESOLUTION_H__
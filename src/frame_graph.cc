@@ -0,0 +1,184 @@
+#include "frame_graph.h"
+
+#include <algorithm>
+#include <iostream>
+
+void FrameGraph::Context::bind_framebuffer() const noexcept {
+  const auto &writes = pass->writes;
+  if (std::find(writes.begin(), writes.end(), BACKBUFFER) != writes.end()) {
+    const RenderTargetDesc &desc = graph->resources[BACKBUFFER].desc;
+    glBindFramebuffer(GL_FRAMEBUFFER, GL_ZERO);
+    glViewport(0, 0, desc.width, desc.height);
+    return;
+  }
+  if (writes.empty()) {
+    return;
+  }
+  const RenderTargetDesc &desc = graph->resources[writes.front()].desc;
+  glBindFramebuffer(GL_FRAMEBUFFER, graph->get_framebuffer(writes));
+  glViewport(0, 0, desc.width, desc.height);
+}
+
+FrameGraph::PassBuilder &FrameGraph::PassBuilder::read(Resource resource) noexcept {
+  graph->passes[pass].reads.push_back(resource);
+  return *this;
+}
+
+FrameGraph::PassBuilder &FrameGraph::PassBuilder::write(Resource resource) noexcept {
+  graph->passes[pass].writes.push_back(resource);
+  graph->resources[resource].writers.push_back(pass);
+  if (resource == BACKBUFFER) {
+    graph->passes[pass].side_effect = true;
+  }
+  return *this;
+}
+
+FrameGraph::PassBuilder &FrameGraph::PassBuilder::side_effect() noexcept {
+  graph->passes[pass].side_effect = true;
+  return *this;
+}
+
+void FrameGraph::begin_frame(int32_t width, int32_t height) noexcept {
+  passes.clear();
+  resources.clear();
+  stats = Stats();
+  ResourceNode backbuffer;
+  backbuffer.name = "backbuffer";
+  backbuffer.desc.width = width;
+  backbuffer.desc.height = height;
+  resources.push_back(backbuffer);
+}
+
+FrameGraph::Resource FrameGraph::create_texture(const char *name, const RenderTargetDesc &desc) noexcept {
+  ResourceNode resource;
+  resource.name = name;
+  resource.desc = desc;
+  resources.push_back(resource);
+  return resources.size() - 1;
+}
+
+FrameGraph::PassBuilder FrameGraph::add_pass(const char *name, std::function<void(const Context &)> execute) noexcept {
+  Pass pass;
+  pass.name = name;
+  pass.execute = std::move(execute);
+  passes.push_back(std::move(pass));
+  ++stats.passes;
+  return PassBuilder(this, passes.size() - 1);
+}
+
+void FrameGraph::cull() noexcept {
+  // pass 的引用计数为仍被需要的写入数，资源的引用计数为读取它的 pass 数
+  for (auto &pass : passes) {
+    pass.refcount = pass.writes.size();
+    for (Resource resource : pass.reads) {
+      ++resources[resource].refcount;
+    }
+  }
+  stack.clear();
+  for (Resource i = 0; i < resources.size(); ++i) {
+    if (resources[i].refcount == 0) {
+      stack.push_back(i);
+    }
+  }
+  // 没有读者的资源不再需要，写入它的 pass 少一个用处；pass 的写入都不再需要且没有副作用时被剔除，
+  // 它读取的资源随之少一个读者
+  while (!stack.empty()) {
+    Resource resource = stack.back();
+    stack.pop_back();
+    for (uint32_t writer : resources[resource].writers) {
+      Pass &pass = passes[writer];
+      if (pass.culled || pass.side_effect || --pass.refcount > 0) {
+        continue;
+      }
+      pass.culled = true;
+      ++stats.culled;
+      for (Resource read : pass.reads) {
+        if (--resources[read].refcount == 0) {
+          stack.push_back(read);
+        }
+      }
+    }
+  }
+}
+
+void FrameGraph::allocate() noexcept {
+  for (int32_t i = 0; i < int32_t(passes.size()); ++i) {
+    const Pass &pass = passes[i];
+    if (pass.culled) {
+      continue;
+    }
+    for (const auto *list : {&pass.reads, &pass.writes}) {
+      for (Resource resource : *list) {
+        ResourceNode &node = resources[resource];
+        if (node.first < 0) {
+          node.first = i;
+        }
+        node.last = i;
+      }
+    }
+    for (Resource resource : pass.reads) {
+      if (resource != BACKBUFFER && std::find(pass.writes.begin(), pass.writes.end(), resource) != pass.writes.end()) {
+        std::cout << "[WARN::FrameGraph] Pass " << pass.name << " reads and writes " << resources[resource].name
+                  << std::endl;
+      }
+    }
+  }
+
+  // 按执行顺序模拟取得与归还，同一帧内归还的纹理可以立即被之后的资源复用
+  const RenderTargetPool::Stats &pool_stats = pool->get_stats();
+  uint64_t pool_bytes = pool_stats.bytes;
+  acquired.clear();
+  for (int32_t i = 0; i < int32_t(passes.size()); ++i) {
+    if (passes[i].culled) {
+      continue;
+    }
+    for (Resource r = BACKBUFFER + 1; r < resources.size(); ++r) {
+      ResourceNode &node = resources[r];
+      if (node.first != i) {
+        continue;
+      }
+      node.texture = pool->acquire(node.desc);
+      stats.requested_bytes += node.desc.bytes();
+      if (std::find(acquired.begin(), acquired.end(), node.texture) == acquired.end()) {
+        acquired.push_back(node.texture);
+        stats.allocated_bytes += node.desc.bytes();
+      }
+    }
+    for (Resource r = BACKBUFFER + 1; r < resources.size(); ++r) {
+      if (resources[r].last == i) {
+        pool->release(resources[r].texture);
+      }
+    }
+  }
+  if (pool_stats.bytes != pool_bytes) {
+    std::cout << "[RENDER] Render target pool: " << pool_stats.textures << " textures, "
+              << pool_stats.bytes / (1024 * 1024) << " MiB" << std::endl;
+  }
+}
+
+void FrameGraph::compile() noexcept {
+  cull();
+  allocate();
+}
+
+void FrameGraph::execute() noexcept {
+  for (const auto &pass : passes) {
+    if (!pass.culled) {
+      pass.execute(Context(this, &pass));
+    }
+  }
+  pool->end_frame();
+}
+
+GLuint FrameGraph::get_framebuffer(const std::vector<Resource> &attachments) noexcept {
+  GLuint depth = GL_ZERO;
+  std::vector<GLuint> colors;
+  for (Resource resource : attachments) {
+    if (resources[resource].desc.is_depth()) {
+      depth = resources[resource].texture;
+    } else {
+      colors.push_back(resources[resource].texture);
+    }
+  }
+  return pool->get_framebuffer(colors, depth);
+}
@@ -0,0 +1,128 @@
+#ifndef __FRAME_GRAPH_H__
+#define __FRAME_GRAPH_H__
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "render_target_pool.h"
+
+/** 帧图
+ * 每帧按执行顺序声明 pass 及其读写的资源，compile 时：
+ *   1. 从有副作用的 pass (写默认帧缓冲或帧图之外的目标) 反向追溯，没有被任何保留的 pass 读取的 pass 被剔除；
+ *   2. 按保留的 pass 计算每个临时资源第一次与最后一次使用的位置，在第一次使用前从 RenderTargetPool 取得纹理，
+ *      最后一次使用后归还，生命周期不重叠的同规格资源因此共用同一张纹理。
+ * 所有资源在 compile 后即有确定的纹理，execute 再按声明顺序依次执行保留的 pass。
+ * GL 中 pass 之间的读写同步由驱动隐式完成，帧图只负责顺序、剔除与显存分配
+ */
+class FrameGraph {
+public:
+  typedef std::shared_ptr<FrameGraph> Ptr;
+  typedef uint32_t Resource;
+
+  // 默认帧缓冲，由窗口系统持有；写入它的 pass 总是保留
+  static constexpr Resource BACKBUFFER = 0;
+
+  struct Stats {
+    uint32_t passes = 0;          // 本帧声明的 pass 数
+    uint32_t culled = 0;          // 被剔除的 pass 数
+    uint64_t requested_bytes = 0; // 保留的临时资源各自所需显存之和
+    uint64_t allocated_bytes = 0; // 实际分配的纹理显存，别名共用后小于 requested_bytes
+  };
+
+private:
+  struct Pass;
+
+public:
+  // 传给 pass 的执行上下文
+  class Context {
+  public:
+    GLuint get_texture(Resource resource) const noexcept { return graph->get_texture(resource); }
+    GLuint get_framebuffer(const std::vector<Resource> &attachments) const noexcept {
+      return graph->get_framebuffer(attachments);
+    }
+    // 绑定由本 pass 写入的资源组成的帧缓冲并设置视口，写入 BACKBUFFER 时绑定默认帧缓冲
+    void bind_framebuffer() const noexcept;
+
+  private:
+    friend class FrameGraph;
+    Context(FrameGraph *graph, const Pass *pass) : graph(graph), pass(pass) {}
+
+    FrameGraph *graph;
+    const Pass *pass;
+  };
+
+  // add_pass 返回，用于声明 pass 读写的资源
+  class PassBuilder {
+  public:
+    PassBuilder &read(Resource resource) noexcept;
+    // 颜色附件按 write 的顺序排列
+    PassBuilder &write(Resource resource) noexcept;
+    // 写入帧图之外的目标，不参与剔除
+    PassBuilder &side_effect() noexcept;
+
+  private:
+    friend class FrameGraph;
+    PassBuilder(FrameGraph *graph, uint32_t pass) : graph(graph), pass(pass) {}
+
+    FrameGraph *graph;
+    uint32_t pass;
+  };
+
+  explicit FrameGraph(RenderTargetPool::Ptr pool) : pool(pool) {}
+  FrameGraph(const FrameGraph &oth) = delete;
+  FrameGraph &operator=(const FrameGraph &oth) = delete;
+
+  // 清空上一帧声明的 pass 与资源，width、height 为默认帧缓冲的尺寸
+  void begin_frame(int32_t width, int32_t height) noexcept;
+  Resource create_texture(const char *name, const RenderTargetDesc &desc) noexcept;
+  PassBuilder add_pass(const char *name, std::function<void(const Context &)> execute) noexcept;
+  void compile() noexcept;
+  // 执行保留的 pass，之后通知渲染目标池一帧结束
+  void execute() noexcept;
+
+  // 资源在本帧对应的纹理，compile 后有效；被剔除的资源为 GL_ZERO
+  GLuint get_texture(Resource resource) const noexcept { return resources[resource].texture; }
+  // 以 attachments 中的颜色资源依次为颜色附件、深度资源为深度附件的帧缓冲
+  GLuint get_framebuffer(const std::vector<Resource> &attachments) noexcept;
+
+  const Stats &get_stats() const noexcept { return stats; }
+  RenderTargetPool::Ptr get_pool() const noexcept { return pool; }
+
+private:
+  struct Pass {
+    const char *name;
+    std::function<void(const Context &)> execute;
+    std::vector<Resource> reads;
+    std::vector<Resource> writes;
+    bool side_effect = false;
+    bool culled = false;
+    uint32_t refcount = 0;  // 保留的 pass 读取的、由它写入的资源数
+  };
+  struct ResourceNode {
+    const char *name;
+    RenderTargetDesc desc;
+    GLuint texture = GL_ZERO;
+    std::vector<uint32_t> writers;
+    uint32_t refcount = 0;  // 保留的 pass 中读取它的次数
+    int32_t first = -1;     // 第一次与最后一次使用它的 pass
+    int32_t last = -1;
+  };
+
+  void cull() noexcept;
+  void allocate() noexcept;
+
+private:
+  RenderTargetPool::Ptr pool;
+  std::vector<Pass> passes;
+  std::vector<ResourceNode> resources;
+  std::vector<Resource> stack;
+  std::vector<GLuint> acquired;  // 本帧取得的不同纹理
+  Stats stats;
+};
+
+#endif  // !__FRAME_GRAPH_H__
@@ -0,0 +1,87 @@
+#include "gbuffer.h"
+
+void GBuffer::declare(FrameGraph &graph, int32_t width, int32_t height) noexcept {
+  this->width = width;
+  this->height = height;
+  albedo_spec = graph.create_texture("gbuffer_albedo_spec", {width, height, GL_RGBA8});
+  normal = graph.create_texture("gbuffer_normal", {width, height, GL_RG16F});
+  depth = graph.create_texture("gbuffer_depth", {width, height, GL_DEPTH24_STENCIL8});
+}
+
+void GBuffer::write(FrameGraph::PassBuilder &pass) const noexcept {
+  pass.write(albedo_spec).write(normal).write(depth);
+}
+
+void GBuffer::read(FrameGraph::PassBuilder &pass) const noexcept {
+  pass.read(albedo_spec).read(normal).read(depth);
+}
+
+void GBuffer::bind_for_geometry(const FrameGraph::Context &context) const noexcept {
+  glBindFramebuffer(GL_FRAMEBUFFER, context.get_framebuffer({albedo_spec, normal, depth}));
+  glViewport(0, 0, width, height);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+}
+
+void GBuffer::bind_textures(const FrameGraph::Context &context, ShaderProgram::Ptr shader) const noexcept {
+  glActiveTexture(GL_TEXTURE0 + ALBEDO_SPEC_UNIT);
+  glBindTexture(GL_TEXTURE_2D, context.get_texture(albedo_spec));
+  glActiveTexture(GL_TEXTURE0 + NORMAL_UNIT);
+  glBindTexture(GL_TEXTURE_2D, context.get_texture(normal));
+  glActiveTexture(GL_TEXTURE0 + DEPTH_UNIT);
+  glBindTexture(GL_TEXTURE_2D, context.get_texture(depth));
+  glActiveTexture(GL_TEXTURE0);
+
+  shader->set_uniform("gAlbedoSpec", ALBEDO_SPEC_UNIT);
+  shader->set_uniform("gNormal", NORMAL_UNIT);
+  shader->set_uniform("gDepth", DEPTH_UNIT);
+}
+
+bool GBuffer::can_blit_depth(GLuint target) noexcept {
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+  GLint samples = 0;
+  glGetIntegerv(GL_SAMPLES, &samples);
+  // 默认帧缓冲的附件名为 GL_DEPTH / GL_STENCIL
+  GLenum depth_attachment = target == GL_ZERO ? GL_DEPTH : GL_DEPTH_ATTACHMENT;
+  GLenum stencil_attachment = target == GL_ZERO ? GL_STENCIL : GL_STENCIL_ATTACHMENT;
+  GLint type = GL_NONE;
+  glGetFramebufferAttachmentParameteriv(
+    GL_DRAW_FRAMEBUFFER, depth_attachment, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &type);
+  if (type == GL_NONE) {
+    return false;
+  }
+  GLint depth_bits = 0;
+  GLint stencil_bits = 0;
+  GLint component = GL_NONE;
+  glGetFramebufferAttachmentParameteriv(
+    GL_DRAW_FRAMEBUFFER, depth_attachment, GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE, &depth_bits);
+  glGetFramebufferAttachmentParameteriv(
+    GL_DRAW_FRAMEBUFFER, depth_attachment, GL_FRAMEBUFFER_ATTACHMENT_COMPONENT_TYPE, &component);
+  glGetFramebufferAttachmentParameteriv(
+    GL_DRAW_FRAMEBUFFER, stencil_attachment, GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE, &stencil_bits);
+  return samples == 0 && depth_bits == 24 && stencil_bits == 8 && component == GL_UNSIGNED_NORMALIZED;
+}
+
+void GBuffer::blit_depth(const FrameGraph::Context &context, ShaderProgram::Ptr copy_prog, Mesh::Ptr screen,
+                         GLuint target) const noexcept {
+  if (can_blit_depth(target)) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, context.get_framebuffer({albedo_spec, normal, depth}));
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+    return;
+  }
+
+  // 格式不同时按深度值写回，深度测试恒通过，不写颜色
+  glBindFramebuffer(GL_FRAMEBUFFER, target);
+  glViewport(0, 0, width, height);
+  glActiveTexture(GL_TEXTURE0 + DEPTH_UNIT);
+  glBindTexture(GL_TEXTURE_2D, context.get_texture(depth));
+  glActiveTexture(GL_TEXTURE0);
+  copy_prog->set_uniform("gDepth", DEPTH_UNIT);
+  glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+  glDepthFunc(GL_ALWAYS);
+  screen->draw(copy_prog);
+  glDepthFunc(GL_LESS);
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
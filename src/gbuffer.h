@@ -0,0 +1,56 @@
+#ifndef __GBUFFER_H__
+#define __GBUFFER_H__
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+
+#include <memory>
+
+#include "frame_graph.h"
+#include "mesh.h"
+#include "shader.h"
+
+/** 延迟渲染使用的 G-buffer
+ * albedoSpec  RGBA8    rgb: 漫反射颜色, a: 镜面反射强度
+ * normal      RG16F    八面体编码的世界空间法线
+ * depth       DEPTH24_STENCIL8，目标深度格式相同时直接 blit，否则用全屏 pass 写回深度
+ * 每像素 12 字节。附件是帧图中的临时资源，光照阶段之后即可被其他 pass 复用
+ */
+class GBuffer {
+public:
+  typedef std::shared_ptr<GBuffer> Ptr;
+
+  // 光照阶段读取 G-buffer 使用的纹理单元
+  static constexpr GLint ALBEDO_SPEC_UNIT = 24;
+  static constexpr GLint NORMAL_UNIT = 25;
+  static constexpr GLint DEPTH_UNIT = 26;
+
+  // 在帧图中声明本帧的附件，每帧 begin_frame 之后调用
+  void declare(FrameGraph &graph, int32_t width, int32_t height) noexcept;
+  // 几何阶段写入全部附件，光照阶段读取全部附件
+  void write(FrameGraph::PassBuilder &pass) const noexcept;
+  void read(FrameGraph::PassBuilder &pass) const noexcept;
+
+  // 绑定为绘制目标并清空，用于几何阶段
+  void bind_for_geometry(const FrameGraph::Context &context) const noexcept;
+  // 绑定 G-buffer 纹理并设置光照 shader 的采样器
+  void bind_textures(const FrameGraph::Context &context, ShaderProgram::Ptr shader) const noexcept;
+  /** 把深度拷贝到 target 帧缓冲，供之后的前向绘制做深度测试
+   * glBlitFramebuffer 拷贝深度要求两边格式完全相同且都不是多重采样，默认帧缓冲的格式由窗口系统决定，
+   * 不满足时改用 copy_prog (shaders/depth_copy.frag) 在 screen 上写 gl_FragDepth。模板不会被拷贝
+   */
+  void blit_depth(const FrameGraph::Context &context, ShaderProgram::Ptr copy_prog, Mesh::Ptr screen,
+                  GLuint target = 0) const noexcept;
+  // target 的深度格式是否与 G-buffer 相同 (DEPTH24_STENCIL8，非多重采样)，相同时两者之间可以直接 blit 深度
+  static bool can_blit_depth(GLuint target) noexcept;
+
+private:
+  int32_t width = 0;
+  int32_t height = 0;
+  FrameGraph::Resource albedo_spec = FrameGraph::BACKBUFFER;
+  FrameGraph::Resource normal = FrameGraph::BACKBUFFER;
+  FrameGraph::Resource depth = FrameGraph::BACKBUFFER;
+};
+
+#endif  // !__GBUFFER_H__
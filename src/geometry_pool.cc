@@ -0,0 +1,157 @@
+#include "geometry_pool.h"
+
+#include <algorithm>
+
+#include "vertex_format.h"
+
+GeometryBlock::GeometryBlock(GLuint format, GLuint vertex_capacity, GLuint index_capacity)
+    : format(format) {
+  vertex_size = VertexFormat::vertex_size(format);
+  glGenBuffers(1, &vbo);
+  glGenBuffers(1, &ebo);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vertex_capacity * vertex_size, nullptr, GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, GL_ZERO);
+  // 不能在 VAO 绑定时改动 GL_ELEMENT_ARRAY_BUFFER，这里借用 GL_COPY_WRITE_BUFFER 分配
+  glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+  glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)index_capacity * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, GL_ZERO);
+
+  free_vertices[0] = vertex_capacity;
+  free_indices[0] = index_capacity;
+}
+
+GeometryBlock::~GeometryBlock() { release(); }
+
+void GeometryBlock::release() noexcept {
+  if (vbo == GL_ZERO) {
+    return;
+  }
+  VertexFormat::forget(format, vbo);
+  glDeleteBuffers(1, &vbo);
+  glDeleteBuffers(1, &ebo);
+  vbo = GL_ZERO;
+  ebo = GL_ZERO;
+}
+
+bool GeometryBlock::take(std::map<GLuint, GLuint> &free_list, GLuint count, Range &range) noexcept {
+  if (count == 0) {
+    range = {0, 0};
+    return true;
+  }
+  for (auto it = free_list.begin(); it != free_list.end(); ++it) {
+    if (it->second < count) {
+      continue;
+    }
+    range = {it->first, count};
+    GLuint rest = it->second - count;
+    GLuint rest_offset = it->first + count;
+    free_list.erase(it);
+    if (rest > 0) {
+      free_list[rest_offset] = rest;
+    }
+    return true;
+  }
+  return false;
+}
+
+void GeometryBlock::give(std::map<GLuint, GLuint> &free_list, const Range &range) noexcept {
+  if (range.count == 0) {
+    return;
+  }
+  auto it = free_list.emplace(range.offset, range.count).first;
+  // 与后一个空闲区间合并
+  auto next = std::next(it);
+  if (next != free_list.end() && it->first + it->second == next->first) {
+    it->second += next->second;
+    free_list.erase(next);
+  }
+  // 与前一个空闲区间合并
+  if (it != free_list.begin()) {
+    auto prev = std::prev(it);
+    if (prev->first + prev->second == it->first) {
+      prev->second += it->second;
+      free_list.erase(it);
+    }
+  }
+}
+
+bool GeometryBlock::allocate(GLuint vertex_count, GLuint index_count, Range &vertices, Range &indices) noexcept {
+  if (!take(free_vertices, vertex_count, vertices)) {
+    return false;
+  }
+  if (!take(free_indices, index_count, indices)) {
+    give(free_vertices, vertices);
+    return false;
+  }
+  return true;
+}
+
+void GeometryBlock::free(const Range &vertices, const Range &indices) noexcept {
+  give(free_vertices, vertices);
+  give(free_indices, indices);
+}
+
+void GeometryBlock::bind() const noexcept { VertexFormat::bind(format, vbo, ebo); }
+
+GeometryAllocation::~GeometryAllocation() {
+  if (block != nullptr) {
+    block->free(vertices, indices);
+  }
+}
+
+std::unordered_map<GLuint, GeometryPool::Ptr> &GeometryPool::pools() noexcept {
+  static std::unordered_map<GLuint, Ptr> pools;
+  return pools;
+}
+
+GeometryPool::Ptr GeometryPool::get(GLuint format) {
+  auto &pool = pools()[format];
+  if (pool == nullptr) {
+    pool = std::make_shared<GeometryPool>(format);
+  }
+  return pool;
+}
+
+void GeometryPool::shutdown() noexcept {
+  for (auto &[format, pool] : pools()) {
+    for (auto &block : pool->blocks) {
+      block->release();
+    }
+  }
+  pools().clear();
+}
+
+GeometryAllocation::Ptr GeometryPool::allocate(
+  const void *vertex_data, GLuint vertex_count, const GLuint *index_data, GLuint index_count) {
+  auto allocation = std::make_shared<GeometryAllocation>();
+  GeometryBlock::Ptr target = nullptr;
+  for (auto &block : blocks) {
+    if (block->allocate(vertex_count, index_count, allocation->vertices, allocation->indices)) {
+      target = block;
+      break;
+    }
+  }
+  if (target == nullptr) {
+    target = std::make_shared<GeometryBlock>(
+      format, std::max(vertex_count, BLOCK_VERTICES), std::max(index_count, BLOCK_INDICES));
+    blocks.push_back(target);
+    target->allocate(vertex_count, index_count, allocation->vertices, allocation->indices);
+  }
+  allocation->block = target;
+
+  GLuint vertex_size = target->get_vertex_size();
+  if (vertex_count > 0) {
+    glBindBuffer(GL_ARRAY_BUFFER, target->get_vbo());
+    glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)allocation->vertices.offset * vertex_size,
+                    (GLsizeiptr)vertex_count * vertex_size, vertex_data);
+    glBindBuffer(GL_ARRAY_BUFFER, GL_ZERO);
+  }
+  if (index_count > 0) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, target->get_ebo());
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)allocation->indices.offset * sizeof(GLuint),
+                    (GLsizeiptr)index_count * sizeof(GLuint), index_data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, GL_ZERO);
+  }
+  return allocation;
+}
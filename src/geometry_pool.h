@@ -0,0 +1,109 @@
+#ifndef __GEOMETRY_POOL_H__
+#define __GEOMETRY_POOL_H__
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/** 静态几何缓冲池
+ * 顶点格式相同（纹理坐标层数与是否蒙皮都相同，见 VertexFormat）的网格共享少数几块大的 VBO / EBO，每个网格只占其中一段，
+ * 以 glDrawElementsBaseVertex 绘制；VAO 按顶点格式共享（见 VertexFormat），换块时只重新指向缓冲，
+ * 相邻且纹理相同的网格可以合并为一次 glMultiDrawElementsBaseVertex。
+ * 每块的空闲区间按偏移有序保存，释放时与相邻区间合并，模型卸载后空间可以被复用。
+ */
+class GeometryBlock {
+public:
+  typedef std::shared_ptr<GeometryBlock> Ptr;
+
+  // 以元素（顶点或索引）为单位的区间
+  struct Range {
+    GLuint offset = 0;
+    GLuint count = 0;
+  };
+
+  GeometryBlock(GLuint format, GLuint vertex_capacity, GLuint index_capacity);
+  GeometryBlock(const GeometryBlock &oth) = delete;
+  GeometryBlock &operator=(const GeometryBlock &oth) = delete;
+  ~GeometryBlock();
+
+  // 删除缓冲，之后的析构不再调用 GL；由 GeometryPool::shutdown 在 GL 线程上调用
+  void release() noexcept;
+
+  // 从空闲区间中首次适配地分配，空间不足时返回 false
+  bool allocate(GLuint vertex_count, GLuint index_count, Range &vertices, Range &indices) noexcept;
+  void free(const Range &vertices, const Range &indices) noexcept;
+
+  // 绑定该格式共享的 VAO 并指向本块的缓冲
+  void bind() const noexcept;
+
+  GLuint get_vbo() const noexcept { return vbo; }
+  GLuint get_ebo() const noexcept { return ebo; }
+  GLuint get_vertex_size() const noexcept { return vertex_size; }
+
+private:
+  static bool take(std::map<GLuint, GLuint> &free_list, GLuint count, Range &range) noexcept;
+  static void give(std::map<GLuint, GLuint> &free_list, const Range &range) noexcept;
+
+private:
+  GLuint format;  // 见 VertexFormat
+  GLuint vertex_size;
+  GLuint vbo = GL_ZERO;
+  GLuint ebo = GL_ZERO;
+  // 空闲区间 偏移 -> 长度
+  std::map<GLuint, GLuint> free_vertices;
+  std::map<GLuint, GLuint> free_indices;
+};
+
+// 网格在池中占用的空间，最后一个持有者析构时归还
+struct GeometryAllocation {
+  typedef std::shared_ptr<GeometryAllocation> Ptr;
+
+  GeometryBlock::Ptr block;
+  GeometryBlock::Range vertices;
+  GeometryBlock::Range indices;
+
+  GeometryAllocation() = default;
+  GeometryAllocation(const GeometryAllocation &oth) = delete;
+  GeometryAllocation &operator=(const GeometryAllocation &oth) = delete;
+  ~GeometryAllocation();
+
+  // glDrawElementsBaseVertex 的索引偏移参数
+  const GLvoid *index_pointer() const noexcept { return (const GLvoid *)(sizeof(GLuint) * (uintptr_t)indices.offset); }
+};
+
+class GeometryPool {
+public:
+  typedef std::shared_ptr<GeometryPool> Ptr;
+
+  // 每块默认容量，超过的网格独占一块
+  static constexpr GLuint BLOCK_VERTICES = 1 << 20;
+  static constexpr GLuint BLOCK_INDICES = 1 << 22;
+
+  // 同一顶点格式的网格共享一个池
+  static Ptr get(GLuint format);
+  /** 在 GL 上下文释放之前、模型释放之后调用，删除所有块的缓冲并清空池
+   * 仍被网格引用的块只剩空闲列表，进程退出时的析构不会调用 GL
+   */
+  static void shutdown() noexcept;
+
+  explicit GeometryPool(GLuint format) : format(format) {}
+
+  // 上传顶点（已按格式交错排列）与索引，返回占用的空间
+  GeometryAllocation::Ptr allocate(const void *vertex_data, GLuint vertex_count, const GLuint *index_data, GLuint index_count);
+
+  size_t get_block_count() const noexcept { return blocks.size(); }
+
+private:
+  static std::unordered_map<GLuint, Ptr> &pools() noexcept;
+
+private:
+  GLuint format;
+  std::vector<GeometryBlock::Ptr> blocks;
+};
+
+#endif  // !__GEOMETRY_POOL_H__
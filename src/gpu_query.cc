@@ -0,0 +1,79 @@
+#include "gpu_query.h"
+
+GpuQuery::GpuQuery(GLenum target) : target(target) {
+  for (auto &frame : ids) {
+    glGenQueries(MAX_SEGMENTS, frame.data());
+  }
+}
+
+GpuQuery::~GpuQuery() {
+  for (auto &frame : ids) {
+    glDeleteQueries(MAX_SEGMENTS, frame.data());
+  }
+}
+
+void GpuQuery::collect() noexcept {
+  // 从最旧的查询开始读取，保证 result 是最新完成的那一个
+  for (uint32_t i = 0; i < LATENCY; ++i) {
+    uint32_t idx = (current + i) % LATENCY;
+    if (!pending[idx]) {
+      continue;
+    }
+    // 各段按顺序提交，最后一段可用时前面的段也已完成
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(ids[idx][segments[idx] - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available == GL_FALSE) {
+      continue;
+    }
+    uint64_t sum = 0;
+    for (uint32_t s = 0; s < segments[idx]; ++s) {
+      GLuint64 value = 0;
+      glGetQueryObjectui64v(ids[idx][s], GL_QUERY_RESULT, &value);
+      sum += value;
+    }
+    result = sum;
+    ++sequence;
+    pending[idx] = false;
+  }
+}
+
+void GpuQuery::begin() noexcept {
+  collect();
+  if (pending[current]) {
+    // 所有查询都还在途中，本帧跳过，避免阻塞
+    return;
+  }
+  segments[current] = 1;
+  glBeginQuery(target, ids[current][0]);
+  active = true;
+  suspended = false;
+}
+
+void GpuQuery::suspend() noexcept {
+  if (!active || suspended) {
+    return;
+  }
+  glEndQuery(target);
+  suspended = true;
+}
+
+void GpuQuery::resume() noexcept {
+  if (!active || !suspended || segments[current] == MAX_SEGMENTS) {
+    return;
+  }
+  glBeginQuery(target, ids[current][segments[current]++]);
+  suspended = false;
+}
+
+void GpuQuery::end() noexcept {
+  if (!active) {
+    return;
+  }
+  if (!suspended) {
+    glEndQuery(target);
+  }
+  active = false;
+  suspended = false;
+  pending[current] = true;
+  current = (current + 1) % LATENCY;
+}
@@ -0,0 +1,56 @@
+#ifndef __GPU_QUERY_H__
+#define __GPU_QUERY_H__
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+
+#include <array>
+#include <memory>
+
+/** 不阻塞 CPU 的 GPU 查询 (GL_SAMPLES_PASSED、GL_TIME_ELAPSED 等)
+ * 内部轮流使用 LATENCY 组查询对象，begin/end 每帧调用一次，
+ * 结果在若干帧后可用时才读取，get_result() 返回最近一次已完成的结果，
+ * get_sequence() 在每次读到新结果时加一，相邻两帧的结果可能相同，用它判断结果是否更新。
+ * 同一目标的查询不能嵌套 (GL_SAMPLES_PASSED 与 GL_ANY_SAMPLES_PASSED 也不能)，
+ * 期间要发起其他查询时以 suspend/resume 分段，一帧的结果为各段之和
+ */
+class GpuQuery {
+public:
+  typedef std::shared_ptr<GpuQuery> Ptr;
+
+  static constexpr uint32_t LATENCY = 3;
+  // 每帧最多的分段数，超出后 resume 不再计数
+  static constexpr uint32_t MAX_SEGMENTS = 4;
+
+  explicit GpuQuery(GLenum target);
+  GpuQuery(const GpuQuery &oth) = delete;
+  GpuQuery &operator=(const GpuQuery &oth) = delete;
+  ~GpuQuery();
+
+  void begin() noexcept;
+  void end() noexcept;
+  // 暂停与继续本帧的查询，未 begin 时什么也不做
+  void suspend() noexcept;
+  void resume() noexcept;
+
+  constexpr uint64_t get_result() const noexcept { return this->result; }
+  constexpr uint64_t get_sequence() const noexcept { return this->sequence; }
+
+private:
+  // 读取所有已完成的查询，不等待
+  void collect() noexcept;
+
+private:
+  GLenum target;
+  std::array<std::array<GLuint, MAX_SEGMENTS>, LATENCY> ids{};
+  std::array<uint32_t, LATENCY> segments{};  // 各帧已使用的分段数
+  std::array<bool, LATENCY> pending{};
+  uint32_t current = 0;
+  bool active = false;     // 本帧已 begin 且未 end
+  bool suspended = false;
+  uint64_t result = 0;
+  uint64_t sequence = 0;  // 已读取的结果数
+};
+
+#endif  // !__GPU_QUERY_H__
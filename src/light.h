@@ -16,6 +16,7 @@ struct Light {
 
   float inner_cutoff = 1;  // 余弦值 [1,0]
   float outer_cutoff = 1;  // 余弦值 [1,0]
+  float range = 10;        // 影响半径，点光源与聚光灯在此距离处衰减为 0
 
   glm::vec3 ambient = {0.1, 0.1, 0.1};
   glm::vec3 diffuse = {1, 1, 1};
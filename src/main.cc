@@ -5,18 +5,45 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 // cpp std lib
+#include <algorithm>
+#include <cmath>
+#include <future>
 #include <iostream>
 #include <memory>
 #include <random>
+#include <thread>
 #include <vector>
 
 // c std lib
 #include <cstdint>
 // project header
+#include "animation_clip.h"
+#include "bone_palette.h"
 #include "camera.h"
+#include "clustered_lighting.h"
+#include "dynamic_resolution.h"
+#include "frame_graph.h"
+#include "gbuffer.h"
+#include "geometry_pool.h"
+#include "gpu_query.h"
 #include "light.h"
 #include "model.h"
+#include "occlusion_culler.h"
+#include "oit_buffer.h"
+#include "render_queue.h"
+#include "scene_bvh.h"
 #include "shader.h"
+#include "shader_variants.h"
+#include "shadow_filter.h"
+#include "simulation.h"
+#include "software_occlusion.h"
+#include "variance_shadow_map.h"
+#include "vertex_format.h"
+#include "snowflakes.h"
+#include "stream_buffer.h"
+#include "stress_scene.h"
+#include "terrain.h"
+#include "texture_streamer.h"
 #include "utils.h"
 #include "MoveControler.h"
 #include "CammerMoveControler.h"
@@ -25,15 +52,67 @@
 
 
 /* global */
-bool keyboardState[1024];
+// 受光照物体的着色器族 (lit.frag)，特性位与源码中的宏一一对应
+enum LitFeature : uint32_t {
+  LIT_ALPHA_TEST = 1 << 0,
+  LIT_RECEIVE_SHADOW = 1 << 1,
+  LIT_CLUSTERED_LIGHTS = 1 << 2,
+  LIT_OIT_OUTPUT = 1 << 3,
+  LIT_SHADOW_POISSON = 1 << 4,
+  LIT_SHADOW_PCSS = 1 << 5,
+  LIT_SHADOW_EVSM = 1 << 6,
+  LIT_INSTANCED = 1 << 7,
+  LIT_TERRAIN = 1 << 8,
+  LIT_SKINNED = 1 << 9,
+};
+ShaderVariants::Ptr lit_variants;
+// 当前选中变体对应的特性位，阴影等级或点光源有无变化时才重新从 lit_variants 中选择
+uint32_t selected_lighting = UINT32_MAX;
+// 从 lit_variants 中选出的变体
 ShaderProgram::Ptr default_prog;
+ShaderProgram::Ptr snowflake_prog;
 ShaderProgram::Ptr shadow_prog;
+ShaderProgram::Ptr evsm_moments_prog;
+// 雪花实例化绘制使用的程序，模型矩阵来自 stream_buffer
+ShaderProgram::Ptr shadow_instanced_prog;
+ShaderProgram::Ptr evsm_moments_instanced_prog;
+ShaderProgram::Ptr depth_instanced_prog;
+ShaderProgram::Ptr gbuffer_instanced_prog;
+// 地形使用的程序，顶点来自高度纹理数组，见 Terrain
+ShaderProgram::Ptr terrain_prog;
+ShaderProgram::Ptr shadow_terrain_prog;
+ShaderProgram::Ptr evsm_moments_terrain_prog;
+ShaderProgram::Ptr depth_terrain_prog;
+ShaderProgram::Ptr gbuffer_terrain_prog;
+// 蒙皮角色使用的程序，骨骼矩阵来自 bone_palette
+ShaderProgram::Ptr skinned_prog;
+ShaderProgram::Ptr shadow_skinned_prog;
+ShaderProgram::Ptr evsm_moments_skinned_prog;
+ShaderProgram::Ptr depth_skinned_prog;
+ShaderProgram::Ptr gbuffer_skinned_prog;
+ShaderProgram::Ptr terrain_stamp_prog;
+ShaderProgram::Ptr gaussian_blur_prog;
+// G-buffer 深度无法直接 blit 到场景目标时写回深度
+ShaderProgram::Ptr depth_copy_prog;
 ShaderProgram::Ptr debug;
 ShaderProgram::Ptr dot_light_prog;
 ShaderProgram::Ptr skybox_prog;
 ShaderProgram::Ptr transparency_prog;
+ShaderProgram::Ptr gbuffer_prog;
+// deferred_variants 的特性位，顺序与创建时的特性列表一致，与 LitFeature 无关
+enum DeferredFeature : uint32_t {
+  DEFERRED_SHADOW_POISSON = 1 << 0,
+  DEFERRED_SHADOW_PCSS = 1 << 1,
+  DEFERRED_SHADOW_EVSM = 1 << 2,
+};
+ShaderVariants::Ptr deferred_variants;
+ShaderProgram::Ptr deferred_prog;
+ShaderProgram::Ptr depth_prog;
+ShaderProgram::Ptr transparency_oit_prog;
+ShaderProgram::Ptr oit_depth_prog;
+ShaderProgram::Ptr oit_resolve_prog;
+ShaderProgram::Ptr upscale_prog;
 
-static const int64_t SNOWFLAKES_COUNT = 64;
 std::random_device rd;
 std::ranlux48 random_engine(rd());
 
@@ -46,11 +125,67 @@ Model::Ptr person;
 Model::Ptr mc_model;
 Model::Ptr hammer;
 
-Mesh::Ptr ground;
+Terrain::Ptr terrain;
+// 雪人底部在积雪中压出的球面半径
+constexpr float SNOWMAN_FOOT_RADIUS = 2.0f;
 Mesh::Ptr screen;
 Mesh::Ptr grass;
 
+// 压力测试场景
+StressSceneConfig stress_config;
+std::vector<Model::Ptr> stress_opaque_models;
+std::vector<Model::Ptr> stress_transparent_models;
+std::vector<Light> point_lights;
+uint64_t scene_triangles = 0;
+
 Light light;
+ClusteredLighting::Ptr clustered_lighting;
+// 阴影过滤等级，T 键切换
+ShadowFilter::Ptr shadow_filter;
+VarianceShadowMap::Ptr variance_shadow_map;
+// 帧图与其临时渲染目标池，G-buffer、OIT 目标与阴影贴图都从池中分配
+RenderTargetPool::Ptr render_target_pool;
+FrameGraph::Ptr frame_graph;
+// 动态分辨率，Z 键切换
+DynamicResolution::Ptr dynamic_resolution;
+bool dynamic_resolution_enabled = true;
+// 延迟渲染，G 键切换
+GBuffer::Ptr gbuffer;
+bool deferred_shading = false;
+// 深度预处理，P 键切换
+bool depth_prepass = false;
+// 顺序无关透明，O 键切换
+OitBuffer::Ptr oit_buffer;
+bool oit_transparency = true;
+// 默认帧缓冲的深度能否直接 blit 给 OIT，不能时场景改画到离屏目标，以便采样其深度
+bool backbuffer_depth_blittable = true;
+// 每帧不透明物体与天空盒着色的片元数
+GpuQuery::Ptr shaded_samples_query;
+// 每帧的动态数据，目前为雪花的逐实例模型矩阵
+StreamBuffer::Ptr stream_buffer;
+StreamBuffer::Allocation snowflake_instances;
+// 除雪人外位置固定的不透明物体，以及本帧按到相机距离从近到远排序后的不透明物体
+// 雪人是大的遮挡体，单独放在 opaque_occluders 中先绘制，不参与遮挡查询
+std::vector<Model::Ptr> static_opaque_objects;
+std::vector<Model::Ptr> opaque_objects;
+std::vector<Model::Ptr> opaque_occluders;
+// 遮挡剔除，X 键在关闭、GPU 查询与软件光栅化之间切换；主视图与阴影的深度不同，各用一份
+OcclusionCuller::Ptr main_culler;
+OcclusionCuller::Ptr shadow_culler;
+WorkerPool::Ptr worker_pool;
+// 模型的外部纹理先只载入小的 mip 尾部，更高的 mip 按屏幕覆盖范围逐帧流送
+TextureStreamer::Ptr texture_streamer;
+SoftwareOcclusion::Ptr main_software_occlusion;
+SoftwareOcclusion::Ptr shadow_software_occlusion;
+std::vector<Model::Ptr> shadow_occludees;
+// 带骨骼动画的角色，每帧在线程池上求值姿态，蒙皮矩阵一次写入调色板
+BonePalette::Ptr bone_palette;
+std::vector<Model::Ptr> skinned_models;
+// 静态物体的碰撞场景，init 中构建后只读，由模拟线程上的移动控制器查询
+SceneBvh::Ptr collision_scene;
+RenderSettings::OcclusionMode occlusion_mode = RenderSettings::OcclusionQueries;
+// 渲染线程当前正在绘制的数据包，只在 display 期间有效
+const RenderPacket *frame_packet = nullptr;
 Texture skybox_tex(Texture::unknown);
 
 int32_t windowWidth = 1024;
@@ -60,9 +195,9 @@ Camera::Ptr camera;
 Camera::Ptr shadow_camera;
 
 int32_t shadowMapResolution = 16384;
-GLuint shadowMapFBO;
-Texture::Ptr shadowTexture;
-Texture::Ptr alphaTexture;
+// 阴影深度与透明度由帧图每帧分配，读取它们的 pass 以本帧的纹理绑定到这两个单元
+constexpr GLint SHADOW_MAP_UNIT = 27;
+constexpr GLint SHADOW_ALPHA_UNIT = 28;
 
 CammerMoveControler cammerMoveControler;
 SnowmanMoveControler snowmanMoveControler;
@@ -70,7 +205,21 @@ FirstPersonalMoveControler firstPersonalMoveControler;
 MoveControler*moveControler = &snowmanMoveControler;
 
 
-float deltaTime = 0;
+// 以下状态只由主线程访问，每帧打包后交给渲染线程
+RenderQueue::Ptr render_queue;
+RenderSettings render_settings;
+glm::ivec2 framebuffer_size(windowWidth, windowHeight);
+std::vector<glm::vec3> static_opaque_positions;
+uint64_t frame_count = 0;
+// 固定步长模拟，主线程每帧取前后两次步进的插值
+Simulation::Ptr simulation;
+// 以下状态只由模拟线程访问
+Model::Ptr sim_model;
+Model::Ptr sim_firstpersonal;
+Camera::Ptr sim_camera;
+glm::vec3 sim_light_position(0, 0, 0);
+std::vector<Transform> sim_snowflakes;
+std::ranlux48 sim_random_engine;
 bool first_personal = false;
 glm::vec3 history_location(0, 0, 0);
 extern glm::vec3 first_personal_camera_y;
@@ -83,60 +232,292 @@ void mouse_move_callback(GLFWwindow *window, double x, double y);
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
 void keyboard_callback(GLFWwindow *window, int32_t key, int32_t scancode, int32_t action, int32_t mods);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
-void rotate_camera();
+void rotate_camera(float dt);
 bool rotate_camera_state(bool is_change);
+void toggle_first_personal();
 float get_time_delta();
 // process user input
-void processInput(GLFWwindow *window);
-Model::Ptr genSnowflakes() {
-  // gen plain snowflakes
-  static Model snowflakes_template("assets/snowflakes.obj");
-  Model::Ptr snowflakes = std::make_shared<Model>(snowflakes_template);
-
-  // setting origin place
-  std::uniform_real_distribution<float> dist(-50, 50);
-  std::uniform_real_distribution<float> height(0, 16);
-
-  snowflakes->translate = glm::vec3(dist(random_engine), 50 + height(random_engine), dist(random_engine));
-  snowflakes->rotate = glm::vec3(dist(random_engine), dist(random_engine), dist(random_engine));
-  snowflakes->scale = glm::vec3(8, 8, 8);
-
-  return snowflakes;
+void processInput(const InputState &input, float dt);
+void init_simulation();
+void build_render_packet(RenderPacket &packet);
+void apply_render_packet(const RenderPacket &packet);
+void render_loop(GLFWwindow *window, std::promise<bool> &ready);
+void release_render_resources();
+void report_stress_stats(float deltaTime);
+// 按各模型在屏幕上的覆盖范围请求纹理 mip，再由流送器完成本帧的上传与释放
+void stream_textures(int32_t viewport_height);
+// 把本帧雪花的模型矩阵写入 stream_buffer
+void upload_snowflake_instances() {
+  snowflake_instances = stream_buffer->allocate(snowflakes.size() * sizeof(glm::mat4), sizeof(glm::mat4));
+  if (snowflake_instances.data == nullptr) {
+    return;
+  }
+  glm::mat4 *matrices = static_cast<glm::mat4 *>(snowflake_instances.data);
+  for (uint32_t i = 0; i < snowflakes.size(); ++i) {
+    matrices[i] = snowflakes[i]->get_model_matrix();
+  }
+  stream_buffer->commit(snowflake_instances);
 }
-
-void anmineSnowflakes() {
-  std::uniform_real_distribution<float> dist(0, 1.1);
-  std::uniform_real_distribution<float> height(0, 16);
-  for (auto item : snowflakes) {
-    // 进行下落
-    if (item->translate.y <= -10) {
-      item->translate.y = 50 + height(random_engine);
+// 所有雪花共用同一份网格，一次实例化绘制；流式缓冲空间不足时退回逐个绘制
+void draw_snowflakes(ShaderProgram::Ptr instanced_prog, ShaderProgram::Ptr fallback_prog, Camera::Ptr camera) {
+  if (snowflakes.empty()) {
+    return;
+  }
+  if (snowflake_instances.data == nullptr) {
+    for (auto item : snowflakes) {
+      item->draw(fallback_prog, camera);
     }
-    item->translate.y -= dist(random_engine);
-
-    item->rotate.z += 10 * dist(random_engine);
-    if (item->rotate.z >= 360) {
-      item->rotate.z -= 360;
+    return;
+  }
+  snowflakes.front()->draw_instanced(
+    instanced_prog, camera, stream_buffer->get_id(), snowflake_instances.offset, snowflakes.size());
+}
+// 软件遮挡剔除：在提交任何绘制之前，把两个视角的遮挡体光栅化到 CPU 上的深度缓冲
+void prepare_software_occlusion() {
+  Model::Ptr snowman = frame_packet->world.first_personal ? snowman_firstpersonal : model;
+  main_software_occlusion->begin_frame(camera->getProjectionMatrix() * camera->getViewMatrix());
+  main_software_occlusion->add_occluder(snowman);
+  main_software_occlusion->add_occluder(mc_model);
+  main_software_occlusion->rasterize();
+
+  shadow_software_occlusion->begin_frame(shadow_camera->getProjectionMatrix() * shadow_camera->getViewMatrix());
+  shadow_software_occlusion->add_occluder(snowman);
+  shadow_software_occlusion->add_occluder(mc_model);
+  shadow_software_occlusion->rasterize();
+}
+// 按遮挡剔除方式绘制 items，调用前遮挡体应已写入深度
+// GPU 查询时 tests 为 false 表示沿用本帧已发起的查询，用于深度预处理之后的着色阶段；
+// 软件剔除的结果在帧开始时已经确定，被遮挡的物体不提交绘制
+// 带骨骼的物体使用 skinned_prog 绘制
+void draw_with_occlusion(OcclusionCuller::Ptr culler, SoftwareOcclusion::Ptr software, const std::vector<Model::Ptr> &items,
+                         ShaderProgram::Ptr prog, ShaderProgram::Ptr skinned_prog, Camera::Ptr camera, bool tests) {
+  if (occlusion_mode != RenderSettings::OcclusionQueries) {
+    for (auto item : items) {
+      if (occlusion_mode == RenderSettings::OcclusionSoftware && software->is_occluded(item)) {
+        continue;
+      }
+      item->draw(item->is_skinned() ? skinned_prog : prog, camera);
     }
-    item->rotate.y += 10 * dist(random_engine);
-    if (item->rotate.y >= 360) {
-      item->rotate.y -= 360;
+    return;
+  }
+  if (tests) {
+    // 包围盒的 GL_ANY_SAMPLES_PASSED 查询不能嵌套在着色片元数的查询中，测试期间暂停后者
+    shaded_samples_query->suspend();
+    culler->begin_tests(camera);
+    for (auto item : items) {
+      culler->test(item);
+    }
+    culler->end_tests();
+    shaded_samples_query->resume();
+  }
+  for (auto item : items) {
+    culler->begin_draw(item);
+    item->draw(item->is_skinned() ? skinned_prog : prog, camera);
+    culler->end_draw();
+  }
+}
+// 绘制投射阴影的物体，草地需要单独处理混合状态
+// 雪人与冰屋在光源视角下遮挡面积最大，先绘制，其余物体以遮挡查询为条件绘制
+void draw_shadow_casters(ShaderProgram::Ptr prog, ShaderProgram::Ptr instanced_prog, ShaderProgram::Ptr terrain_prog,
+                         ShaderProgram::Ptr skinned_prog) {
+  terrain->draw(terrain_prog, shadow_camera);
+  draw_snowflakes(instanced_prog, prog, shadow_camera);
+  if(frame_packet->world.first_personal){
+    snowman_firstpersonal->draw(prog, shadow_camera);
+  }else{
+    model->draw(prog, shadow_camera);
+  }
+  mc_model->draw(prog, shadow_camera);
+
+  draw_with_occlusion(
+    shadow_culler, shadow_software_occlusion, shadow_occludees, prog, skinned_prog, shadow_camera, true);
+}
+// 绘制所有透明物体
+void draw_transparent_objects(ShaderProgram::Ptr prog) {
+  grass->draw(prog, camera);
+  mc_model->draw(prog, camera);
+  for (auto item : stress_transparent_models) {
+    item->draw(prog, camera);
+  }
+}
+// 主线程：不透明物体从近到远排序，让被遮挡的片元尽早被深度测试剔除
+// 下标 0 为雪人，i + 1 对应 static_opaque_objects[i]
+void sort_opaque_objects(const WorldState &world, std::vector<uint32_t> &order) {
+  const Transform &snowman = world.first_personal ? world.snowman_firstpersonal : world.snowman;
+  std::vector<std::pair<float, uint32_t>> keyed;
+  keyed.reserve(static_opaque_positions.size() + 1);
+  glm::vec3 offset = snowman.translate - world.camera.position;
+  keyed.push_back({glm::dot(offset, offset), 0});
+  for (uint32_t i = 0; i < static_opaque_positions.size(); ++i) {
+    offset = static_opaque_positions[i] - world.camera.position;
+    keyed.push_back({glm::dot(offset, offset), i + 1});
+  }
+  std::sort(keyed.begin(), keyed.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+  order.resize(keyed.size());
+  for (uint32_t i = 0; i < keyed.size(); ++i) {
+    order[i] = keyed[i].second;
+  }
+}
+// 绘制所有不透明物体，前向与延迟两条路径共用
+// 先绘制遮挡体，使用 GPU 查询时冰屋虽是透明物体，其完全不透明的部分也先写入深度，
+// 再按遮挡剔除的结果绘制其余物体；occlusion_tests 为 false 时沿用本帧的查询
+// 地形紧随其后，在遮挡查询之前写入深度
+// 雪花很小，几乎不遮挡其他物体，不参与排序与查询，放在最后绘制
+void draw_opaque_objects(ShaderProgram::Ptr prog, ShaderProgram::Ptr snowflake_prog, ShaderProgram::Ptr terrain_prog,
+                         ShaderProgram::Ptr skinned_prog, bool occlusion_tests) {
+  for (auto item : opaque_occluders) {
+    item->draw(prog, camera);
+  }
+  terrain->draw(terrain_prog, camera);
+  if (occlusion_mode == RenderSettings::OcclusionQueries && occlusion_tests) {
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    mc_model->draw(oit_depth_prog, camera);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  }
+  draw_with_occlusion(main_culler, main_software_occlusion, opaque_objects, prog, skinned_prog, camera, occlusion_tests);
+  draw_snowflakes(snowflake_prog, prog, camera);
+}
+// 按场景选择光照变体：没有点光源时不带分簇光照。每帧调用，只在选择结果变化时查找变体
+void select_lit_programs() {
+  uint32_t shadow_tier = 0;
+  uint32_t deferred_tier = 0;
+  if (shadow_filter->tier == ShadowFilter::PoissonPCF) {
+    shadow_tier = LIT_SHADOW_POISSON;
+    deferred_tier = DEFERRED_SHADOW_POISSON;
+  } else if (shadow_filter->tier == ShadowFilter::PCSS) {
+    shadow_tier = LIT_SHADOW_PCSS;
+    deferred_tier = DEFERRED_SHADOW_PCSS;
+  } else if (shadow_filter->tier == ShadowFilter::EVSM) {
+    shadow_tier = LIT_SHADOW_EVSM;
+    deferred_tier = DEFERRED_SHADOW_EVSM;
+  }
+  uint32_t lighting = LIT_RECEIVE_SHADOW | shadow_tier | (point_lights.empty() ? 0 : LIT_CLUSTERED_LIGHTS);
+  if (lighting == selected_lighting) {
+    return;
+  }
+  selected_lighting = lighting;
+  default_prog = lit_variants->get(lighting);
+  skinned_prog = lit_variants->get(lighting | LIT_SKINNED);
+  snowflake_prog = lit_variants->get(lighting | LIT_INSTANCED);
+  terrain_prog = lit_variants->get(lighting | LIT_TERRAIN);
+  transparency_prog = lit_variants->get(lighting | LIT_ALPHA_TEST);
+  transparency_oit_prog = lit_variants->get(lighting | LIT_ALPHA_TEST | LIT_OIT_OUTPUT);
+  deferred_prog = deferred_variants->get(deferred_tier);
+}
+void stream_textures(int32_t viewport_height) {
+  // 包围球投影到屏幕上的直径：半径 / (距离 * tan(fovy / 2)) 为占视口高度的一半
+  float tan_half_fovy = std::tan(glm::radians(camera->fovy) * 0.5f);
+  auto request = [&](const Model::Ptr &item) {
+    glm::vec3 min, max;
+    item->get_bounds(min, max);
+    glm::vec3 center = glm::vec3(item->get_model_matrix() * glm::vec4((min + max) * 0.5f, 1.0f));
+    float radius = glm::length(max - min) * 0.5f * std::max(item->scale.x, std::max(item->scale.y, item->scale.z));
+    float distance = std::max(glm::length(center - camera->position), camera->zNear);
+    item->request_textures(std::min(radius / (distance * tan_half_fovy), 1.0f) * viewport_height);
+  };
+  Model::Ptr snowman = frame_packet->world.first_personal ? snowman_firstpersonal : model;
+  for (const auto &item : {snowman, person, hammer, mc_model}) {
+    request(item);
+  }
+  for (const auto *list : {&stress_opaque_models, &stress_transparent_models}) {
+    for (const auto &item : *list) {
+      request(item);
     }
-    item->rotate.x += 10 * dist(random_engine);
-    if (item->rotate.x >= 360) {
-      item->rotate.x -= 360;
+  }
+  texture_streamer->update();
+}
+// 按压力测试配置复制模型并铺满场景
+void place_stress_copies(Model::Ptr source, std::vector<Model::Ptr> &target, uint32_t stream) {
+  std::vector<glm::vec3> positions = stress_layout(stress_config, stress_config.copies, stream);
+  std::vector<float> yaws = stress_yaws(stress_config, stress_config.copies, stream);
+  for (uint32_t i = 0; i < positions.size(); ++i) {
+    Model::Ptr copy = std::make_shared<Model>(*source);
+    copy->translate = positions[i] + glm::vec3(0, source->translate.y, 0);
+    copy->rotate = source->rotate + glm::vec3(0, yaws[i], 0);
+    target.push_back(copy);
+  }
+}
+// PMX 中没有动作，为角色生成两个程序化的循环动作并同时播放，骨骼名为 MMD 的标准骨骼名
+void add_character_clips(Model::Ptr character) {
+  Animator::Ptr animator = character->get_animator();
+  if (animator == nullptr) {
+    return;
+  }
+  const Skeleton &skeleton = *animator->get_skeleton();
+  const float half_turn = glm::radians(180.0f);
+  // 呼吸与轻微的左右张望
+  uint32_t idle = animator->add_clip(AnimationClip::oscillate("idle", skeleton, 4.0f, {
+    {"センター", glm::vec3(0, 1, 0), 0.08f, 2, 0.0f, true},
+    {"上半身", glm::vec3(1, 0, 0), 0.03f, 2},
+    {"上半身2", glm::vec3(1, 0, 0), 0.03f, 2, 0.5f},
+    {"首", glm::vec3(0, 1, 0), 0.12f, 1},
+    {"頭", glm::vec3(1, 0, 0), 0.06f, 2, 0.8f},
+    {"左腕", glm::vec3(0, 0, 1), 0.08f, 1},
+    {"右腕", glm::vec3(0, 0, 1), 0.08f, 1, half_turn},
+  }));
+  // 随节奏摆动身体与手臂
+  uint32_t sway = animator->add_clip(AnimationClip::oscillate("sway", skeleton, 3.0f, {
+    {"下半身", glm::vec3(0, 1, 0), 0.12f, 1},
+    {"上半身", glm::vec3(0, 0, 1), 0.08f, 1},
+    {"頭", glm::vec3(0, 0, 1), 0.08f, 1, half_turn},
+    {"左ひじ", glm::vec3(0, 1, 0), 0.2f, 2},
+    {"右ひじ", glm::vec3(0, 1, 0), 0.2f, 2, half_turn},
+  }));
+  animator->play(idle);
+  animator->play(sway, 0.0f);
+}
+// 各角色的两层动作按各自的相位交替占主导，再由调色板在线程池上求出全部蒙皮矩阵
+void animate_characters(float dt) {
+  static float elapsed = 0;
+  elapsed += dt;
+  for (uint32_t i = 0; i < skinned_models.size(); ++i) {
+    std::vector<Animator::Layer> &layers = skinned_models[i]->get_animator()->get_layers();
+    if (layers.size() >= 2) {
+      layers[1].weight = 0.5f + 0.5f * std::sin(elapsed * 0.4f + i * 0.7f);
     }
   }
+  bone_palette->update(dt);
 }
 // init function
 void init() {
   // init shader
-  default_prog = std::make_shared<ShaderProgram>("shaders/default.vert", "shaders/default.frag");
+  lit_variants = std::make_shared<ShaderVariants>("shaders/default.vert", "shaders/lit.frag",
+    std::vector<std::string>{
+      "ALPHA_TEST", "RECEIVE_SHADOW", "CLUSTERED_LIGHTS", "OIT_OUTPUT", "SHADOW_POISSON", "SHADOW_PCSS", "SHADOW_EVSM",
+      "INSTANCED", "TERRAIN", "SKINNED"});
   dot_light_prog = std::make_shared<ShaderProgram>("shaders/default.vert", "shaders/dot_light.frag");
   shadow_prog = std::make_shared<ShaderProgram>("shaders/shadow.vert", "shaders/shadow.frag");
+  evsm_moments_prog = std::make_shared<ShaderProgram>("shaders/shadow.vert", "shaders/evsm_moments.frag");
+  gaussian_blur_prog = std::make_shared<ShaderProgram>("shaders/deferred.vert", "shaders/gaussian_blur.frag");
+  depth_copy_prog = std::make_shared<ShaderProgram>("shaders/deferred.vert", "shaders/depth_copy.frag");
   debug = std::make_shared<ShaderProgram>("shaders/debug.vert", "shaders/debug.frag");
   skybox_prog = std::make_shared<ShaderProgram>("shaders/skybox.vert", "shaders/skybox.frag");
-  transparency_prog = std::make_shared<ShaderProgram>("shaders/default.vert","shaders/transparency.frag");
+  gbuffer_prog = std::make_shared<ShaderProgram>("shaders/default.vert", "shaders/gbuffer.frag");
+  deferred_variants = std::make_shared<ShaderVariants>("shaders/deferred.vert", "shaders/deferred.frag",
+    std::vector<std::string>{"SHADOW_POISSON", "SHADOW_PCSS", "SHADOW_EVSM"});
+  depth_prog = std::make_shared<ShaderProgram>("shaders/depth.vert", "shaders/depth.frag");
+  oit_depth_prog = std::make_shared<ShaderProgram>("shaders/default.vert", "shaders/oit_depth.frag");
+  oit_resolve_prog = std::make_shared<ShaderProgram>("shaders/deferred.vert", "shaders/oit_resolve.frag");
+  upscale_prog = std::make_shared<ShaderProgram>("shaders/deferred.vert", "shaders/upscale.frag");
+  const std::vector<std::string> instanced = {"INSTANCED"};
+  shadow_instanced_prog = std::make_shared<ShaderProgram>("shaders/shadow.vert", "shaders/shadow.frag", instanced);
+  evsm_moments_instanced_prog =
+    std::make_shared<ShaderProgram>("shaders/shadow.vert", "shaders/evsm_moments.frag", instanced);
+  depth_instanced_prog = std::make_shared<ShaderProgram>("shaders/depth.vert", "shaders/depth.frag", instanced);
+  gbuffer_instanced_prog = std::make_shared<ShaderProgram>("shaders/default.vert", "shaders/gbuffer.frag", instanced);
+  const std::vector<std::string> terrain_defines = {"TERRAIN"};
+  shadow_terrain_prog = std::make_shared<ShaderProgram>("shaders/shadow.vert", "shaders/shadow.frag", terrain_defines);
+  evsm_moments_terrain_prog =
+    std::make_shared<ShaderProgram>("shaders/shadow.vert", "shaders/evsm_moments.frag", terrain_defines);
+  depth_terrain_prog = std::make_shared<ShaderProgram>("shaders/depth.vert", "shaders/depth.frag", terrain_defines);
+  gbuffer_terrain_prog = std::make_shared<ShaderProgram>("shaders/default.vert", "shaders/gbuffer.frag", terrain_defines);
+  const std::vector<std::string> skinned = {"SKINNED"};
+  shadow_skinned_prog = std::make_shared<ShaderProgram>("shaders/shadow.vert", "shaders/shadow.frag", skinned);
+  evsm_moments_skinned_prog =
+    std::make_shared<ShaderProgram>("shaders/shadow.vert", "shaders/evsm_moments.frag", skinned);
+  depth_skinned_prog = std::make_shared<ShaderProgram>("shaders/depth.vert", "shaders/depth.frag", skinned);
+  gbuffer_skinned_prog = std::make_shared<ShaderProgram>("shaders/default.vert", "shaders/gbuffer.frag", skinned);
+  terrain_stamp_prog = std::make_shared<ShaderProgram>("shaders/deferred.vert", "shaders/terrain_stamp.frag");
 
   // init camera
   camera = std::make_shared<Camera>();
@@ -149,19 +530,45 @@ void init() {
   light.type = Light::SunLight;
   light.ambient = {0.45, 0.45, 0.45};
   light.diffuse = {(float)218 / 255, (float)218 / 255, (float)192 / 255};
+  clustered_lighting = std::make_shared<ClusteredLighting>();
+  render_target_pool = std::make_shared<RenderTargetPool>();
+  frame_graph = std::make_shared<FrameGraph>(render_target_pool);
+  dynamic_resolution = std::make_shared<DynamicResolution>();
+  gbuffer = std::make_shared<GBuffer>();
+  oit_buffer = std::make_shared<OitBuffer>();
+  shaded_samples_query = std::make_shared<GpuQuery>(GL_SAMPLES_PASSED);
 
   // init objects;
+  // 模型加载时用线程池并行构建各网格的 BVH
+  worker_pool = std::make_shared<WorkerPool>();
+  Model::set_worker_pool(worker_pool);
+  bone_palette = std::make_shared<BonePalette>(worker_pool);
+  texture_streamer = std::make_shared<TextureStreamer>();
+  Model::set_texture_streamer(texture_streamer);
   model = std::make_shared<Model>("assets/snowman.obj");
   snowman_firstpersonal = std::make_shared<Model>("assets/snowmanfirstperson.obj");
   person = std::make_shared<Model>("assets/sl/神里绫华.pmx");
   mc_model = std::make_shared<Model>("assets/icehouse/icehouse.obj");
   hammer = std::make_shared<Model>("assets/hammer.obj");
-  for (uint16_t i = 0; i < SNOWFLAKES_COUNT; ++i) {
-    snowflakes.push_back(genSnowflakes());
+  if (stress_config.enabled) {
+    random_engine.seed(stress_config.seed);
+  }
+  Model snowflakes_template("assets/snowflakes.obj");
+  for (uint32_t i = 0; i < stress_config.snowflakes; ++i) {
+    snowflakes.push_back(genSnowflakes(snowflakes_template, random_engine));
+  }
+  if (stress_config.enabled) {
+    // 雪花铺满整个压力测试区域
+    std::vector<glm::vec3> positions = stress_layout(stress_config, stress_config.snowflakes, 4);
+    for (uint32_t i = 0; i < positions.size(); ++i) {
+      snowflakes[i]->translate.x = positions[i].x;
+      snowflakes[i]->translate.z = positions[i].z;
+    }
   }
   cube_light = std::make_shared<Model>("assets/cube.obj");
   skybox = std::make_shared<Model>("assets/cube.obj");
-  ground = std::make_shared<Mesh>();
+  // 地形的块在线程池上生成，首帧起围绕相机逐步载入
+  terrain = std::make_shared<Terrain>(TerrainConfig(), worker_pool);
   screen = std::make_shared<Mesh>();
   screen->vertices = {
     {{-1, -1, 0}, {0, 1, 0}, {0, 0}},
@@ -169,21 +576,14 @@ void init() {
     { {-1, 1, 0}, {0, 1, 0}, {0, 1}},
     {  {1, 1, 0}, {0, 1, 0}, {1, 1}}
   };
-  ground->vertices = {
-    {{-1, 0, -1}, {0, 1, 0}, {0, 0}},
-    { {1, 0, -1}, {0, 1, 0}, {1, 0}},
-    { {-1, 0, 1}, {0, 1, 0}, {0, 1}},
-    {  {1, 0, 1}, {0, 1, 0}, {1, 1}}
-  };
-  ground->indices = {0, 1, 2, 2, 1, 3};
   screen->indices = {0, 1, 2, 2, 1, 3};
   grass = std::make_shared<Mesh>(*screen);
-  ground->setup();
   screen->setup();
 
   // texture init
-  ground->add_texture(std::make_shared<Texture>("assets/wall.jpg", Texture::diffuse));
-  ground->add_texture(std::make_shared<Texture>(Texture::specular, Texture2DFromUChar(nullptr)));
+  const unsigned char snow_color[] = {236, 240, 248, 255};
+  terrain->add_texture(std::make_shared<Texture>(Texture::diffuse, Texture2DFromUChar(snow_color)));
+  terrain->add_texture(std::make_shared<Texture>(Texture::specular, Texture2DFromUChar(nullptr)));
 
   std::vector<std::string> files = {
     "assets/skybox/right.jpg",
@@ -206,29 +606,12 @@ void init() {
   shadow_camera->bottom = -100;
   shadow_camera->top = 100;
   shadow_camera->zFar = 200;
+  shadow_filter = std::make_shared<ShadowFilter>();
+  variance_shadow_map = std::make_shared<VarianceShadowMap>();
+  shadow_filter->set_light_size(2.0f, shadow_camera->zFar - shadow_camera->zNear, shadow_camera->right - shadow_camera->left);
   shadow_camera->position = light.position;
 
 
-  shadowTexture = std::make_shared<Texture>(Texture::shadow);
-  alphaTexture = std::make_shared<Texture>(Texture::alpha);
-  glGenFramebuffers(1, &shadowMapFBO);
-  shadowTexture->type = Texture::shadow;
-  shadowTexture->id = Texture2DForShadowMap(shadowMapResolution, shadowMapResolution, GL_CLAMP_TO_BORDER);
-  glBindFramebuffer(GL_FRAMEBUFFER, shadowMapFBO);
-  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowTexture->id, 0);
-
-  alphaTexture->type = Texture::alpha;
-  unsigned int texColorBuffer;
-  glGenTextures(1, &texColorBuffer);
-  glBindTexture(GL_TEXTURE_2D, texColorBuffer);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, shadowMapResolution, shadowMapResolution, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  alphaTexture->id = texColorBuffer;
-
-  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, alphaTexture->id, 0);  
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
   // properties setting
   person->translate = glm::vec3(20, 0, 70);
   mc_model->translate = glm::vec3(0, -5, 0);
@@ -236,133 +619,400 @@ void init() {
   mc_model->rotate = {0, 180, 0};
   hammer->translate = {-10, 15, 35};
   model->translate = {0,0,10};
-  ground->scale = glm::vec3(50, 50, 50);
   cube_light->scale = {0.2, 0.2, 0.2};
   cube_light->translate = light.position;
 
   grass->translate = {10, 1, 0};
 
-  ground->add_texture(shadowTexture);
-  model->add_texture(shadowTexture);
-  //screen->add_texture(shadowTexture);
-  grass->add_texture(shadowTexture);
-  snowman_firstpersonal->add_texture(shadowTexture);
-  person->add_texture(shadowTexture);
-  mc_model->add_texture(shadowTexture);
-  hammer->add_texture(shadowTexture);
-  for (auto item : snowflakes) {
-    item->add_texture(shadowTexture);
+  // 动作在复制之前添加，副本共享同一份动画片段
+  add_character_clips(person);
+
+  if (stress_config.enabled) {
+    // 副本共享原模型的缓冲与纹理，需在纹理添加完成后复制
+    place_stress_copies(model, stress_opaque_models, 0);
+    place_stress_copies(person, stress_opaque_models, 1);
+    place_stress_copies(hammer, stress_opaque_models, 2);
+    place_stress_copies(mc_model, stress_transparent_models, 3);
+    point_lights = stress_lights(stress_config);
+    // 角色副本错开动作的时刻与速率
+    std::uniform_real_distribution<float> offset(0.0f, 4.0f), rate(0.8f, 1.25f);
+    for (auto item : stress_opaque_models) {
+      if (!item->is_skinned()) {
+        continue;
+      }
+      for (auto &layer : item->get_animator()->get_layers()) {
+        layer.time = offset(random_engine);
+        layer.speed = rate(random_engine);
+      }
+    }
+
+    scene_triangles = model->get_triangle_count() + person->get_triangle_count() + hammer->get_triangle_count() +
+                      mc_model->get_triangle_count() + grass->indices.size() / 3;
+    for (auto item : snowflakes) {
+      scene_triangles += item->get_triangle_count();
+    }
+    for (auto item : stress_opaque_models) {
+      scene_triangles += item->get_triangle_count();
+    }
+    for (auto item : stress_transparent_models) {
+      scene_triangles += item->get_triangle_count();
+    }
+    std::cout << "[STRESS] objects=" << 4 + snowflakes.size() + stress_opaque_models.size() + stress_transparent_models.size()
+              << " triangles=" << scene_triangles << " lights=" << point_lights.size() << std::endl;
   }
 
-  ground->add_texture(alphaTexture);
-  model->add_texture(alphaTexture);
-  screen->add_texture(alphaTexture);
-  grass->add_texture(alphaTexture);
-  snowman_firstpersonal->add_texture(alphaTexture);
-  person->add_texture(alphaTexture);
-  mc_model->add_texture(alphaTexture);
-  hammer->add_texture(alphaTexture);
-  for (auto item : snowflakes) {
-    item->add_texture(alphaTexture);
+  // 每帧区域容纳全部雪花的模型矩阵
+  stream_buffer = std::make_shared<StreamBuffer>(
+    GL_ARRAY_BUFFER, std::max<GLsizeiptr>(snowflakes.size() * sizeof(glm::mat4), 64 * 1024));
+
+  if (person->is_skinned()) {
+    skinned_models.push_back(person);
+  }
+  for (auto item : stress_opaque_models) {
+    if (item->is_skinned()) {
+      skinned_models.push_back(item);
+    }
   }
+  for (auto item : skinned_models) {
+    bone_palette->add(item->get_animator());
+  }
+
+  static_opaque_objects.push_back(person);
+  static_opaque_objects.push_back(hammer);
+  static_opaque_objects.insert(static_opaque_objects.end(), stress_opaque_models.begin(), stress_opaque_models.end());
+
+  // 包围盒只需要写深度的程序
+  main_culler = std::make_shared<OcclusionCuller>(depth_prog);
+  shadow_culler = std::make_shared<OcclusionCuller>(depth_prog);
+  main_software_occlusion = std::make_shared<SoftwareOcclusion>(worker_pool);
+  shadow_software_occlusion = std::make_shared<SoftwareOcclusion>(worker_pool);
+  shadow_occludees = {person, hammer};
+  shadow_occludees.insert(shadow_occludees.end(), stress_opaque_models.begin(), stress_opaque_models.end());
+  shadow_occludees.insert(shadow_occludees.end(), stress_transparent_models.begin(), stress_transparent_models.end());
+
+  // 雪人与雪花会移动，不参与碰撞
+  // 地形只在视距内加入碰撞，间距 2 的网格足以挡住雪人与相机
+  Mesh::Ptr terrain_collision = terrain->build_collision_mesh(terrain->get_config().view_distance, 2.0f);
+  collision_scene = std::make_shared<SceneBvh>();
+  collision_scene->add(*terrain_collision, glm::mat4(1.0f));
+  collision_scene->add(*mc_model);
+  for (auto item : shadow_occludees) {
+    collision_scene->add(*item);
+  }
+  collision_scene->build();
+  MoveControler::set_collision_scene(collision_scene);
 
-  default_prog->use();
+  // 提前创建首帧会用到的变体，与其他程序一起并行编译
+  select_lit_programs();
 
   glEnable(GL_DEPTH_TEST);
 }
 
 void display() {
+  stream_buffer->begin_frame();
+  upload_snowflake_instances();
+  animate_characters(frame_packet->delta_time);
+
   // 传递光源位置
   shadow_camera->position = light.position;
   shadow_camera->direction = glm::normalize(glm::vec3(0, 0, 0) - shadow_camera->position);
   shadow_camera->aspect = (float)windowWidth / windowHeight;
-  default_prog->set_light("light", light);
-  default_prog->set_uniform("shadow_zNear", shadow_camera->zNear);
-  default_prog->set_uniform("shadow_zFar", shadow_camera->zFar);
   dot_light_prog->set_light("light", light);
-  transparency_prog->set_light("light", light);
-  transparency_prog->set_uniform("shadow_zNear", shadow_camera->zNear);
-  transparency_prog->set_uniform("shadow_zFar", shadow_camera->zFar);
 
-  // 传递相机位置
-  default_prog->set_uniform("cameraPos", camera->position);
-  transparency_prog->set_uniform("cameraPos", camera->position);
+  if (occlusion_mode == RenderSettings::OcclusionSoftware) {
+    prepare_software_occlusion();
+  }
 
+  // 地形：围绕相机载入、卸载块并选择 LOD，再把雪人脚下的积雪压实
+  terrain->update(camera);
+  Model::Ptr snowman = frame_packet->world.first_personal ? snowman_firstpersonal : model;
+  terrain->deform(terrain_stamp_prog, screen, snowman->translate, SNOWMAN_FOOT_RADIUS);
 
-  glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-  /*-----draw objs-------*/
+  // 动态分辨率：场景画到按比例缩小的离屏目标，最后放大到窗口；关闭时直接画到默认帧缓冲 (OIT 需要时除外)
+  glm::ivec2 render_size(windowWidth, windowHeight);
+  if (dynamic_resolution_enabled) {
+    render_size = dynamic_resolution->get_render_size(windowWidth, windowHeight);
+  }
 
-  // shadow draw
-  glBindFramebuffer(GL_FRAMEBUFFER, shadowMapFBO);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  glViewport(0, 0, shadowMapResolution, shadowMapResolution);
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  stream_textures(render_size.y);
+
+  // 分簇光源
+  clustered_lighting->update(point_lights, camera, render_size.x, render_size.y);
+
+  // 本帧的 pass 按执行顺序声明，compile 时剔除无人读取的 pass 并为临时渲染目标分配纹理
+  frame_graph->begin_frame(windowWidth, windowHeight);
+  bool evsm = shadow_filter->tier == ShadowFilter::EVSM;
+  // 阴影贴图只被接收阴影的 pass 读取；EVSM 等级下没有读者，阴影 pass 连同两张附件一起被剔除
+  FrameGraph::Resource shadow_depth = frame_graph->create_texture(
+    "shadow_depth", {shadowMapResolution, shadowMapResolution, GL_DEPTH_COMPONENT32, GL_LINEAR, GL_CLAMP_TO_BORDER, true});
+  FrameGraph::Resource shadow_alpha =
+    frame_graph->create_texture("shadow_alpha", {shadowMapResolution, shadowMapResolution, GL_RGBA8, GL_LINEAR});
+  auto read_shadow = [&](FrameGraph::PassBuilder &pass) {
+    if (!evsm) {
+      pass.read(shadow_depth).read(shadow_alpha);
+    }
+  };
+  // 在读取阴影的 pass 开始时绑定其本帧的纹理；EVSM 等级下资源被剔除，着色器也不采样它们
+  auto bind_shadow = [&](const FrameGraph::Context &context) {
+    GLuint depth = context.get_texture(shadow_depth);
+    glActiveTexture(GL_TEXTURE0 + SHADOW_MAP_UNIT);
+    glBindTexture(GL_TEXTURE_2D, depth);
+    glActiveTexture(GL_TEXTURE0 + SHADOW_ALPHA_UNIT);
+    glBindTexture(GL_TEXTURE_2D, context.get_texture(shadow_alpha));
+    glActiveTexture(GL_TEXTURE0);
+    shadow_filter->bind_depth(depth);
+  };
+  // 不透明物体、光源、天空盒与透明物体都画到场景目标中
+  FrameGraph::Resource scene_color = FrameGraph::BACKBUFFER;
+  FrameGraph::Resource scene_depth = FrameGraph::BACKBUFFER;
+  bool offscreen_scene = dynamic_resolution_enabled || (oit_transparency && !backbuffer_depth_blittable);
+  if (offscreen_scene) {
+    scene_color = frame_graph->create_texture("scene_color", {render_size.x, render_size.y, GL_RGBA8, GL_LINEAR});
+    scene_depth = frame_graph->create_texture("scene_depth", {render_size.x, render_size.y, GL_DEPTH24_STENCIL8});
+  }
+  auto write_scene = [&](FrameGraph::PassBuilder pass) {
+    pass.write(scene_color);
+    if (scene_depth != scene_color) {
+      pass.write(scene_depth);
+    }
+  };
+  auto scene_framebuffer = [&](const FrameGraph::Context &context) {
+    return scene_color == FrameGraph::BACKBUFFER ? GL_ZERO : context.get_framebuffer({scene_color, scene_depth});
+  };
 
+  /*-----draw objs-------*/
 
-  for (uint16_t i = 0; i < SNOWFLAKES_COUNT; ++i) {
-    snowflakes[i]->draw(shadow_prog, shadow_camera);
-  }
-  if(first_personal){
-    snowman_firstpersonal->draw(shadow_prog, shadow_camera);
-  }else{
-    model->draw(shadow_prog, shadow_camera);
+  // shadow draw
+  frame_graph->add_pass("shadow_map", [&](const FrameGraph::Context &context) {
+    context.bind_framebuffer();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    draw_shadow_casters(shadow_prog, shadow_instanced_prog, shadow_terrain_prog, shadow_skinned_prog);
+    glDisable(GL_BLEND);
+    grass->draw(shadow_prog, shadow_camera);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  }).write(shadow_alpha).write(shadow_depth);
+  if (evsm) {
+    // 低分辨率的矩目标，模糊后生成 mipmap；矩目标由 VarianceShadowMap 持有，不经过帧图分配
+    frame_graph->add_pass("evsm_moments", [&](const FrameGraph::Context &) {
+      variance_shadow_map->begin();
+      glm::vec2 exponents(VarianceShadowMap::POSITIVE_EXPONENT, VarianceShadowMap::NEGATIVE_EXPONENT);
+      evsm_moments_prog->set_uniform("evsmExponents", exponents);
+      evsm_moments_instanced_prog->set_uniform("evsmExponents", exponents);
+      evsm_moments_terrain_prog->set_uniform("evsmExponents", exponents);
+      evsm_moments_skinned_prog->set_uniform("evsmExponents", exponents);
+      draw_shadow_casters(
+        evsm_moments_prog, evsm_moments_instanced_prog, evsm_moments_terrain_prog, evsm_moments_skinned_prog);
+      grass->draw(evsm_moments_prog, shadow_camera);
+      variance_shadow_map->blur(gaussian_blur_prog, screen);
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }).side_effect();
   }
-  
-  person->draw(shadow_prog, shadow_camera);
-  hammer->draw(shadow_prog, shadow_camera);
-  mc_model->draw(shadow_prog, shadow_camera);
-  glDisable(GL_BLEND);
-  grass->draw(shadow_prog, shadow_camera);
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  
 
   // default draw
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  glViewport(0, 0, windowWidth, windowHeight);
-
-
-  skybox_prog->use();
-  glActiveTexture(GL_TEXTURE16);
-  glBindTexture(GL_TEXTURE_CUBE_MAP, skybox_tex.id);
-  skybox_prog->set_uniform("skybox", 16);
+  write_scene(frame_graph->add_pass("clear", [&](const FrameGraph::Context &context) {
+    context.bind_framebuffer();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  }));
+
+  if (depth_prepass && !deferred_shading) {
+    // 先只写深度，之后每个像素只有最近的片元通过 GL_EQUAL 被着色
+    write_scene(frame_graph->add_pass("depth_prepass", [&](const FrameGraph::Context &context) {
+      context.bind_framebuffer();
+      glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+      draw_opaque_objects(depth_prog, depth_instanced_prog, depth_terrain_prog, depth_skinned_prog, true);
+      glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    }));
+  }
 
-  skybox->translate = camera->position;
-  glDepthMask(GL_FALSE);
-  skybox->draw(skybox_prog, camera);
-  glDepthMask(GL_TRUE);
+  // 统计着色的片元数，不含深度预处理
+  if (deferred_shading) {
+    // 几何阶段：只写入 G-buffer
+    gbuffer->declare(*frame_graph, render_size.x, render_size.y);
+    FrameGraph::PassBuilder geometry = frame_graph->add_pass("gbuffer", [&](const FrameGraph::Context &context) {
+      shaded_samples_query->begin();
+      gbuffer->bind_for_geometry(context);
+      draw_opaque_objects(gbuffer_prog, gbuffer_instanced_prog, gbuffer_terrain_prog, gbuffer_skinned_prog, true);
+    });
+    gbuffer->write(geometry);
+
+    // 光照阶段：全屏四边形逐像素着色，背景像素留给之后的天空盒
+    FrameGraph::PassBuilder lighting = frame_graph->add_pass("deferred_lighting", [&](const FrameGraph::Context &context) {
+      context.bind_framebuffer();
+      deferred_prog->use();
+      deferred_prog->set_light("light", light);
+      deferred_prog->set_uniform("cameraPos", camera->position);
+      deferred_prog->set_uniform("view", camera->getViewMatrix());
+      deferred_prog->set_uniform("inverseViewProjection",
+                                 glm::inverse(camera->getProjectionMatrix() * camera->getViewMatrix()));
+      deferred_prog->set_uniform("shadowVP", shadow_camera->getProjectionMatrix() * shadow_camera->getViewMatrix());
+      bind_shadow(context);
+      deferred_prog->set_uniform("shadowMap", SHADOW_MAP_UNIT);
+      deferred_prog->set_uniform("shadowAlpha", SHADOW_ALPHA_UNIT);
+      shadow_filter->bind(deferred_prog);
+      variance_shadow_map->bind(deferred_prog);
+      clustered_lighting->bind(deferred_prog);
+      gbuffer->bind_textures(context, deferred_prog);
+
+      glDisable(GL_DEPTH_TEST);
+      screen->draw(deferred_prog);
+      glEnable(GL_DEPTH_TEST);
+
+      // 透明物体仍走前向渲染，需要不透明物体的深度
+      gbuffer->blit_depth(context, depth_copy_prog, screen, scene_framebuffer(context));
+    });
+    gbuffer->read(lighting);
+    read_shadow(lighting);
+    write_scene(lighting);
+  } else {
+    FrameGraph::PassBuilder forward = frame_graph->add_pass("forward_opaque", [&](const FrameGraph::Context &context) {
+      context.bind_framebuffer();
+      bind_shadow(context);
+      shaded_samples_query->begin();
+      if (depth_prepass) {
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+        draw_opaque_objects(default_prog, snowflake_prog, terrain_prog, skinned_prog, false);
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+      } else {
+        draw_opaque_objects(default_prog, snowflake_prog, terrain_prog, skinned_prog, true);
+      }
+    });
+    read_shadow(forward);
+    write_scene(forward);
+  }
 
-  cube_light->translate = light.position;
-  cube_light->draw(dot_light_prog, camera);
+  write_scene(frame_graph->add_pass("lights_and_skybox", [&](const FrameGraph::Context &context) {
+    context.bind_framebuffer();
+    cube_light->translate = light.position;
+    cube_light->draw(dot_light_prog, camera);
+    for (const auto &point_light : point_lights) {
+      dot_light_prog->set_light("light", point_light);
+      cube_light->translate = point_light.position;
+      cube_light->draw(dot_light_prog, camera);
+    }
+    dot_light_prog->set_light("light", light);
+
+    // 天空盒在不透明物体之后绘制，深度恒为 1，只填充未被覆盖的像素
+    skybox_prog->use();
+    glActiveTexture(GL_TEXTURE16);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, skybox_tex.id);
+    skybox_prog->set_uniform("skybox", 16);
+
+    skybox->translate = camera->position;
+    glDepthFunc(GL_LEQUAL);
+    glDepthMask(GL_FALSE);
+    skybox->draw(skybox_prog, camera);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+    shaded_samples_query->end();
+  }));
+
+  if (oit_transparency) {
+    // 加权混合 OIT：透明物体无需排序，按任意顺序提交
+    oit_buffer->declare(*frame_graph, render_size.x, render_size.y);
+    FrameGraph::PassBuilder accumulation = frame_graph->add_pass("oit_accumulation", [&](const FrameGraph::Context &context) {
+      GLuint source_depth = scene_depth == FrameGraph::BACKBUFFER ? GL_ZERO : context.get_texture(scene_depth);
+      oit_buffer->begin(context, depth_copy_prog, screen, scene_framebuffer(context), source_depth);
+      bind_shadow(context);
+      // 透明物体上完全不透明的部分先写入深度
+      glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+      draw_transparent_objects(oit_depth_prog);
+      glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+      oit_buffer->begin_accumulation();
+      glDepthFunc(GL_LEQUAL);
+      draw_transparent_objects(transparency_oit_prog);
+      glDepthFunc(GL_LESS);
+      oit_buffer->end_accumulation(scene_framebuffer(context));
+    });
+    // 深度从场景的帧缓冲拷贝而来
+    accumulation.read(scene_depth);
+    read_shadow(accumulation);
+    oit_buffer->write(accumulation);
+
+    // 合成到场景的帧缓冲
+    FrameGraph::PassBuilder resolve = frame_graph->add_pass("oit_resolve", [&](const FrameGraph::Context &context) {
+      context.bind_framebuffer();
+      oit_resolve_prog->use();
+      oit_buffer->bind_textures(context, oit_resolve_prog);
+      // 平均颜色按 1 - revealage 覆盖在不透明场景之上
+      glEnable(GL_BLEND);
+      glBlendEquation(GL_FUNC_ADD);
+      glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+      glDisable(GL_DEPTH_TEST);
+      screen->draw(oit_resolve_prog);
+      glEnable(GL_DEPTH_TEST);
+      glDisable(GL_BLEND);
+    });
+    oit_buffer->read(resolve);
+    write_scene(resolve);
+  } else {
+    FrameGraph::PassBuilder transparent = frame_graph->add_pass("transparent", [&](const FrameGraph::Context &context) {
+      context.bind_framebuffer();
+      bind_shadow(context);
+      glEnable(GL_BLEND);
+      glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+      glBlendEquation(GL_FUNC_ADD);
+
+      // 冰屋的不透明部分可能已作为遮挡体写入深度
+      glDepthFunc(GL_LEQUAL);
+      draw_transparent_objects(transparency_prog);
+      glDepthFunc(GL_LESS);
+      glDisable(GL_BLEND);
+    });
+    read_shadow(transparent);
+    write_scene(transparent);
+  }
 
+  if (scene_color != FrameGraph::BACKBUFFER) {
+    // 带锐化的双线性放大，覆盖窗口的每个像素；只为 OIT 离屏时原样拷贝
+    frame_graph->add_pass("upscale", [&](const FrameGraph::Context &context) {
+      context.bind_framebuffer();
+      upscale_prog->use();
+      dynamic_resolution->bind(upscale_prog, context.get_texture(scene_color));
+      if (!dynamic_resolution_enabled) {
+        upscale_prog->set_uniform("sharpness", 0.0f);
+      }
+      glDisable(GL_DEPTH_TEST);
+      screen->draw(upscale_prog);
+      glEnable(GL_DEPTH_TEST);
+    }).read(scene_color).write(FrameGraph::BACKBUFFER);
+  }
+  frame_graph->compile();
+
+  // 所有已创建的光照变体共享光源、相机与阴影参数
+  select_lit_programs();
+  for (const auto &[features, prog] : lit_variants->get_compiled()) {
+    prog->set_light("light", light);
+    prog->set_uniform("cameraPos", camera->position);
+    if (features & LIT_RECEIVE_SHADOW) {
+      prog->set_uniform("shadow_zNear", shadow_camera->zNear);
+      prog->set_uniform("shadow_zFar", shadow_camera->zFar);
+      prog->set_uniform("shadowVP", shadow_camera->getProjectionMatrix() * shadow_camera->getViewMatrix());
+      prog->set_uniform("shadowMap", SHADOW_MAP_UNIT);
+      prog->set_uniform("shadowAlpha", SHADOW_ALPHA_UNIT);
+      shadow_filter->bind(prog);
+      variance_shadow_map->bind(prog);
+    }
+    if (features & LIT_CLUSTERED_LIGHTS) {
+      clustered_lighting->bind(prog);
+    }
+    if (features & LIT_SKINNED) {
+      bone_palette->bind(prog);
+    }
+  }
+  for (const auto &prog : {shadow_skinned_prog, evsm_moments_skinned_prog, depth_skinned_prog, gbuffer_skinned_prog}) {
+    bone_palette->bind(prog);
+  }
 
-  default_prog->use();
-  default_prog->set_uniform("shadowVP", shadow_camera->getProjectionMatrix() * shadow_camera->getViewMatrix());
-  transparency_prog->use();
-  transparency_prog->set_uniform("shadowVP", shadow_camera->getProjectionMatrix() * shadow_camera->getViewMatrix());
+  glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+  dynamic_resolution->begin_frame();
+  frame_graph->execute();
+  dynamic_resolution->end_frame();
 
-  for (uint16_t i = 0; i < SNOWFLAKES_COUNT; ++i) {
-    snowflakes[i]->draw(default_prog, camera);
-  }
-  
-  if(first_personal){
-    snowman_firstpersonal->draw(default_prog, camera);
-  }else{
-    model->draw(default_prog, camera);
-  }
-  
-  person->draw(default_prog, camera);
-  hammer->draw(default_prog, camera);
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  glBlendEquation(GL_FUNC_ADD);
-  
-  transparency_prog->use();
-  transparency_prog->set_uniform("shadowVP", shadow_camera->getProjectionMatrix() * shadow_camera->getViewMatrix());
-  grass->draw(transparency_prog, camera);
-  mc_model->draw(transparency_prog, camera);
-  glDisable(GL_BLEND);
-  
   debug->use();
   //  glDisable(GL_DEPTH_TEST);
   //  glViewport(0, 0, windowWidth / 2, windowHeight / 2);
@@ -371,13 +1021,15 @@ void display() {
   //  glEnable(GL_DEPTH_TEST);
   //  glDisable(GL_BLEND);
 
-
-
-  anmineSnowflakes();
+  bone_palette->end_frame();
+  stream_buffer->end_frame();
 }
 
 // main
 int main(int argc, char *argv[]) {
+  if (!stress_config.parse_args(argc, argv)) {
+    return -1;
+  }
   // init glfw
   glfwInit();
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -392,17 +1044,8 @@ int main(int argc, char *argv[]) {
     glfwTerminate();
     return -1;
   }
-  glfwMakeContextCurrent(window);
-
-  // init glad
-  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-    std::cout << "Failed to initialize GLAD" << std::endl;
-    return -1;
-  }
 
   glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-  // set viewport
-  glViewport(0, 0, windowWidth, windowHeight);
   // set callback function for window size change
   glfwSetFramebufferSizeCallback(window, frambuffer_size_callback);
   glfwSetCursorPosCallback(window, mouse_move_callback);
@@ -410,81 +1053,262 @@ int main(int argc, char *argv[]) {
   glfwSetKeyCallback(window, keyboard_callback);
   glfwSetMouseButtonCallback(window, mouse_button_callback);
 
-  init();
+  // GL 上下文只在渲染线程上使用，等待其完成初始化
+  render_queue = std::make_shared<RenderQueue>();
+  std::promise<bool> render_ready;
+  std::future<bool> render_ready_future = render_ready.get_future();
+  std::thread render_thread(render_loop, window, std::ref(render_ready));
+  if (!render_ready_future.get()) {
+    render_thread.join();
+    glfwTerminate();
+    return -1;
+  }
+  init_simulation();
 
-  // loop for continuios render and event loop for window
+  // event loop for window, rendering runs on render_thread
   while (!glfwWindowShouldClose(window)) {
-    //delta time
-    //-------------------------------------
-    deltaTime = get_time_delta();
-    // user input
-    // ------------------------------------
-    processInput(window);
-    // rotate cammer
+    // event dispatch
+    // -----------------------------------
+    glfwPollEvents();
+    // build render packet
     // ------------------------------------
-    rotate_camera();
+    RenderPacket *packet = render_queue->begin_write();
+    if (packet == nullptr) {
+      break;
+    }
+    build_render_packet(*packet);
+    render_queue->end_write();
+  }
+
+  // for exit
+  render_queue->close();
+  render_thread.join();
+  simulation->stop();
+  glfwTerminate();
+  return 0;
+}
+
+// 渲染线程：持有 GL 上下文，按顺序绘制主线程提交的数据包
+void render_loop(GLFWwindow *window, std::promise<bool> &ready) {
+  glfwMakeContextCurrent(window);
+
+  // init glad
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    std::cout << "Failed to initialize GLAD" << std::endl;
+    ready.set_value(false);
+    return;
+  }
+  // set viewport
+  glViewport(0, 0, windowWidth, windowHeight);
+  backbuffer_depth_blittable = GBuffer::can_blit_depth(GL_ZERO);
+
+  ShaderProgram::enable_parallel_compile();
+  init();
+  ready.set_value(true);
+
+  while ((frame_packet = render_queue->begin_read()) != nullptr) {
+    apply_render_packet(*frame_packet);
     // render
     // ------------------------------------
     display();
-    // event dispatch and swap buffer
+    if (stress_config.enabled) {
+      report_stress_stats(frame_packet->delta_time);
+    }
+    // swap buffer
     // -----------------------------------
-    glfwPollEvents();
     glfwSwapBuffers(window);
+    render_queue->end_read();
   }
+  release_render_resources();
+  glfwMakeContextCurrent(nullptr);
+}
 
-  // for exit
-  glfwTerminate();
-  return 0;
+// 在渲染线程释放上下文之前释放网格与几何缓冲：全局对象在进程退出时于主线程析构，
+// 那时没有当前的 GL 上下文，VertexFormat 等函数内静态对象也可能已先析构
+void release_render_resources() {
+  for (auto *item : {&model, &cube_light, &skybox, &snowman_firstpersonal, &person, &mc_model, &hammer}) {
+    item->reset();
+  }
+  for (auto *items : {&snowflakes, &stress_opaque_models, &stress_transparent_models, &static_opaque_objects,
+                      &opaque_objects, &opaque_occluders, &shadow_occludees, &skinned_models}) {
+    items->clear();
+  }
+  terrain.reset();
+  screen.reset();
+  grass.reset();
+  // 包围盒网格由遮挡剔除持有
+  main_culler.reset();
+  shadow_culler.reset();
+  glDeleteTextures(1, &skybox_tex.id);
+  skybox_tex.id = GL_ZERO;
+
+  GeometryPool::shutdown();
+  VertexFormat::shutdown();
 }
 
 // callback function for window size changed
 void frambuffer_size_callback(GLFWwindow *window, int32_t width, int32_t height) {
-  windowWidth = width;
-  windowHeight = height;
-  glViewport(0, 0, width, height);
+  // 视口由渲染线程在 display 中按数据包设置
+  framebuffer_size = glm::ivec2(width, height);
   return;
 }
-// process user input
-void processInput(GLFWwindow *window) {
-  float myDeltaTime = deltaTime;
+// 模拟线程：处理一个步长内的输入
+void processInput(const InputState &input, float dt) {
   float sen = 10.0f;
-  if (keyboardState[GLFW_KEY_ESCAPE]) {
-    glfwSetWindowShouldClose(window, true);
+  // 光源移动速度，原先按每帧 0.05 调参
+  float light_sen = 3.0f;
+  if (input.keys[GLFW_KEY_W]) {
+    moveControler->move_ahead(sen, dt, sim_camera, sim_model, sim_firstpersonal);
   }
-  if (keyboardState[GLFW_KEY_W]) {
-    moveControler->move_ahead(sen, myDeltaTime, camera, model, snowman_firstpersonal);
+  if (input.keys[GLFW_KEY_S]) {
+    moveControler->move_back(sen, dt, sim_camera, sim_model, sim_firstpersonal);
   }
-  if (keyboardState[GLFW_KEY_S]) {
-    moveControler->move_back(sen, myDeltaTime, camera, model, snowman_firstpersonal);
+  if (input.keys[GLFW_KEY_A]) {
+    moveControler->move_left(sen, dt, sim_camera, sim_model, sim_firstpersonal);
   }
-  if (keyboardState[GLFW_KEY_A]) {
-    moveControler->move_left(sen, myDeltaTime, camera, model, snowman_firstpersonal);
+  if (input.keys[GLFW_KEY_D]) {
+    moveControler->move_right(sen, dt, sim_camera, sim_model, sim_firstpersonal);
+  }
+
+  if (input.keys[GLFW_KEY_R] && !first_personal)
+    sim_camera->position = MoveControler::move_sphere(sim_camera->position, {0, sen * dt, 0}, MoveControler::CAMERA_RADIUS);
+  if (input.keys[GLFW_KEY_F] && !first_personal)
+    sim_camera->position = MoveControler::move_sphere(sim_camera->position, {0, -sen * dt, 0}, MoveControler::CAMERA_RADIUS);
+
+  if (input.keys[GLFW_KEY_I]) {
+    sim_light_position.z -= light_sen * dt;
   }
-  if (keyboardState[GLFW_KEY_D]) {
-    moveControler->move_right(sen, myDeltaTime, camera, model, snowman_firstpersonal);
+  if (input.keys[GLFW_KEY_K]) {
+    sim_light_position.z += light_sen * dt;
+  }
+  if (input.keys[GLFW_KEY_J]) {
+    sim_light_position.x -= light_sen * dt;
+  }
+  if (input.keys[GLFW_KEY_L]) {
+    sim_light_position.x += light_sen * dt;
+  }
+  if (input.keys[GLFW_KEY_U])
+    sim_light_position.y += light_sen * dt;
+  if (input.keys[GLFW_KEY_H])
+    sim_light_position.y -= light_sen * dt;
+
+  for (int32_t key : input.pressed_keys) {
+    if (key == GLFW_KEY_C && !first_personal) {
+      rotate_camera_state(true);
+    }
+    if (key == GLFW_KEY_V && !first_personal) {
+      moveControler = &cammerMoveControler;
+    }
+    if (key == GLFW_KEY_B && !first_personal) {
+      moveControler = &snowmanMoveControler;
+    }
   }
 
-  if (keyboardState[GLFW_KEY_R] && !first_personal)
-    camera->position.y += sen * myDeltaTime;
-  if (keyboardState[GLFW_KEY_F] && !first_personal)
-    camera->position.y -= sen * myDeltaTime;
+  for (uint32_t i = 0; i < input.right_clicks; ++i) {
+    toggle_first_personal();
+  }
 
-  if (keyboardState[GLFW_KEY_I]) {
-    light.position.z -= 0.05f;
+  float xoffset = input.mouse_offset.x;
+  float yoffset = input.mouse_offset.y;
+  if (xoffset == 0 && yoffset == 0) {
+    return;
   }
-  if (keyboardState[GLFW_KEY_K]) {
-    light.position.z += 0.05f;
+  if (!input.left_button && !first_personal) 
+  {
+    sim_camera->yaw += xoffset;
+    sim_camera->pitch += yoffset;
+    sim_camera->pitch = glm::clamp(sim_camera->pitch, -89.0f, 89.0f);
+  }else{
+    if(first_personal){
+      sim_firstpersonal->rotate -= glm::vec3(0, xoffset, 0);
+      sim_camera->direction = snowmanMoveControler.get_model_direction(sim_firstpersonal);
+      sim_camera->position = sim_firstpersonal->translate + first_personal_camera_y + snowmanMoveControler.get_model_direction(sim_firstpersonal);
+    }else{
+      sim_model->rotate -= glm::vec3(0, xoffset, 0);
+    }
+    
   }
-  if (keyboardState[GLFW_KEY_J]) {
-    light.position.x -= 0.05f;
+}
+
+// 模拟线程：固定步长推进整个世界，并把结果写入 state
+void simulate(const InputState &input, float dt, WorldState &state) {
+  processInput(input, dt);
+  rotate_camera(dt);
+  anmineSnowflakes(sim_snowflakes, sim_random_engine, dt);
+
+  state.snowman = Transform::capture(*sim_model);
+  state.snowman_firstpersonal = Transform::capture(*sim_firstpersonal);
+  state.snowflakes = sim_snowflakes;
+  state.camera = CameraPose::capture(*sim_camera);
+  state.light_position = sim_light_position;
+  state.first_personal = first_personal;
+}
+
+// 以 init 完成后的场景作为模拟初始状态并启动模拟线程
+// 此时渲染线程在等待第一个数据包，可以安全读取场景对象
+void init_simulation() {
+  for (auto item : static_opaque_objects) {
+    static_opaque_positions.push_back(item->translate);
   }
-  if (keyboardState[GLFW_KEY_L]) {
-    light.position.x += 0.05f;
+  // 模拟线程只需要变换，用不带网格的空模型承载
+  sim_model = std::make_shared<Model>();
+  Transform::capture(*model).apply(*sim_model);
+  sim_firstpersonal = std::make_shared<Model>();
+  Transform::capture(*snowman_firstpersonal).apply(*sim_firstpersonal);
+  sim_camera = std::make_shared<Camera>(*camera);
+  sim_light_position = light.position;
+  sim_snowflakes.clear();
+  for (auto item : snowflakes) {
+    sim_snowflakes.push_back(Transform::capture(*item));
+  }
+  sim_random_engine.seed(random_engine());
+
+  simulation = std::make_shared<Simulation>(simulate);
+  WorldState initial;
+  simulate(InputState(), 0, initial);
+  simulation->start(initial);
+}
+
+// 主线程：收集本帧渲染需要的全部数据
+void build_render_packet(RenderPacket &packet) {
+  packet.frame = frame_count++;
+  packet.delta_time = get_time_delta();
+  packet.width = framebuffer_size.x;
+  packet.height = framebuffer_size.y;
+  packet.settings = render_settings;
+  simulation->interpolate(packet.world);
+  sort_opaque_objects(packet.world, packet.opaque_order);
+}
+
+// 渲染线程：把数据包写回用于绘制的对象
+void apply_render_packet(const RenderPacket &packet) {
+  windowWidth = packet.width;
+  windowHeight = packet.height;
+  deferred_shading = packet.settings.deferred_shading;
+  depth_prepass = packet.settings.depth_prepass;
+  oit_transparency = packet.settings.oit_transparency;
+  dynamic_resolution_enabled = packet.settings.dynamic_resolution;
+  occlusion_mode = packet.settings.occlusion;
+  shadow_filter->tier = packet.settings.shadow_tier;
+
+  const WorldState &world = packet.world;
+  world.snowman.apply(*model);
+  world.snowman_firstpersonal.apply(*snowman_firstpersonal);
+  world.camera.apply(*camera);
+  light.position = world.light_position;
+  for (uint32_t i = 0; i < snowflakes.size() && i < world.snowflakes.size(); ++i) {
+    world.snowflakes[i].apply(*snowflakes[i]);
+  }
+
+  opaque_objects.clear();
+  opaque_occluders.clear();
+  for (uint32_t index : packet.opaque_order) {
+    if (index == 0) {
+      opaque_occluders.push_back(world.first_personal ? snowman_firstpersonal : model);
+    } else {
+      opaque_objects.push_back(static_opaque_objects[index - 1]);
+    }
   }
-  if (keyboardState[GLFW_KEY_U])
-    light.position.y += 0.05f;
-  if (keyboardState[GLFW_KEY_H])
-    light.position.y -= 0.05f;
 }
 
 void mouse_move_callback(GLFWwindow *window, double x, double y) {
@@ -500,73 +1324,90 @@ void mouse_move_callback(GLFWwindow *window, double x, double y) {
   xoffset *= sensitivity;
   yoffset *= sensitivity;
 
-  if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_RELEASE && !first_personal) 
-  {
-    camera->yaw += xoffset;
-    camera->pitch += yoffset;
-    camera->pitch = glm::clamp(camera->pitch, -89.0f, 89.0f);
-  }else{
-    if(first_personal){
-      snowman_firstpersonal->rotate -= glm::vec3(0, xoffset, 0);
-      camera->direction = snowmanMoveControler.get_model_direction(snowman_firstpersonal);
-      camera->position = snowman_firstpersonal->translate + first_personal_camera_y + snowmanMoveControler.get_model_direction(snowman_firstpersonal);
-    }else{
-      model->rotate -= glm::vec3(0, xoffset, 0);
-    }
-    
-  }
-  
-
+  bool left_button = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+  simulation->update_input([&](InputState &input) {
+    input.mouse_offset += glm::vec2(xoffset, yoffset);
+    input.left_button = left_button;
+  });
 }
 
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset) {}
 
 void keyboard_callback(GLFWwindow *window, int32_t key, int32_t scancode, int32_t action, int32_t mods) {
-  keyboardState[key] = (action == GLFW_PRESS || action == GLFW_REPEAT) ? true : false;
+  if (key < 0 || key >= 1024) {
+    return;
+  }
+  simulation->update_input([&](InputState &input) {
+    input.keys[key] = (action == GLFW_PRESS || action == GLFW_REPEAT) ? true : false;
+    if (action == GLFW_PRESS) {
+      input.pressed_keys.push_back(key);
+    }
+  });
 
-  if (key == GLFW_KEY_C && action == GLFW_PRESS && !first_personal) {
-    rotate_camera_state(true);
+  if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
+    glfwSetWindowShouldClose(window, true);
   }
-  if (key == GLFW_KEY_V && action == GLFW_PRESS && !first_personal) {
-    moveControler = &cammerMoveControler;
+  if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+    render_settings.shadow_tier = ShadowFilter::next_tier(render_settings.shadow_tier);
+    std::cout << "[RENDER] shadow filter: " << ShadowFilter::tier_name(render_settings.shadow_tier) << std::endl;
   }
-  if (key == GLFW_KEY_B && action == GLFW_PRESS && !first_personal) {
-    moveControler = &snowmanMoveControler;
+  if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+    render_settings.oit_transparency = !render_settings.oit_transparency;
+    std::cout << "[RENDER] order independent transparency " << (render_settings.oit_transparency ? "on" : "off") << std::endl;
+  }
+  if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+    render_settings.depth_prepass = !render_settings.depth_prepass;
+    std::cout << "[RENDER] depth pre-pass " << (render_settings.depth_prepass ? "on" : "off") << std::endl;
+  }
+  if (key == GLFW_KEY_G && action == GLFW_PRESS) {
+    render_settings.deferred_shading = !render_settings.deferred_shading;
+    std::cout << "[RENDER] " << (render_settings.deferred_shading ? "deferred" : "forward") << " shading" << std::endl;
+  }
+  if (key == GLFW_KEY_Z && action == GLFW_PRESS) {
+    render_settings.dynamic_resolution = !render_settings.dynamic_resolution;
+    std::cout << "[RENDER] dynamic resolution " << (render_settings.dynamic_resolution ? "on" : "off") << std::endl;
+  }
+  if (key == GLFW_KEY_X && action == GLFW_PRESS) {
+    render_settings.occlusion = RenderSettings::OcclusionMode((render_settings.occlusion + 1) % 3);
+    const char *names[] = {"off", "GPU queries", SoftwareRaster::avx2_supported() ? "software (AVX2)" : "software"};
+    std::cout << "[RENDER] occlusion culling: " << names[render_settings.occlusion] << std::endl;
   }
 }
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods){
   if(button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS){
-    first_personal = !first_personal;
-    if(first_personal){
-      snowman_firstpersonal->translate = model->translate;
-      snowman_firstpersonal->rotate = model->rotate;
-      history_location = camera->position;
-      camera->mode = camera->mode & ~Camera::EulerAngle;
-      camera->position = snowman_firstpersonal->translate + first_personal_camera_y + snowmanMoveControler.get_model_direction(snowman_firstpersonal);
-      camera->direction = snowmanMoveControler.get_model_direction(snowman_firstpersonal);
-
-      moveControler = &firstPersonalMoveControler;
-    }else{
-      model->translate = snowman_firstpersonal->translate;
-      model->rotate = snowman_firstpersonal->rotate;
-      camera->mode = camera->mode | Camera::EulerAngle;
-      camera->position = history_location;
+    simulation->update_input([](InputState &input) { ++input.right_clicks; });
+  }
+}
+// 模拟线程：切换第一人称
+void toggle_first_personal() {
+  first_personal = !first_personal;
+  if(first_personal){
+    sim_firstpersonal->translate = sim_model->translate;
+    sim_firstpersonal->rotate = sim_model->rotate;
+    history_location = sim_camera->position;
+    sim_camera->mode = sim_camera->mode & ~Camera::EulerAngle;
+    sim_camera->position = sim_firstpersonal->translate + first_personal_camera_y + snowmanMoveControler.get_model_direction(sim_firstpersonal);
+    sim_camera->direction = snowmanMoveControler.get_model_direction(sim_firstpersonal);
+
+    moveControler = &firstPersonalMoveControler;
+  }else{
+    sim_model->translate = sim_firstpersonal->translate;
+    sim_model->rotate = sim_firstpersonal->rotate;
+    sim_camera->mode = sim_camera->mode | Camera::EulerAngle;
+    sim_camera->position = history_location;
 
-      moveControler = &snowmanMoveControler;
+    moveControler = &snowmanMoveControler;
 
-    }
-    
-    
   }
 }
-void rotate_camera() {
+void rotate_camera(float dt) {
 
   if (rotate_camera_state(false)) {
-    float myDeltaTime = deltaTime;
+    float myDeltaTime = dt;
     float sen = 1;
     float speed = sen * myDeltaTime * 10;
     float pointx = 0.0, pointz = 0.0;
-    glm::vec3 old_position = camera->position;
+    glm::vec3 old_position = sim_camera->position;
     float old_position_x = old_position.x;
     float old_position_z = old_position.z;
 
@@ -595,8 +1436,8 @@ void rotate_camera() {
     float new_position_x = old_position_x + delx;
     float new_position_z = old_position_z + delz;
 
-    camera->position.x = new_position_x;
-    camera->position.z = new_position_z;
+    sim_camera->position.x = new_position_x;
+    sim_camera->position.z = new_position_z;
   }
 }
 bool rotate_camera_state(bool is_change) {
@@ -607,6 +1448,46 @@ bool rotate_camera_state(bool is_change) {
   return state;
 }
 
+// 压力测试模式下按间隔输出平均帧时间，便于绘制 帧时间-规模 曲线
+void report_stress_stats(float deltaTime) {
+  static float elapsed = 0;
+  static uint32_t frames = 0;
+  elapsed += deltaTime;
+  ++frames;
+  if (elapsed < stress_config.report_interval) {
+    return;
+  }
+  std::cout << "[STRESS] copies=" << stress_config.copies << " snowflakes=" << snowflakes.size()
+            << " lights=" << point_lights.size() << " triangles=" << scene_triangles
+            << " shaded_samples=" << shaded_samples_query->get_result()
+            << " stream_kb=" << stream_buffer->get_stats().bytes_streamed / 1024
+            << " fence_stalls=" << stream_buffer->get_stats().fence_stalls
+            << " occlusion_tests=" << main_culler->get_stats().tested << "/" << shadow_culler->get_stats().tested
+            << " occluded=" << main_culler->get_stats().occluded << "/" << shadow_culler->get_stats().occluded
+            << " occlusion_nested=" << main_culler->get_stats().nested + shadow_culler->get_stats().nested
+            << " sw_culled=" << main_software_occlusion->get_stats().culled << "/"
+            << shadow_software_occlusion->get_stats().culled
+            << " sw_raster_ms=" << main_software_occlusion->get_stats().raster_ms + shadow_software_occlusion->get_stats().raster_ms
+            << " terrain_chunks=" << terrain->get_stats().drawn << "/" << terrain->get_stats().resident
+            << " terrain_triangles=" << terrain->get_stats().triangles
+            << " passes=" << frame_graph->get_stats().passes - frame_graph->get_stats().culled << "/"
+            << frame_graph->get_stats().passes
+            << " rt_mb=" << frame_graph->get_stats().allocated_bytes / (1024 * 1024) << "/"
+            << frame_graph->get_stats().requested_bytes / (1024 * 1024)
+            << " rt_pool_mb=" << render_target_pool->get_stats().bytes / (1024 * 1024)
+            << " render_scale=" << (dynamic_resolution_enabled ? dynamic_resolution->get_scale() : 1.0f)
+            << " gpu_ms=" << dynamic_resolution->get_gpu_ms()
+            << " tex_resident_mb=" << texture_streamer->get_stats().resident_bytes / (1024 * 1024)
+            << " tex_upload_kb=" << texture_streamer->get_stats().uploaded_bytes / 1024
+            << " tex_pending=" << texture_streamer->get_stats().pending_decodes
+            << " skinned=" << bone_palette->get_stats().animators << " bones=" << bone_palette->get_stats().bones
+            << " pose_ms=" << bone_palette->get_stats().evaluate_ms
+            << " tex_evicted=" << texture_streamer->get_stats().evicted_levels
+            << " frame_ms=" << elapsed * 1000 / frames << std::endl;
+  elapsed = 0;
+  frames = 0;
+}
+
 float get_time_delta(){
   static float last_frame = glfwGetTime();
   float current_frame = glfwGetTime();
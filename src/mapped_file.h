@@ -0,0 +1,29 @@
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+// 只读内存映射的文件，映射失败时 data 为 nullptr
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &file_path) noexcept;
+  MappedFile(const MappedFile &oth) = delete;
+  MappedFile &operator=(const MappedFile &oth) = delete;
+  ~MappedFile();
+
+  const uint8_t *get_data() const noexcept { return data; }
+  size_t get_size() const noexcept { return size; }
+
+private:
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+#ifdef _WIN32
+  void *file = nullptr;
+  void *mapping = nullptr;
+#endif
+};
+
+#endif  // !__MAPPED_FILE_H__
@@ -1,7 +1,6 @@
 #include "mesh.h"
 
 #include <glm/gtc/matrix_transform.hpp>
-#include <stb_image.h>
 
 #include <ctime>
 #include <iostream>
@@ -9,6 +8,7 @@
 
 
 #include "utils.h"
+#include "vertex_format.h"
 
 
 struct VertexInner {
@@ -31,26 +31,74 @@ Texture::Texture(
   const std::string &path, Texture::Type type, bool need_vFlip, GLenum wrapMode, GLenum magFilterMode, GLenum minFilterMode) {
   this->path = path;
   this->type = type;
-  stbi_set_flip_vertically_on_load_thread(need_vFlip);
-  this->id = Texture2DFromFile(path, wrapMode, magFilterMode, minFilterMode);
-  stbi_set_flip_vertically_on_load_thread(false);
+  this->id = Texture2DFromFile(path, wrapMode, magFilterMode, minFilterMode, need_vFlip);
 }
 
-Mesh::Mesh(const std::vector<Vertex> &vertices, const std::vector<GLuint> &indices, const std::vector<Texture::Ptr> &textures) {
+void VertexSkin::add(uint16_t bone, float weight) noexcept {
+  if (weight <= 0.0f) {
+    return;
+  }
+  // 替换权重最小的一个
+  uint32_t slot = 0;
+  for (uint32_t i = 1; i < 4; ++i) {
+    if (weights[i] < weights[slot]) {
+      slot = i;
+    }
+  }
+  if (weight > weights[slot]) {
+    bones[slot] = bone;
+    weights[slot] = weight;
+  }
+}
+
+void VertexSkin::normalize() noexcept {
+  float sum = weights[0] + weights[1] + weights[2] + weights[3];
+  if (sum <= 0.0f) {
+    bones[0] = 0;
+    weights[0] = 1.0f;
+    return;
+  }
+  for (uint32_t i = 0; i < 4; ++i) {
+    weights[i] /= sum;
+  }
+}
+
+Mesh::Mesh(const std::vector<Vertex> &vertices,
+           const std::vector<GLuint> &indices,
+           const std::vector<Texture::Ptr> &textures,
+           const std::vector<VertexSkin> &skin) {
   // 赋值
   this->vertices = vertices;
   this->indices = indices;
   this->textures = textures;
+  this->skin = skin;
 
 
   setup();
 }
 
+Mesh::Mesh(std::vector<Vertex> &&vertices,
+           std::vector<GLuint> &&indices,
+           const std::vector<Texture::Ptr> &textures,
+           const std::vector<float> &interleaved,
+           GLuint texcoords_layers) {
+  this->vertices = std::move(vertices);
+  this->indices = std::move(indices);
+  this->textures = textures;
+  this->texcoords_layers = texcoords_layers;
+
+  this->geometry = GeometryPool::get(this->texcoords_layers)
+                     ->allocate(interleaved.data(), this->vertices.size(), this->indices.data(), this->indices.size());
+  this->has_setup = true;
+}
+
 Mesh::Mesh(const Mesh &oth) {
   // 基础属性
   this->vertices = oth.vertices;
   this->indices = oth.indices;
   this->textures = oth.textures;
+  this->skin = oth.skin;
+  this->opaque = oth.opaque;
 
   this->translate = oth.translate;
   this->rotate = oth.rotate;
@@ -58,9 +106,8 @@ Mesh::Mesh(const Mesh &oth) {
 
   this->texcoords_layers = oth.texcoords_layers;
   this->has_setup = oth.has_setup;
-  this->vao = oth.vao;
-  this->vbo = oth.vbo;
-  this->ebo = oth.ebo;
+  this->geometry = oth.geometry;
+  this->bvh = oth.bvh;
 
   setup();
 }
@@ -69,6 +116,8 @@ Mesh::Mesh(Mesh &&oth) {
   this->vertices = std::move(oth.vertices);
   this->indices = std::move(oth.indices);
   this->textures = std::move(oth.textures);
+  this->skin = std::move(oth.skin);
+  this->opaque = oth.opaque;
 
   this->translate = std::move(oth.translate);
   this->rotate = std::move(oth.rotate);
@@ -76,19 +125,11 @@ Mesh::Mesh(Mesh &&oth) {
 
   this->texcoords_layers = oth.texcoords_layers;
   oth.texcoords_layers = 0;
-  this->current_shader = oth.current_shader;
-  oth.current_shader = 0;
 
   this->has_setup = oth.has_setup;
-  this->shader_vao_map = std::move(oth.shader_vao_map);
-  oth.shader_vao_map.clear();
 
-  this->vao = oth.vao;
-  oth.vao = GL_ZERO;
-  this->vbo = oth.vbo;
-  oth.vbo.reset();
-  this->ebo = oth.ebo;
-  oth.ebo.reset();
+  this->geometry = std::move(oth.geometry);
+  this->bvh = std::move(oth.bvh);
 
   setup();
 }
@@ -97,6 +138,8 @@ Mesh &Mesh::operator=(const Mesh &oth) noexcept {
   this->vertices = oth.vertices;
   this->indices = oth.indices;
   this->textures = oth.textures;
+  this->skin = oth.skin;
+  this->opaque = oth.opaque;
 
   this->translate = oth.translate;
   this->rotate = oth.rotate;
@@ -104,9 +147,8 @@ Mesh &Mesh::operator=(const Mesh &oth) noexcept {
 
   this->texcoords_layers = oth.texcoords_layers;
   this->has_setup = oth.has_setup;
-  this->vao = oth.vao;
-  this->vbo = oth.vbo;
-  this->ebo = oth.ebo;
+  this->geometry = oth.geometry;
+  this->bvh = oth.bvh;
 
   setup();
   return (*this);
@@ -115,6 +157,8 @@ Mesh &Mesh::operator=(Mesh &&oth) noexcept {
   this->vertices = std::move(oth.vertices);
   this->indices = std::move(oth.indices);
   this->textures = std::move(oth.textures);
+  this->skin = std::move(oth.skin);
+  this->opaque = oth.opaque;
 
   this->translate = std::move(oth.translate);
   this->rotate = std::move(oth.rotate);
@@ -122,30 +166,18 @@ Mesh &Mesh::operator=(Mesh &&oth) noexcept {
 
   this->texcoords_layers = oth.texcoords_layers;
   oth.texcoords_layers = 0;
-  this->current_shader = oth.current_shader;
-  oth.current_shader = 0;
 
   this->has_setup = oth.has_setup;
-  this->shader_vao_map = std::move(oth.shader_vao_map);
-  oth.shader_vao_map.clear();
 
-  this->vao = oth.vao;
-  oth.vao = GL_ZERO;
-  this->vbo = oth.vbo;
-  oth.vbo.reset();
-  this->ebo = oth.ebo;
-  oth.ebo.reset();
+  this->geometry = std::move(oth.geometry);
+  this->bvh = std::move(oth.bvh);
 
   setup();
   return (*this);
 }
 Mesh::~Mesh() {
-  // 释放缓冲对象
-  std::vector<GLuint> VAOs;
-  for (const auto &i : shader_vao_map) {
-    VAOs.push_back(i.second);
-  }
-  glDeleteBuffers(VAOs.size(), VAOs.data());
+  // 缓冲属于 GeometryPool，VAO 属于 VertexFormat，这里不删除任何 GL 对象；
+  // geometry 的最后一个持有者析构时归还占用的区间
 }
 
 void Mesh::setup() noexcept {
@@ -164,19 +196,11 @@ void Mesh::setup() noexcept {
     }
   }
 
-  // 对于VBO指针的解析需要着色器对象，需要在draw call时进行
-  // 同时要进行记忆, 所以将其和VAO的绑定将移动至draw call前进行
-  this->vbo = std::make_shared<VBO>();
-  this->ebo = std::make_shared<EBO>();
-
-  /*--------------------EBO----------------------------*/
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo->id);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-  /*--------------------VBO----------------------------*/
-  glBindBuffer(GL_ARRAY_BUFFER, vbo->id);
-  // 申请缓冲空间
-  GLuint perVertexSize = sizeof(VertexInner) + sizeof(glm::vec2) * this->texcoords_layers;
+  // 顶点与索引放入同一顶点格式共享的缓冲池，VAO 按顶点格式共享
+  bool skinned = this->skin.size() == this->vertices.size() && !this->skin.empty();
+  GLuint format = this->texcoords_layers | (skinned ? VertexFormat::SKINNED : 0);
+  GLuint perVertexSize = VertexFormat::vertex_size(format);
+  GLuint skinOffset = VertexFormat::skin_offset(format);
   // 将位置信息加入到缓冲中
   // 1.构建传输用数组 [unsafe]
   unsigned char *inner_data = (unsigned char *)malloc(perVertexSize * this->vertices.size());
@@ -194,90 +218,30 @@ void Mesh::setup() noexcept {
 #else
     memcpy(ptr->TexCoords, this->vertices[i].TexCoords.data(), sizeof(glm::vec2) * this->texcoords_layers);
 #endif
+    if (skinned) {
+      // 骨骼下标与量化为 uint16 的权重
+      uint16_t *skin_ptr = (uint16_t *)((unsigned char *)ptr + skinOffset);
+      for (int j = 0; j < 4; ++j) {
+        skin_ptr[j] = this->skin[i].bones[j];
+        skin_ptr[4 + j] = (uint16_t)(glm::clamp(this->skin[i].weights[j], 0.0f, 1.0f) * 65535.0f + 0.5f);
+      }
+    }
   }
 
-  // 3.从内存空间将数据发送到GPU buffer
-  glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * perVertexSize, inner_data, GL_STATIC_DRAW);
+  // 3.从内存空间将数据发送到缓冲池
+  this->geometry = GeometryPool::get(format)
+                     ->allocate(inner_data, this->vertices.size(), this->indices.data(), this->indices.size());
   // 5.finish
   free(inner_data);
 
-  glBindBuffer(GL_ARRAY_BUFFER, GL_ZERO);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_ZERO);
   this->has_setup = true;
 }
 
-void Mesh::prepare_draw(ShaderProgram::Ptr shader) noexcept {
-  // O(1) check
-  if (shader->get_id() == this->current_shader) {
-    return;
-  }
-  // 切换为指定的shader
-  this->current_shader = shader->get_id();
-  // 查找是否已经生成VAO
-  if (shader_vao_map.find(current_shader) != shader_vao_map.end()) {
-    this->vao = shader_vao_map.find(current_shader)->second;
-    return;
-  }
-
-  // 如果未找到对应的VAO，则需要生成
-  glGenVertexArrays(1, &(this->vao));
-  shader_vao_map.insert({current_shader, this->vao});
-  // 进行VBO 和 EBO的绑定
-  glBindVertexArray(this->vao);
-
-  /*-----VBO-------*/
-  glBindBuffer(GL_ARRAY_BUFFER, this->vbo->id);
-  // 绑定指针
-  GLint location = -1;
-  GLuint perVertexSize = sizeof(VertexInner) + sizeof(glm::vec2) * this->texcoords_layers;
-  // 顶点位置
-  location = glGetAttribLocation(current_shader, shader_postion_in.c_str());
-  if (location >= 0) {
-    glEnableVertexAttribArray(location);
-    glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, perVertexSize, (GLvoid *)0);
-  }
-  // 法线向量
-  location = glGetAttribLocation(current_shader, shader_normal_in.c_str());
-  if (location >= 0) {
-    glEnableVertexAttribArray(location);
-    glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, perVertexSize, (GLvoid *)offsetof(VertexInner, Normal));
-  }
-
-  // 纹理坐标
-  for (GLuint i = 0; i < this->texcoords_layers; ++i) {
-    std::string shader_texcoord_in = shader_texcoord_prefix_in + std::to_string(i);
-    location = glGetAttribLocation(current_shader, shader_texcoord_in.c_str());
-    if (location >= 0) {
-      glEnableVertexAttribArray(location);
-      glVertexAttribPointer(
-        location, 2, GL_FLOAT, GL_FALSE, perVertexSize, (GLvoid *)(sizeof(glm::vec2) * i + offsetof(VertexInner, TexCoords)));
-    }
-  }
-
-  /*-----EBO-------*/
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo->id);
-
-  glBindVertexArray(GL_ZERO);
-  glBindBuffer(GL_ARRAY_BUFFER, GL_ZERO);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_ZERO);
-}
-
 void Mesh::draw(ShaderProgram::Ptr shader, Camera::Ptr camera) noexcept {
   shader->use();
-  prepare_draw(shader);
   if (camera != nullptr) {
     // 传模型矩阵
-    glm::mat4 unit(1.0f);  // 单位矩阵
-    glm::mat4 scale = glm::scale(unit, this->scale);
-    glm::mat4 translate = glm::translate(unit, this->translate);
-
-    glm::mat4 rotate = unit;  // 旋转
-    rotate = glm::rotate(rotate, glm::radians(this->rotate.x), glm::vec3(1, 0, 0));
-    rotate = glm::rotate(rotate, glm::radians(this->rotate.y), glm::vec3(0, 1, 0));
-    rotate = glm::rotate(rotate, glm::radians(this->rotate.z), glm::vec3(0, 0, 1));
-
-    // 模型变换矩阵
-    glm::mat4 model = translate * rotate * scale;
+    glm::mat4 model = get_model_matrix();
     shader->set_uniform("model", model);
 
     // 计算模型矩阵逆矩阵的转置
@@ -287,7 +251,78 @@ void Mesh::draw(ShaderProgram::Ptr shader, Camera::Ptr camera) noexcept {
     shader->set_uniform("view", camera->getViewMatrix());
     shader->set_uniform("projection", camera->getProjectionMatrix());
   }
+  bind_textures(shader);
+
+  // 绘制mesh，属性位置固定，VAO 与程序无关
+  geometry->block->bind();
+  glDrawElementsBaseVertex(
+    GL_TRIANGLES, geometry->indices.count, GL_UNSIGNED_INT, geometry->index_pointer(), geometry->vertices.offset);
+  glBindVertexArray(GL_ZERO);
+  glBindTexture(GL_TEXTURE_2D, GL_ZERO);
+}
 
+void Mesh::draw_multi(ShaderProgram::Ptr shader, Mesh *meshes, GLsizei count) noexcept {
+  Mesh &first = meshes[0];
+  shader->use();
+  first.bind_textures(shader);
+
+  std::vector<GLsizei> counts(count);
+  std::vector<const GLvoid *> offsets(count);
+  std::vector<GLint> base_vertices(count);
+  for (GLsizei i = 0; i < count; ++i) {
+    counts[i] = meshes[i].geometry->indices.count;
+    offsets[i] = meshes[i].geometry->index_pointer();
+    base_vertices[i] = meshes[i].geometry->vertices.offset;
+  }
+
+  first.geometry->block->bind();
+  glMultiDrawElementsBaseVertex(
+    GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, (const GLvoid *const *)offsets.data(), count, base_vertices.data());
+  glBindVertexArray(GL_ZERO);
+  glBindTexture(GL_TEXTURE_2D, GL_ZERO);
+}
+
+bool Mesh::can_batch(const Mesh &oth) const noexcept {
+  if (geometry == nullptr || oth.geometry == nullptr || geometry->block != oth.geometry->block) {
+    return false;
+  }
+  if (textures.size() != oth.textures.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < textures.size(); ++i) {
+    if (textures[i] != oth.textures[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Mesh::draw_instanced(ShaderProgram::Ptr shader, GLuint instance_buffer, GLintptr offset, GLsizei count) noexcept {
+  shader->use();
+  bind_textures(shader);
+
+  geometry->block->bind();
+  // 实例数据每帧位于流式缓冲的不同位置，每次绘制重新指定；VAO 为同格式网格共享，绘制后关闭
+  glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+  for (GLuint column = 0; column < 4; ++column) {
+    GLuint location = AttribLocation::INSTANCE_MODEL + column;
+    glEnableVertexAttribArray(location);
+    glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (GLvoid *)(offset + sizeof(glm::vec4) * column));
+    glVertexAttribDivisor(location, 1);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, GL_ZERO);
+  glDrawElementsInstancedBaseVertex(GL_TRIANGLES, geometry->indices.count, GL_UNSIGNED_INT, geometry->index_pointer(), count,
+                                    geometry->vertices.offset);
+  for (GLuint column = 0; column < 4; ++column) {
+    glDisableVertexAttribArray(AttribLocation::INSTANCE_MODEL + column);
+  }
+  glBindVertexArray(GL_ZERO);
+  glBindTexture(GL_TEXTURE_2D, GL_ZERO);
+}
+
+void Mesh::bind_textures(ShaderProgram::Ptr shader) noexcept { bind_textures(shader, textures); }
+
+void Mesh::bind_textures(ShaderProgram::Ptr shader, const std::vector<Texture::Ptr> &textures) noexcept {
   GLuint diffuseNr = 0;
   GLuint specularNr = 0;
   GLuint shadowNr = 0;
@@ -316,12 +351,31 @@ void Mesh::draw(ShaderProgram::Ptr shader, Camera::Ptr camera) noexcept {
     shader->set_uniform(prefix + name + number, i);
   }
   glActiveTexture(GL_TEXTURE0);
-
-  // 绘制mesh
-  glBindVertexArray(vao);
-  glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-  glBindVertexArray(GL_ZERO);
-  glBindTexture(GL_TEXTURE_2D, GL_ZERO);
 }
 
 void Mesh::add_texture(Texture::Ptr texture) noexcept { textures.push_back(texture); }
+
+glm::mat4 Mesh::get_model_matrix() const noexcept {
+  glm::mat4 unit(1.0f);  // 单位矩阵
+  glm::mat4 scale = glm::scale(unit, this->scale);
+  glm::mat4 translate = glm::translate(unit, this->translate);
+
+  glm::mat4 rotate = unit;  // 旋转
+  rotate = glm::rotate(rotate, glm::radians(this->rotate.x), glm::vec3(1, 0, 0));
+  rotate = glm::rotate(rotate, glm::radians(this->rotate.y), glm::vec3(0, 1, 0));
+  rotate = glm::rotate(rotate, glm::radians(this->rotate.z), glm::vec3(0, 0, 1));
+
+  return translate * rotate * scale;
+}
+
+void Mesh::build_bvh() noexcept {
+  if (bvh != nullptr) {
+    return;
+  }
+  std::vector<glm::vec3> positions;
+  positions.reserve(vertices.size());
+  for (const auto &vertex : vertices) {
+    positions.push_back(vertex.Position);
+  }
+  bvh = std::make_shared<const MeshBvh>(positions, indices);
+}
@@ -4,17 +4,24 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <stdint.h>
+
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "bvh.h"
 #include "camera.h"
+#include "geometry_pool.h"
 #include "shader.h"
 
 
 const static std::string shader_postion_in = "position";
 const static std::string shader_normal_in = "normal";
 const static std::string shader_texcoord_prefix_in = "texcoord";
+const static std::string shader_instance_model_in = "instanceModel";
+const static std::string shader_bone_indices_in = "boneIndices";
+const static std::string shader_bone_weights_in = "boneWeights";
 
 /** 顶点
  * 为了解决一个顶点多个纹理坐标的问题，现在约定:
@@ -35,6 +42,19 @@ struct Vertex {
   }
 };
 
+/** 顶点的蒙皮数据
+ * 最多受 4 根骨骼影响，下标指向 Skeleton 中的骨骼，权重之和为 1
+ */
+struct VertexSkin {
+  uint16_t bones[4] = {0, 0, 0, 0};
+  float weights[4] = {0, 0, 0, 0};
+
+  // 保留权重最大的 4 根骨骼
+  void add(uint16_t bone, float weight) noexcept;
+  // 归一化权重，没有任何骨骼时完全跟随 0 号骨骼
+  void normalize() noexcept;
+};
+
 /** 材质
  * 对于着色器中材质变量的命名方式为
  * 漫反射纹理：textures.diffuseN; N >= 0;
@@ -55,29 +75,10 @@ struct Texture {
           GLenum magFilterMode = GL_LINEAR,
           GLenum minFilterMode = GL_LINEAR_MIPMAP_LINEAR);
   ~Texture() {
-    GLuint *p = &(this->id);
-    glDeleteTextures(1, p);
-  }
-};
-
-struct VBO {
-  typedef std::shared_ptr<VBO> Ptr;
-  GLuint id = GL_ZERO;
-  VBO() { glGenBuffers(1, &id); }
-  ~VBO() {
-    if (id != GL_ZERO)
-      glDeleteBuffers(1, &id);
-  }
-};
-
-struct EBO {
-  typedef std::shared_ptr<EBO> Ptr;
-  GLuint id = GL_ZERO;
-  EBO() { glGenBuffers(1, &id); }
-
-  ~EBO() {
-    if (id != GL_ZERO)
-      glDeleteBuffers(1, &id);
+    // 渲染线程退出前已删除的纹理 id 为 0，不再调用 GL
+    if (this->id != GL_ZERO) {
+      glDeleteTextures(1, &(this->id));
+    }
   }
 };
 
@@ -86,7 +87,17 @@ public:
   typedef std::shared_ptr<Mesh> Ptr;
   // 方法
   Mesh(){};
-  Mesh(const std::vector<Vertex> &vertices, const std::vector<GLuint> &indices, const std::vector<Texture::Ptr> &textures);
+  // skin 非空时须与 vertices 一一对应，网格以蒙皮顶点格式上传
+  Mesh(const std::vector<Vertex> &vertices,
+       const std::vector<GLuint> &indices,
+       const std::vector<Texture::Ptr> &textures,
+       const std::vector<VertexSkin> &skin = {});
+  // interleaved 已是 texcoords_layers 层纹理坐标的 GPU 顶点布局时直接上传，省去 setup 中的逐顶点拷贝
+  Mesh(std::vector<Vertex> &&vertices,
+       std::vector<GLuint> &&indices,
+       const std::vector<Texture::Ptr> &textures,
+       const std::vector<float> &interleaved,
+       GLuint texcoords_layers);
   Mesh(const Mesh &oth);
   Mesh(Mesh &&oth);
   Mesh &operator=(const Mesh &oth) noexcept;
@@ -95,34 +106,49 @@ public:
 
   void setup() noexcept;
   void draw(ShaderProgram::Ptr shader, Camera::Ptr camera = nullptr) noexcept;
+  // 实例化绘制，instance_buffer 的 offset 处为 count 个逐实例的 mat4 模型矩阵
+  void draw_instanced(ShaderProgram::Ptr shader, GLuint instance_buffer, GLintptr offset, GLsizei count) noexcept;
+  // 连续 count 个网格以一次 glMultiDrawElementsBaseVertex 绘制，要求 can_batch 成立，使用第一个网格的纹理
+  static void draw_multi(ShaderProgram::Ptr shader, Mesh *meshes, GLsizei count) noexcept;
+  // 位于同一缓冲块且纹理相同的网格可以合并绘制
+  bool can_batch(const Mesh &oth) const noexcept;
+  bool is_skinned() const noexcept { return !skin.empty(); }
 
   void add_texture(Texture::Ptr texture) noexcept;
+  // 按上面的命名规则把 textures 依次绑定到 0 号起的纹理单元，地形等自行提交绘制的对象也使用
+  static void bind_textures(ShaderProgram::Ptr shader, const std::vector<Texture::Ptr> &textures) noexcept;
+
+  // 由 translate / rotate / scale 得到的变换矩阵，单独绘制的网格使用
+  glm::mat4 get_model_matrix() const noexcept;
+
+  // 构建模型空间的三角形 BVH，已构建时直接返回；拷贝的网格共享同一份 BVH
+  void build_bvh() noexcept;
+  const MeshBvh::Ptr &get_bvh() const noexcept { return bvh; }
 
 public:
   // 基础数据
   std::vector<Vertex> vertices;        // 顶点
   std::vector<GLuint> indices;         // 索引
   std::vector<Texture::Ptr> textures;  // 材质
+  std::vector<VertexSkin> skin;        // 蒙皮数据，与 vertices 一一对应，为空时网格不随骨骼变形
+  bool opaque = true;                  // 材质没有透明度贴图，可以作为软件遮挡剔除的遮挡体
 public:
   glm::vec3 translate = glm::vec3(0, 0, 0);
   glm::vec3 rotate = glm::vec3(0, 0, 0);  // 角度制
   glm::vec3 scale = glm::vec3(1, 1, 1);
 
 private:
-  void prepare_draw(ShaderProgram::Ptr shader) noexcept;
+  void bind_textures(ShaderProgram::Ptr shader) noexcept;
 
 private:
   // 一些网格参数
   GLuint texcoords_layers = 0;  // 网格中顶点对应的纹理坐标的层数：
   bool has_setup = false;
 
-  std::unordered_map<GLuint, GLuint> shader_vao_map;
-  GLuint current_shader = GL_ZERO;
-
 private:
-  // 渲染数据
-  GLuint vao = GL_ZERO;  // 现在使用的VAO
-  VBO::Ptr vbo = nullptr;
-  EBO::Ptr ebo = nullptr;
+  // 渲染数据，缓冲由 GeometryPool 管理，VAO 按顶点格式共享
+  GeometryAllocation::Ptr geometry = nullptr;
+  // 碰撞与拾取查询用的三角形 BVH，构建后只读
+  MeshBvh::Ptr bvh = nullptr;
 };
 #endif  // !__MESH_H__
@@ -1,7 +1,10 @@
 #include "model.h"
 
 #include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <iostream>
+#include <limits>
 #include <string_view>
 
 
@@ -14,8 +17,15 @@
 
 #include <stdint.h>
 
+#include "animation_clip.h"
+#include "obj_loader.h"
+#include "texture_container.h"
 #include "utils.h"
 
+static double elapsed_ms(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
 Model::Model(const Model &oth) {
   this->translate = oth.translate;
   this->rotate = oth.rotate;
@@ -27,8 +37,13 @@ Model::Model(const Model &oth) {
 
   this->meshs = oth.meshs;
   this->texture_loaded = oth.texture_loaded;
+  this->skeleton = oth.skeleton;
+  this->animator = oth.animator != nullptr ? std::make_shared<Animator>(*oth.animator) : nullptr;
 
   this->has_loaded = oth.has_loaded;
+  this->bounds_min = oth.bounds_min;
+  this->bounds_max = oth.bounds_max;
+  this->has_bounds = oth.has_bounds;
 
   load(this->model_path, this->aiProcessFlags);
 }
@@ -45,8 +60,13 @@ Model::Model(Model &&oth) {
   oth.meshs.clear();
   this->texture_loaded = std::move(oth.texture_loaded);
   oth.texture_loaded.clear();
+  this->skeleton = std::move(oth.skeleton);
+  this->animator = std::move(oth.animator);
 
   this->has_loaded = oth.has_loaded;
+  this->bounds_min = oth.bounds_min;
+  this->bounds_max = oth.bounds_max;
+  this->has_bounds = oth.has_bounds;
 
   load(this->model_path, this->aiProcessFlags);
 }
@@ -61,8 +81,13 @@ Model &Model::operator=(const Model &oth) noexcept {
 
   this->meshs = oth.meshs;
   this->texture_loaded = oth.texture_loaded;
+  this->skeleton = oth.skeleton;
+  this->animator = oth.animator != nullptr ? std::make_shared<Animator>(*oth.animator) : nullptr;
 
   this->has_loaded = oth.has_loaded;
+  this->bounds_min = oth.bounds_min;
+  this->bounds_max = oth.bounds_max;
+  this->has_bounds = oth.has_bounds;
 
   load(this->model_path, this->aiProcessFlags);
   return (*this);
@@ -80,8 +105,13 @@ Model &Model::operator=(Model &&oth) noexcept {
   oth.meshs.clear();
   this->texture_loaded = std::move(oth.texture_loaded);
   oth.texture_loaded.clear();
+  this->skeleton = std::move(oth.skeleton);
+  this->animator = std::move(oth.animator);
 
   this->has_loaded = oth.has_loaded;
+  this->bounds_min = oth.bounds_min;
+  this->bounds_max = oth.bounds_max;
+  this->has_bounds = oth.has_bounds;
 
   load(this->model_path, this->aiProcessFlags);
   return (*this);
@@ -109,20 +139,108 @@ void Model::load(const std::string &file_path, uint32_t aiProcessFlags) {
 
   this->model_path = file_path;
   this->aiProcessFlags = aiProcessFlags;
+  this->load_stats = LoadStats();
+  root_dir = file_path.substr(0, file_path.find_last_of('/'));
+
+  // OBJ 且只要求三角化、翻转纹理坐标与生成法线时使用快速导入，其余格式或快速导入失败时使用 Assimp
+  constexpr uint32_t OBJ_FAST_PATH_FLAGS =
+    aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals | aiProcess_GenSmoothNormals;
+  std::string extension = file_path.substr(std::min(file_path.find_last_of('.'), file_path.size()));
+  std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+  bool loaded = extension == ".obj" && (aiProcessFlags & ~OBJ_FAST_PATH_FLAGS) == 0 && load_obj(file_path, aiProcessFlags);
+  if (!loaded && !load_assimp(file_path, aiProcessFlags)) {
+    return;
+  }
+  auto bvh_start = std::chrono::steady_clock::now();
+  build_mesh_bvhs();
+  load_stats.bvh_ms = elapsed_ms(bvh_start);
+  has_loaded = true;
+}
+
+bool Model::load_assimp(const std::string &file_path, uint32_t aiProcessFlags) {
+  auto import_start = std::chrono::steady_clock::now();
   Assimp::Importer importer;
   const aiScene *scene = importer.ReadFile(file_path, aiProcessFlags);
+  load_stats.import_ms = elapsed_ms(import_start);
 
   if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
     std::cout << "[ERROR::ASSIMP] Failed to load model: " << importer.GetErrorString() << std::endl;
-    return;
+    return false;
   }
 
-  root_dir = file_path.substr(0, file_path.find_last_of('/'));
+  auto process_start = std::chrono::steady_clock::now();
+  load_skeleton(file_path, scene);
   for (uint32_t i = 0; i < scene->mNumMeshes; ++i) {
     aiMesh *aimesh = scene->mMeshes[i];
     meshs.push_back(std::move(processMesh(aimesh, scene)));
   }
-  has_loaded = true;
+  // 纹理加载发生在 processMesh 内部，单独统计
+  load_stats.process_ms = elapsed_ms(process_start) - load_stats.texture_ms;
+  return true;
+}
+
+bool Model::load_obj(const std::string &file_path, uint32_t aiProcessFlags) {
+  auto import_start = std::chrono::steady_clock::now();
+  ObjLoader loader(worker_pool);
+  bool flip_uv = aiProcessFlags & aiProcess_FlipUVs;
+  bool gen_normals = aiProcessFlags & (aiProcess_GenNormals | aiProcess_GenSmoothNormals);
+  if (!loader.load(file_path, flip_uv, gen_normals)) {
+    return false;
+  }
+  load_stats.import_ms = elapsed_ms(import_start);
+
+  // 顶点已由导入器生成交错布局，这里只创建纹理并上传
+  auto process_start = std::chrono::steady_clock::now();
+  for (auto &group : loader.get_groups()) {
+    const ObjLoader::Material &material = loader.get_materials()[group.material];
+    std::vector<Texture::Ptr> textures = loadTextures(nullptr, material.diffuse, Texture::diffuse);
+    std::vector<Texture::Ptr> specularMaps = loadTextures(nullptr, material.specular, Texture::specular);
+    textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+    Mesh mesh(std::move(group.vertices), std::move(group.indices), textures, group.interleaved, group.texcoords_layers);
+    // 与 Assimp 路径相同：带透明度贴图或半透明的材质不能作为遮挡体
+    mesh.opaque = !material.opacity_map && material.opacity >= 1.0f;
+    meshs.push_back(std::move(mesh));
+  }
+  load_stats.process_ms = elapsed_ms(process_start) - load_stats.texture_ms;
+  return true;
+}
+
+void Model::load_skeleton(const std::string &file_path, const aiScene *scene) noexcept {
+  bool has_bones = false;
+  for (uint32_t i = 0; i < scene->mNumMeshes; ++i) {
+    has_bones |= scene->mMeshes[i]->HasBones();
+  }
+  if (!has_bones) {
+    return;
+  }
+  // Assimp 的 MMD 导入器不生成骨骼节点，偏移矩阵也不可靠，PMX 的骨骼层级与位置从骨骼表中读取
+  std::string extension = file_path.substr(std::min(file_path.find_last_of('.'), file_path.size()));
+  std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+  skeleton = extension == ".pmx" ? Skeleton::from_pmx(file_path) : Skeleton::from_assimp(scene);
+  if (skeleton == nullptr) {
+    return;
+  }
+  animator = std::make_shared<Animator>(skeleton);
+  for (uint32_t i = 0; i < scene->mNumAnimations; ++i) {
+    animator->add_clip(AnimationClip::from_assimp(scene->mAnimations[i], *skeleton));
+  }
+}
+
+void Model::build_mesh_bvhs() noexcept {
+  // 大网格先领取，避免最后只剩一个线程在构建最大的网格
+  std::vector<uint32_t> jobs(meshs.size());
+  for (uint32_t i = 0; i < jobs.size(); ++i) {
+    jobs[i] = i;
+  }
+  std::sort(jobs.begin(), jobs.end(),
+            [&](uint32_t a, uint32_t b) { return meshs[a].indices.size() > meshs[b].indices.size(); });
+  if (worker_pool == nullptr || jobs.size() < 2) {
+    for (uint32_t index : jobs) {
+      meshs[index].build_bvh();
+    }
+    return;
+  }
+  worker_pool->run(jobs.size(), [&](uint32_t job) { meshs[jobs[job]].build_bvh(); });
 }
 
 Mesh Model::processMesh(const aiMesh *mesh, const aiScene *scene) noexcept {
@@ -161,6 +279,7 @@ Mesh Model::processMesh(const aiMesh *mesh, const aiScene *scene) noexcept {
   }
 
   // 处理材质
+  bool opaque = true;
   if (mesh->mMaterialIndex >= 0) {
     aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
     std::vector<Texture::Ptr> diffuseMaps = loadMaterialTextures(scene, material, aiTextureType_DIFFUSE);
@@ -168,12 +287,39 @@ Mesh Model::processMesh(const aiMesh *mesh, const aiScene *scene) noexcept {
 
     std::vector<Texture::Ptr> specularMaps = loadMaterialTextures(scene, material, aiTextureType_SPECULAR);
     textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+
+    // 带透明度贴图或半透明的材质不能作为遮挡体
+    float opacity = 1.0f;
+    material->Get(AI_MATKEY_OPACITY, opacity);
+    opaque = material->GetTextureCount(aiTextureType_OPACITY) == 0 && opacity >= 1.0f;
+  }
+  // 处理蒙皮，骨骼按名字对应到骨架；带骨骼的模型中没有骨骼的网格整体跟随 0 号骨骼
+  std::vector<VertexSkin> skin;
+  if (skeleton != nullptr) {
+    skin.resize(mesh->mNumVertices);
+    for (uint32_t i = 0; i < mesh->mNumBones; ++i) {
+      const aiBone *bone = mesh->mBones[i];
+      int32_t index = skeleton->find(bone->mName.C_Str());
+      if (index == Skeleton::NO_PARENT) {
+        continue;
+      }
+      for (uint32_t j = 0; j < bone->mNumWeights; ++j) {
+        const aiVertexWeight &weight = bone->mWeights[j];
+        if (weight.mVertexId < skin.size()) {
+          skin[weight.mVertexId].add(index, weight.mWeight);
+        }
+      }
+    }
+    for (auto &i : skin) {
+      i.normalize();
+    }
   }
-  return std::move(Mesh(vertices, indices, textures));
+  Mesh result(vertices, indices, textures, skin);
+  result.opaque = opaque;
+  return result;
 }
 
-void Model::draw(ShaderProgram::Ptr shader, Camera::Ptr camera) noexcept {
-  // 传模型矩阵
+glm::mat4 Model::get_model_matrix() const noexcept {
   glm::mat4 unit(1.0f);  // 单位矩阵
   glm::mat4 scale = glm::scale(unit, this->scale);
   glm::mat4 translate = glm::translate(unit, this->translate);
@@ -183,19 +329,66 @@ void Model::draw(ShaderProgram::Ptr shader, Camera::Ptr camera) noexcept {
   rotate = glm::rotate(rotate, glm::radians(this->rotate.y), glm::vec3(0, 1, 0));
   rotate = glm::rotate(rotate, glm::radians(this->rotate.z), glm::vec3(0, 0, 1));
 
-  // 模型变换矩阵
-  glm::mat4 model = translate * rotate * scale;
+  return translate * rotate * scale;
+}
+
+void Model::get_bounds(glm::vec3 &min, glm::vec3 &max) noexcept {
+  if (!has_bounds) {
+    bounds_min = glm::vec3(std::numeric_limits<float>::max());
+    bounds_max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (const auto &mesh : meshs) {
+      for (const auto &vertex : mesh.vertices) {
+        bounds_min = glm::min(bounds_min, vertex.Position);
+        bounds_max = glm::max(bounds_max, vertex.Position);
+      }
+    }
+    if (bounds_min.x > bounds_max.x) {
+      bounds_min = bounds_max = glm::vec3(0, 0, 0);
+    }
+    has_bounds = true;
+  }
+  min = bounds_min;
+  max = bounds_max;
+}
+
+void Model::draw(ShaderProgram::Ptr shader, Camera::Ptr camera) noexcept {
+  // 传模型矩阵
+  glm::mat4 model = get_model_matrix();
   shader->set_uniform("model", model);
 
   // 计算模型矩阵逆矩阵的转置
   glm::mat4 NormalMatrix = glm::transpose(glm::inverse(model));
   shader->set_uniform("NormalMatrix", NormalMatrix);
 
+  shader->set_uniform("view", camera->getViewMatrix());
+  shader->set_uniform("projection", camera->getProjectionMatrix());
+  // 本帧蒙皮矩阵在调色板中的位置，未求值时为 -1，着色器按绑定姿态绘制
+  if (animator != nullptr) {
+    shader->set_uniform("boneOffset", (GLint)animator->get_palette_offset());
+  }
+
+  // 相邻且可合并的网格一次绘制
+  for (uint32_t i = 0; i < meshs.size();) {
+    uint32_t count = 1;
+    while (i + count < meshs.size() && meshs[i].can_batch(meshs[i + count])) {
+      ++count;
+    }
+    if (count == 1) {
+      meshs[i].draw(shader);
+    } else {
+      Mesh::draw_multi(shader, &meshs[i], count);
+    }
+    i += count;
+  }
+}
+
+void Model::draw_instanced(
+  ShaderProgram::Ptr shader, Camera::Ptr camera, GLuint instance_buffer, GLintptr offset, GLsizei count) noexcept {
   shader->set_uniform("view", camera->getViewMatrix());
   shader->set_uniform("projection", camera->getProjectionMatrix());
 
   for (uint32_t i = 0; i < meshs.size(); ++i) {
-    meshs[i].draw(shader);
+    meshs[i].draw_instanced(shader, instance_buffer, offset, count);
   }
 }
 
@@ -218,27 +411,43 @@ Texture::Type convert_from_aiTextureType(aiTextureType aitype) {
 
 std::vector<Texture::Ptr>
 Model::loadMaterialTextures(const aiScene *scene, const aiMaterial *material, const aiTextureType type) {
-  std::vector<Texture::Ptr> textures_tmp;
-  uint32_t i = 0;
-  for (i = 0; i < material->GetTextureCount(type); ++i) {
+  std::vector<std::string> relative_paths;
+  for (uint32_t i = 0; i < material->GetTextureCount(type); ++i) {
     aiString str;
     material->GetTexture(type, i, &str);
-    std::string texture_path = str.C_Str();
-    int64_t last_slash_pos = texture_path.find_last_of('/');
-    texture_path = root_dir + '/' + texture_path;
+    relative_paths.push_back(str.C_Str());
+  }
+  return loadTextures(scene, relative_paths, convert_from_aiTextureType(type));
+}
+
+std::vector<Texture::Ptr>
+Model::loadTextures(const aiScene *scene, const std::vector<std::string> &relative_paths, Texture::Type type) {
+  auto texture_start = std::chrono::steady_clock::now();
+  std::vector<Texture::Ptr> textures_tmp;
+  for (const auto &relative_path : relative_paths) {
+    std::string texture_path = root_dir + '/' + relative_path;
 
     // 检查是否已经加载
     if (texture_loaded.find(texture_path) == texture_loaded.end()) {
       // 未加载
-      Texture::Ptr texture = std::make_shared<Texture>(convert_from_aiTextureType(type));
-      const aiTexture *aitexture = scene->GetEmbeddedTexture(texture_path.c_str());
+      Texture::Ptr texture = std::make_shared<Texture>(type);
+      const aiTexture *aitexture = scene != nullptr ? scene->GetEmbeddedTexture(texture_path.c_str()) : nullptr;
       if (aitexture != nullptr) {
         texture->id = Texture2DFromAssimp(aitexture, GL_CLAMP_TO_EDGE);
       } else {
-        texture->id = Texture2DFromFile(texture_path, GL_CLAMP_TO_EDGE);
+        // 图像旁有同名的 KTX2 / DDS 时优先使用，其 mip 链已预先生成，加载时无需解码；容器无效时仍使用原图像
+        std::string container_path = TextureContainer::find_sibling(texture_path);
+        if (!container_path.empty()) {
+          texture->id = Texture2DFromFile(container_path, GL_CLAMP_TO_EDGE);
+        }
+        if (texture->id == GL_ZERO && texture_streamer != nullptr) {
+          texture_streamer->load(texture, texture_path, GL_CLAMP_TO_EDGE);
+        } else if (texture->id == GL_ZERO) {
+          texture->id = Texture2DFromFile(texture_path, GL_CLAMP_TO_EDGE);
+        }
       }
 
-      texture->type = convert_from_aiTextureType(type);
+      texture->type = type;
       texture->path = texture_path;
       textures_tmp.push_back(texture);
       texture_loaded.insert(std::pair<std::string, Texture::Ptr>(texture->path, texture));
@@ -247,8 +456,8 @@ Model::loadMaterialTextures(const aiScene *scene, const aiMaterial *material, co
     }
   }
   // 检查是否为不存在而退出
-  if (i == 0) {
-    Texture::Ptr texture = std::make_shared<Texture>(convert_from_aiTextureType(type));
+  if (relative_paths.empty()) {
+    Texture::Ptr texture = std::make_shared<Texture>(type);
     const std::string default_texture_path = texture->path;
     // 添加默认材质 [hard code may be unsafe consider random string]
     if (texture_loaded.find(default_texture_path) == texture_loaded.end()) {
@@ -260,9 +469,27 @@ Model::loadMaterialTextures(const aiScene *scene, const aiMaterial *material, co
       textures_tmp.push_back(texture_loaded.find(default_texture_path)->second);
     }
   }
+  load_stats.texture_ms += elapsed_ms(texture_start);
   return textures_tmp;
 }
 
+void Model::request_textures(float pixels) const noexcept {
+  if (texture_streamer == nullptr) {
+    return;
+  }
+  for (const auto &[path, texture] : texture_loaded) {
+    texture_streamer->request(texture, pixels);
+  }
+}
+
+uint64_t Model::get_triangle_count() const noexcept {
+  uint64_t count = 0;
+  for (const auto &i : meshs) {
+    count += i.indices.size() / 3;
+  }
+  return count;
+}
+
 void Model::add_texture(Texture::Ptr texture) noexcept {
   for (auto &i : meshs) {
     i.add_texture(texture);
@@ -9,15 +9,31 @@
 #include <assimp/scene.h>
 #include <unordered_map>
 
+#include "animator.h"
 #include "camera.h"
 #include "mesh.h"
 #include "shader.h"
+#include "texture_streamer.h"
+#include "worker_pool.h"
 
 
 class Model {
 public:
   typedef std::shared_ptr<Model> Ptr;
 
+  // 最近一次 load 各阶段的耗时（毫秒），用于性能测试
+  struct LoadStats {
+    double import_ms = 0;   // Assimp 导入
+    double process_ms = 0;  // processMesh (不含纹理)
+    double texture_ms = 0;  // 纹理解码与上传
+    double bvh_ms = 0;      // 各网格的三角形 BVH 构建
+  };
+
+  // 设置后 load 用该线程池并行解析 OBJ 并构建各网格的 BVH，否则都在调用线程上进行
+  static void set_worker_pool(WorkerPool::Ptr pool) noexcept { worker_pool = pool; }
+  // 设置后 load 经该流送器渐进加载外部纹理文件，否则同步解码并上传完整的 mip 链
+  static void set_texture_streamer(TextureStreamer::Ptr streamer) noexcept { texture_streamer = streamer; }
+
   Model() = default;
   Model(const std::string &file_path) { load(file_path); }
   Model(const Model &oth);
@@ -29,23 +45,62 @@ public:
   void load(const std::string &file_path, bool flipUV = true, bool genNormal = true) noexcept;
   void load(const std::string &file_path, uint32_t aiProcessFlags);
   void draw(ShaderProgram::Ptr shader, Camera::Ptr camera) noexcept;
+  // 以 instance_buffer 中的 count 个模型矩阵实例化绘制，忽略自身的变换
+  void draw_instanced(
+    ShaderProgram::Ptr shader, Camera::Ptr camera, GLuint instance_buffer, GLintptr offset, GLsizei count) noexcept;
 
-  void add_mesh(const Mesh &mesh) noexcept { meshs.push_back(mesh); }
+  const std::vector<Mesh> &get_meshes() const noexcept { return meshs; }
+  void add_mesh(const Mesh &mesh) noexcept {
+    meshs.push_back(mesh);
+    has_bounds = false;
+  }
   void add_texture(Texture::Ptr texture) noexcept;
 
+  // 由 translate / rotate / scale 得到的模型变换矩阵
+  glm::mat4 get_model_matrix() const noexcept;
+  // 模型空间的轴对齐包围盒，首次调用时由全部顶点计算并缓存
+  void get_bounds(glm::vec3 &min, glm::vec3 &max) noexcept;
+
+  const LoadStats &get_load_stats() const noexcept { return load_stats; }
+  uint64_t get_triangle_count() const noexcept;
+  // 模型本帧在屏幕上约覆盖 pixels 像素，向流送器请求其纹理所需的 mip
+  void request_textures(float pixels) const noexcept;
+
+  // 带骨骼的模型各自持有一个 Animator，副本之间共享骨架与动画片段；不带骨骼时为空
+  const Animator::Ptr &get_animator() const noexcept { return animator; }
+  bool is_skinned() const noexcept { return animator != nullptr; }
+
 public:
   glm::vec3 translate = glm::vec3(0, 0, 0);
   glm::vec3 rotate = glm::vec3(0, 0, 0);
   glm::vec3 scale = glm::vec3(1, 1, 1);
 
 private:
+  // 两种导入路径，成功时 meshs 已填充
+  bool load_assimp(const std::string &file_path, uint32_t aiProcessFlags);
+  bool load_obj(const std::string &file_path, uint32_t aiProcessFlags);
+  // PMX 的骨架从文件中直接读取，其余格式由 Assimp 的骨骼与节点树得到；同时导入场景中的动画
+  void load_skeleton(const std::string &file_path, const aiScene *scene) noexcept;
   Mesh processMesh(const aiMesh *mesh, const aiScene *scene) noexcept;
   std::vector<Texture::Ptr> loadMaterialTextures(const aiScene *scene, const aiMaterial *material, const aiTextureType type);
+  // 加载 root_dir 下的纹理，已加载的直接复用；relative_paths 为空时使用 type 的默认纹理，scene 非空时先查找内嵌纹理
+  std::vector<Texture::Ptr>
+  loadTextures(const aiScene *scene, const std::vector<std::string> &relative_paths, Texture::Type type);
+  void build_mesh_bvhs() noexcept;
 
 private:
+  inline static WorkerPool::Ptr worker_pool = nullptr;
+  inline static TextureStreamer::Ptr texture_streamer = nullptr;
+
   std::vector<Mesh> meshs;
   std::unordered_map<std::string, Texture::Ptr> texture_loaded;
+  Skeleton::Ptr skeleton = nullptr;
+  Animator::Ptr animator = nullptr;
   bool has_loaded = false;
+  LoadStats load_stats;
+  glm::vec3 bounds_min = glm::vec3(0, 0, 0);
+  glm::vec3 bounds_max = glm::vec3(0, 0, 0);
+  bool has_bounds = false;
 
 private:
   std::string root_dir;     // 模型所处的文件夹
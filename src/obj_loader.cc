@@ -0,0 +1,510 @@
+#include "obj_loader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string_view>
+
+#include "mapped_file.h"
+
+namespace {
+
+// 每块至少 64 KiB，块数不超过线程数的 4 倍，块大小不均时空闲线程可以领取剩余的块
+constexpr size_t MIN_CHUNK_SIZE = 64 * 1024;
+constexpr uint32_t CHUNKS_PER_THREAD = 4;
+// 生成顶点时每个任务处理的顶点数
+constexpr uint32_t VERTICES_PER_JOB = 16 * 1024;
+
+bool is_space(char c) noexcept { return c == ' ' || c == '\t' || c == '\r'; }
+
+const char *skip_space(const char *p, const char *end) noexcept {
+  while (p < end && is_space(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+// 行首的关键字，cursor 移到关键字之后
+std::string_view keyword(const char *&cursor, const char *end) noexcept {
+  const char *begin = skip_space(cursor, end);
+  cursor = begin;
+  while (cursor < end && !is_space(*cursor)) {
+    ++cursor;
+  }
+  return std::string_view(begin, cursor - begin);
+}
+
+// 行的剩余部分去掉首尾空白，材质名与纹理路径可以含空格
+std::string rest_of_line(const char *cursor, const char *end) noexcept {
+  cursor = skip_space(cursor, end);
+  while (end > cursor && is_space(end[-1])) {
+    --end;
+  }
+  return std::string(cursor, end - cursor);
+}
+
+template <typename F>
+void for_each_line(const char *begin, const char *end, F &&f) noexcept {
+  while (begin < end) {
+    const char *eol = static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+    if (eol == nullptr) {
+      eol = end;
+    }
+    f(begin, eol);
+    begin = eol + 1;
+  }
+}
+
+template <typename T>
+const char *parse_number(const char *p, const char *end, T &value) noexcept {
+  // from_chars 不接受前导的 '+'
+  if (p < end && *p == '+') {
+    ++p;
+  }
+  auto [ptr, ec] = std::from_chars(p, end, value);
+  return ec == std::errc() ? ptr : nullptr;
+}
+
+// 浮点数的 std::from_chars 在 libc++ 20 与 libstdc++ 11 之前没有实现，退回 strtof。
+// 映射的文件不以 '\0' 结尾，先把数字拷贝到缓冲中；strtof 受 C locale 影响，程序不修改 locale
+#if (defined(_LIBCPP_VERSION) && _LIBCPP_VERSION < 200000) || (defined(__GLIBCXX__) && !defined(__cpp_lib_to_chars))
+const char *parse_number(const char *p, const char *end, float &value) noexcept {
+  char buffer[64];
+  size_t length = 0;
+  while (p + length < end && length + 1 < sizeof(buffer) && !is_space(p[length]) && p[length] != '\n' &&
+         p[length] != '/' && p[length] != '#') {
+    buffer[length] = p[length];
+    ++length;
+  }
+  buffer[length] = '\0';
+  char *stop = nullptr;
+  value = std::strtof(buffer, &stop);
+  return stop == buffer ? nullptr : p + (stop - buffer);
+}
+#endif
+
+// 连续的空白分隔的浮点数，返回读到的个数
+int32_t parse_floats(const char *p, const char *end, float *values, int32_t count) noexcept {
+  int32_t i = 0;
+  for (; i < count; ++i) {
+    p = skip_space(p, end);
+    p = parse_number(p, end, values[i]);
+    if (p == nullptr) {
+      break;
+    }
+  }
+  return i;
+}
+
+// OBJ 的索引从 1 开始，负数相对于当前已定义的个数；defined 为当前已定义的个数，total 为整个文件中的个数
+bool resolve_index(int64_t raw, uint32_t defined, uint32_t total, int32_t &index) noexcept {
+  if (raw > 0 && raw <= int64_t(total)) {
+    index = int32_t(raw - 1);
+    return true;
+  }
+  if (raw < 0 && -raw <= int64_t(defined)) {
+    index = int32_t(defined + raw);
+    return true;
+  }
+  return false;
+}
+
+// 纹理路径前可以有 -bm 1、-o u v w 等选项，跳过后返回路径
+std::string texture_path(const char *cursor, const char *end) noexcept {
+  while (true) {
+    const char *p = skip_space(cursor, end);
+    if (p >= end || *p != '-') {
+      return rest_of_line(p, end);
+    }
+    std::string_view option = keyword(p, end);
+    // -o / -s / -t 带 1 ~ 3 个数，-mm 带 2 个数，其余选项带 1 个参数
+    int32_t max_args = option == "-o" || option == "-s" || option == "-t" ? 3 : option == "-mm" ? 2 : 1;
+    bool numeric = max_args > 1;
+    for (int32_t i = 0; i < max_args; ++i) {
+      const char *arg = skip_space(p, end);
+      float value;
+      if (numeric && (arg >= end || parse_number(arg, end, value) == nullptr)) {
+        break;
+      }
+      keyword(p, end);
+    }
+    cursor = p;
+  }
+}
+
+}  // namespace
+
+void ObjLoader::run(uint32_t count, const std::function<void(uint32_t)> &job) noexcept {
+  if (pool == nullptr || count < 2) {
+    for (uint32_t i = 0; i < count; ++i) {
+      job(i);
+    }
+    return;
+  }
+  pool->run(count, job);
+}
+
+bool ObjLoader::load(const std::string &file_path, bool flip_uv, bool gen_normals) noexcept {
+  MappedFile file(file_path);
+  if (file.get_data() == nullptr) {
+    std::cout << "[ERROR::ObjLoader] Failed to map file: " << file_path << std::endl;
+    return false;
+  }
+  root_dir = file_path.substr(0, file_path.find_last_of('/'));
+
+  // 按大小等分后把每个切点移到下一行的开头
+  const char *data = reinterpret_cast<const char *>(file.get_data());
+  const char *data_end = data + file.get_size();
+  uint32_t concurrency = pool != nullptr ? pool->get_concurrency() : 1;
+  uint32_t chunk_count =
+    uint32_t(std::clamp<size_t>(file.get_size() / MIN_CHUNK_SIZE, 1, concurrency * CHUNKS_PER_THREAD));
+  chunks.resize(chunk_count);
+  const char *cursor = data;
+  for (uint32_t i = 0; i < chunk_count; ++i) {
+    const char *split = i + 1 == chunk_count ? data_end : data + file.get_size() * (i + 1) / chunk_count;
+    split = std::max(split, cursor);
+    const char *eol = static_cast<const char *>(std::memchr(split, '\n', data_end - split));
+    split = eol == nullptr ? data_end : eol + 1;
+    chunks[i].begin = cursor;
+    chunks[i].end = split;
+    cursor = split;
+  }
+
+  run(chunk_count, [&](uint32_t i) { count_chunk(chunks[i]); });
+  uint32_t position_count = 0, texcoord_count = 0, normal_count = 0;
+  for (auto &chunk : chunks) {
+    chunk.first_position = position_count;
+    chunk.first_texcoord = texcoord_count;
+    chunk.first_normal = normal_count;
+    position_count += chunk.positions;
+    texcoord_count += chunk.texcoords;
+    normal_count += chunk.normals;
+  }
+  positions.resize(position_count);
+  texcoords.resize(texcoord_count);
+  normals.resize(normal_count);
+  run(chunk_count, [&](uint32_t i) { parse_chunk(chunks[i], flip_uv); });
+  for (const auto &chunk : chunks) {
+    if (!chunk.error.empty()) {
+      std::cout << "[ERROR::ObjLoader] " << chunk.error << " in " << file_path << std::endl;
+      return false;
+    }
+  }
+
+  for (const auto &chunk : chunks) {
+    for (const auto &library : chunk.libraries) {
+      load_library(root_dir + '/' + library);
+    }
+  }
+
+  // 按块的顺序合并，没有 usemtl 的面使用默认材质。与 Assimp 一样每个 o / g 的名字是一个对象，
+  // 对象内再按材质拆分，同名的对象合并；分组按 (对象, 材质) 第一次出现的顺序排列
+  std::map<std::pair<std::string, uint32_t>, uint32_t> group_index;
+  std::vector<std::vector<Range>> group_ranges;
+  std::string object;
+  uint32_t material = UINT32_MAX;
+  groups.clear();
+  auto add_range = [&](uint32_t chunk, uint32_t begin, uint32_t end) {
+    if (begin == end) {
+      return;
+    }
+    if (material == UINT32_MAX) {
+      material = find_material(std::string());
+    }
+    auto [it, inserted] = group_index.try_emplace({object, material}, uint32_t(groups.size()));
+    if (inserted) {
+      groups.emplace_back();
+      groups.back().name = object;
+      groups.back().material = material;
+      group_ranges.emplace_back();
+    }
+    group_ranges[it->second].push_back({chunk, begin, end});
+  };
+  for (uint32_t i = 0; i < chunk_count; ++i) {
+    uint32_t begin = 0;
+    for (const auto &change : chunks[i].switches) {
+      add_range(i, begin, change.offset);
+      if (change.object) {
+        object = change.name;
+      } else {
+        material = find_material(change.name);
+      }
+      begin = change.offset;
+    }
+    add_range(i, begin, chunks[i].corners.size());
+  }
+
+  local_positions.assign(positions.size(), -1);
+  for (uint32_t i = 0; i < groups.size(); ++i) {
+    build_group(groups[i], group_ranges[i], gen_normals);
+  }
+
+  chunks.clear();
+  positions.clear();
+  local_positions.clear();
+  texcoords.clear();
+  normals.clear();
+  return true;
+}
+
+void ObjLoader::count_chunk(Chunk &chunk) noexcept {
+  for_each_line(chunk.begin, chunk.end, [&](const char *line, const char *end) {
+    line = skip_space(line, end);
+    if (end - line < 2 || line[0] != 'v') {
+      return;
+    }
+    if (is_space(line[1])) {
+      ++chunk.positions;
+    } else if (end - line > 2 && is_space(line[2])) {
+      chunk.texcoords += line[1] == 't';
+      chunk.normals += line[1] == 'n';
+    }
+  });
+}
+
+void ObjLoader::parse_chunk(Chunk &chunk, bool flip_uv) noexcept {
+  uint32_t position = chunk.first_position;
+  uint32_t texcoord = chunk.first_texcoord;
+  uint32_t normal = chunk.first_normal;
+  for_each_line(chunk.begin, chunk.end, [&](const char *line, const char *end) {
+    if (!chunk.error.empty()) {
+      return;
+    }
+    const char *cursor = line;
+    std::string_view key = keyword(cursor, end);
+    float values[3] = {0, 0, 0};
+    if (key == "v") {
+      if (parse_floats(cursor, end, values, 3) < 3) {
+        chunk.error = "Invalid vertex position";
+        return;
+      }
+      positions[position++] = {values[0], values[1], values[2]};
+    } else if (key == "vt") {
+      if (parse_floats(cursor, end, values, 2) < 1) {
+        chunk.error = "Invalid texture coordinate";
+        return;
+      }
+      texcoords[texcoord++] = {values[0], flip_uv ? 1.0f - values[1] : values[1]};
+    } else if (key == "vn") {
+      if (parse_floats(cursor, end, values, 3) < 3) {
+        chunk.error = "Invalid vertex normal";
+        return;
+      }
+      normals[normal++] = {values[0], values[1], values[2]};
+    } else if (key == "f") {
+      if (!parse_face(chunk, cursor, end, position, texcoord, normal)) {
+        chunk.error = "Invalid face \"" + rest_of_line(line, end) + "\"";
+      }
+    } else if (key == "usemtl") {
+      chunk.switches.push_back({uint32_t(chunk.corners.size()), false, rest_of_line(cursor, end)});
+    } else if (key == "o" || key == "g") {
+      chunk.switches.push_back({uint32_t(chunk.corners.size()), true, rest_of_line(cursor, end)});
+    } else if (key == "mtllib") {
+      chunk.libraries.push_back(rest_of_line(cursor, end));
+    }
+  });
+}
+
+bool ObjLoader::parse_face(Chunk &chunk, const char *cursor, const char *end, uint32_t defined_positions,
+                           uint32_t defined_texcoords, uint32_t defined_normals) noexcept {
+  // 多边形以第一个顶点为中心扇形三角化
+  Corner first, previous;
+  uint32_t count = 0;
+  while (true) {
+    cursor = skip_space(cursor, end);
+    if (cursor >= end || *cursor == '#') {
+      break;
+    }
+    Corner corner = {MISSING, MISSING, MISSING};
+    int64_t raw;
+    cursor = parse_number(cursor, end, raw);
+    if (cursor == nullptr || !resolve_index(raw, defined_positions, positions.size(), corner.v)) {
+      return false;
+    }
+    if (cursor < end && *cursor == '/') {
+      ++cursor;
+      // v//vn 没有纹理坐标
+      if (cursor < end && *cursor != '/') {
+        cursor = parse_number(cursor, end, raw);
+        if (cursor == nullptr || !resolve_index(raw, defined_texcoords, texcoords.size(), corner.vt)) {
+          return false;
+        }
+      }
+      if (cursor < end && *cursor == '/') {
+        ++cursor;
+        cursor = parse_number(cursor, end, raw);
+        if (cursor == nullptr || !resolve_index(raw, defined_normals, normals.size(), corner.vn)) {
+          return false;
+        }
+      }
+    }
+    if (cursor < end && !is_space(*cursor)) {
+      return false;
+    }
+    if (count == 0) {
+      first = corner;
+    } else if (count >= 2) {
+      chunk.corners.insert(chunk.corners.end(), {first, previous, corner});
+    }
+    previous = corner;
+    ++count;
+  }
+  return true;
+}
+
+void ObjLoader::load_library(const std::string &file_path) noexcept {
+  MappedFile file(file_path);
+  if (file.get_data() == nullptr) {
+    std::cout << "[WARN::ObjLoader] Failed to open material library: " << file_path << std::endl;
+    return;
+  }
+  const char *data = reinterpret_cast<const char *>(file.get_data());
+  Material *material = nullptr;
+  for_each_line(data, data + file.get_size(), [&](const char *line, const char *end) {
+    const char *cursor = line;
+    std::string_view key = keyword(cursor, end);
+    if (key == "newmtl") {
+      materials.push_back({rest_of_line(cursor, end)});
+      material = &materials.back();
+      return;
+    }
+    if (material == nullptr) {
+      return;
+    }
+    float value;
+    if (key == "map_Kd") {
+      material->diffuse.push_back(texture_path(cursor, end));
+    } else if (key == "map_Ks") {
+      material->specular.push_back(texture_path(cursor, end));
+    } else if (key == "map_d") {
+      material->opacity_map = true;
+    } else if (key == "d" && parse_floats(cursor, end, &value, 1) == 1) {
+      material->opacity = value;
+    } else if (key == "Tr" && parse_floats(cursor, end, &value, 1) == 1) {
+      material->opacity = 1.0f - value;
+    }
+  });
+}
+
+uint32_t ObjLoader::find_material(const std::string &name) noexcept {
+  for (uint32_t i = 0; i < materials.size(); ++i) {
+    if (materials[i].name == name) {
+      return i;
+    }
+  }
+  // 未定义的材质与没有 usemtl 的面一样使用默认材质，与 Assimp 相同命名为 DefaultMaterial
+  static const std::string DEFAULT_MATERIAL = "DefaultMaterial";
+  for (uint32_t i = 0; i < materials.size(); ++i) {
+    if (materials[i].name == DEFAULT_MATERIAL) {
+      return i;
+    }
+  }
+  materials.push_back({DEFAULT_MATERIAL});
+  return materials.size() - 1;
+}
+
+void ObjLoader::build_group(Group &group, const std::vector<Range> &ranges, bool gen_normals) noexcept {
+  // 按 (v, vt, vn) 去重：同一位置的不同组合串成链表，链通常只有一两个节点。
+  // 位置先映射为组内的紧凑编号，每组的开销只与该组用到的位置数有关，而不是整个文件的位置数
+  std::vector<uint32_t> used;          // 紧凑编号 → 全局位置下标
+  std::vector<int32_t> head;           // 按紧凑编号索引
+  std::vector<int32_t> next;
+  std::vector<Corner> keys;
+  std::vector<uint32_t> key_position;  // 每个顶点的紧凑位置编号
+  size_t corner_count = 0;
+  for (const auto &range : ranges) {
+    corner_count += range.end - range.begin;
+  }
+  group.indices.reserve(corner_count);
+  bool has_texcoords = false;
+  bool missing_normals = false;
+  for (const auto &range : ranges) {
+    const std::vector<Corner> &corners = chunks[range.chunk].corners;
+    for (uint32_t i = range.begin; i < range.end; ++i) {
+      const Corner &corner = corners[i];
+      int32_t &local = local_positions[corner.v];
+      if (local < 0) {
+        local = used.size();
+        used.push_back(corner.v);
+        head.push_back(-1);
+      }
+      int32_t id = head[local];
+      while (id >= 0 && (keys[id].vt != corner.vt || keys[id].vn != corner.vn)) {
+        id = next[id];
+      }
+      if (id < 0) {
+        id = keys.size();
+        keys.push_back(corner);
+        key_position.push_back(local);
+        next.push_back(head[local]);
+        head[local] = id;
+        has_texcoords |= corner.vt != MISSING;
+        missing_normals |= corner.vn == MISSING;
+      }
+      group.indices.push_back(id);
+    }
+  }
+  for (uint32_t v : used) {
+    local_positions[v] = -1;
+  }
+
+  // 平滑法线：面法线 (以面积加权) 累加到所用的位置上，同一位置的顶点共用
+  std::vector<glm::vec3> smooth;
+  if (gen_normals && missing_normals) {
+    uint32_t triangles = group.indices.size() / 3;
+    std::vector<glm::vec3> face_normals(triangles);
+    run((triangles + VERTICES_PER_JOB - 1) / VERTICES_PER_JOB, [&](uint32_t job) {
+      uint32_t end = std::min((job + 1) * VERTICES_PER_JOB, triangles);
+      for (uint32_t t = job * VERTICES_PER_JOB; t < end; ++t) {
+        const glm::vec3 &p0 = positions[keys[group.indices[t * 3]].v];
+        const glm::vec3 &p1 = positions[keys[group.indices[t * 3 + 1]].v];
+        const glm::vec3 &p2 = positions[keys[group.indices[t * 3 + 2]].v];
+        face_normals[t] = glm::cross(p1 - p0, p2 - p0);
+      }
+    });
+    smooth.assign(used.size(), glm::vec3(0, 0, 0));
+    for (uint32_t t = 0; t < triangles; ++t) {
+      for (uint32_t k = 0; k < 3; ++k) {
+        smooth[key_position[group.indices[t * 3 + k]]] += face_normals[t];
+      }
+    }
+    run((used.size() + VERTICES_PER_JOB - 1) / VERTICES_PER_JOB, [&](uint32_t job) {
+      uint32_t end = std::min<uint32_t>((job + 1) * VERTICES_PER_JOB, used.size());
+      for (uint32_t v = job * VERTICES_PER_JOB; v < end; ++v) {
+        float length = glm::length(smooth[v]);
+        smooth[v] = length > 0 ? smooth[v] / length : glm::vec3(0, 1, 0);
+      }
+    });
+  }
+
+  // 并行生成 Vertex 与交错的顶点数据
+  group.texcoords_layers = has_texcoords ? 1 : 0;
+  uint32_t stride = 6 + 2 * group.texcoords_layers;
+  uint32_t vertex_count = keys.size();
+  group.vertices.resize(vertex_count);
+  group.interleaved.resize(size_t(vertex_count) * stride);
+  run((vertex_count + VERTICES_PER_JOB - 1) / VERTICES_PER_JOB, [&](uint32_t job) {
+    uint32_t end = std::min((job + 1) * VERTICES_PER_JOB, vertex_count);
+    for (uint32_t i = job * VERTICES_PER_JOB; i < end; ++i) {
+      const Corner &key = keys[i];
+      Vertex &vertex = group.vertices[i];
+      vertex.Position = positions[key.v];
+      if (key.vn != MISSING) {
+        vertex.Normal = normals[key.vn];
+      } else if (!smooth.empty()) {
+        vertex.Normal = smooth[key_position[i]];
+      }
+      float *out = &group.interleaved[size_t(i) * stride];
+      std::memcpy(out, &vertex.Position, sizeof(glm::vec3));
+      std::memcpy(out + 3, &vertex.Normal, sizeof(glm::vec3));
+      if (has_texcoords) {
+        glm::vec2 texcoord = key.vt != MISSING ? texcoords[key.vt] : glm::vec2(0, 0);
+        vertex.TexCoords.assign(1, texcoord);
+        std::memcpy(out + 6, &texcoord, sizeof(glm::vec2));
+      }
+    }
+  });
+}
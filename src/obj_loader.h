@@ -0,0 +1,111 @@
+#ifndef __OBJ_LOADER_H__
+#define __OBJ_LOADER_H__
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "mesh.h"
+#include "worker_pool.h"
+
+/** Wavefront OBJ / MTL 的快速导入
+ * OBJ 文件以内存映射读取并按行切分为若干块，在线程池上并行解析 (std::from_chars)：
+ *   1. 各块先统计 v / vt / vn 的行数，前缀和给出每块写入全局数组的起点，负数 (相对) 索引因此也能就地解析；
+ *   2. 各块把顶点属性直接写入全局数组，面以扇形三角化后记录在块内，o / g / usemtl 记为块内的切换点；
+ *   3. 按块的顺序合并，同一对象 (o / g) 中同一材质的三角形组成一个分组，分组内按 (v, vt, vn) 去重得到索引；
+ *   4. 缺少法线时按位置并行累加面法线得到平滑法线，再并行生成 Vertex 与交错的 GPU 顶点数据。
+ * 只依赖 CPU，不调用 GL；纹理与网格的创建由 Model 在 GL 线程上完成。
+ * 线、点与自由曲面等 Model 不绘制的元素被忽略，解析失败时由调用者退回 Assimp
+ */
+class ObjLoader {
+public:
+  struct Material {
+    std::string name;
+    std::vector<std::string> diffuse;   // map_Kd，相对 OBJ 所在目录
+    std::vector<std::string> specular;  // map_Ks
+    float opacity = 1.0f;               // d，或 1 - Tr
+    bool opacity_map = false;           // 有 map_d
+  };
+
+  // 同一对象中使用同一材质的三角形，与 Assimp 为 OBJ 生成的网格一一对应
+  struct Group {
+    std::string name;  // o / g 的名字，之前没有 o / g 时为空
+    uint32_t material;
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    GLuint texcoords_layers = 0;   // 有纹理坐标时为 1
+    std::vector<float> interleaved; // 与 Mesh::setup 相同的交错布局：位置、法线、各层纹理坐标
+  };
+
+  // pool 为空时在调用线程上逐块解析
+  explicit ObjLoader(WorkerPool::Ptr pool) : pool(pool) {}
+
+  // flip_uv 对应 aiProcess_FlipUVs，gen_normals 对应 aiProcess_GenSmoothNormals (只为缺少法线的顶点生成)
+  bool load(const std::string &file_path, bool flip_uv, bool gen_normals) noexcept;
+
+  const std::vector<Material> &get_materials() const noexcept { return materials; }
+  std::vector<Group> &get_groups() noexcept { return groups; }
+
+private:
+  static constexpr int32_t MISSING = -1;
+
+  struct Corner {
+    int32_t v;
+    int32_t vt;
+    int32_t vn;
+  };
+  // 从 corners 中的 offset 起切换到另一个对象 (o / g) 或材质 (usemtl)
+  struct Switch {
+    uint32_t offset;
+    bool object;
+    std::string name;
+  };
+  struct Chunk {
+    const char *begin;
+    const char *end;
+    uint32_t positions = 0;  // 块内 v / vt / vn 的行数，第一遍统计
+    uint32_t texcoords = 0;
+    uint32_t normals = 0;
+    uint32_t first_position = 0;  // 前缀和
+    uint32_t first_texcoord = 0;
+    uint32_t first_normal = 0;
+    std::vector<Corner> corners;  // 三角化后每 3 个一组
+    std::vector<Switch> switches;
+    std::vector<std::string> libraries;  // mtllib
+    std::string error;
+  };
+  // 分组由各块中连续的三角形区间拼接而成
+  struct Range {
+    uint32_t chunk;
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  void run(uint32_t count, const std::function<void(uint32_t)> &job) noexcept;
+  void count_chunk(Chunk &chunk) noexcept;
+  void parse_chunk(Chunk &chunk, bool flip_uv) noexcept;
+  bool parse_face(Chunk &chunk, const char *cursor, const char *end, uint32_t positions, uint32_t texcoords,
+                  uint32_t normals) noexcept;
+  void load_library(const std::string &file_path) noexcept;
+  uint32_t find_material(const std::string &name) noexcept;
+  void build_group(Group &group, const std::vector<Range> &ranges, bool gen_normals) noexcept;
+
+private:
+  WorkerPool::Ptr pool;
+  std::string root_dir;
+  std::vector<Chunk> chunks;
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec2> texcoords;
+  std::vector<glm::vec3> normals;
+  // build_group 的草稿：全局位置下标 → 当前分组内的紧凑编号，未用到为 -1，每组结束时只恢复用过的项
+  std::vector<int32_t> local_positions;
+  std::vector<Material> materials;
+  std::vector<Group> groups;
+};
+
+#endif  // !__OBJ_LOADER_H__
@@ -0,0 +1,137 @@
+#include "occlusion_culler.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+OcclusionCuller::OcclusionCuller(ShaderProgram::Ptr box_prog, uint32_t retest_interval)
+    : box_prog(box_prog), retest_interval(std::max<uint32_t>(retest_interval, 1)) {
+  // [0, 1] 的单位立方体，绘制时缩放到包围盒
+  std::vector<Vertex> vertices;
+  for (uint32_t i = 0; i < 8; ++i) {
+    vertices.push_back(Vertex(glm::vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1)));
+  }
+  std::vector<GLuint> indices = {
+    0, 2, 1, 1, 2, 3,  // z = 0
+    4, 5, 6, 5, 7, 6,  // z = 1
+    0, 1, 4, 1, 5, 4,  // y = 0
+    2, 6, 3, 3, 6, 7,  // y = 1
+    0, 4, 2, 2, 4, 6,  // x = 0
+    1, 3, 5, 3, 7, 5,  // x = 1
+  };
+  box = std::make_shared<Mesh>(vertices, indices, std::vector<Texture::Ptr>{});
+}
+
+OcclusionCuller::~OcclusionCuller() {
+  for (auto &[model, entry] : entries) {
+    glDeleteQueries(1, &entry.query);
+  }
+}
+
+OcclusionCuller::Entry &OcclusionCuller::get_entry(const Model *model) noexcept {
+  auto found = entries.find(model);
+  if (found != entries.end()) {
+    return found->second;
+  }
+  Entry entry;
+  glGenQueries(1, &entry.query);
+  entry.phase = entries.size() % retest_interval;
+  return entries.emplace(model, entry).first->second;
+}
+
+void OcclusionCuller::begin_tests(Camera::Ptr camera) noexcept {
+  ++frame;
+  this->camera = camera;
+  stats.tested = 0;
+  stats.occluded = 0;
+  for (auto &[model, entry] : entries) {
+    entry.issued = false;
+    if (entry.pending) {
+      GLint available = GL_FALSE;
+      glGetQueryObjectiv(entry.query, GL_QUERY_RESULT_AVAILABLE, &available);
+      if (available == GL_TRUE) {
+        GLuint passed = GL_FALSE;
+        glGetQueryObjectuiv(entry.query, GL_QUERY_RESULT, &passed);
+        entry.visible = passed != GL_FALSE;
+        entry.pending = false;
+      }
+    }
+    if (!entry.visible) {
+      ++stats.occluded;
+    }
+  }
+
+  // 在其他样本查询中 glBeginQuery 会以 GL_INVALID_OPERATION 失败，条件绘制也随之失效
+  GLint samples = 0, any_samples = 0;
+  glGetQueryiv(GL_SAMPLES_PASSED, GL_CURRENT_QUERY, &samples);
+  glGetQueryiv(GL_ANY_SAMPLES_PASSED, GL_CURRENT_QUERY, &any_samples);
+  nested = samples != 0 || any_samples != 0;
+  if (nested) {
+    ++stats.nested;
+    if (!warned_nested) {
+      std::cout << "[WARN::OcclusionCuller] Occlusion tests issued inside another samples query, skipping" << std::endl;
+      warned_nested = true;
+    }
+  }
+
+  glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+  glDepthMask(GL_FALSE);
+  box_prog->set_uniform("view", camera->getViewMatrix());
+  box_prog->set_uniform("projection", camera->getProjectionMatrix());
+}
+
+void OcclusionCuller::test(const Model::Ptr &model) noexcept {
+  Entry &entry = get_entry(model.get());
+  if (nested) {
+    return;
+  }
+  if (entry.visible && (frame + entry.phase) % retest_interval != 0) {
+    return;
+  }
+
+  glm::vec3 min, max;
+  model->get_bounds(min, max);
+  // 相机位于包围盒内（含近裁剪面的距离）时，包围盒朝向相机的面会被裁掉，直接视为可见
+  glm::vec3 local = glm::vec3(glm::inverse(model->get_model_matrix()) * glm::vec4(camera->position, 1.0f));
+  glm::vec3 scales = glm::abs(model->scale);
+  float scale = std::max(std::min({scales.x, scales.y, scales.z}), 1e-4f);
+  glm::vec3 margin(camera->zNear / scale);
+  if (glm::all(glm::greaterThanEqual(local, min - margin)) && glm::all(glm::lessThanEqual(local, max + margin))) {
+    entry.visible = true;
+    return;
+  }
+
+  glm::mat4 box_model = model->get_model_matrix() * glm::translate(glm::mat4(1.0f), min) *
+                        glm::scale(glm::mat4(1.0f), glm::max(max - min, glm::vec3(1e-4f)));
+  box_prog->set_uniform("model", box_model);
+  glBeginQuery(GL_ANY_SAMPLES_PASSED, entry.query);
+  box->draw(box_prog);
+  glEndQuery(GL_ANY_SAMPLES_PASSED);
+  entry.issued = true;
+  entry.pending = true;
+  ++stats.tested;
+}
+
+void OcclusionCuller::end_tests() noexcept {
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  glDepthMask(GL_TRUE);
+}
+
+void OcclusionCuller::begin_draw(const Model::Ptr &model) noexcept {
+  auto found = entries.find(model.get());
+  if (found == entries.end() || !found->second.issued) {
+    return;
+  }
+  // GPU 端等待查询结果，不阻塞 CPU
+  glBeginConditionalRender(found->second.query, GL_QUERY_WAIT);
+  conditional = true;
+}
+
+void OcclusionCuller::end_draw() noexcept {
+  if (conditional) {
+    glEndConditionalRender();
+    conditional = false;
+  }
+}
@@ -0,0 +1,81 @@
+#ifndef __OCCLUSION_CULLER_H__
+#define __OCCLUSION_CULLER_H__
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+
+#include <memory>
+#include <unordered_map>
+
+#include "camera.h"
+#include "mesh.h"
+#include "model.h"
+#include "shader.h"
+
+/** 基于硬件遮挡查询的剔除
+ * 先绘制遮挡体，再关闭颜色与深度写入，为其余物体的包围盒发起 GL_ANY_SAMPLES_PASSED 查询，
+ * 之后以 glBeginConditionalRender 绘制物体本身，由 GPU 根据查询结果跳过被遮挡的物体，CPU 不等待结果。
+ * 时间相关性：结果在之后的帧里不阻塞地读回，已知可见的物体每 retest_interval 帧才重新查询一次，
+ * 期间直接绘制；被遮挡的物体每帧都查询，重新露出时当帧即可绘制。
+ * 每个通道（主视图、阴影）的深度缓冲不同，各自使用一个实例
+ */
+class OcclusionCuller {
+public:
+  typedef std::shared_ptr<OcclusionCuller> Ptr;
+
+  static constexpr uint32_t RETEST_INTERVAL = 4;
+
+  struct Stats {
+    uint32_t tested = 0;    // 本帧发起的查询数
+    uint32_t occluded = 0;  // 最近读回结果为被遮挡的物体数
+    uint64_t nested = 0;    // 累计因已有样本查询在进行而跳过查询的次数，应始终为 0
+  };
+
+  // box_prog 只需要 position 输入与 model / view / projection 三个矩阵，如 depth.vert
+  explicit OcclusionCuller(ShaderProgram::Ptr box_prog, uint32_t retest_interval = RETEST_INTERVAL);
+  OcclusionCuller(const OcclusionCuller &oth) = delete;
+  OcclusionCuller &operator=(const OcclusionCuller &oth) = delete;
+  ~OcclusionCuller();
+
+  /** 读回已完成的查询并关闭颜色与深度写入，之后以 camera 的视图投影绘制包围盒
+   * 样本查询不能嵌套，调用者须先暂停进行中的 GL_SAMPLES_PASSED 查询 (见 GpuQuery::suspend)；
+   * 否则本次不发起查询，全部物体直接绘制，并计入 Stats::nested
+   */
+  void begin_tests(Camera::Ptr camera) noexcept;
+  // 以 model 的包围盒与当前深度缓冲比较，可见且未到重测间隔的物体不查询
+  void test(const Model::Ptr &model) noexcept;
+  // 恢复颜色与深度写入
+  void end_tests() noexcept;
+
+  // 以本帧的查询结果为条件绘制，本帧未查询的物体直接绘制
+  void begin_draw(const Model::Ptr &model) noexcept;
+  void end_draw() noexcept;
+
+  const Stats &get_stats() const noexcept { return stats; }
+
+private:
+  struct Entry {
+    GLuint query = GL_ZERO;
+    uint32_t phase = 0;    // 错开各物体的重测帧
+    bool visible = true;   // 最近读回的结果
+    bool pending = false;  // 结果尚未读回
+    bool issued = false;   // 本帧发起了查询
+  };
+
+  Entry &get_entry(const Model *model) noexcept;
+
+private:
+  ShaderProgram::Ptr box_prog;
+  Mesh::Ptr box;
+  uint32_t retest_interval;
+  Camera::Ptr camera = nullptr;
+  uint64_t frame = 0;
+  bool conditional = false;
+  bool nested = false;  // 本次测试期间有其他样本查询在进行
+  bool warned_nested = false;
+  std::unordered_map<const Model *, Entry> entries;
+  Stats stats;
+};
+
+#endif  // !__OCCLUSION_CULLER_H__
@@ -0,0 +1,84 @@
+#include "oit_buffer.h"
+
+#include <iostream>
+
+#include "gbuffer.h"
+
+void OitBuffer::declare(FrameGraph &graph, int32_t width, int32_t height) noexcept {
+  this->width = width;
+  this->height = height;
+  accum = graph.create_texture("oit_accum", {width, height, GL_RGBA16F});
+  revealage = graph.create_texture("oit_revealage", {width, height, GL_R16F});
+  depth = graph.create_texture("oit_depth", {width, height, GL_DEPTH24_STENCIL8});
+}
+
+void OitBuffer::write(FrameGraph::PassBuilder &pass) const noexcept {
+  pass.write(accum).write(revealage).write(depth);
+}
+
+void OitBuffer::read(FrameGraph::PassBuilder &pass) const noexcept { pass.read(accum).read(revealage); }
+
+void OitBuffer::begin(const FrameGraph::Context &context, ShaderProgram::Ptr copy_prog, Mesh::Ptr screen, GLuint source,
+                      GLuint source_depth) const noexcept {
+  GLuint fbo = context.get_framebuffer({accum, revealage, depth});
+  if (GBuffer::can_blit_depth(source)) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, width, height);
+  } else if (source_depth != GL_ZERO) {
+    // 格式不同时按深度值写回，深度测试恒通过，不写颜色
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, width, height);
+    glActiveTexture(GL_TEXTURE0 + GBuffer::DEPTH_UNIT);
+    glBindTexture(GL_TEXTURE_2D, source_depth);
+    glActiveTexture(GL_TEXTURE0);
+    copy_prog->set_uniform("gDepth", GBuffer::DEPTH_UNIT);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthFunc(GL_ALWAYS);
+    screen->draw(copy_prog);
+    glDepthFunc(GL_LESS);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  } else {
+    // 拿不到不透明物体的深度，透明物体不再被遮挡，只提示一次
+    static bool warned = false;
+    if (!warned) {
+      std::cout << "[WARN::OitBuffer] source depth can neither be blitted nor sampled, transparent objects ignore occlusion"
+                << std::endl;
+      warned = true;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, width, height);
+    glClear(GL_DEPTH_BUFFER_BIT);
+  }
+
+  const GLfloat zero[] = {0.0f, 0.0f, 0.0f, 0.0f};
+  glClearBufferfv(GL_COLOR, 0, zero);
+  glClearBufferfv(GL_COLOR, 1, zero);
+}
+
+void OitBuffer::begin_accumulation() const noexcept {
+  glDepthMask(GL_FALSE);
+  glEnable(GL_BLEND);
+  glBlendEquation(GL_FUNC_ADD);
+  glBlendFunc(GL_ONE, GL_ONE);
+}
+
+void OitBuffer::end_accumulation(GLuint target) const noexcept {
+  glDepthMask(GL_TRUE);
+  glDisable(GL_BLEND);
+  glBindFramebuffer(GL_FRAMEBUFFER, target);
+  glViewport(0, 0, width, height);
+}
+
+void OitBuffer::bind_textures(const FrameGraph::Context &context, ShaderProgram::Ptr shader) const noexcept {
+  glActiveTexture(GL_TEXTURE0 + ACCUM_UNIT);
+  glBindTexture(GL_TEXTURE_2D, context.get_texture(accum));
+  glActiveTexture(GL_TEXTURE0 + REVEALAGE_UNIT);
+  glBindTexture(GL_TEXTURE_2D, context.get_texture(revealage));
+  glActiveTexture(GL_TEXTURE0);
+
+  shader->set_uniform("oitAccum", ACCUM_UNIT);
+  shader->set_uniform("oitRevealage", REVEALAGE_UNIT);
+}
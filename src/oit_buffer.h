@@ -0,0 +1,57 @@
+#ifndef __OIT_BUFFER_H__
+#define __OIT_BUFFER_H__
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+
+#include <memory>
+
+#include "frame_graph.h"
+#include "mesh.h"
+#include "shader.h"
+
+/** 加权混合顺序无关透明 (Weighted Blended OIT) 使用的渲染目标
+ * accum      RGBA16F  Σ(颜色 × alpha × 权重, alpha × 权重)
+ * revealage  R16F     Σ -log2(1 - alpha)，合成时取 exp2(-x) 得到 Π(1 - alpha)
+ * depth      DEPTH24_STENCIL8，从不透明物体所在的帧缓冲拷贝而来，只做深度测试。来源格式不同时 (多重采样或
+ *            非 24/8 的默认帧缓冲) 不能 blit，与 GBuffer::blit_depth 一样改用全屏 pass 写回深度
+ * GL 3.3 没有按附件设置的混合函数 (glBlendFunci)，两个附件都使用 GL_ONE, GL_ONE 累加，
+ * 乘积形式的 revealage 因此转换为对数域的求和。
+ * 附件是帧图中的临时资源，深度与 G-buffer 的深度规格相同，生命周期不重叠时共用同一张纹理
+ */
+class OitBuffer {
+public:
+  typedef std::shared_ptr<OitBuffer> Ptr;
+
+  // 合成阶段读取使用的纹理单元
+  static constexpr GLint ACCUM_UNIT = 29;
+  static constexpr GLint REVEALAGE_UNIT = 30;
+
+  // 在帧图中声明本帧的附件，每帧 begin_frame 之后调用
+  void declare(FrameGraph &graph, int32_t width, int32_t height) noexcept;
+  // 累积阶段写入全部附件，合成阶段读取两个颜色附件
+  void write(FrameGraph::PassBuilder &pass) const noexcept;
+  void read(FrameGraph::PassBuilder &pass) const noexcept;
+
+  /** 从 source 帧缓冲拷贝深度，绑定并清空累积目标
+   * source 的深度格式与 depth 不同时，用 copy_prog (shaders/depth_copy.frag) 在 screen 上采样 source_depth 写回；
+   * 默认帧缓冲的深度无法采样，此时 source_depth 为 0，调用方需保证场景画在离屏目标中
+   */
+  void begin(const FrameGraph::Context &context, ShaderProgram::Ptr copy_prog, Mesh::Ptr screen, GLuint source = 0,
+             GLuint source_depth = 0) const noexcept;
+  // 设置累积阶段的混合与深度状态，透明物体在此之后可按任意顺序提交
+  void begin_accumulation() const noexcept;
+  // 恢复默认状态并绑定 target 帧缓冲，之后用 bind_textures 进行合成
+  void end_accumulation(GLuint target = 0) const noexcept;
+  void bind_textures(const FrameGraph::Context &context, ShaderProgram::Ptr shader) const noexcept;
+
+private:
+  int32_t width = 0;
+  int32_t height = 0;
+  FrameGraph::Resource accum = FrameGraph::BACKBUFFER;
+  FrameGraph::Resource revealage = FrameGraph::BACKBUFFER;
+  FrameGraph::Resource depth = FrameGraph::BACKBUFFER;
+};
+
+#endif  // !__OIT_BUFFER_H__
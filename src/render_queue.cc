@@ -0,0 +1,62 @@
+#include "render_queue.h"
+
+RenderQueue::RenderQueue() {
+  for (uint32_t i = 0; i < SLOT_COUNT; ++i) {
+    free_slots.push_back(i);
+  }
+}
+
+RenderPacket *RenderQueue::begin_write() {
+  std::unique_lock<std::mutex> lock(mutex);
+  slot_freed.wait(lock, [this]() { return closed || !free_slots.empty(); });
+  if (closed) {
+    return nullptr;
+  }
+  writing = free_slots.back();
+  free_slots.pop_back();
+  return &slots[writing];
+}
+
+void RenderQueue::end_write() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (writing < 0) {
+      return;
+    }
+    ready_slots.push_back(writing);
+    writing = -1;
+  }
+  packet_ready.notify_one();
+}
+
+const RenderPacket *RenderQueue::begin_read() {
+  std::unique_lock<std::mutex> lock(mutex);
+  packet_ready.wait(lock, [this]() { return closed || !ready_slots.empty(); });
+  if (ready_slots.empty()) {
+    return nullptr;
+  }
+  reading = ready_slots.front();
+  ready_slots.pop_front();
+  return &slots[reading];
+}
+
+void RenderQueue::end_read() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (reading < 0) {
+      return;
+    }
+    free_slots.push_back(reading);
+    reading = -1;
+  }
+  slot_freed.notify_one();
+}
+
+void RenderQueue::close() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+  }
+  slot_freed.notify_all();
+  packet_ready.notify_all();
+}
@@ -0,0 +1,79 @@
+#ifndef __RENDER_QUEUE_H__
+#define __RENDER_QUEUE_H__
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "shadow_filter.h"
+#include "simulation.h"
+
+// 渲染开关，由主线程的按键回调修改
+struct RenderSettings {
+  // 遮挡剔除方式：关闭、GPU 遮挡查询、CPU 软件光栅化
+  enum OcclusionMode : uint8_t { OcclusionOff, OcclusionQueries, OcclusionSoftware };
+
+  bool deferred_shading = false;   // G 键
+  bool depth_prepass = false;      // P 键
+  bool oit_transparency = true;    // O 键
+  bool dynamic_resolution = true;  // Z 键
+  OcclusionMode occlusion = OcclusionQueries;  // X 键
+  ShadowFilter::Tier shadow_tier = ShadowFilter::PoissonPCF;  // T 键
+};
+
+/** 一帧的渲染数据包
+ * 由主线程完整填写后交给渲染线程，渲染线程只读
+ */
+struct RenderPacket {
+  uint64_t frame = 0;
+  float delta_time = 0;
+  int32_t width = 0, height = 0;
+  RenderSettings settings;
+  // 插值后的场景状态：相机、光源与各动态物体的变换
+  WorldState world;
+  // 不透明物体从近到远的绘制顺序，下标对应渲染线程的不透明物体列表
+  std::vector<uint32_t> opaque_order;
+};
+
+/** 三缓冲的渲染数据包队列
+ * 渲染线程占用一个槽位时，其余两个槽位供主线程写入与排队，主线程最多领先渲染线程两帧；
+ * 没有空闲槽位时 begin_write 阻塞，以此限制输入到画面的延迟
+ */
+class RenderQueue {
+public:
+  typedef std::shared_ptr<RenderQueue> Ptr;
+
+  static constexpr uint32_t SLOT_COUNT = 3;
+
+  RenderQueue();
+  RenderQueue(const RenderQueue &oth) = delete;
+  RenderQueue &operator=(const RenderQueue &oth) = delete;
+
+  // 主线程：取一个空闲槽位写入，队列关闭后返回 nullptr
+  RenderPacket *begin_write();
+  void end_write();
+
+  // 渲染线程：按提交顺序取出数据包，队列关闭且为空时返回 nullptr
+  const RenderPacket *begin_read();
+  void end_read();
+
+  // 唤醒双方并让后续调用返回 nullptr
+  void close() noexcept;
+
+private:
+  std::mutex mutex;
+  std::condition_variable slot_freed;
+  std::condition_variable packet_ready;
+  RenderPacket slots[SLOT_COUNT];
+  std::vector<uint32_t> free_slots;
+  std::deque<uint32_t> ready_slots;
+  int32_t writing = -1;
+  int32_t reading = -1;
+  bool closed = false;
+};
+
+#endif  // !__RENDER_QUEUE_H__
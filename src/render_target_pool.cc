@@ -0,0 +1,206 @@
+#include "render_target_pool.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+// 附件内部格式对应的上传格式、类型与每像素字节数，只列出渲染器用到的格式
+struct FormatInfo {
+  GLenum internal_format;
+  GLenum format;
+  GLenum type;
+  uint32_t bytes;
+};
+
+constexpr FormatInfo FORMATS[] = {
+  {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4},
+  {GL_RGBA16F, GL_RGBA, GL_FLOAT, 8},
+  {GL_RG16F, GL_RG, GL_FLOAT, 4},
+  {GL_RG32F, GL_RG, GL_FLOAT, 8},
+  {GL_R16F, GL_RED, GL_FLOAT, 2},
+  {GL_R32F, GL_RED, GL_FLOAT, 4},
+  {GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 4},
+  {GL_DEPTH_COMPONENT32, GL_DEPTH_COMPONENT, GL_FLOAT, 4},
+  {GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, 4},
+  {GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 4},
+};
+
+const FormatInfo &format_info(GLenum internal_format) noexcept {
+  for (const auto &info : FORMATS) {
+    if (info.internal_format == internal_format) {
+      return info;
+    }
+  }
+  std::cout << "[WARN::RenderTargetPool] Unknown internal format 0x" << std::hex << internal_format << std::dec
+            << ", treated as RGBA8" << std::endl;
+  return FORMATS[0];
+}
+
+}  // namespace
+
+bool RenderTargetDesc::is_depth() const noexcept { return attachment() != GL_COLOR_ATTACHMENT0; }
+
+GLenum RenderTargetDesc::attachment() const noexcept {
+  switch (format_info(internal_format).format) {
+    case GL_DEPTH_COMPONENT:
+      return GL_DEPTH_ATTACHMENT;
+    case GL_DEPTH_STENCIL:
+      return GL_DEPTH_STENCIL_ATTACHMENT;
+    default:
+      return GL_COLOR_ATTACHMENT0;
+  }
+}
+
+uint64_t RenderTargetDesc::bytes() const noexcept {
+  return uint64_t(width) * height * format_info(internal_format).bytes;
+}
+
+RenderTargetPool::~RenderTargetPool() {
+  for (const auto &framebuffer : framebuffers) {
+    glDeleteFramebuffers(1, &framebuffer.fbo);
+  }
+  for (const auto &target : targets) {
+    glDeleteTextures(1, &target.texture);
+  }
+}
+
+GLuint RenderTargetPool::create_texture(const RenderTargetDesc &desc) noexcept {
+  const FormatInfo &info = format_info(desc.internal_format);
+  GLuint texture = GL_ZERO;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, desc.internal_format, desc.width, desc.height, 0, info.format, info.type, NULL);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, desc.filter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, desc.filter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, desc.wrap);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, desc.wrap);
+  if (desc.wrap == GL_CLAMP_TO_BORDER) {
+    GLfloat border_color[] = {1.0, 1.0, 1.0, 1.0};
+    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border_color);
+  }
+  if (desc.compare) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+  }
+  glBindTexture(GL_TEXTURE_2D, GL_ZERO);
+  return texture;
+}
+
+GLuint RenderTargetPool::acquire(const RenderTargetDesc &desc) noexcept {
+  for (auto &target : targets) {
+    if (!target.in_use && target.desc == desc) {
+      target.in_use = true;
+      target.last_used = frame;
+      return target.texture;
+    }
+  }
+  Target target;
+  target.texture = create_texture(desc);
+  target.desc = desc;
+  target.in_use = true;
+  target.last_used = frame;
+  targets.push_back(target);
+  ++stats.textures;
+  stats.bytes += desc.bytes();
+  ++stats.created;
+  return target.texture;
+}
+
+void RenderTargetPool::release(GLuint texture) noexcept {
+  for (auto &target : targets) {
+    if (target.texture == texture) {
+      target.in_use = false;
+      return;
+    }
+  }
+}
+
+const RenderTargetDesc *RenderTargetPool::get_desc(GLuint texture) const noexcept {
+  for (const auto &target : targets) {
+    if (target.texture == texture) {
+      return &target.desc;
+    }
+  }
+  return nullptr;
+}
+
+GLuint RenderTargetPool::get_framebuffer(const std::vector<GLuint> &colors, GLuint depth) noexcept {
+  Framebuffer key = {};
+  if (colors.size() > MAX_COLOR_ATTACHMENTS) {
+    std::cout << "[ERROR::RenderTargetPool] Too many color attachments: " << colors.size() << std::endl;
+    return GL_ZERO;
+  }
+  std::copy(colors.begin(), colors.end(), key.colors);
+  key.depth = depth;
+  for (const auto &framebuffer : framebuffers) {
+    if (std::equal(key.colors, key.colors + MAX_COLOR_ATTACHMENTS, framebuffer.colors) &&
+        key.depth == framebuffer.depth) {
+      return framebuffer.fbo;
+    }
+  }
+  key.fbo = create_framebuffer(key);
+  framebuffers.push_back(key);
+  stats.framebuffers = framebuffers.size();
+  return key.fbo;
+}
+
+GLuint RenderTargetPool::create_framebuffer(const Framebuffer &key) noexcept {
+  GLuint fbo = GL_ZERO;
+  glGenFramebuffers(1, &fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  GLenum draw_buffers[MAX_COLOR_ATTACHMENTS];
+  GLsizei count = 0;
+  for (; count < GLsizei(MAX_COLOR_ATTACHMENTS) && key.colors[count] != GL_ZERO; ++count) {
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + count, GL_TEXTURE_2D, key.colors[count], 0);
+    draw_buffers[count] = GL_COLOR_ATTACHMENT0 + count;
+  }
+  if (key.depth != GL_ZERO) {
+    const RenderTargetDesc *desc = get_desc(key.depth);
+    GLenum attachment = desc != nullptr ? desc->attachment() : GL_DEPTH_ATTACHMENT;
+    glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, key.depth, 0);
+  }
+  // 只有深度附件时不写颜色
+  if (count > 0) {
+    glDrawBuffers(count, draw_buffers);
+  } else {
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+  }
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    std::cout << "[ERROR::RenderTargetPool] Framebuffer is not complete" << std::endl;
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, GL_ZERO);
+  return fbo;
+}
+
+void RenderTargetPool::end_frame() noexcept {
+  ++frame;
+  auto idle = [&](const Target &target) { return !target.in_use && frame - target.last_used > MAX_IDLE_FRAMES; };
+  bool evicted = false;
+  for (const auto &target : targets) {
+    if (!idle(target)) {
+      continue;
+    }
+    // 用到该纹理的帧缓冲一并删除
+    auto uses = [&](const Framebuffer &framebuffer) {
+      return framebuffer.depth == target.texture ||
+             std::find(framebuffer.colors, framebuffer.colors + MAX_COLOR_ATTACHMENTS, target.texture) !=
+               framebuffer.colors + MAX_COLOR_ATTACHMENTS;
+    };
+    for (const auto &framebuffer : framebuffers) {
+      if (uses(framebuffer)) {
+        glDeleteFramebuffers(1, &framebuffer.fbo);
+      }
+    }
+    framebuffers.erase(std::remove_if(framebuffers.begin(), framebuffers.end(), uses), framebuffers.end());
+    glDeleteTextures(1, &target.texture);
+    --stats.textures;
+    stats.bytes -= target.desc.bytes();
+    evicted = true;
+  }
+  if (evicted) {
+    targets.erase(std::remove_if(targets.begin(), targets.end(), idle), targets.end());
+    stats.framebuffers = framebuffers.size();
+  }
+}
@@ -0,0 +1,90 @@
+#ifndef __RENDER_TARGET_POOL_H__
+#define __RENDER_TARGET_POOL_H__
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+// 渲染目标纹理的描述，描述完全相同的纹理可以互相替代
+struct RenderTargetDesc {
+  int32_t width = 0;
+  int32_t height = 0;
+  GLenum internal_format = GL_RGBA8;
+  GLenum filter = GL_NEAREST;
+  GLenum wrap = GL_CLAMP_TO_EDGE;  // GL_CLAMP_TO_BORDER 时边框为 (1, 1, 1, 1)，即最远深度
+  bool compare = false;            // 深度纹理以 sampler2DShadow 采样
+
+  bool operator==(const RenderTargetDesc &oth) const noexcept = default;
+
+  bool is_depth() const noexcept;
+  // 作为帧缓冲附件时的挂载点，颜色纹理返回 GL_COLOR_ATTACHMENT0
+  GLenum attachment() const noexcept;
+  uint64_t bytes() const noexcept;
+};
+
+/** 渲染目标池
+ * acquire 优先复用描述相同的空闲纹理，release 后纹理回到池中，同一帧内之后的请求可以直接拿到它，
+ * 生命周期不重叠的目标因此共用同一块显存。连续 MAX_IDLE_FRAMES 帧没有用到的纹理被删除，
+ * 窗口尺寸变化或渲染路径切换后旧尺寸的目标不会一直占用显存。
+ * 帧缓冲按附件组合缓存，附件纹理被删除时一并删除
+ */
+class RenderTargetPool {
+public:
+  typedef std::shared_ptr<RenderTargetPool> Ptr;
+
+  static constexpr uint32_t MAX_IDLE_FRAMES = 30;
+  static constexpr uint32_t MAX_COLOR_ATTACHMENTS = 4;
+
+  struct Stats {
+    uint32_t textures = 0;      // 池中的纹理数，含空闲的
+    uint64_t bytes = 0;         // 池中纹理占用的显存
+    uint32_t framebuffers = 0;  // 缓存的帧缓冲数
+    uint64_t created = 0;       // 累计创建的纹理数
+  };
+
+  RenderTargetPool() = default;
+  RenderTargetPool(const RenderTargetPool &oth) = delete;
+  RenderTargetPool &operator=(const RenderTargetPool &oth) = delete;
+  ~RenderTargetPool();
+
+  GLuint acquire(const RenderTargetDesc &desc) noexcept;
+  void release(GLuint texture) noexcept;
+  const RenderTargetDesc *get_desc(GLuint texture) const noexcept;
+
+  /** 以 colors 依次为颜色附件、depth 为深度附件 (可为 GL_ZERO) 的帧缓冲，首次请求时创建
+   * 附件必须是池中的纹理
+   */
+  GLuint get_framebuffer(const std::vector<GLuint> &colors, GLuint depth) noexcept;
+
+  // 每帧结束时调用，删除长时间空闲的纹理
+  void end_frame() noexcept;
+
+  const Stats &get_stats() const noexcept { return stats; }
+
+private:
+  struct Target {
+    GLuint texture;
+    RenderTargetDesc desc;
+    bool in_use;
+    uint64_t last_used;
+  };
+  struct Framebuffer {
+    GLuint colors[MAX_COLOR_ATTACHMENTS];
+    GLuint depth;
+    GLuint fbo;
+  };
+
+  static GLuint create_texture(const RenderTargetDesc &desc) noexcept;
+  GLuint create_framebuffer(const Framebuffer &key) noexcept;
+
+private:
+  std::vector<Target> targets;
+  std::vector<Framebuffer> framebuffers;
+  uint64_t frame = 0;
+  Stats stats;
+};
+
+#endif  // !__RENDER_TARGET_POOL_H__
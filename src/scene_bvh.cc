@@ -0,0 +1,168 @@
+#include "scene_bvh.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 滑动的最多迭代次数，通常两三次就能沿墙角停下
+constexpr uint32_t MAX_SLIDES = 4;
+// 与表面保持的间隙，避免下一次查询从接触状态开始
+constexpr float SKIN = 0.01f;
+
+}  // namespace
+
+uint32_t SceneBvh::add(const Model &model) {
+  uint32_t object = object_count++;
+  glm::mat4 matrix = model.get_model_matrix();
+  for (const auto &mesh : model.get_meshes()) {
+    add_instance(mesh, matrix, object);
+  }
+  return object;
+}
+
+uint32_t SceneBvh::add(const Mesh &mesh, const glm::mat4 &matrix) {
+  uint32_t object = object_count++;
+  add_instance(mesh, matrix, object);
+  return object;
+}
+
+void SceneBvh::add_instance(const Mesh &mesh, const glm::mat4 &matrix, uint32_t object) {
+  if (mesh.get_bvh() == nullptr || mesh.get_bvh()->get_triangle_count() == 0) {
+    return;
+  }
+  Instance instance;
+  instance.bvh = mesh.get_bvh();
+  instance.matrix = matrix;
+  instance.inverse = glm::inverse(matrix);
+  instance.normal_matrix = glm::transpose(glm::mat3(instance.inverse));
+  instance.min_scale = std::min(std::min(glm::length(glm::vec3(matrix[0])), glm::length(glm::vec3(matrix[1]))),
+                                glm::length(glm::vec3(matrix[2])));
+  instance.object = object;
+  instances.push_back(instance);
+}
+
+void SceneBvh::build() {
+  // 实例的世界包围盒由模型空间包围盒的八个角点变换得到
+  std::vector<Bvh::Aabb> bounds(instances.size());
+  for (uint32_t i = 0; i < instances.size(); ++i) {
+    const Bvh::Aabb &local = instances[i].bvh->get_bounds();
+    for (uint32_t corner = 0; corner < 8; ++corner) {
+      glm::vec3 point((corner & 1) ? local.max.x : local.min.x, (corner & 2) ? local.max.y : local.min.y,
+                      (corner & 4) ? local.max.z : local.min.z);
+      bounds[i].grow(glm::vec3(instances[i].matrix * glm::vec4(point, 1)));
+    }
+  }
+  std::vector<uint32_t> order;
+  Bvh::build(bounds, 1, nodes, order);
+  std::vector<Instance> sorted;
+  sorted.reserve(instances.size());
+  for (uint32_t index : order) {
+    sorted.push_back(instances[index]);
+  }
+  instances = std::move(sorted);
+}
+
+void SceneBvh::to_world(const Instance &instance, const MeshBvh::Hit &local, Hit &hit) noexcept {
+  hit.point = glm::vec3(instance.matrix * glm::vec4(local.point, 1));
+  hit.normal = glm::normalize(instance.normal_matrix * local.normal);
+  hit.object = instance.object;
+}
+
+bool SceneBvh::raycast(const glm::vec3 &origin, const glm::vec3 &dir, float max_t, Hit &hit) const noexcept {
+  bool found = false;
+  Bvh::Ray ray(origin, dir);
+  Bvh::traverse_ray(nodes, ray, 0, max_t, [&](uint32_t first, uint32_t count) {
+    for (uint32_t i = first; i < first + count; ++i) {
+      const Instance &instance = instances[i];
+      // 仿射变换下射线参数 t 不变
+      glm::vec3 local_origin = glm::vec3(instance.inverse * glm::vec4(origin, 1));
+      glm::vec3 local_dir = glm::mat3(instance.inverse) * dir;
+      MeshBvh::Hit local;
+      if (instance.bvh->raycast(local_origin, local_dir, max_t, local)) {
+        max_t = local.t;
+        hit.t = local.t;
+        to_world(instance, local, hit);
+        found = true;
+      }
+    }
+  });
+  return found;
+}
+
+bool SceneBvh::sweep_sphere(
+  const glm::vec3 &origin, const glm::vec3 &dir, float radius, float max_t, Hit &hit) const noexcept {
+  bool found = false;
+  Bvh::Ray ray(origin, dir);
+  Bvh::traverse_ray(nodes, ray, radius, max_t, [&](uint32_t first, uint32_t count) {
+    for (uint32_t i = first; i < first + count; ++i) {
+      const Instance &instance = instances[i];
+      glm::vec3 local_origin = glm::vec3(instance.inverse * glm::vec4(origin, 1));
+      glm::vec3 local_dir = glm::mat3(instance.inverse) * dir;
+      MeshBvh::Hit local;
+      if (instance.bvh->sweep_sphere(local_origin, local_dir, radius / instance.min_scale, max_t, local)) {
+        max_t = local.t;
+        hit.t = local.t;
+        to_world(instance, local, hit);
+        found = true;
+      }
+    }
+  });
+  return found;
+}
+
+bool SceneBvh::closest_point(const glm::vec3 &point, float max_distance, Hit &hit) const noexcept {
+  bool found = false;
+  float max_distance2 = max_distance * max_distance;
+  Bvh::traverse_nearest(nodes, point, max_distance2, [&](uint32_t first, uint32_t count) {
+    for (uint32_t i = first; i < first + count; ++i) {
+      const Instance &instance = instances[i];
+      glm::vec3 local_point = glm::vec3(instance.inverse * glm::vec4(point, 1));
+      MeshBvh::Hit local;
+      if (!instance.bvh->closest_point(local_point, std::sqrt(max_distance2) / instance.min_scale, local)) {
+        continue;
+      }
+      // 缩放后模型空间的距离与世界空间不同，按世界空间重新比较
+      Hit world;
+      to_world(instance, local, world);
+      glm::vec3 offset = point - world.point;
+      float distance2 = glm::dot(offset, offset);
+      if (distance2 >= max_distance2) {
+        continue;
+      }
+      max_distance2 = distance2;
+      hit = world;
+      hit.t = std::sqrt(distance2);
+      if (hit.t > 1e-6f) {
+        hit.normal = offset / hit.t;
+      }
+      found = true;
+    }
+  });
+  return found;
+}
+
+glm::vec3 SceneBvh::slide_sphere(glm::vec3 position, glm::vec3 delta, float radius) const noexcept {
+  Hit hit;
+  if (closest_point(position, radius, hit) && hit.t > 0) {
+    position += hit.normal * (radius + SKIN - hit.t);
+  }
+  for (uint32_t i = 0; i < MAX_SLIDES; ++i) {
+    float length = glm::length(delta);
+    if (length <= 1e-6f) {
+      break;
+    }
+    // 多扫过 SKIN 的距离，终点离表面不足 SKIN 时也算接触
+    float skin_t = SKIN / length;
+    if (!sweep_sphere(position, delta, radius, 1.0f + skin_t, hit)) {
+      position += delta;
+      break;
+    }
+    // 停在接触点前 SKIN 处，剩余的位移投影到接触面上
+    float t = std::min(std::max(hit.t - skin_t, 0.0f), 1.0f);
+    position += delta * t;
+    delta *= 1.0f - t;
+    delta -= hit.normal * glm::dot(delta, hit.normal);
+  }
+  return position;
+}
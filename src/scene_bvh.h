@@ -0,0 +1,70 @@
+#ifndef __SCENE_BVH_H__
+#define __SCENE_BVH_H__
+
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "bvh.h"
+#include "mesh.h"
+#include "model.h"
+
+/** 场景级的 BVH
+ * 叶子为摆放好的网格实例（网格的 MeshBvh 加上世界变换），查询先在实例的世界包围盒上遍历，
+ * 再把射线或点变换到网格的模型空间中查询网格自身的 BVH。
+ * 实例的变换在 add 时记录，build 后只读，可以在模拟线程上查询。
+ * 非均匀缩放的实例中球按最小缩放轴换算半径，结果偏保守
+ */
+class SceneBvh {
+public:
+  typedef std::shared_ptr<SceneBvh> Ptr;
+
+  // 查询结果，均在世界空间中
+  struct Hit {
+    float t = 0;                            // 射线 / 球心运动的参数，closest_point 中为距离
+    glm::vec3 point = glm::vec3(0);         // 表面上的接触点
+    glm::vec3 normal = glm::vec3(0, 1, 0);  // 单位法线，朝向查询一侧
+    uint32_t object = 0;                    // add 返回的物体编号
+  };
+
+  // 以当前变换加入模型的全部网格，返回物体编号；未构建 BVH 的网格被忽略
+  uint32_t add(const Model &model);
+  uint32_t add(const Mesh &mesh, const glm::mat4 &matrix);
+  void build();
+
+  bool raycast(const glm::vec3 &origin, const glm::vec3 &dir, float max_t, Hit &hit) const noexcept;
+  bool sweep_sphere(const glm::vec3 &origin, const glm::vec3 &dir, float radius, float max_t, Hit &hit) const noexcept;
+  bool closest_point(const glm::vec3 &point, float max_distance, Hit &hit) const noexcept;
+
+  /** 半径为 radius 的球从 position 移动 delta，碰到表面时去掉沿法线的分量继续滑动，返回最终位置。
+   * 开始前先把已经嵌入表面的球推出
+   */
+  glm::vec3 slide_sphere(glm::vec3 position, glm::vec3 delta, float radius) const noexcept;
+
+  uint32_t get_object_count() const noexcept { return object_count; }
+  uint32_t get_instance_count() const noexcept { return instances.size(); }
+
+private:
+  struct Instance {
+    MeshBvh::Ptr bvh;
+    glm::mat4 matrix;
+    glm::mat4 inverse;
+    glm::mat3 normal_matrix;
+    float min_scale;  // 三个轴中最小的缩放
+    uint32_t object;
+  };
+
+  void add_instance(const Mesh &mesh, const glm::mat4 &matrix, uint32_t object);
+  // 把实例模型空间中的结果变换回世界空间
+  static void to_world(const Instance &instance, const MeshBvh::Hit &local, Hit &hit) noexcept;
+
+private:
+  std::vector<Instance> instances;  // build 后按叶子顺序排列
+  std::vector<Bvh::Node> nodes;
+  uint32_t object_count = 0;
+};
+
+#endif  // !__SCENE_BVH_H__
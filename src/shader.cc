@@ -7,14 +7,131 @@
 #include <ostream>
 #include <stdint.h>
 
+#include <algorithm>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <string_view>
 
-Shader::Shader(const std::string_view &src_path) : m_id(GL_ZERO) {
-  // read the source into "m_src"
+#include "vertex_format.h"
+
+/*-----程序二进制缓存-------*/
+static std::string binary_cache_dir = "shader_cache";
+
+static uint64_t fnv1a64(const std::string_view &data, uint64_t hash = 0xcbf29ce484222325ull) noexcept {
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+static bool binary_cache_supported() noexcept {
+  static int supported = -1;
+  if (supported < 0) {
+    GLint formats = 0;
+    if (GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_get_program_binary) {
+      glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    }
+    supported = formats > 0 ? 1 : 0;
+  }
+  return supported == 1;
+}
+
+static bool parallel_compile_supported() noexcept {
+  return GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile;
+}
+
+// 驱动升级后旧的二进制失效，因此驱动信息也是键的一部分
+static uint64_t program_key(const std::vector<Shader::Ptr> &shaders) noexcept {
+  uint64_t hash = fnv1a64(reinterpret_cast<const char *>(glGetString(GL_VENDOR)));
+  hash = fnv1a64(reinterpret_cast<const char *>(glGetString(GL_RENDERER)), hash);
+  hash = fnv1a64(reinterpret_cast<const char *>(glGetString(GL_VERSION)), hash);
+  // 属性位置在链接前绑定，同样固化在二进制中
+  hash = fnv1a64(std::to_string(VertexFormat::layout_version()), hash);
+  for (auto shader : shaders) {
+    hash = fnv1a64(std::to_string(shader->get_type()), hash);
+    hash = fnv1a64(shader->get_source(), hash);
+  }
+  return hash;
+}
+
+static std::filesystem::path binary_cache_path(uint64_t key) {
+  std::stringstream ss;
+  ss << std::hex << key << ".bin";
+  return std::filesystem::path(binary_cache_dir) / ss.str();
+}
+
+// 文件格式: GLenum binary_format + 程序二进制
+static bool load_program_binary(GLuint program, uint64_t key) noexcept {
+  std::ifstream fd(binary_cache_path(key), std::ios::in | std::ios::binary);
+  if (!fd.is_open()) {
+    return false;
+  }
+  GLenum format = 0;
+  if (!fd.read(reinterpret_cast<char *>(&format), sizeof(format))) {
+    return false;
+  }
+  std::string binary((std::istreambuf_iterator<char>(fd)), std::istreambuf_iterator<char>());
+  if (binary.empty()) {
+    return false;
+  }
+  glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+  return true;
+}
+
+static void save_program_binary(GLuint program, uint64_t key) noexcept {
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return;
+  }
+  std::string binary(length, '\0');
+  GLenum format = 0;
+  glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+  std::error_code ec;
+  std::filesystem::create_directories(binary_cache_dir, ec);
+  std::ofstream fd(binary_cache_path(key), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!fd.is_open()) {
+    std::cout << "[WARN::ShaderProgram] Program binary cache not writable: " << binary_cache_dir << std::endl;
+    return;
+  }
+  fd.write(reinterpret_cast<const char *>(&format), sizeof(format));
+  fd.write(binary.data(), binary.size());
+}
+
+/*-----Shader-------*/
+Shader::Shader(GLenum shader_type, const std::string_view &src_path, const std::vector<std::string> &defines)
+    : m_type(shader_type), m_id(GL_ZERO) {
+  m_src = read_source(src_path);
+  if (defines.empty()) {
+    return;
+  }
+  // 在 #version 行之后插入宏定义
+  std::string define_lines;
+  for (const auto &define : defines) {
+    define_lines += "#define " + define + "\n";
+  }
+  size_t pos = 0;
+  if (m_src.compare(0, 8, "#version") == 0) {
+    pos = m_src.find('\n');
+    pos = pos == std::string::npos ? m_src.size() : pos + 1;
+  }
+  m_src.insert(pos, define_lines);
+}
+
+Shader::~Shader() {
+  if (m_id != 0) {
+    glDeleteShader(m_id);
+  }
+}
+
+// 读取文件内容，失败时输出错误并返回空字符串
+static std::string read_file(const std::string_view &src_path) noexcept {
+  // read the source into string
   std::ifstream fd;
   std::stringstream ss;
   try {
@@ -25,17 +142,62 @@ Shader::Shader(const std::string_view &src_path) : m_id(GL_ZERO) {
     ss << fd.rdbuf();
     fd.close();
   } catch (std::ifstream::failure e) {
-    std::cout << "[ERROR::Shader] Source File Not Successfully Read: " << e.what() << std::endl;
+    std::cout << "[ERROR::Shader] Source File Not Successfully Read: " << src_path << " " << e.what() << std::endl;
   }
-  m_src = ss.str();
+  return ss.str();
 }
 
-Shader::~Shader() {
-  if (m_id != 0) {
-    glDeleteShader(m_id);
+static std::string expand_includes(const std::filesystem::path &src_path, std::vector<std::filesystem::path> &included,
+                                   uint32_t depth) noexcept {
+  constexpr uint32_t MAX_DEPTH = 16;
+  std::string src = read_file(src_path.string());
+  std::string result;
+  result.reserve(src.size());
+  std::istringstream lines(src);
+  std::string line;
+  uint32_t line_number = 0;
+  while (std::getline(lines, line)) {
+    ++line_number;
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+      result += line;
+      result += '\n';
+      continue;
+    }
+    size_t open = line.find('"', start + 8);
+    size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+    if (close == std::string::npos || depth >= MAX_DEPTH) {
+      std::cout << "[ERROR::Shader] Invalid #include in " << src_path.string() << ":" << line_number << std::endl;
+      continue;
+    }
+    std::filesystem::path path = (src_path.parent_path() / line.substr(open + 1, close - open - 1)).lexically_normal();
+    if (std::find(included.begin(), included.end(), path) == included.end()) {
+      included.push_back(path);
+      result += expand_includes(path, included, depth + 1);
+    }
+    // 编译日志中的行号仍对应包含它的文件
+    result += "#line " + std::to_string(line_number + 1) + "\n";
   }
+  return result;
+}
+
+std::string Shader::read_source(const std::string_view &src_path) noexcept {
+  std::vector<std::filesystem::path> included;
+  return expand_includes(std::filesystem::path(src_path).lexically_normal(), included, 0);
 }
 
+void Shader::compile() noexcept {
+  if (m_id != GL_ZERO) {
+    return;
+  }
+  this->m_id = glCreateShader(m_type);
+  auto src_cstr = this->m_src.c_str();
+  glShaderSource(this->m_id, 1, &src_cstr, nullptr);
+  glCompileShader(this->m_id);
+}
+
+bool Shader::get_status() const noexcept { return m_id != GL_ZERO && check_compile_status(this, m_type) == 0x0; }
+
 int32_t Shader::check_compile_status(const Shader *shader, GLenum shader_type) {
   int32_t sucess;
   char log[512];
@@ -48,6 +210,7 @@ int32_t Shader::check_compile_status(const Shader *shader, GLenum shader_type) {
   if (sucess == GL_TRUE) {
     return 0x0;
   }
+  glGetShaderInfoLog(shader_id, 512, nullptr, log);
   // cout error info
   std::string shader_type_str;
   switch (shader_type) {
@@ -66,44 +229,30 @@ int32_t Shader::check_compile_status(const Shader *shader, GLenum shader_type) {
 }
 
 
-VertexShader::VertexShader(const std::string_view &src_path) : Shader(src_path) {
-  this->m_id = glCreateShader(GL_VERTEX_SHADER);
-  auto src_cstr = this->m_src.c_str();
-  glShaderSource(this->m_id, 1, &src_cstr, nullptr);
-  glCompileShader(this->m_id);
-  int32_t rt = check_compile_status(this, GL_VERTEX_SHADER);
-  if (rt != 0x0) {
-    m_status = false;
-  } else {
-    m_status = true;
-  }
-}
+VertexShader::VertexShader(const std::string_view &src_path, const std::vector<std::string> &defines)
+    : Shader(GL_VERTEX_SHADER, src_path, defines) {}
 
-FragmentShader::FragmentShader(const std::string_view &src_path) : Shader(src_path) {
-  this->m_id = glCreateShader(GL_FRAGMENT_SHADER);
-  auto src_cstr = this->m_src.c_str();
-  glShaderSource(this->m_id, 1, &src_cstr, nullptr);
-  glCompileShader(this->m_id);
-  int32_t rt = check_compile_status(this, GL_FRAGMENT_SHADER);
-  if (rt != 0x0) {
-    m_status = false;
-  } else {
-    m_status = true;
+FragmentShader::FragmentShader(const std::string_view &src_path, const std::vector<std::string> &defines)
+    : Shader(GL_FRAGMENT_SHADER, src_path, defines) {}
+
+/*-----ShaderProgram-------*/
+void ShaderProgram::set_binary_cache_dir(const std::string &dir) noexcept { binary_cache_dir = dir; }
+
+void ShaderProgram::enable_parallel_compile() noexcept {
+  if (GLAD_GL_KHR_parallel_shader_compile) {
+    // 0xFFFFFFFF 表示由驱动决定线程数
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+  } else if (GLAD_GL_ARB_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
   }
 }
 
 ShaderProgram::ShaderProgram(const std::string_view &vertex_shader_filename,
-                             const std::string_view &fragement_shader_filename) {
+                             const std::string_view &fragement_shader_filename,
+                             const std::vector<std::string> &defines) {
   std::vector<Shader::Ptr> shaders;
-  Shader::Ptr vertex_shader = std::make_shared<VertexShader>(vertex_shader_filename);
-  Shader::Ptr fragement_shader = std::make_shared<FragmentShader>(fragement_shader_filename);
-  if (vertex_shader->get_status()) {
-    shaders.push_back(vertex_shader);
-  }
-
-  if (fragement_shader->get_status()) {
-    shaders.push_back(fragement_shader);
-  }
+  shaders.push_back(std::make_shared<VertexShader>(vertex_shader_filename, defines));
+  shaders.push_back(std::make_shared<FragmentShader>(fragement_shader_filename, defines));
   this->init(shaders);
 }
 
@@ -111,24 +260,73 @@ ShaderProgram::ShaderProgram(const std::vector<Shader::Ptr> &shaders) { this->in
 
 void ShaderProgram::init(const std::vector<Shader::Ptr> &shaders) noexcept {
   this->m_id = glCreateProgram();
-  for (auto idx : shaders) {
-    glAttachShader(this->m_id, idx->get_id());
+  this->m_shaders = shaders;
+  if (!binary_cache_dir.empty() && binary_cache_supported()) {
+    m_key = program_key(shaders);
+    m_from_cache = load_program_binary(m_id, m_key);
+  }
+  if (!m_from_cache) {
+    link_from_source();
+  }
+}
+
+void ShaderProgram::link_from_source() const noexcept {
+  for (auto shader : m_shaders) {
+    shader->compile();
+    glAttachShader(this->m_id, shader->get_id());
+  }
+  if (!binary_cache_dir.empty() && binary_cache_supported()) {
+    glProgramParameteri(this->m_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
   }
+  VertexFormat::bind_attrib_locations(this->m_id);
   glLinkProgram(this->m_id);
+}
+
+bool ShaderProgram::is_ready() const noexcept {
+  if (m_linked || !parallel_compile_supported()) {
+    return true;
+  }
+  GLint completed = GL_TRUE;
+  glGetProgramiv(this->m_id, GL_COMPLETION_STATUS_KHR, &completed);
+  return completed == GL_TRUE;
+}
+
+void ShaderProgram::finish_link() const noexcept {
+  if (m_linked) {
+    return;
+  }
+  m_linked = true;
   int success{};
-  char log_info[512];
   glGetProgramiv(this->m_id, GL_LINK_STATUS, &success);
+  if (!success && m_from_cache) {
+    // 驱动拒绝了缓存的二进制，退回源码编译
+    m_from_cache = false;
+    link_from_source();
+    glGetProgramiv(this->m_id, GL_LINK_STATUS, &success);
+  }
   if (!success) {
+    char log_info[512];
+    for (auto shader : m_shaders) {
+      shader->get_status();
+    }
     glGetProgramInfoLog(this->m_id, 512, nullptr, log_info);
     std::cout << "[ERROR::ShaderProgram] Program Link Failed\n" << log_info << std::endl;
+  } else if (!m_from_cache && m_key != 0) {
+    save_program_binary(this->m_id, m_key);
+  }
+  for (auto shader : m_shaders) {
+    if (shader->get_id() != GL_ZERO) {
+      glDetachShader(this->m_id, shader->get_id());
+    }
   }
+  m_shaders.clear();
 }
+
 ShaderProgram::~ShaderProgram() {
   if (this->m_id != GL_ZERO) {
     glDeleteProgram(this->m_id);
   }
 }
-
 void ShaderProgram::set_uniform(const std::string_view &name, bool value) const noexcept {
   this->use();
   glUniform1i(glGetUniformLocation(this->m_id, name.data()), static_cast<int>(value));
@@ -141,6 +339,10 @@ void ShaderProgram::set_uniform(const std::string_view &name, GLfloat value) con
   this->use();
   glUniform1f(glGetUniformLocation(this->m_id, name.data()), value);
 }
+void ShaderProgram::set_uniform(const std::string_view &name, const glm::vec2 &value) const noexcept {
+  this->use();
+  glUniform2fv(glGetUniformLocation(this->m_id, name.data()), 1, glm::value_ptr(value));
+}
 void ShaderProgram::set_uniform(const std::string_view &name, const glm::vec3 &value) const noexcept {
   this->use();
   glUniform3fv(glGetUniformLocation(this->m_id, name.data()), 1, glm::value_ptr(value));
@@ -176,4 +378,7 @@ void ShaderProgram::set_material(const std::string_view &name, const Material& v
   set_uniform(prefix + "specular", value.specular);
 }
 
-void ShaderProgram::use() const noexcept { glUseProgram(this->m_id); }
+void ShaderProgram::use() const noexcept {
+  finish_link();
+  glUseProgram(this->m_id);
+}
@@ -17,48 +17,75 @@
 class Shader {
 public:
   typedef std::shared_ptr<Shader> Ptr;
-  explicit Shader(const std::string_view &src_path);
+  // defines 以 "NAME" 或 "NAME VALUE" 的形式插入到 #version 之后
+  explicit Shader(GLenum shader_type, const std::string_view &src_path, const std::vector<std::string> &defines = {});
   ~Shader();
 
+  // 提交编译但不等待结果，编译状态在链接失败时才查询；重复调用为空操作
+  void compile() noexcept;
+
   constexpr GLuint get_id() const noexcept { return this->m_id; }
-  constexpr bool get_status() const noexcept { return this->m_status; }
+  constexpr GLenum get_type() const noexcept { return this->m_type; }
+  const std::string &get_source() const noexcept { return this->m_src; }
+  bool get_status() const noexcept;
 
 public:
   static int32_t check_compile_status(const Shader *shader, GLenum shader_type);
+  /** 读取源码，并展开其中独占一行的 #include "file"
+   * file 相对于包含它的文件所在目录，可以嵌套，同一文件只展开一次；
+   * 多个着色器共用的代码 (如地形顶点、蒙皮) 放在 shaders/ 下的 .glsl 片段中，保证各处完全一致
+   */
+  static std::string read_source(const std::string_view &src_path) noexcept;
 
 protected:
+  GLenum m_type;
   GLuint m_id = 0;
   std::string m_src;
-  bool m_status = false;
 };
 
 class VertexShader : public Shader {
 public:
   typedef std::shared_ptr<VertexShader> Ptr;
-  explicit VertexShader(const std::string_view &src_path);
+  explicit VertexShader(const std::string_view &src_path, const std::vector<std::string> &defines = {});
 };
 
 class FragmentShader : public Shader {
 public:
   typedef std::shared_ptr<FragmentShader> Ptr;
-  explicit FragmentShader(const std::string_view &src_path);
+  explicit FragmentShader(const std::string_view &src_path, const std::vector<std::string> &defines = {});
 };
 
+/** 着色器程序
+ * 构造时只提交编译与链接，不等待驱动完成，多个程序可以由驱动并行编译
+ * (KHR_parallel_shader_compile)；链接状态在第一次 use/get_id 时才查询
+ * 设置了二进制缓存目录时，以源码 + 驱动信息的哈希为键缓存 glGetProgramBinary 的结果，
+ * 再次启动时直接 glProgramBinary，驱动不接受时退回源码编译
+ */
 class ShaderProgram {
 public:
   typedef std::shared_ptr<ShaderProgram> Ptr;
-  explicit ShaderProgram(const std::string_view &vertex_shader_filename, const std::string_view &fragement_shader_filename);
+  explicit ShaderProgram(const std::string_view &vertex_shader_filename,
+                         const std::string_view &fragement_shader_filename,
+                         const std::vector<std::string> &defines = {});
   explicit ShaderProgram(const std::vector<Shader::Ptr> &shaders);
 
   ~ShaderProgram();
 
 public:
   void use() const noexcept;
-  constexpr GLuint get_id() const noexcept { return this->m_id; }
+  GLuint get_id() const noexcept {
+    finish_link();
+    return this->m_id;
+  }
+  // 驱动是否已完成链接，不阻塞；不支持并行编译时总是返回 true
+  bool is_ready() const noexcept;
+  // 是否从程序二进制缓存中载入
+  constexpr bool is_from_cache() const noexcept { return this->m_from_cache; }
 
   void set_uniform(const std::string_view &name, bool value) const noexcept;
   void set_uniform(const std::string_view &name, GLint value) const noexcept;
   void set_uniform(const std::string_view &name, GLfloat value) const noexcept;
+  void set_uniform(const std::string_view &name, const glm::vec2 &value) const noexcept;
   void set_uniform(const std::string_view &name, const glm::vec3 &value) const noexcept;
   void set_uniform(const std::string_view &name, const glm::vec4 &value) const noexcept;
   void set_uniform(const std::string_view &name, const glm::mat4 &value) const noexcept;
@@ -66,11 +93,25 @@ public:
   void set_light(const std::string_view &name, const Light& value) const noexcept;
   void set_material(const std::string_view &name, const Material& value) const noexcept;
 
+public:
+  // 程序二进制缓存目录，空字符串表示不使用缓存
+  static void set_binary_cache_dir(const std::string &dir) noexcept;
+  // 允许驱动使用后台线程编译 (KHR/ARB_parallel_shader_compile)，需在创建程序前调用
+  static void enable_parallel_compile() noexcept;
+
 private:
   void init(const std::vector<Shader::Ptr> &shaders) noexcept;
+  void link_from_source() const noexcept;
+  // 等待链接完成并检查结果，只在第一次调用时生效
+  void finish_link() const noexcept;
 
 private:
-  GLuint m_id;
+  GLuint m_id = GL_ZERO;
+  uint64_t m_key = 0;
+  mutable bool m_from_cache = false;
+  // 链接完成前保留着色器，以便输出编译日志或在二进制失效时重新编译
+  mutable std::vector<Shader::Ptr> m_shaders;
+  mutable bool m_linked = false;
 };
 
 
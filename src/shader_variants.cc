@@ -0,0 +1,31 @@
+#include "shader_variants.h"
+
+#include <iostream>
+
+ShaderVariants::ShaderVariants(const std::string &vertex_shader_filename,
+                               const std::string &fragment_shader_filename,
+                               const std::vector<std::string> &features)
+    : vertex_shader_filename(vertex_shader_filename),
+      fragment_shader_filename(fragment_shader_filename),
+      features(features) {}
+
+ShaderProgram::Ptr ShaderVariants::get(uint32_t mask) noexcept {
+  auto iter = variants.find(mask);
+  if (iter != variants.end()) {
+    return iter->second;
+  }
+
+  std::vector<std::string> defines;
+  for (uint32_t i = 0; i < features.size(); ++i) {
+    if (mask & (1u << i)) {
+      defines.push_back(features[i]);
+    }
+  }
+  if (features.size() < 32 && mask >> features.size() != 0) {
+    std::cout << "[WARN::ShaderVariants] Unknown feature bits in mask " << mask << " for " << fragment_shader_filename
+              << std::endl;
+  }
+  auto program = std::make_shared<ShaderProgram>(vertex_shader_filename, fragment_shader_filename, defines);
+  variants.insert({mask, program});
+  return program;
+}
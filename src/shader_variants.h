@@ -0,0 +1,36 @@
+#ifndef __SHADER_VARIANTS_H__
+#define __SHADER_VARIANTS_H__
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "shader.h"
+
+/** 着色器族：同一份源码按特性位掩码插入不同的 #define 生成变体
+ * 第 i 位对应 features[i]，变体在第一次 get 时才创建并缓存，
+ * 之后同一掩码总是返回同一个 ShaderProgram
+ */
+class ShaderVariants {
+public:
+  typedef std::shared_ptr<ShaderVariants> Ptr;
+
+  ShaderVariants(const std::string &vertex_shader_filename,
+                 const std::string &fragment_shader_filename,
+                 const std::vector<std::string> &features);
+
+  ShaderProgram::Ptr get(uint32_t mask) noexcept;
+  // 已创建的变体，用于统一设置每帧的 uniform
+  const std::unordered_map<uint32_t, ShaderProgram::Ptr> &get_compiled() const noexcept { return variants; }
+
+private:
+  std::string vertex_shader_filename;
+  std::string fragment_shader_filename;
+  std::vector<std::string> features;
+  std::unordered_map<uint32_t, ShaderProgram::Ptr> variants;
+};
+
+#endif  // !__SHADER_VARIANTS_H__
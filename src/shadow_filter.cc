@@ -0,0 +1,57 @@
+#include "shadow_filter.h"
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+ShadowFilter::ShadowFilter() {
+  glGenSamplers(1, &depth_sampler);
+  glSamplerParameteri(depth_sampler, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+  glSamplerParameteri(depth_sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glSamplerParameteri(depth_sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glSamplerParameteri(depth_sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+  glSamplerParameteri(depth_sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+  GLfloat border_color[] = {1.0, 1.0, 1.0, 1.0};
+  glSamplerParameterfv(depth_sampler, GL_TEXTURE_BORDER_COLOR, border_color);
+}
+
+ShadowFilter::~ShadowFilter() {
+  if (depth_sampler != GL_ZERO) {
+    glDeleteSamplers(1, &depth_sampler);
+  }
+}
+
+void ShadowFilter::bind_depth(GLuint shadow_texture) const noexcept {
+  if (tier != PCSS) {
+    return;
+  }
+  glActiveTexture(GL_TEXTURE0 + DEPTH_UNIT);
+  glBindTexture(GL_TEXTURE_2D, shadow_texture);
+  glBindSampler(DEPTH_UNIT, depth_sampler);
+  glActiveTexture(GL_TEXTURE0);
+}
+
+void ShadowFilter::bind(ShaderProgram::Ptr shader) const noexcept {
+  shader->set_uniform("shadowDepth", DEPTH_UNIT);
+  shader->set_uniform("shadowPenumbraScale", penumbra_scale);
+}
+
+void ShadowFilter::set_light_size(float angle_degree, float depth_range, float ortho_width) noexcept {
+  // 深度差 d (0~1) 对应世界距离 d * depth_range，半影宽度为距离 × tan(张角)，再换算到纹理坐标
+  penumbra_scale = std::tan(glm::radians(angle_degree)) * depth_range / ortho_width;
+}
+
+const char *ShadowFilter::tier_name(Tier tier) noexcept {
+  switch (tier) {
+  case HardwarePCF:
+    return "hardware pcf";
+  case PoissonPCF:
+    return "poisson pcf";
+  case PCSS:
+    return "pcss";
+  case EVSM:
+    return "evsm";
+  default:
+    return "unknown";
+  }
+}
@@ -0,0 +1,55 @@
+#ifndef __SHADOW_FILTER_H__
+#define __SHADOW_FILTER_H__
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+
+#include <memory>
+
+#include "shader.h"
+
+/** 阴影过滤等级
+ * 阴影深度图以 GL_COMPARE_REF_TO_TEXTURE 创建，着色器通过 sampler2DShadow 做硬件 PCF；
+ * PCSS 搜索遮挡物需要原始深度，通过一个关闭比较的采样器对象把同一张纹理
+ * 绑定到 DEPTH_UNIT 上 (采样器对象的状态覆盖纹理自身的状态)
+ * 等级对应着色器中的宏，切换等级即切换着色器变体
+ */
+class ShadowFilter {
+public:
+  typedef std::shared_ptr<ShadowFilter> Ptr;
+
+  enum Tier {
+    HardwarePCF = 0,  // 1 次双线性硬件 PCF
+    PoissonPCF = 1,   // 16 次旋转泊松盘硬件 PCF
+    PCSS = 2,         // 软阴影
+    EVSM = 3,         // 指数方差阴影，见 VarianceShadowMap
+    TIER_COUNT
+  };
+
+  static constexpr GLint DEPTH_UNIT = 23;
+
+  ShadowFilter();
+  ShadowFilter(const ShadowFilter &oth) = delete;
+  ShadowFilter &operator=(const ShadowFilter &oth) = delete;
+  ~ShadowFilter();
+
+  // 设置相关 uniform
+  void bind(ShaderProgram::Ptr shader) const noexcept;
+  // 把本帧的阴影深度以关闭比较的采样器绑定到 DEPTH_UNIT，供 PCSS 使用
+  void bind_depth(GLuint shadow_texture) const noexcept;
+  // 按正交阴影相机的尺寸与光源张角计算半影比例
+  void set_light_size(float angle_degree, float depth_range, float ortho_width) noexcept;
+
+  static Tier next_tier(Tier tier) noexcept { return static_cast<Tier>((tier + 1) % TIER_COUNT); }
+  static const char *tier_name(Tier tier) noexcept;
+
+public:
+  Tier tier = PoissonPCF;
+
+private:
+  GLuint depth_sampler = GL_ZERO;
+  float penumbra_scale = 0;
+};
+
+#endif  // !__SHADOW_FILTER_H__
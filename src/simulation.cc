@@ -0,0 +1,146 @@
+#include "simulation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// 沿最短路径插值角度（角度制），欧拉角在模拟中会不断累加或回绕
+float lerp_angle(float a, float b, float t) noexcept {
+  float delta = b - a;
+  delta -= 360.0f * std::floor((delta + 180.0f) / 360.0f);
+  return a + delta * t;
+}
+
+glm::vec3 lerp_angles(const glm::vec3 &a, const glm::vec3 &b, float t) noexcept {
+  return glm::vec3(lerp_angle(a.x, b.x, t), lerp_angle(a.y, b.y, t), lerp_angle(a.z, b.z, t));
+}
+
+Transform lerp_transform(const Transform &a, const Transform &b, float t) noexcept {
+  glm::vec3 offset = b.translate - a.translate;
+  if (glm::dot(offset, offset) > Simulation::TELEPORT_DISTANCE * Simulation::TELEPORT_DISTANCE) {
+    return b;
+  }
+  return {glm::mix(a.translate, b.translate, t), lerp_angles(a.rotate, b.rotate, t), glm::mix(a.scale, b.scale, t)};
+}
+}  // namespace
+
+void Transform::apply(Model &model) const noexcept {
+  model.translate = translate;
+  model.rotate = rotate;
+  model.scale = scale;
+}
+
+CameraPose CameraPose::capture(const Camera &camera) noexcept {
+  return {camera.position, camera.direction, camera.pitch, camera.yaw, camera.mode};
+}
+
+void CameraPose::apply(Camera &camera) const noexcept {
+  camera.position = position;
+  camera.direction = direction;
+  camera.pitch = pitch;
+  camera.yaw = yaw;
+  camera.mode = mode;
+}
+
+void WorldState::lerp(const WorldState &a, const WorldState &b, float t, WorldState &out) noexcept {
+  out.snowman = lerp_transform(a.snowman, b.snowman, t);
+  out.snowman_firstpersonal = lerp_transform(a.snowman_firstpersonal, b.snowman_firstpersonal, t);
+
+  out.snowflakes.resize(b.snowflakes.size());
+  size_t common = std::min(a.snowflakes.size(), b.snowflakes.size());
+  for (size_t i = 0; i < common; ++i) {
+    out.snowflakes[i] = lerp_transform(a.snowflakes[i], b.snowflakes[i], t);
+  }
+  std::copy(b.snowflakes.begin() + common, b.snowflakes.end(), out.snowflakes.begin() + common);
+
+  // 切换第一人称时相机会跳变，与瞬移的物体一样直接取新状态
+  glm::vec3 offset = b.camera.position - a.camera.position;
+  if (a.camera.mode != b.camera.mode || glm::dot(offset, offset) > Simulation::TELEPORT_DISTANCE * Simulation::TELEPORT_DISTANCE) {
+    out.camera = b.camera;
+  } else {
+    out.camera.position = glm::mix(a.camera.position, b.camera.position, t);
+    glm::vec3 direction = glm::mix(a.camera.direction, b.camera.direction, t);
+    out.camera.direction = glm::dot(direction, direction) > 1e-8f ? glm::normalize(direction) : b.camera.direction;
+    out.camera.pitch = glm::mix(a.camera.pitch, b.camera.pitch, t);
+    out.camera.yaw = lerp_angle(a.camera.yaw, b.camera.yaw, t);
+    out.camera.mode = b.camera.mode;
+  }
+
+  out.light_position = glm::mix(a.light_position, b.light_position, t);
+  out.first_personal = b.first_personal;
+}
+
+void InputState::consume() noexcept {
+  pressed_keys.clear();
+  mouse_offset = glm::vec2(0, 0);
+  right_clicks = 0;
+}
+
+Simulation::Simulation(StepFunc step, float rate) : step(std::move(step)), dt(1.0f / rate) {}
+
+Simulation::~Simulation() { stop(); }
+
+void Simulation::start(const WorldState &initial) {
+  if (running) {
+    return;
+  }
+  previous = initial;
+  current = initial;
+  back = initial;
+  current_time = Clock::now();
+  running = true;
+  worker = std::thread(&Simulation::run, this);
+}
+
+void Simulation::stop() noexcept {
+  running = false;
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+void Simulation::update_input(const std::function<void(InputState &input)> &modify) {
+  std::lock_guard<std::mutex> lock(input_mutex);
+  modify(pending_input);
+}
+
+float Simulation::interpolate(WorldState &out) {
+  std::lock_guard<std::mutex> lock(state_mutex);
+  std::chrono::duration<float> elapsed = Clock::now() - current_time;
+  float alpha = std::clamp(elapsed.count() / dt, 0.0f, 1.0f);
+  WorldState::lerp(previous, current, alpha, out);
+  return alpha;
+}
+
+void Simulation::run() noexcept {
+  const auto step_duration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(dt));
+  Clock::time_point next_tick = current_time + step_duration;
+  InputState input;
+  while (running) {
+    std::this_thread::sleep_until(next_tick);
+
+    uint32_t steps = 0;
+    while (next_tick <= Clock::now() && steps < MAX_CATCH_UP_STEPS) {
+      {
+        std::lock_guard<std::mutex> lock(input_mutex);
+        input = pending_input;
+        pending_input.consume();
+      }
+      step(input, dt, back);
+      ++steps;
+
+      // 新状态成为 current，原 current 成为插值起点
+      {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        std::swap(previous, current);
+        std::swap(current, back);
+        current_time = next_tick;
+      }
+      ticks.fetch_add(1, std::memory_order_relaxed);
+      next_tick += step_duration;
+    }
+    if (steps == MAX_CATCH_UP_STEPS) {
+      next_tick = Clock::now() + step_duration;
+    }
+  }
+}
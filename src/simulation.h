@@ -0,0 +1,121 @@
+#ifndef __SIMULATION_H__
+#define __SIMULATION_H__
+
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "camera.h"
+#include "model.h"
+
+// 物体的变换，角度制欧拉角
+struct Transform {
+  glm::vec3 translate = glm::vec3(0, 0, 0);
+  glm::vec3 rotate = glm::vec3(0, 0, 0);
+  glm::vec3 scale = glm::vec3(1, 1, 1);
+
+  static Transform capture(const Model &model) noexcept { return {model.translate, model.rotate, model.scale}; }
+  void apply(Model &model) const noexcept;
+};
+
+// 相机位姿，投影参数由渲染线程维护
+struct CameraPose {
+  glm::vec3 position = glm::vec3(0, 0, 0);
+  glm::vec3 direction = glm::vec3(0, 0, -1);
+  float pitch = 0.0f, yaw = 0.0f;
+  uint64_t mode = Camera::EulerAngle | Camera::Perspective;
+
+  static CameraPose capture(const Camera &camera) noexcept;
+  void apply(Camera &camera) const noexcept;
+};
+
+// 一次模拟步进后的完整世界状态，渲染线程只读
+struct WorldState {
+  Transform snowman;
+  Transform snowman_firstpersonal;
+  std::vector<Transform> snowflakes;
+  CameraPose camera;
+  glm::vec3 light_position = glm::vec3(0, 0, 0);
+  bool first_personal = false;
+
+  // 在 a、b 之间按 t 插值，离散量取 b
+  static void lerp(const WorldState &a, const WorldState &b, float t, WorldState &out) noexcept;
+};
+
+// 两次模拟步进之间主线程收集到的输入
+struct InputState {
+  std::bitset<1024> keys;               // 当前按住的按键
+  std::vector<int32_t> pressed_keys;    // 自上次步进以来按下的按键
+  glm::vec2 mouse_offset = glm::vec2(0, 0);  // 自上次步进以来累积的鼠标位移
+  bool left_button = false;             // 左键是否按住
+  uint32_t right_clicks = 0;            // 自上次步进以来右键按下的次数
+
+  // 步进读取后清空一次性的事件
+  void consume() noexcept;
+};
+
+/** 固定步长模拟线程
+ * 模拟线程以固定频率调用 step，把结果写入后台状态后与 current 交换；
+ * 渲染线程在 previous 与 current 之间按经过的时间插值，帧率与模拟稳定性互不影响。
+ * step 运行在模拟线程上，只能访问模拟线程自己的数据。
+ */
+class Simulation {
+public:
+  typedef std::shared_ptr<Simulation> Ptr;
+  typedef std::chrono::steady_clock Clock;
+  typedef std::function<void(const InputState &input, float dt, WorldState &state)> StepFunc;
+
+  static constexpr float DEFAULT_RATE = 60.0f;
+  // 落后超过这么多步时放弃追赶，避免卡顿后连续步进拖垮模拟线程
+  static constexpr uint32_t MAX_CATCH_UP_STEPS = 5;
+  // 一步内位移超过该距离视为瞬移（如雪花回到顶部），不做插值
+  static constexpr float TELEPORT_DISTANCE = 5.0f;
+
+public:
+  Simulation(StepFunc step, float rate = DEFAULT_RATE);
+  ~Simulation();
+
+  // 以 initial 作为前两帧状态启动模拟线程
+  void start(const WorldState &initial);
+  void stop() noexcept;
+
+  // 主线程修改待处理的输入
+  void update_input(const std::function<void(InputState &input)> &modify);
+
+  // 取出当前时刻的插值状态，返回插值系数
+  float interpolate(WorldState &out);
+
+  float get_step() const noexcept { return dt; }
+  uint64_t get_tick_count() const noexcept { return ticks.load(std::memory_order_relaxed); }
+
+private:
+  void run() noexcept;
+
+private:
+  StepFunc step;
+  float dt;
+  std::thread worker;
+  std::atomic<bool> running = false;
+  std::atomic<uint64_t> ticks = 0;
+
+  std::mutex input_mutex;
+  InputState pending_input;
+
+  // previous / current 供渲染线程插值，back 只由模拟线程写入
+  std::mutex state_mutex;
+  WorldState previous;
+  WorldState current;
+  WorldState back;
+  Clock::time_point current_time;
+};
+
+#endif  // !__SIMULATION_H__
@@ -0,0 +1,522 @@
+#include "skeleton.h"
+
+#include <assimp/scene.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "mapped_file.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SKELETON_USE_SSE2
+#endif
+
+Pose::Pose(uint32_t bone_count) : bone_count(bone_count) {
+  stride = (bone_count + LANES - 1) / LANES * LANES;
+  data.assign((size_t)CHANNELS * stride, 0.0f);
+  std::fill(channel(QW), channel(QW) + stride, 1.0f);
+  std::fill(channel(SX), channel(SX) + stride * 3, 1.0f);
+}
+
+void Pose::set(uint32_t bone, const glm::vec3 &translation, const glm::quat &rotation, const glm::vec3 &scale) noexcept {
+  const float values[CHANNELS] = {translation.x, translation.y, translation.z, rotation.x, rotation.y,
+                                  rotation.z,    rotation.w,    scale.x,       scale.y,    scale.z};
+  for (uint32_t c = 0; c < CHANNELS; ++c) {
+    channel(c)[bone] = values[c];
+  }
+}
+
+void Pose::clear() noexcept { std::fill(data.begin(), data.end(), 0.0f); }
+
+void Pose::normalize(float total_weight, const Pose &rest) noexcept {
+  if (total_weight <= 1e-6f) {
+    data = rest.data;
+    return;
+  }
+  const float inv_weight = 1.0f / total_weight;
+  const uint32_t linear[6] = {TX, TY, TZ, SX, SY, SZ};
+  float *x = channel(QX), *y = channel(QY), *z = channel(QZ), *w = channel(QW);
+#ifdef SKELETON_USE_SSE2
+  const __m128 inv = _mm_set1_ps(inv_weight);
+  const __m128 epsilon = _mm_set1_ps(1e-12f);
+  for (uint32_t i = 0; i < stride; i += LANES) {
+    for (uint32_t c : linear) {
+      _mm_storeu_ps(channel(c) + i, _mm_mul_ps(_mm_loadu_ps(channel(c) + i), inv));
+    }
+    __m128 qx = _mm_loadu_ps(x + i), qy = _mm_loadu_ps(y + i), qz = _mm_loadu_ps(z + i), qw = _mm_loadu_ps(w + i);
+    __m128 length2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)),
+                                _mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw)));
+    // 退化的四元数 (混合的各层正好相互抵消) 取静止姿态
+    __m128 valid = _mm_cmpgt_ps(length2, epsilon);
+    __m128 scale = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(length2, epsilon)));
+    __m128 *components[4] = {&qx, &qy, &qz, &qw};
+    float *targets[4] = {x, y, z, w};
+    const float *fallback[4] = {rest.channel(QX), rest.channel(QY), rest.channel(QZ), rest.channel(QW)};
+    for (uint32_t c = 0; c < 4; ++c) {
+      __m128 value = _mm_mul_ps(*components[c], scale);
+      value = _mm_or_ps(_mm_and_ps(valid, value), _mm_andnot_ps(valid, _mm_loadu_ps(fallback[c] + i)));
+      _mm_storeu_ps(targets[c] + i, value);
+    }
+  }
+#else
+  for (uint32_t i = 0; i < stride; ++i) {
+    for (uint32_t c : linear) {
+      channel(c)[i] *= inv_weight;
+    }
+    float length2 = x[i] * x[i] + y[i] * y[i] + z[i] * z[i] + w[i] * w[i];
+    if (length2 > 1e-12f) {
+      float scale = 1.0f / std::sqrt(length2);
+      x[i] *= scale;
+      y[i] *= scale;
+      z[i] *= scale;
+      w[i] *= scale;
+    } else {
+      x[i] = rest.channel(QX)[i];
+      y[i] = rest.channel(QY)[i];
+      z[i] = rest.channel(QZ)[i];
+      w[i] = rest.channel(QW)[i];
+    }
+  }
+#endif
+}
+
+static Affine to_affine(const glm::mat4 &m) noexcept {
+  Affine result;
+  for (uint32_t r = 0; r < 3; ++r) {
+    for (uint32_t c = 0; c < 4; ++c) {
+      result.rows[r][c] = m[c][r];
+    }
+  }
+  return result;
+}
+
+static bool is_identity(const glm::mat4 &m) noexcept {
+  for (uint32_t c = 0; c < 4; ++c) {
+    for (uint32_t r = 0; r < 4; ++r) {
+      if (std::abs(m[c][r] - (c == r ? 1.0f : 0.0f)) > 1e-5f) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// c = a * b；c 可以与 a 或 b 是同一个
+static inline void multiply(const Affine &a, const Affine &b, Affine &c) noexcept {
+#ifdef SKELETON_USE_SSE2
+  const __m128 b0 = _mm_loadu_ps(b.rows[0]), b1 = _mm_loadu_ps(b.rows[1]), b2 = _mm_loadu_ps(b.rows[2]);
+  const __m128 b3 = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+  const __m128 a0 = _mm_loadu_ps(a.rows[0]), a1 = _mm_loadu_ps(a.rows[1]), a2 = _mm_loadu_ps(a.rows[2]);
+  const __m128 *a_rows[3] = {&a0, &a1, &a2};
+  for (uint32_t r = 0; r < 3; ++r) {
+    const __m128 row = *a_rows[r];
+    __m128 x = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+    x = _mm_add_ps(x, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+    x = _mm_add_ps(x, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+    x = _mm_add_ps(x, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+    _mm_storeu_ps(c.rows[r], x);
+  }
+#else
+  Affine result;
+  for (uint32_t r = 0; r < 3; ++r) {
+    for (uint32_t col = 0; col < 4; ++col) {
+      result.rows[r][col] =
+        a.rows[r][0] * b.rows[0][col] + a.rows[r][1] * b.rows[1][col] + a.rows[r][2] * b.rows[2][col];
+    }
+    result.rows[r][3] += a.rows[r][3];
+  }
+  c = result;
+#endif
+}
+
+// 平移 * 旋转 * 缩放，4 根骨骼一组，SoA 计算后转置为各骨骼的行
+static void compose_local(const Pose &pose, Affine *locals) noexcept {
+  const float *tx = pose.channel(Pose::TX), *ty = pose.channel(Pose::TY), *tz = pose.channel(Pose::TZ);
+  const float *qx = pose.channel(Pose::QX), *qy = pose.channel(Pose::QY), *qz = pose.channel(Pose::QZ),
+              *qw = pose.channel(Pose::QW);
+  const float *sx = pose.channel(Pose::SX), *sy = pose.channel(Pose::SY), *sz = pose.channel(Pose::SZ);
+#ifdef SKELETON_USE_SSE2
+  const __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f);
+  for (uint32_t i = 0; i < pose.stride; i += Pose::LANES) {
+    __m128 x = _mm_loadu_ps(qx + i), y = _mm_loadu_ps(qy + i), z = _mm_loadu_ps(qz + i), w = _mm_loadu_ps(qw + i);
+    __m128 x2 = _mm_mul_ps(x, two), y2 = _mm_mul_ps(y, two), z2 = _mm_mul_ps(z, two);
+    __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+    __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+    __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+    __m128 scale_x = _mm_loadu_ps(sx + i), scale_y = _mm_loadu_ps(sy + i), scale_z = _mm_loadu_ps(sz + i);
+
+    __m128 row0[4] = {_mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), scale_x), _mm_mul_ps(_mm_sub_ps(xy, wz), scale_y),
+                      _mm_mul_ps(_mm_add_ps(xz, wy), scale_z), _mm_loadu_ps(tx + i)};
+    __m128 row1[4] = {_mm_mul_ps(_mm_add_ps(xy, wz), scale_x), _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), scale_y),
+                      _mm_mul_ps(_mm_sub_ps(yz, wx), scale_z), _mm_loadu_ps(ty + i)};
+    __m128 row2[4] = {_mm_mul_ps(_mm_sub_ps(xz, wy), scale_x), _mm_mul_ps(_mm_add_ps(yz, wx), scale_y),
+                      _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), scale_z), _mm_loadu_ps(tz + i)};
+    __m128 *rows[3] = {row0, row1, row2};
+    for (uint32_t r = 0; r < 3; ++r) {
+      __m128 *m = rows[r];
+      _MM_TRANSPOSE4_PS(m[0], m[1], m[2], m[3]);
+      for (uint32_t lane = 0; lane < Pose::LANES; ++lane) {
+        _mm_storeu_ps(locals[i + lane].rows[r], m[lane]);
+      }
+    }
+  }
+#else
+  for (uint32_t i = 0; i < pose.stride; ++i) {
+    float x = qx[i], y = qy[i], z = qz[i], w = qw[i];
+    Affine &m = locals[i];
+    m.rows[0][0] = (1.0f - 2.0f * (y * y + z * z)) * sx[i];
+    m.rows[0][1] = 2.0f * (x * y - w * z) * sy[i];
+    m.rows[0][2] = 2.0f * (x * z + w * y) * sz[i];
+    m.rows[0][3] = tx[i];
+    m.rows[1][0] = 2.0f * (x * y + w * z) * sx[i];
+    m.rows[1][1] = (1.0f - 2.0f * (x * x + z * z)) * sy[i];
+    m.rows[1][2] = 2.0f * (y * z - w * x) * sz[i];
+    m.rows[1][3] = ty[i];
+    m.rows[2][0] = 2.0f * (x * z - w * y) * sx[i];
+    m.rows[2][1] = 2.0f * (y * z + w * x) * sy[i];
+    m.rows[2][2] = (1.0f - 2.0f * (x * x + y * y)) * sz[i];
+    m.rows[2][3] = tz[i];
+  }
+#endif
+}
+
+Skeleton::Skeleton(std::vector<Bone> input) {
+  // 按深度稳定排序，父骨骼总在子骨骼之前；成环的父子关系从环上断开
+  const uint32_t count = input.size();
+  std::vector<uint32_t> depth(count, 0);
+  for (uint32_t i = 0; i < count; ++i) {
+    int32_t parent = input[i].parent;
+    if (parent < 0 || (uint32_t)parent >= count || (uint32_t)parent == i) {
+      input[i].parent = NO_PARENT;
+    }
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t steps = 0;
+    for (int32_t parent = input[i].parent; parent != NO_PARENT && steps <= count; parent = input[parent].parent) {
+      ++steps;
+    }
+    if (steps > count) {
+      input[i].parent = NO_PARENT;
+      steps = 0;
+    }
+    depth[i] = steps;
+  }
+  std::vector<uint32_t> order(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return depth[a] < depth[b]; });
+  std::vector<int32_t> new_index(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    new_index[order[i]] = i;
+  }
+
+  bones.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    Bone bone = std::move(input[order[i]]);
+    if (bone.parent != NO_PARENT) {
+      bone.parent = new_index[bone.parent];
+    }
+    bones.push_back(std::move(bone));
+  }
+
+  rest_pose = Pose(count);
+  inverse_bind.resize(count);
+  parent_space.resize(count);
+  has_parent_space.resize(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    const Bone &bone = bones[i];
+    index_of.emplace(bone.name, i);
+    rest_pose.set(i, bone.rest_translation, bone.rest_rotation, bone.rest_scale);
+    inverse_bind[i] = to_affine(glm::inverse(bone.bind));
+
+    // 静止姿态下应有 父骨骼的绑定矩阵 * parent_space * 局部变换 = 本骨骼的绑定矩阵
+    glm::mat4 local = glm::translate(glm::mat4(1.0f), bone.rest_translation) * glm::mat4_cast(bone.rest_rotation) *
+                      glm::scale(glm::mat4(1.0f), bone.rest_scale);
+    glm::mat4 parent_bind = bone.parent == NO_PARENT ? glm::mat4(1.0f) : bones[bone.parent].bind;
+    glm::mat4 space = glm::inverse(parent_bind) * bone.bind * glm::inverse(local);
+    parent_space[i] = to_affine(space);
+    has_parent_space[i] = !is_identity(space);
+  }
+}
+
+int32_t Skeleton::find(const std::string &name) const noexcept {
+  auto found = index_of.find(name);
+  return found == index_of.end() ? NO_PARENT : found->second;
+}
+
+void Skeleton::compute_palette(const Pose &pose, std::vector<Affine> &scratch, float *palette) const noexcept {
+  scratch.resize(pose.stride);
+  compose_local(pose, scratch.data());
+  // 父骨骼在前，原地把局部变换累乘为网格空间的变换
+  Affine *output = reinterpret_cast<Affine *>(palette);
+  for (uint32_t i = 0; i < bones.size(); ++i) {
+    Affine &model = scratch[i];
+    if (has_parent_space[i]) {
+      multiply(parent_space[i], model, model);
+    }
+    if (bones[i].parent != NO_PARENT) {
+      multiply(scratch[bones[i].parent], model, model);
+    }
+    multiply(model, inverse_bind[i], output[i]);
+  }
+}
+
+// 分解为平移、旋转与缩放，不处理切变
+static void decompose(const glm::mat4 &m, glm::vec3 &translation, glm::quat &rotation, glm::vec3 &scale) noexcept {
+  translation = glm::vec3(m[3]);
+  scale = glm::vec3(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])));
+  glm::mat3 basis(glm::vec3(m[0]) / std::max(scale.x, 1e-8f), glm::vec3(m[1]) / std::max(scale.y, 1e-8f),
+                  glm::vec3(m[2]) / std::max(scale.z, 1e-8f));
+  rotation = glm::normalize(glm::quat_cast(basis));
+}
+
+static glm::mat4 to_glm(const aiMatrix4x4 &m) noexcept { return glm::transpose(glm::make_mat4(&m.a1)); }
+
+Skeleton::Ptr Skeleton::from_assimp(const aiScene *scene) noexcept {
+  std::vector<Bone> bones;
+  std::unordered_map<std::string, int32_t> found;
+  for (uint32_t i = 0; i < scene->mNumMeshes; ++i) {
+    const aiMesh *mesh = scene->mMeshes[i];
+    for (uint32_t j = 0; j < mesh->mNumBones; ++j) {
+      const aiBone *source = mesh->mBones[j];
+      std::string name = source->mName.C_Str();
+      if (found.find(name) != found.end()) {
+        continue;
+      }
+      found.emplace(name, bones.size());
+      Bone bone;
+      bone.name = name;
+      bone.bind = glm::inverse(to_glm(source->mOffsetMatrix));
+      bones.push_back(std::move(bone));
+    }
+  }
+  if (bones.empty()) {
+    return nullptr;
+  }
+  if (bones.size() > MAX_BONES) {
+    std::cout << "[WARN::Skeleton] " << bones.size() << " bones exceed the limit of " << MAX_BONES << std::endl;
+    return nullptr;
+  }
+
+  std::unordered_map<std::string, const aiNode *> nodes;
+  std::vector<const aiNode *> stack = {scene->mRootNode};
+  while (!stack.empty()) {
+    const aiNode *node = stack.back();
+    stack.pop_back();
+    nodes.emplace(node->mName.C_Str(), node);
+    for (uint32_t i = 0; i < node->mNumChildren; ++i) {
+      stack.push_back(node->mChildren[i]);
+    }
+  }
+  for (auto &bone : bones) {
+    auto node = nodes.find(bone.name);
+    if (node == nodes.end()) {
+      // 没有对应节点的骨骼作为根骨骼，静止姿态即绑定姿态
+      decompose(bone.bind, bone.rest_translation, bone.rest_rotation, bone.rest_scale);
+      continue;
+    }
+    decompose(to_glm(node->second->mTransformation), bone.rest_translation, bone.rest_rotation, bone.rest_scale);
+    // 最近的同为骨骼的祖先节点作为父骨骼，中间的节点由 parent_space 吸收
+    for (const aiNode *parent = node->second->mParent; parent != nullptr; parent = parent->mParent) {
+      auto index = found.find(parent->mName.C_Str());
+      if (index != found.end()) {
+        bone.parent = index->second;
+        break;
+      }
+    }
+  }
+  return std::make_shared<Skeleton>(std::move(bones));
+}
+
+namespace {
+// PMX 的顺序读取，越界后 ok 为 false 且之后的读取都返回 0
+struct PmxReader {
+  const uint8_t *cursor;
+  const uint8_t *end;
+  bool ok = true;
+
+  bool skip(size_t size) noexcept {
+    if (!ok || (size_t)(end - cursor) < size) {
+      ok = false;
+      return false;
+    }
+    cursor += size;
+    return true;
+  }
+  template <typename T> T read() noexcept {
+    T value{};
+    const uint8_t *at = cursor;
+    if (skip(sizeof(T))) {
+      memcpy(&value, at, sizeof(T));
+    }
+    return value;
+  }
+  // 骨骼下标为有符号数，-1 表示没有
+  int32_t index(uint8_t size) noexcept {
+    if (size == 1) {
+      return read<int8_t>();
+    } else if (size == 2) {
+      return read<int16_t>();
+    }
+    return read<int32_t>();
+  }
+  // encoding 0 为 UTF-16LE，1 为 UTF-8；统一转为 UTF-8，与 Assimp 中的骨骼名一致
+  std::string text(uint8_t encoding) noexcept {
+    int32_t length = read<int32_t>();
+    const uint8_t *at = cursor;
+    if (length < 0 || !skip(length)) {
+      ok = false;
+      return std::string();
+    }
+    if (encoding != 0) {
+      return std::string((const char *)at, length);
+    }
+    std::string result;
+    for (int32_t i = 0; i + 1 < length; i += 2) {
+      uint32_t code = at[i] | at[i + 1] << 8;
+      if (code >= 0xD800 && code < 0xDC00 && i + 3 < length) {
+        uint32_t low = at[i + 2] | at[i + 3] << 8;
+        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        i += 2;
+      }
+      if (code < 0x80) {
+        result += (char)code;
+      } else if (code < 0x800) {
+        result += (char)(0xC0 | code >> 6);
+        result += (char)(0x80 | (code & 0x3F));
+      } else if (code < 0x10000) {
+        result += (char)(0xE0 | code >> 12);
+        result += (char)(0x80 | (code >> 6 & 0x3F));
+        result += (char)(0x80 | (code & 0x3F));
+      } else {
+        result += (char)(0xF0 | code >> 18);
+        result += (char)(0x80 | (code >> 12 & 0x3F));
+        result += (char)(0x80 | (code >> 6 & 0x3F));
+        result += (char)(0x80 | (code & 0x3F));
+      }
+    }
+    return result;
+  }
+};
+}  // namespace
+
+Skeleton::Ptr Skeleton::from_pmx(const std::string &file_path) noexcept {
+  MappedFile file(file_path);
+  if (file.get_data() == nullptr) {
+    std::cout << "[ERROR::Skeleton] Failed to open " << file_path << std::endl;
+    return nullptr;
+  }
+  PmxReader reader{file.get_data(), file.get_data() + file.get_size()};
+  if (file.get_size() < 9 || memcmp(file.get_data(), "PMX ", 4) != 0) {
+    std::cout << "[ERROR::Skeleton] Not a PMX file: " << file_path << std::endl;
+    return nullptr;
+  }
+  reader.skip(8);  // 标识与版本号
+  uint8_t global_count = reader.read<uint8_t>();
+  uint8_t globals[8] = {};
+  for (uint32_t i = 0; i < global_count; ++i) {
+    uint8_t value = reader.read<uint8_t>();
+    if (i < 8) {
+      globals[i] = value;
+    }
+  }
+  const uint8_t encoding = globals[0], extra_uvs = globals[1], vertex_index = globals[2], texture_index = globals[3],
+                bone_index = globals[5];
+  for (uint32_t i = 0; i < 4; ++i) {
+    reader.text(encoding);  // 模型名与注释
+  }
+
+  // 跳过骨骼表之前的顶点、面、纹理与材质
+  int32_t vertex_count = reader.read<int32_t>();
+  for (int32_t i = 0; i < vertex_count && reader.ok; ++i) {
+    reader.skip(32 + 16 * extra_uvs);
+    uint8_t deform = reader.read<uint8_t>();
+    const size_t deform_sizes[5] = {bone_index, bone_index * 2 + 4u, bone_index * 4 + 16u, bone_index * 2 + 40u,
+                                    bone_index * 4 + 16u};
+    if (deform > 4) {
+      reader.ok = false;
+      break;
+    }
+    reader.skip(deform_sizes[deform] + 4);
+  }
+  int32_t face_count = reader.read<int32_t>();
+  reader.skip((size_t)std::max(face_count, 0) * vertex_index);
+  int32_t texture_count = reader.read<int32_t>();
+  for (int32_t i = 0; i < texture_count && reader.ok; ++i) {
+    reader.text(encoding);
+  }
+  int32_t material_count = reader.read<int32_t>();
+  for (int32_t i = 0; i < material_count && reader.ok; ++i) {
+    reader.text(encoding);
+    reader.text(encoding);
+    reader.skip(16 + 12 + 4 + 12 + 1 + 16 + 4 + texture_index * 2 + 1);
+    uint8_t shared_toon = reader.read<uint8_t>();
+    reader.skip(shared_toon == 0 ? texture_index : 1);
+    reader.text(encoding);
+    reader.skip(4);
+  }
+
+  int32_t bone_count = reader.read<int32_t>();
+  if (!reader.ok || bone_count <= 0 || (uint32_t)bone_count > MAX_BONES) {
+    if (!reader.ok || bone_count < 0) {
+      std::cout << "[ERROR::Skeleton] Malformed PMX: " << file_path << std::endl;
+    }
+    return nullptr;
+  }
+  std::vector<Bone> bones(bone_count);
+  std::vector<glm::vec3> positions(bone_count);
+  for (int32_t i = 0; i < bone_count && reader.ok; ++i) {
+    bones[i].name = reader.text(encoding);
+    reader.text(encoding);
+    positions[i].x = reader.read<float>();
+    positions[i].y = reader.read<float>();
+    positions[i].z = reader.read<float>();
+    bones[i].parent = reader.index(bone_index);
+    reader.skip(4);  // 变形阶层
+    uint16_t flags = reader.read<uint16_t>();
+    reader.skip((flags & 0x0001) ? bone_index : 12);       // 尾端：骨骼或偏移
+    if (flags & (0x0100 | 0x0200)) {                       // 付与旋转 / 平移
+      reader.skip(bone_index + 4);
+    }
+    if (flags & 0x0400) {                                  // 固定轴
+      reader.skip(12);
+    }
+    if (flags & 0x0800) {                                  // 局部坐标轴
+      reader.skip(24);
+    }
+    if (flags & 0x2000) {                                  // 外部父骨骼
+      reader.skip(4);
+    }
+    if (flags & 0x0020) {                                  // IK
+      reader.skip(bone_index + 8);
+      int32_t links = reader.read<int32_t>();
+      for (int32_t j = 0; j < links && reader.ok; ++j) {
+        reader.skip(bone_index);
+        if (reader.read<uint8_t>() != 0) {
+          reader.skip(24);
+        }
+      }
+    }
+  }
+  if (!reader.ok) {
+    std::cout << "[ERROR::Skeleton] Malformed PMX bones: " << file_path << std::endl;
+    return nullptr;
+  }
+
+  // PMX 的骨骼只有位置：绑定姿态为平移，静止姿态为相对父骨骼的偏移
+  for (int32_t i = 0; i < bone_count; ++i) {
+    int32_t parent = bones[i].parent;
+    bool has_parent = parent >= 0 && parent < bone_count && parent != i;
+    bones[i].parent = has_parent ? parent : NO_PARENT;
+    bones[i].bind = glm::translate(glm::mat4(1.0f), positions[i]);
+    bones[i].rest_translation = has_parent ? positions[i] - positions[parent] : positions[i];
+  }
+  return std::make_shared<Skeleton>(std::move(bones));
+}
@@ -0,0 +1,105 @@
+#ifndef __SKELETON_H__
+#define __SKELETON_H__
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct aiScene;
+
+/** 行主序的 3x4 仿射变换，最后一行隐含为 (0, 0, 0, 1)
+ * 每行恰好是一个 vec4，SIMD 一次处理一行；也是蒙皮矩阵在调色板中的布局
+ */
+struct Affine {
+  float rows[3][4];
+};
+
+/** 各骨骼相对父骨骼的局部变换，SoA 布局
+ * 平移、旋转 (四元数 xyzw)、缩放的 10 个分量各占一段连续数组，骨骼数补齐到 LANES 的倍数，
+ * 采样、混合与转换为矩阵时 SIMD 一次处理 LANES 根骨骼；补齐的骨骼保持单位变换
+ */
+struct Pose {
+  static constexpr uint32_t LANES = 4;
+  enum Channel : uint32_t { TX, TY, TZ, QX, QY, QZ, QW, SX, SY, SZ, CHANNELS };
+
+  uint32_t bone_count = 0;
+  uint32_t stride = 0;      // 补齐后的骨骼数
+  std::vector<float> data;  // data[channel * stride + bone]
+
+  Pose() = default;
+  explicit Pose(uint32_t bone_count);
+
+  float *channel(uint32_t c) noexcept { return data.data() + (size_t)c * stride; }
+  const float *channel(uint32_t c) const noexcept { return data.data() + (size_t)c * stride; }
+
+  void set(uint32_t bone, const glm::vec3 &translation, const glm::quat &rotation, const glm::vec3 &scale) noexcept;
+  // 全部分量置 0，作为混合累加的起点
+  void clear() noexcept;
+  // 累加的总权重为 total_weight：平移与缩放取加权平均，四元数归一化；
+  // 总权重为 0 或四元数退化的骨骼取 rest 中的值
+  void normalize(float total_weight, const Pose &rest) noexcept;
+};
+
+/** 骨架：骨骼的层级与绑定姿态
+ * 骨骼按父骨骼在前的顺序排列，一次前向遍历即可由局部变换得到网格空间的变换；
+ * 绑定矩阵的逆把网格空间的顶点变到骨骼空间，与当前姿态相乘得到蒙皮矩阵。
+ * 两种来源：
+ *   from_assimp  网格引用的骨骼，层级与静止姿态取自同名的节点，适用于 FBX / glTF / DAE 等
+ *   from_pmx     Assimp 的 MMD 导入器不生成骨骼节点，层级与骨骼位置直接读取 PMX 的骨骼表
+ */
+class Skeleton {
+public:
+  typedef std::shared_ptr<Skeleton> Ptr;
+
+  static constexpr int32_t NO_PARENT = -1;
+  // 顶点中的骨骼下标为 uint16
+  static constexpr uint32_t MAX_BONES = 65535;
+
+  struct Bone {
+    std::string name;
+    int32_t parent = NO_PARENT;
+    glm::mat4 bind = glm::mat4(1.0f);  // 绑定姿态下骨骼空间到网格空间的变换
+    // 静止姿态，相对父骨骼；动画片段中没有关键帧的骨骼保持该姿态
+    glm::vec3 rest_translation = glm::vec3(0, 0, 0);
+    glm::quat rest_rotation = glm::quat(1, 0, 0, 0);
+    glm::vec3 rest_scale = glm::vec3(1, 1, 1);
+  };
+
+  // 没有任何骨骼时返回 nullptr
+  static Ptr from_assimp(const aiScene *scene) noexcept;
+  static Ptr from_pmx(const std::string &file_path) noexcept;
+
+  // bones 中的父骨骼以下标给出，顺序任意，构造时重新排序
+  explicit Skeleton(std::vector<Bone> bones);
+  Skeleton(const Skeleton &oth) = delete;
+  Skeleton &operator=(const Skeleton &oth) = delete;
+
+  // 不存在时返回 NO_PARENT
+  int32_t find(const std::string &name) const noexcept;
+  uint32_t get_bone_count() const noexcept { return bones.size(); }
+  const std::vector<Bone> &get_bones() const noexcept { return bones; }
+  const Pose &get_rest_pose() const noexcept { return rest_pose; }
+
+  /** 由局部姿态求各骨骼的蒙皮矩阵，每根骨骼以 Affine 的三行写入 palette
+   * palette 可以是写合并的映射内存，只顺序写入、不回读；scratch 为调用者持有的临时空间
+   */
+  void compute_palette(const Pose &pose, std::vector<Affine> &scratch, float *palette) const noexcept;
+
+private:
+  std::vector<Bone> bones;
+  std::unordered_map<std::string, int32_t> index_of;
+  Pose rest_pose;
+  std::vector<Affine> inverse_bind;
+  // 父骨骼空间到本骨骼静止姿态所在空间的固定变换，吸收了两者之间不是骨骼的节点；
+  // 对根骨骼则是到网格空间的变换。绝大多数骨骼为单位变换，此时跳过
+  std::vector<Affine> parent_space;
+  std::vector<uint8_t> has_parent_space;
+};
+
+#endif  // !__SKELETON_H__
@@ -0,0 +1,45 @@
+#include "snowflakes.h"
+
+#include <glm/glm.hpp>
+
+Model::Ptr genSnowflakes(const Model &snowflakes_template, std::ranlux48 &random_engine) {
+  // gen plain snowflakes
+  Model::Ptr snowflakes = std::make_shared<Model>(snowflakes_template);
+
+  // setting origin place
+  std::uniform_real_distribution<float> dist(-50, 50);
+  std::uniform_real_distribution<float> height(0, 16);
+
+  snowflakes->translate = glm::vec3(dist(random_engine), 50 + height(random_engine), dist(random_engine));
+  snowflakes->rotate = glm::vec3(dist(random_engine), dist(random_engine), dist(random_engine));
+  snowflakes->scale = glm::vec3(8, 8, 8);
+
+  return snowflakes;
+}
+
+void anmineSnowflakes(std::vector<Transform> &snowflakes, std::ranlux48 &random_engine, float deltaTime) {
+  // 原先按 60 帧每秒逐帧调出的步长，换算为每秒的速度
+  const float steps = 60 * deltaTime;
+  std::uniform_real_distribution<float> dist(0, 1.1);
+  std::uniform_real_distribution<float> height(0, 16);
+  for (auto &item : snowflakes) {
+    // 进行下落
+    if (item.translate.y <= -10) {
+      item.translate.y = 50 + height(random_engine);
+    }
+    item.translate.y -= steps * dist(random_engine);
+
+    item.rotate.z += steps * 10 * dist(random_engine);
+    if (item.rotate.z >= 360) {
+      item.rotate.z -= 360;
+    }
+    item.rotate.y += steps * 10 * dist(random_engine);
+    if (item.rotate.y >= 360) {
+      item.rotate.y -= 360;
+    }
+    item.rotate.x += steps * 10 * dist(random_engine);
+    if (item.rotate.x >= 360) {
+      item.rotate.x -= 360;
+    }
+  }
+}
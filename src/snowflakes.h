@@ -0,0 +1,16 @@
+#ifndef __SNOWFLAKES_H__
+#define __SNOWFLAKES_H__
+
+#include <random>
+#include <vector>
+
+#include "model.h"
+#include "simulation.h"
+
+// 以模板模型复制出一片雪花，随机放置在场景上空
+Model::Ptr genSnowflakes(const Model &snowflakes_template, std::ranlux48 &random_engine);
+
+// 雪花下落与自转，速度按 deltaTime（秒）缩放
+void anmineSnowflakes(std::vector<Transform> &snowflakes, std::ranlux48 &random_engine, float deltaTime);
+
+#endif  // !__SNOWFLAKES_H__
@@ -0,0 +1,238 @@
+#include "software_occlusion.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+constexpr int32_t TILES_X = SoftwareOcclusion::WIDTH / SoftwareOcclusion::TILE_WIDTH;
+constexpr int32_t TILES_Y = SoftwareOcclusion::HEIGHT / SoftwareOcclusion::TILE_HEIGHT;
+constexpr int32_t BLOCKS_X = TILES_X / SoftwareOcclusion::BLOCK_TILES;
+constexpr int32_t BLOCKS_Y = TILES_Y / SoftwareOcclusion::BLOCK_TILES;
+constexpr int32_t BAND_COUNT = SoftwareOcclusion::HEIGHT / SoftwareOcclusion::BAND_HEIGHT;
+// w 小于此值的顶点视为在相机平面附近，所在三角形不作为遮挡体
+constexpr float MIN_W = 1e-5f;
+}  // namespace
+
+SoftwareOcclusion::SoftwareOcclusion(WorkerPool::Ptr pool) : pool(pool) {
+  use_avx2 = SoftwareRaster::avx2_supported();
+  depth.assign(WIDTH * HEIGHT, 1.0f);
+  tile_max.assign(TILES_X * TILES_Y, 1.0f);
+  block_max.assign(BLOCKS_X * BLOCKS_Y, 1.0f);
+}
+
+void SoftwareOcclusion::begin_frame(const glm::mat4 &view_projection) noexcept {
+  this->view_projection = view_projection;
+  occluders.clear();
+  occluder_offsets.clear();
+  triangle_total = 0;
+  results.clear();
+  stats = Stats();
+}
+
+void SoftwareOcclusion::add_occluder(const Model::Ptr &model) noexcept {
+  glm::mat4 mvp = view_projection * model->get_model_matrix();
+  for (const auto &mesh : model->get_meshes()) {
+    if (!mesh.opaque || mesh.indices.size() < 3) {
+      continue;
+    }
+    occluders.push_back({&mesh, mvp});
+    occluder_offsets.push_back(triangle_total);
+    triangle_total += mesh.indices.size() / 3;
+  }
+}
+
+bool SoftwareOcclusion::setup_triangle(const glm::vec4 clip[3], SoftwareRaster::Triangle &tri) noexcept {
+  float x[3], y[3], z[3];
+  for (int i = 0; i < 3; ++i) {
+    // 跨越近/远裁剪面的三角形在 GPU 上会被裁掉一部分，直接丢弃
+    if (clip[i].w < MIN_W || clip[i].z < -clip[i].w || clip[i].z > clip[i].w) {
+      return false;
+    }
+    float inv_w = 1.0f / clip[i].w;
+    x[i] = (clip[i].x * inv_w * 0.5f + 0.5f) * WIDTH;
+    y[i] = (clip[i].y * inv_w * 0.5f + 0.5f) * HEIGHT;
+    z[i] = clip[i].z * inv_w * 0.5f + 0.5f;
+  }
+  float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+  if (std::abs(area) < 1e-6f) {
+    return false;
+  }
+  // 统一为逆时针，不区分正反面
+  if (area < 0) {
+    std::swap(x[1], x[2]);
+    std::swap(y[1], y[2]);
+    std::swap(z[1], z[2]);
+    area = -area;
+  }
+
+  float min_x = std::min({x[0], x[1], x[2]}), max_x = std::max({x[0], x[1], x[2]});
+  float min_y = std::min({y[0], y[1], y[2]}), max_y = std::max({y[0], y[1], y[2]});
+  tri.min_x = std::max<int32_t>(0, (int32_t)std::floor(min_x));
+  tri.max_x = std::min<int32_t>(WIDTH - 1, (int32_t)std::floor(max_x));
+  tri.min_y = std::max<int32_t>(0, (int32_t)std::floor(min_y));
+  tri.max_y = std::min<int32_t>(HEIGHT - 1, (int32_t)std::floor(max_y));
+  if (tri.min_x > tri.max_x || tri.min_y > tri.max_y) {
+    return false;
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    int j = (i + 1) % 3;
+    tri.edge_a[i] = -(y[j] - y[i]);
+    tri.edge_b[i] = x[j] - x[i];
+    tri.edge_c[i] = -(tri.edge_a[i] * x[i] + tri.edge_b[i] * y[i]);
+  }
+  tri.dzdx = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+  tri.dzdy = ((x[1] - x[0]) * (z[2] - z[0]) - (x[2] - x[0]) * (z[1] - z[0])) / area;
+  // 以像素中心采样，再加上像素内可能的最大增量，得到像素内最远的深度
+  float bias = 0.5f * (std::abs(tri.dzdx) + std::abs(tri.dzdy));
+  tri.z0 = z[0] - tri.dzdx * x[0] - tri.dzdy * y[0] + bias;
+  return true;
+}
+
+void SoftwareOcclusion::setup_job(uint32_t job) noexcept {
+  uint32_t job_count = job_triangles.size();
+  uint32_t begin = (uint64_t)triangle_total * job / job_count;
+  uint32_t end = (uint64_t)triangle_total * (job + 1) / job_count;
+  auto &output = job_triangles[job];
+  output.clear();
+  if (begin >= end) {
+    return;
+  }
+
+  // 找到起始三角形所在的遮挡体
+  uint32_t occluder = std::upper_bound(occluder_offsets.begin(), occluder_offsets.end(), begin) - occluder_offsets.begin() - 1;
+  SoftwareRaster::Triangle tri;
+  for (uint32_t global = begin; global < end; ++global) {
+    while (occluder + 1 < occluders.size() && occluder_offsets[occluder + 1] <= global) {
+      ++occluder;
+    }
+    const Occluder &item = occluders[occluder];
+    uint32_t first_index = (global - occluder_offsets[occluder]) * 3;
+    glm::vec4 clip[3];
+    for (int i = 0; i < 3; ++i) {
+      const glm::vec3 &position = item.mesh->vertices[item.mesh->indices[first_index + i]].Position;
+      clip[i] = item.mvp * glm::vec4(position, 1.0f);
+    }
+    if (setup_triangle(clip, tri)) {
+      output.push_back(tri);
+    }
+  }
+}
+
+void SoftwareOcclusion::raster_band(uint32_t band) noexcept {
+  int32_t y_begin = band * BAND_HEIGHT;
+  int32_t y_end = y_begin + BAND_HEIGHT;
+  std::fill(depth.begin() + y_begin * WIDTH, depth.begin() + y_end * WIDTH, 1.0f);
+  for (const auto &triangles : job_triangles) {
+    if (use_avx2) {
+      SoftwareRaster::rasterize_avx2(triangles.data(), triangles.size(), depth.data(), WIDTH, y_begin, y_end);
+    } else {
+      SoftwareRaster::rasterize_scalar(triangles.data(), triangles.size(), depth.data(), WIDTH, y_begin, y_end);
+    }
+  }
+
+  // 条带正好是一行块，在本线程内建立两层最大深度
+  int32_t block_y = band;
+  for (int32_t block_x = 0; block_x < BLOCKS_X; ++block_x) {
+    float block_value = 0.0f;
+    for (int32_t ty = block_y * BLOCK_TILES; ty < (block_y + 1) * BLOCK_TILES; ++ty) {
+      for (int32_t tx = block_x * BLOCK_TILES; tx < (block_x + 1) * BLOCK_TILES; ++tx) {
+        float tile_value = 0.0f;
+        for (int32_t y = ty * TILE_HEIGHT; y < (ty + 1) * TILE_HEIGHT; ++y) {
+          const float *row = depth.data() + y * WIDTH + tx * TILE_WIDTH;
+          for (int32_t x = 0; x < TILE_WIDTH; ++x) {
+            tile_value = std::max(tile_value, row[x]);
+          }
+        }
+        tile_max[ty * TILES_X + tx] = tile_value;
+        block_value = std::max(block_value, tile_value);
+      }
+    }
+    block_max[block_y * BLOCKS_X + block_x] = block_value;
+  }
+}
+
+void SoftwareOcclusion::rasterize() noexcept {
+  auto start = std::chrono::steady_clock::now();
+  job_triangles.resize(pool->get_concurrency());
+  pool->run(job_triangles.size(), [this](uint32_t job) { setup_job(job); });
+  for (const auto &triangles : job_triangles) {
+    stats.occluder_triangles += triangles.size();
+  }
+  pool->run(BAND_COUNT, [this](uint32_t band) { raster_band(band); });
+  stats.raster_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool SoftwareOcclusion::is_occluded(const Model::Ptr &model) noexcept {
+  auto found = results.find(model.get());
+  if (found != results.end()) {
+    return found->second;
+  }
+  bool occluded = test_bounds(model);
+  results.emplace(model.get(), occluded);
+  ++stats.tested;
+  if (occluded) {
+    ++stats.culled;
+  }
+  return occluded;
+}
+
+bool SoftwareOcclusion::test_bounds(const Model::Ptr &model) const noexcept {
+  glm::vec3 min, max;
+  model->get_bounds(min, max);
+  glm::mat4 mvp = view_projection * model->get_model_matrix();
+
+  float min_x = std::numeric_limits<float>::max(), max_x = std::numeric_limits<float>::lowest();
+  float min_y = min_x, max_y = max_x;
+  float min_z = min_x;
+  for (int corner = 0; corner < 8; ++corner) {
+    glm::vec3 position((corner & 1) ? max.x : min.x, (corner & 2) ? max.y : min.y, (corner & 4) ? max.z : min.z);
+    glm::vec4 clip = mvp * glm::vec4(position, 1.0f);
+    // 包围盒跨过相机平面时无法得到屏幕矩形
+    if (clip.w < MIN_W) {
+      return false;
+    }
+    float inv_w = 1.0f / clip.w;
+    float x = (clip.x * inv_w * 0.5f + 0.5f) * WIDTH;
+    float y = (clip.y * inv_w * 0.5f + 0.5f) * HEIGHT;
+    min_x = std::min(min_x, x);
+    max_x = std::max(max_x, x);
+    min_y = std::min(min_y, y);
+    max_y = std::max(max_y, y);
+    min_z = std::min(min_z, clip.z * inv_w * 0.5f + 0.5f);
+  }
+  // 完全在屏幕外的物体交给视锥剔除，这里不作判断
+  if (max_x < 0 || max_y < 0 || min_x >= WIDTH || min_y >= HEIGHT) {
+    return false;
+  }
+  // 遮挡体在轮廓像素上可能只覆盖了中心，向外扩展 1 个像素，让相邻的未覆盖像素参与比较
+  min_x -= 1.0f;
+  min_y -= 1.0f;
+  max_x += 1.0f;
+  max_y += 1.0f;
+  int32_t tile_x0 = std::max<int32_t>(0, (int32_t)std::floor(min_x)) / TILE_WIDTH;
+  int32_t tile_x1 = std::min<int32_t>(WIDTH - 1, (int32_t)std::floor(max_x)) / TILE_WIDTH;
+  int32_t tile_y0 = std::max<int32_t>(0, (int32_t)std::floor(min_y)) / TILE_HEIGHT;
+  int32_t tile_y1 = std::min<int32_t>(HEIGHT - 1, (int32_t)std::floor(max_y)) / TILE_HEIGHT;
+
+  for (int32_t block_y = tile_y0 / BLOCK_TILES; block_y <= tile_y1 / BLOCK_TILES; ++block_y) {
+    for (int32_t block_x = tile_x0 / BLOCK_TILES; block_x <= tile_x1 / BLOCK_TILES; ++block_x) {
+      // 整块都比物体近，块内无需逐 tile 检查
+      if (block_max[block_y * BLOCKS_X + block_x] < min_z) {
+        continue;
+      }
+      int32_t ty_end = std::min(tile_y1, (block_y + 1) * BLOCK_TILES - 1);
+      int32_t tx_end = std::min(tile_x1, (block_x + 1) * BLOCK_TILES - 1);
+      for (int32_t ty = std::max(tile_y0, block_y * BLOCK_TILES); ty <= ty_end; ++ty) {
+        for (int32_t tx = std::max(tile_x0, block_x * BLOCK_TILES); tx <= tx_end; ++tx) {
+          if (tile_max[ty * TILES_X + tx] >= min_z) {
+            return false;
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
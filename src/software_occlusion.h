@@ -0,0 +1,87 @@
+#ifndef __SOFTWARE_OCCLUSION_H__
+#define __SOFTWARE_OCCLUSION_H__
+
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "model.h"
+#include "software_raster.h"
+#include "worker_pool.h"
+
+/** CPU 软件光栅化的遮挡剔除，不依赖 GPU 查询
+ * 每帧把少量大的遮挡体（不透明材质的网格）以低分辨率光栅化到深度缓冲，
+ * 屏幕按行分为若干条带，由工作线程各自光栅化，支持时使用 AVX2 一次处理 8 个像素。
+ * 深度缓冲之上建立两层最大深度：8 × 4 像素的 tile 与 4 × 4 个 tile 的块。
+ * 物体以包围盒在屏幕上的矩形与最近深度测试，矩形覆盖的 tile 都比它更近时被剔除，完全不提交绘制。
+ * 跨越近/远裁剪面的遮挡体三角形被丢弃，遮挡体深度取像素内的最远值。遮挡体的覆盖只在像素中心采样，
+ * 轮廓边缘的像素可能只被部分覆盖，因此物体的矩形向外扩展 1 个像素再测试；
+ * 这能避免绝大多数误剔除，但对比像素还细的缝隙仍不是严格保守的
+ */
+class SoftwareOcclusion {
+public:
+  typedef std::shared_ptr<SoftwareOcclusion> Ptr;
+
+  static constexpr int32_t WIDTH = 256;
+  static constexpr int32_t HEIGHT = 128;
+  static constexpr int32_t TILE_WIDTH = 8;
+  static constexpr int32_t TILE_HEIGHT = 4;
+  static constexpr int32_t BLOCK_TILES = 4;  // 每块包含 BLOCK_TILES × BLOCK_TILES 个 tile
+  static constexpr int32_t BAND_HEIGHT = TILE_HEIGHT * BLOCK_TILES;
+
+  struct Stats {
+    uint32_t occluder_triangles = 0;  // 本帧光栅化的遮挡体三角形数
+    uint32_t tested = 0;              // 本帧测试的物体数
+    uint32_t culled = 0;              // 其中被剔除的物体数
+    double raster_ms = 0;             // 本帧光栅化与建立层次深度的耗时
+  };
+
+  explicit SoftwareOcclusion(WorkerPool::Ptr pool);
+
+  // 以本帧的视图投影矩阵开始，清空遮挡体列表
+  void begin_frame(const glm::mat4 &view_projection) noexcept;
+  // 加入模型中材质不透明的网格作为遮挡体，模型需在 rasterize 前保持不变
+  void add_occluder(const Model::Ptr &model) noexcept;
+  // 并行地变换、光栅化全部遮挡体并建立层次深度
+  void rasterize() noexcept;
+
+  // 模型的包围盒是否被遮挡体完全挡住，同一帧内的结果被缓存，深度预处理与着色阶段各问一次也只计数一次
+  bool is_occluded(const Model::Ptr &model) noexcept;
+
+  bool is_avx2() const noexcept { return use_avx2; }
+  const Stats &get_stats() const noexcept { return stats; }
+
+private:
+  struct Occluder {
+    const Mesh *mesh;
+    glm::mat4 mvp;
+  };
+
+  // 裁剪空间的三角形转为屏幕空间，无法保守处理或不可见时返回 false
+  static bool setup_triangle(const glm::vec4 clip[3], SoftwareRaster::Triangle &tri) noexcept;
+  void setup_job(uint32_t job) noexcept;
+  void raster_band(uint32_t band) noexcept;
+  bool test_bounds(const Model::Ptr &model) const noexcept;
+
+private:
+  WorkerPool::Ptr pool;
+  bool use_avx2;
+  glm::mat4 view_projection = glm::mat4(1.0f);
+  std::vector<Occluder> occluders;
+  // 每个遮挡体三角形的全局起始编号，用于把三角形均分给各个任务
+  std::vector<uint32_t> occluder_offsets;
+  uint32_t triangle_total = 0;
+  std::vector<std::vector<SoftwareRaster::Triangle>> job_triangles;
+
+  std::vector<float> depth;
+  std::vector<float> tile_max;
+  std::vector<float> block_max;
+  std::unordered_map<const Model *, bool> results;  // 本帧已测试的物体
+  Stats stats;
+};
+
+#endif  // !__SOFTWARE_OCCLUSION_H__
@@ -0,0 +1,59 @@
+#include "software_raster.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace SoftwareRaster {
+
+void rasterize_scalar(
+  const Triangle *triangles, uint32_t count, float *depth, int32_t width, int32_t y_begin, int32_t y_end) noexcept {
+  for (uint32_t t = 0; t < count; ++t) {
+    const Triangle &tri = triangles[t];
+    int32_t row_begin = tri.min_y > y_begin ? tri.min_y : y_begin;
+    int32_t row_end = tri.max_y + 1 < y_end ? tri.max_y + 1 : y_end;
+    for (int32_t y = row_begin; y < row_end; ++y) {
+      float cy = y + 0.5f;
+      float r0 = tri.edge_b[0] * cy + tri.edge_c[0];
+      float r1 = tri.edge_b[1] * cy + tri.edge_c[1];
+      float r2 = tri.edge_b[2] * cy + tri.edge_c[2];
+      float rz = tri.z0 + tri.dzdy * cy;
+      float *row = depth + (int64_t)y * width;
+      for (int32_t x = tri.min_x; x <= tri.max_x; ++x) {
+        float cx = x + 0.5f;
+        if (tri.edge_a[0] * cx + r0 <= 0 || tri.edge_a[1] * cx + r1 <= 0 || tri.edge_a[2] * cx + r2 <= 0) {
+          continue;
+        }
+        float z = tri.dzdx * cx + rz;
+        z = z < 1.0f ? z : 1.0f;
+        row[x] = z < row[x] ? z : row[x];
+      }
+    }
+  }
+}
+
+bool avx2_supported() noexcept {
+  if (!avx2_compiled) {
+    return false;
+  }
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+  __cpuid(info, 1);
+  // OSXSAVE 与 AVX，且操作系统保存了 YMM 寄存器
+  if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 0x6) != 0x6) {
+    return false;
+  }
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+}  // namespace SoftwareRaster
@@ -0,0 +1,32 @@
+#ifndef __SOFTWARE_RASTER_H__
+#define __SOFTWARE_RASTER_H__
+
+#include <stdint.h>
+
+/** SoftwareOcclusion 使用的深度光栅化内核
+ * 只依赖基本类型：AVX2 版本所在的编译单元以 -mavx2 编译，
+ * 若包含 glm 或 STL 的内联函数，链接器可能把带 AVX2 指令的实例用到其他编译单元中
+ */
+namespace SoftwareRaster {
+
+// 屏幕空间中的三角形，已按逆时针排列
+struct Triangle {
+  float edge_a[3], edge_b[3], edge_c[3];  // 边函数 a * x + b * y + c，三角形内部三者均为正
+  float z0, dzdx, dzdy;                   // 深度平面 z = z0 + dzdx * x + dzdy * y，已加上覆盖像素内的最大偏移
+  int32_t min_x, max_x, min_y, max_y;     // 像素包围矩形（闭区间）
+};
+
+// 深度缓冲每行的像素数需为 8 的倍数，行 [y_begin, y_end) 内以更近的深度覆盖
+void rasterize_scalar(
+  const Triangle *triangles, uint32_t count, float *depth, int32_t width, int32_t y_begin, int32_t y_end) noexcept;
+void rasterize_avx2(
+  const Triangle *triangles, uint32_t count, float *depth, int32_t width, int32_t y_begin, int32_t y_end) noexcept;
+
+// rasterize_avx2 是否以 AVX2 编译，由 software_raster_avx2.cc 定义
+extern const bool avx2_compiled;
+// 编译与 CPU 均支持 AVX2，运行时检测
+bool avx2_supported() noexcept;
+
+}  // namespace SoftwareRaster
+
+#endif  // !__SOFTWARE_RASTER_H__
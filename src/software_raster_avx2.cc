@@ -0,0 +1,67 @@
+#include "software_raster.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace SoftwareRaster {
+
+extern const bool avx2_compiled = true;
+
+void rasterize_avx2(
+  const Triangle *triangles, uint32_t count, float *depth, int32_t width, int32_t y_begin, int32_t y_end) noexcept {
+  const __m256 lane = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.0f);
+  for (uint32_t t = 0; t < count; ++t) {
+    const Triangle &tri = triangles[t];
+    int32_t row_begin = tri.min_y > y_begin ? tri.min_y : y_begin;
+    int32_t row_end = tri.max_y + 1 < y_end ? tri.max_y + 1 : y_end;
+    if (row_begin >= row_end) {
+      continue;
+    }
+    int32_t column_begin = tri.min_x & ~7;
+    // 每次处理一行中连续的 8 个像素
+    __m256 a0 = _mm256_set1_ps(tri.edge_a[0]), a1 = _mm256_set1_ps(tri.edge_a[1]), a2 = _mm256_set1_ps(tri.edge_a[2]);
+    __m256 dzdx = _mm256_set1_ps(tri.dzdx);
+    for (int32_t y = row_begin; y < row_end; ++y) {
+      float cy = y + 0.5f;
+      __m256 r0 = _mm256_set1_ps(tri.edge_b[0] * cy + tri.edge_c[0]);
+      __m256 r1 = _mm256_set1_ps(tri.edge_b[1] * cy + tri.edge_c[1]);
+      __m256 r2 = _mm256_set1_ps(tri.edge_b[2] * cy + tri.edge_c[2]);
+      __m256 rz = _mm256_set1_ps(tri.z0 + tri.dzdy * cy);
+      float *row = depth + (int64_t)y * width;
+      for (int32_t x = column_begin; x <= tri.max_x; x += 8) {
+        __m256 cx = _mm256_add_ps(_mm256_set1_ps((float)x), lane);
+        __m256 e0 = _mm256_add_ps(_mm256_mul_ps(a0, cx), r0);
+        __m256 e1 = _mm256_add_ps(_mm256_mul_ps(a1, cx), r1);
+        __m256 e2 = _mm256_add_ps(_mm256_mul_ps(a2, cx), r2);
+        __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GT_OQ), _mm256_cmp_ps(e1, zero, _CMP_GT_OQ)),
+                                      _mm256_cmp_ps(e2, zero, _CMP_GT_OQ));
+        if (_mm256_movemask_ps(inside) == 0) {
+          continue;
+        }
+        __m256 z = _mm256_min_ps(_mm256_add_ps(_mm256_mul_ps(dzdx, cx), rz), one);
+        __m256 old = _mm256_loadu_ps(row + x);
+        _mm256_storeu_ps(row + x, _mm256_blendv_ps(old, _mm256_min_ps(old, z), inside));
+      }
+    }
+  }
+}
+
+}  // namespace SoftwareRaster
+
+#else
+
+namespace SoftwareRaster {
+
+extern const bool avx2_compiled = false;
+
+// 非 x86 平台或未开启 AVX2 编译，退回标量版本
+void rasterize_avx2(
+  const Triangle *triangles, uint32_t count, float *depth, int32_t width, int32_t y_begin, int32_t y_end) noexcept {
+  rasterize_scalar(triangles, count, depth, width, y_begin, y_end);
+}
+
+}  // namespace SoftwareRaster
+
+#endif
@@ -0,0 +1,118 @@
+#include "stream_buffer.h"
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+
+StreamBuffer::StreamBuffer(GLenum target, GLsizeiptr frame_size) : target(target), frame_size(frame_size) {
+  GLsizeiptr total_size = frame_size * FRAMES_IN_FLIGHT;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(target, buffer);
+  if (GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage) {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(target, total_size, nullptr, flags);
+    mapped = static_cast<uint8_t *>(glMapBufferRange(target, 0, total_size, flags));
+    persistent = mapped != nullptr;
+    if (!persistent) {
+      std::cout << "[WARN::StreamBuffer] persistent mapping failed, fallback to unsynchronized mapping" << std::endl;
+      // 不可变存储无法重新分配，换一个缓冲对象
+      glBindBuffer(target, GL_ZERO);
+      glDeleteBuffers(1, &buffer);
+      glGenBuffers(1, &buffer);
+      glBindBuffer(target, buffer);
+    }
+  }
+  if (!persistent) {
+    glBufferData(target, total_size, nullptr, GL_STREAM_DRAW);
+  }
+  glBindBuffer(target, GL_ZERO);
+  // 第一帧从区域 0 开始
+  frame = FRAMES_IN_FLIGHT - 1;
+}
+
+StreamBuffer::~StreamBuffer() {
+  for (auto &fence : fences) {
+    if (fence != nullptr) {
+      glDeleteSync(fence);
+    }
+  }
+  if (persistent) {
+    glBindBuffer(target, buffer);
+    glUnmapBuffer(target);
+    glBindBuffer(target, GL_ZERO);
+  }
+  glDeleteBuffers(1, &buffer);
+}
+
+void StreamBuffer::begin_frame() noexcept {
+  frame = (frame + 1) % FRAMES_IN_FLIGHT;
+  frame_offset = 0;
+  GLsync fence = fences[frame];
+  if (fence == nullptr) {
+    return;
+  }
+  // 先不等待地查询，只有 GPU 确实落后时才计为一次停顿
+  GLenum status = glClientWaitSync(fence, 0, 0);
+  if (status == GL_TIMEOUT_EXPIRED) {
+    ++stats.fence_stalls;
+    auto start = std::chrono::steady_clock::now();
+    do {
+      status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    } while (status == GL_TIMEOUT_EXPIRED);
+    stats.stall_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+  glDeleteSync(fence);
+  fences[frame] = nullptr;
+}
+
+void StreamBuffer::end_frame() noexcept {
+  stats.bytes_streamed = frame_offset;
+  if (fences[frame] != nullptr) {
+    glDeleteSync(fences[frame]);
+  }
+  fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+StreamBuffer::Allocation StreamBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment) noexcept {
+  Allocation allocation;
+  // 非常驻映射不能同时持有两个映射范围，见类注释
+  assert(!outstanding && "commit the previous StreamBuffer allocation first");
+  if (outstanding) {
+    std::cout << "[ERROR::StreamBuffer] previous allocation is not committed, request " << size << " bytes dropped"
+              << std::endl;
+    return allocation;
+  }
+  GLsizeiptr begin = (frame_offset + alignment - 1) / alignment * alignment;
+  if (begin + size > frame_size) {
+    if (!warned_overflow) {
+      std::cout << "[WARN::StreamBuffer] frame region of " << frame_size << " bytes is full, request " << size
+                << " bytes dropped" << std::endl;
+      warned_overflow = true;
+    }
+    return allocation;
+  }
+  frame_offset = begin + size;
+  allocation.offset = frame * frame_size + begin;
+  allocation.size = size;
+  if (persistent) {
+    allocation.data = mapped + allocation.offset;
+  } else {
+    // 该区域已由 fence 保证不再被 GPU 读取，无需驱动同步
+    glBindBuffer(target, buffer);
+    allocation.data = glMapBufferRange(target, allocation.offset, size,
+                                       GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    glBindBuffer(target, GL_ZERO);
+    outstanding = allocation.data != nullptr;
+  }
+  return allocation;
+}
+
+void StreamBuffer::commit(const Allocation &allocation) noexcept {
+  if (persistent || allocation.data == nullptr) {
+    return;
+  }
+  glBindBuffer(target, buffer);
+  glUnmapBuffer(target);
+  glBindBuffer(target, GL_ZERO);
+  outstanding = false;
+}
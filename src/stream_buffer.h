@@ -0,0 +1,74 @@
+#ifndef __STREAM_BUFFER_H__
+#define __STREAM_BUFFER_H__
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+
+#include <memory>
+
+/** 每帧动态数据的流式环形缓冲
+ * 一块大缓冲按 FRAMES_IN_FLIGHT 均分为若干帧区域，每帧只向自己的区域写入，
+ * 帧结束时插入 glFenceSync，再次轮到该区域时等待其 fence，保证 GPU 已读完旧数据。
+ * 支持 GL 4.4 / ARB_buffer_storage 时以 GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT 常驻映射，
+ * 写入即可见；否则每次分配用 GL_MAP_UNSYNCHRONIZED_BIT 映射对应范围，commit 时解除映射。
+ * 两条路径都不会触发驱动的拷贝或隐式同步。
+ * 非常驻映射时同一缓冲同时只能映射一个范围，且映射期间 GPU 不能读取该缓冲，因此每个分配必须先 commit
+ * 再进行下一次 allocate，也不能整帧保持映射；两条路径都按这一约定使用，allocate 中断言。
+ */
+class StreamBuffer {
+public:
+  typedef std::shared_ptr<StreamBuffer> Ptr;
+
+  static constexpr uint32_t FRAMES_IN_FLIGHT = 3;
+
+  // 一次分配：data 为 CPU 可写指针，offset 为在缓冲中的字节偏移
+  struct Allocation {
+    void *data = nullptr;
+    GLintptr offset = 0;
+    GLsizeiptr size = 0;
+  };
+
+  // 每帧的统计
+  struct Stats {
+    uint64_t bytes_streamed = 0;  // 上一帧写入的字节数
+    uint64_t fence_stalls = 0;    // 累计等待 fence 的次数
+    double stall_ms = 0;          // 累计等待 fence 的时间
+  };
+
+  // frame_size 为每帧区域的字节数
+  StreamBuffer(GLenum target, GLsizeiptr frame_size);
+  StreamBuffer(const StreamBuffer &oth) = delete;
+  StreamBuffer &operator=(const StreamBuffer &oth) = delete;
+  ~StreamBuffer();
+
+  // 帧开始时切换到下一个区域，必要时等待其 fence
+  void begin_frame() noexcept;
+  // 帧结束时为本帧区域插入 fence
+  void end_frame() noexcept;
+
+  // 在本帧区域内分配，空间不足或上一个分配尚未 commit 时返回 data 为 nullptr 的分配
+  Allocation allocate(GLsizeiptr size, GLsizeiptr alignment = 16) noexcept;
+  // 写入完成后调用，非常驻映射时解除映射
+  void commit(const Allocation &allocation) noexcept;
+
+  GLuint get_id() const noexcept { return buffer; }
+  bool is_persistent() const noexcept { return persistent; }
+  const Stats &get_stats() const noexcept { return stats; }
+
+private:
+  GLenum target;
+  GLuint buffer = GL_ZERO;
+  GLsizeiptr frame_size;
+  bool persistent = false;
+  uint8_t *mapped = nullptr;
+  bool outstanding = false;  // 非常驻映射时有一个已映射、尚未 commit 的分配
+
+  uint32_t frame = 0;
+  GLsizeiptr frame_offset = 0;  // 本帧区域内已分配的字节数
+  GLsync fences[FRAMES_IN_FLIGHT] = {};
+  Stats stats;
+  bool warned_overflow = false;
+};
+
+#endif  // !__STREAM_BUFFER_H__
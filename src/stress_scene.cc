@@ -0,0 +1,230 @@
+#include "stress_scene.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+
+static std::string trim(const std::string &str) {
+  size_t begin = str.find_first_not_of(" \t\r\n");
+  if (begin == std::string::npos) {
+    return "";
+  }
+  size_t end = str.find_last_not_of(" \t\r\n");
+  return str.substr(begin, end - begin + 1);
+}
+
+// 解析无符号整数。std::stoul 接受负号并回绕成很大的数，因此这里只接受纯数字；
+// 负数或超出 T 的值给出警告并保留原值，其他格式错误返回 false
+template <typename T>
+static bool parse_unsigned(const std::string &key, const std::string &value, T &out) noexcept {
+  uint64_t parsed = 0;
+  auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), parsed);
+  // 只有 '-' 之后全是数字才算负数，"-abc"、"-" 之类仍是格式错误
+  bool negative = value.size() > 1 && value[0] == '-' &&
+                  std::all_of(value.begin() + 1, value.end(), [](unsigned char c) { return std::isdigit(c) != 0; });
+  if (negative) {
+    std::cout << "[WARN::StressScene] Negative value for " << key << ": " << value << ", keep " << out << std::endl;
+    return true;
+  }
+  if (value.empty() || end != value.data() + value.size() ||
+      (ec != std::errc() && ec != std::errc::result_out_of_range)) {
+    std::cout << "[ERROR::StressScene] Invalid value for " << key << ": " << value << std::endl;
+    return false;
+  }
+  if (ec == std::errc::result_out_of_range || parsed > std::numeric_limits<T>::max()) {
+    std::cout << "[WARN::StressScene] Value out of range for " << key << ": " << value << ", keep " << out << std::endl;
+    return true;
+  }
+  out = (T)parsed;
+  return true;
+}
+
+// 解析正的有限浮点数，不满足时给出警告并保留原值
+static bool parse_positive(const std::string &key, const std::string &value, float &out) noexcept {
+  size_t end = 0;
+  float parsed = 0;
+  try {
+    parsed = std::stof(value, &end);
+  } catch (const std::out_of_range &e) {
+    std::cout << "[WARN::StressScene] Value out of range for " << key << ": " << value << ", keep " << out << std::endl;
+    return true;
+  } catch (const std::exception &e) {
+    end = 0;
+  }
+  if (end == 0 || end != value.size()) {
+    std::cout << "[ERROR::StressScene] Invalid value for " << key << ": " << value << std::endl;
+    return false;
+  }
+  if (!std::isfinite(parsed) || parsed <= 0) {
+    std::cout << "[WARN::StressScene] Value must be positive for " << key << ": " << value << ", keep " << out
+              << std::endl;
+    return true;
+  }
+  out = parsed;
+  return true;
+}
+
+bool StressSceneConfig::parse_args(int argc, char *argv[]) noexcept {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.rfind("--", 0) != 0) {
+      std::cout << "[ERROR::StressScene] Unknown argument: " << arg << std::endl;
+      return false;
+    }
+    arg = arg.substr(2);
+    if (arg == "stress") {
+      enabled = true;
+      continue;
+    }
+
+    std::string key = arg;
+    std::string value;
+    size_t eq = arg.find('=');
+    if (eq != std::string::npos) {
+      key = arg.substr(0, eq);
+      value = arg.substr(eq + 1);
+    } else if (i + 1 < argc) {
+      value = argv[++i];
+    } else {
+      std::cout << "[ERROR::StressScene] Missing value for: --" << key << std::endl;
+      return false;
+    }
+
+    if (key == "stress-file") {
+      enabled = true;
+      if (!load_file(value)) {
+        return false;
+      }
+    } else if (!set(key, value)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool StressSceneConfig::load_file(const std::string &file_path) noexcept {
+  std::ifstream fd(file_path);
+  if (!fd.is_open()) {
+    std::cout << "[ERROR::StressScene] Failed to open config: " << file_path << std::endl;
+    return false;
+  }
+  std::string line;
+  while (std::getline(fd, line)) {
+    line = trim(line.substr(0, line.find('#')));
+    if (line.empty()) {
+      continue;
+    }
+    size_t eq = line.find('=');
+    if (eq == std::string::npos) {
+      std::cout << "[ERROR::StressScene] Invalid line in " << file_path << ": " << line << std::endl;
+      return false;
+    }
+    if (!set(trim(line.substr(0, eq)), trim(line.substr(eq + 1)))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool StressSceneConfig::set(const std::string &key, const std::string &value) noexcept {
+  if (key == "copies") {
+    return parse_unsigned(key, value, copies);
+  } else if (key == "snowflakes") {
+    return parse_unsigned(key, value, snowflakes);
+  } else if (key == "lights") {
+    return parse_unsigned(key, value, lights);
+  } else if (key == "area") {
+    return parse_positive(key, value, area);
+  } else if (key == "seed") {
+    return parse_unsigned(key, value, seed);
+  } else if (key == "report-interval") {
+    return parse_positive(key, value, report_interval);
+  } else if (key == "layout") {
+    if (value == "grid") {
+      layout = Layout::Grid;
+    } else if (value == "random") {
+      layout = Layout::Random;
+    } else {
+      std::cout << "[ERROR::StressScene] Unknown layout: " << value << std::endl;
+      return false;
+    }
+  } else {
+    std::cout << "[ERROR::StressScene] Unknown option: " << key << std::endl;
+    return false;
+  }
+  return true;
+}
+
+std::vector<glm::vec3> stress_layout(const StressSceneConfig &config, uint32_t count, uint32_t stream) noexcept {
+  std::vector<glm::vec3> positions;
+  positions.reserve(count);
+  if (count == 0) {
+    return positions;
+  }
+  float half = config.area / 2;
+
+  if (config.layout == StressSceneConfig::Grid) {
+    uint32_t side = (uint32_t)std::ceil(std::sqrt((double)count));
+    float step = config.area / side;
+    // 不同资源的网格在格子内相互错开，避免完全重合
+    float offset = step * (0.125f + 0.25f * (stream % 4));
+    for (uint32_t i = 0; i < count; ++i) {
+      float x = -half + offset + step * (i % side);
+      float z = -half + offset + step * (i / side);
+      positions.push_back({x, 0, z});
+    }
+    return positions;
+  }
+
+  std::ranlux48 engine(config.seed * 0x9E3779B97F4A7C15ull + stream);
+  std::uniform_real_distribution<float> dist(-half, half);
+  for (uint32_t i = 0; i < count; ++i) {
+    float x = dist(engine);
+    float z = dist(engine);
+    positions.push_back({x, 0, z});
+  }
+  return positions;
+}
+
+std::vector<float> stress_yaws(const StressSceneConfig &config, uint32_t count, uint32_t stream) noexcept {
+  std::vector<float> yaws(count, 0.0f);
+  if (config.layout == StressSceneConfig::Grid) {
+    return yaws;
+  }
+  std::ranlux48 engine(config.seed * 0xC2B2AE3D27D4EB4Full + stream);
+  std::uniform_real_distribution<float> dist(0, 360);
+  for (auto &yaw : yaws) {
+    yaw = dist(engine);
+  }
+  return yaws;
+}
+
+std::vector<Light> stress_lights(const StressSceneConfig &config) noexcept {
+  const uint32_t light_stream = 0xFFFF;
+  std::vector<glm::vec3> positions = stress_layout(config, config.lights, light_stream);
+  std::ranlux48 engine(config.seed * 0x165667B19E3779F9ull + light_stream);
+  std::uniform_real_distribution<float> height(2, 8);
+  std::uniform_real_distribution<float> hue(0, 1);
+
+  std::vector<Light> lights;
+  lights.reserve(positions.size());
+  for (const auto &position : positions) {
+    Light light;
+    light.type = Light::PointLight;
+    light.position = position + glm::vec3(0, height(engine), 0);
+    light.range = 12;
+    // 暖色灯笼
+    float h = hue(engine);
+    light.diffuse = glm::vec3(1.0f, 0.55f + 0.35f * h, 0.25f + 0.25f * h) * 4.0f;
+    light.specular = light.diffuse;
+    light.ambient = {0, 0, 0};
+    lights.push_back(light);
+  }
+  return lights;
+}
@@ -0,0 +1,50 @@
+#ifndef __STRESS_SCENE_H__
+#define __STRESS_SCENE_H__
+
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "light.h"
+
+/** 压力测试场景配置
+ * 命令行: --stress [--stress-file path] [--copies N] [--snowflakes M] [--lights K]
+ *         [--area A] [--layout grid|random] [--seed S] [--report-interval sec]
+ * 配置文件: 每行一个 key = value，key 与命令行参数同名（不带 --），# 开头为注释
+ */
+struct StressSceneConfig {
+  enum Layout { Random = 0x0, Grid = 0x1 };
+
+  bool enabled = false;
+  uint32_t copies = 1;          // 每种模型的副本数
+  uint32_t snowflakes = 64;     // 雪花数量
+  uint32_t lights = 0;          // 点光源数量
+  float area = 100;             // 放置区域的边长，以原点为中心
+  Layout layout = Layout::Random;
+  uint64_t seed = 1;            // 随机种子，相同种子生成相同场景
+  float report_interval = 1.0;  // 帧时间统计输出间隔（秒）
+
+  // 解析命令行，返回 false 表示参数错误
+  bool parse_args(int argc, char *argv[]) noexcept;
+  // 读取配置文件
+  bool load_file(const std::string &file_path) noexcept;
+  // 设置单个配置项
+  bool set(const std::string &key, const std::string &value) noexcept;
+};
+
+/** 生成 count 个放置位置（y = 0）
+ * stream 用于区分不同资源，使各资源的随机序列相互独立且各自可复现。
+ * 两种布局都不保证模型互不重叠：随机布局为均匀分布，网格布局只把不同 stream 在格子内错开 1/4 格
+ */
+std::vector<glm::vec3> stress_layout(const StressSceneConfig &config, uint32_t count, uint32_t stream) noexcept;
+
+// 随机朝向（绕 y 轴，角度制），网格布局下恒为 0
+std::vector<float> stress_yaws(const StressSceneConfig &config, uint32_t count, uint32_t stream) noexcept;
+
+// 生成 config.lights 个点光源
+std::vector<Light> stress_lights(const StressSceneConfig &config) noexcept;
+
+#endif  // !__STRESS_SCENE_H__
@@ -0,0 +1,415 @@
+#include "terrain.h"
+
+#include <glm/gtc/type_ptr.hpp>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "vertex_format.h"
+
+namespace {
+
+// 整数格点上的伪随机值，取值 [0, 1)
+float lattice(int32_t x, int32_t z) noexcept {
+  uint32_t h = uint32_t(x) * 0x8da6b343u ^ uint32_t(z) * 0xd8163841u;
+  h ^= h >> 15;
+  h *= 0x2c1b3c6du;
+  h ^= h >> 12;
+  h *= 0x297a2d39u;
+  h ^= h >> 15;
+  return (h >> 8) * (1.0f / 16777216.0f);
+}
+
+// 格点之间平滑插值的值噪声，取值 [0, 1)
+float value_noise(float x, float z) noexcept {
+  float fx = std::floor(x);
+  float fz = std::floor(z);
+  int32_t ix = int32_t(fx);
+  int32_t iz = int32_t(fz);
+  float tx = x - fx;
+  float tz = z - fz;
+  tx = tx * tx * (3 - 2 * tx);
+  tz = tz * tz * (3 - 2 * tz);
+  float a = lattice(ix, iz) + (lattice(ix + 1, iz) - lattice(ix, iz)) * tx;
+  float b = lattice(ix, iz + 1) + (lattice(ix + 1, iz + 1) - lattice(ix, iz + 1)) * tx;
+  return a + (b - a) * tz;
+}
+
+// 五个倍频的分形噪声，归一化到 [0, 1)
+float fractal_noise(float x, float z) noexcept {
+  float sum = 0;
+  float amplitude = 0.5f;
+  float frequency = 1.0f / 128.0f;
+  for (uint32_t octave = 0; octave < 5; ++octave) {
+    sum += value_noise(x * frequency, z * frequency) * amplitude;
+    amplitude *= 0.5f;
+    frequency *= 2.0f;
+  }
+  return sum / (1.0f - amplitude * 2.0f);
+}
+
+float smoothstep(float edge0, float edge1, float x) noexcept {
+  float t = std::clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+  return t * t * (3 - 2 * t);
+}
+
+// 由 projection * view 提取的六个裁剪平面 (Gribb & Hartmann)，法线朝向视锥内部
+void frustum_planes(const glm::mat4 &m, glm::vec4 planes[6]) noexcept {
+  glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+  glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+  glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+  glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+  planes[0] = row3 + row0;
+  planes[1] = row3 - row0;
+  planes[2] = row3 + row1;
+  planes[3] = row3 - row1;
+  planes[4] = row3 + row2;
+  planes[5] = row3 - row2;
+}
+
+// 包围盒在法线方向上最远的角点也在某个平面之外时，整个盒子在视锥外
+bool outside_frustum(const glm::vec4 planes[6], const Bvh::Aabb &box) noexcept {
+  for (uint32_t i = 0; i < 6; ++i) {
+    glm::vec3 farthest(planes[i].x >= 0 ? box.max.x : box.min.x, planes[i].y >= 0 ? box.max.y : box.min.y,
+                       planes[i].z >= 0 ? box.max.z : box.min.z);
+    if (glm::dot(glm::vec3(planes[i]), farthest) + planes[i].w < 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+Terrain::Terrain(const TerrainConfig &config, WorkerPool::Ptr worker_pool) : config(config), worker_pool(worker_pool) {
+  uint32_t resolution = 2;
+  while (resolution < this->config.chunk_resolution) {
+    resolution <<= 1;
+  }
+  if (resolution != this->config.chunk_resolution) {
+    std::cout << "[WARN::Terrain] chunk_resolution " << this->config.chunk_resolution
+              << " is not a power of two, using " << resolution << std::endl;
+    this->config.chunk_resolution = resolution;
+  }
+  // 最粗一级每边 2 格
+  while ((2u << max_lod) < resolution) {
+    ++max_lod;
+  }
+  if (!this->config.heightmap.empty() && !load_heightmap(this->config.heightmap)) {
+    std::cout << "[WARN::Terrain] Failed to load heightmap " << this->config.heightmap << ", using procedural noise"
+              << std::endl;
+  }
+
+  // 视距内的块加上卸载前的滞后一圈
+  uint32_t radius = std::ceil(this->config.view_distance / this->config.chunk_size) + 1;
+  GLint slots = (2 * radius + 1) * (2 * radius + 1);
+  GLint max_layers = 0;
+  glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+  if (slots > max_layers) {
+    std::cout << "[WARN::Terrain] " << slots << " chunks exceed GL_MAX_ARRAY_TEXTURE_LAYERS (" << max_layers << ")"
+              << std::endl;
+    slots = max_layers;
+  }
+  for (GLint slot = slots; slot-- > 0;) {
+    free_slots.push_back(slot);
+  }
+  glGenTextures(1, &heights);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, heights);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32F, layer_size(), layer_size(), slots, 0, GL_RED, GL_FLOAT, nullptr);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, GL_ZERO);
+
+  glGenFramebuffers(1, &stamp_fbo);
+  build_grid();
+}
+
+Terrain::~Terrain() {
+  glDeleteFramebuffers(1, &stamp_fbo);
+  glDeleteTextures(1, &heights);
+  glDeleteVertexArrays(1, &vao);
+  GLuint buffers[] = {vbo, ebo};
+  glDeleteBuffers(2, buffers);
+}
+
+bool Terrain::load_heightmap(const std::string &path) {
+  int32_t width = 0, height = 0, channels = 0;
+  uint16_t *data = stbi_load_16(path.c_str(), &width, &height, &channels, 1);
+  if (data == nullptr) {
+    return false;
+  }
+  if (width < 2 || height < 2) {
+    stbi_image_free(data);
+    return false;
+  }
+  heightmap.resize(width * height);
+  for (int32_t i = 0; i < width * height; ++i) {
+    heightmap[i] = data[i] / 65535.0f;
+  }
+  heightmap_width = width;
+  heightmap_height = height;
+  stbi_image_free(data);
+  return true;
+}
+
+void Terrain::build_grid() {
+  uint32_t n = config.chunk_resolution;
+  std::vector<glm::vec3> vertices;
+  vertices.reserve((n + 1) * (n + 1));
+  for (uint32_t j = 0; j <= n; ++j) {
+    for (uint32_t i = 0; i <= n; ++i) {
+      vertices.push_back(glm::vec3(i, 0, j));
+    }
+  }
+  // 各级 LOD 依次排在同一个索引缓冲中，三角形从上方看为逆时针
+  std::vector<GLuint> indices;
+  for (uint32_t lod = 0; lod <= max_lod; ++lod) {
+    uint32_t step = 1u << lod;
+    lod_first.push_back(indices.size());
+    for (uint32_t j = 0; j < n; j += step) {
+      for (uint32_t i = 0; i < n; i += step) {
+        GLuint a = j * (n + 1) + i;
+        GLuint b = a + step;
+        GLuint c = a + step * (n + 1);
+        GLuint d = c + step;
+        indices.insert(indices.end(), {a, c, b, b, c, d});
+      }
+    }
+    lod_count.push_back(indices.size() - lod_first.back());
+  }
+
+  glGenVertexArrays(1, &vao);
+  glGenBuffers(1, &vbo);
+  glGenBuffers(1, &ebo);
+  glBindVertexArray(vao);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+  glEnableVertexAttribArray(AttribLocation::POSITION);
+  glVertexAttribPointer(AttribLocation::POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+  glBindVertexArray(GL_ZERO);
+}
+
+float Terrain::height_at(float x, float z) const noexcept {
+  float relief = 0;
+  if (!heightmap.empty()) {
+    // 高度图铺满整个地形，双线性采样
+    float u = std::clamp(x / config.size + 0.5f, 0.0f, 1.0f) * (heightmap_width - 1);
+    float v = std::clamp(z / config.size + 0.5f, 0.0f, 1.0f) * (heightmap_height - 1);
+    int32_t x0 = std::min(int32_t(u), heightmap_width - 2);
+    int32_t z0 = std::min(int32_t(v), heightmap_height - 2);
+    int32_t x1 = x0 + 1;
+    int32_t z1 = z0 + 1;
+    float tx = u - x0;
+    float tz = v - z0;
+    float a = heightmap[z0 * heightmap_width + x0] * (1 - tx) + heightmap[z0 * heightmap_width + x1] * tx;
+    float b = heightmap[z1 * heightmap_width + x0] * (1 - tx) + heightmap[z1 * heightmap_width + x1] * tx;
+    relief = a * (1 - tz) + b * tz;
+  } else {
+    relief = fractal_noise(x, z);
+  }
+  float mask = smoothstep(config.flat_extent, config.flat_extent + config.flat_blend, std::max(std::abs(x), std::abs(z)));
+  return relief * config.height_scale * mask + config.snow_depth;
+}
+
+void Terrain::generate(const glm::ivec2 &coord, std::vector<float> &data) const noexcept {
+  GLsizei size = layer_size();
+  glm::vec2 origin = chunk_origin(coord);
+  data.resize(size * size);
+  for (GLsizei j = 0; j < size; ++j) {
+    for (GLsizei i = 0; i < size; ++i) {
+      // 纹素 (i, j) 对应网格点 (i - 1, j - 1)
+      data[j * size + i] = height_at(origin.x + (i - 1) * spacing(), origin.y + (j - 1) * spacing());
+    }
+  }
+}
+
+float Terrain::chunk_distance(const glm::ivec2 &coord, const glm::vec2 &point) const noexcept {
+  glm::vec2 min = chunk_origin(coord);
+  glm::vec2 max = min + config.chunk_size;
+  glm::vec2 offset = glm::max(glm::max(min - point, point - max), glm::vec2(0));
+  return glm::length(offset);
+}
+
+void Terrain::update(Camera::Ptr camera) {
+  glm::vec2 eye(camera->position.x, camera->position.z);
+  // 卸载时多留半块的滞后，避免相机在边界附近来回走动时反复载入
+  for (auto it = chunks.begin(); it != chunks.end();) {
+    if (chunk_distance(it->second.coord, eye) > config.view_distance + config.chunk_size * 0.5f) {
+      free_slots.push_back(it->second.slot);
+      it = chunks.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // 只遍历相机周围的方形区域，开销与地形总面积无关
+  int32_t radius = std::ceil(config.view_distance / config.chunk_size);
+  int32_t half = std::floor(config.size * 0.5f / config.chunk_size);
+  glm::ivec2 center(std::floor(eye.x / config.chunk_size), std::floor(eye.y / config.chunk_size));
+  requests.clear();
+  for (int32_t z = std::max(center.y - radius, -half); z <= std::min(center.y + radius, half - 1); ++z) {
+    for (int32_t x = std::max(center.x - radius, -half); x <= std::min(center.x + radius, half - 1); ++x) {
+      glm::ivec2 coord(x, z);
+      float distance = chunk_distance(coord, eye);
+      if (distance <= config.view_distance && chunks.find(key(coord)) == chunks.end()) {
+        requests.push_back({distance, coord});
+      }
+    }
+  }
+  uint32_t count = std::min<uint32_t>({config.max_uploads, uint32_t(requests.size()), uint32_t(free_slots.size())});
+  std::partial_sort(requests.begin(), requests.begin() + count, requests.end(),
+                    [](const auto &a, const auto &b) { return a.first < b.first; });
+  upload_heights.resize(std::max<size_t>(upload_heights.size(), count));
+  auto job = [&](uint32_t i) { generate(requests[i].second, upload_heights[i]); };
+  if (worker_pool != nullptr && count > 1) {
+    worker_pool->run(count, job);
+  } else {
+    for (uint32_t i = 0; i < count; ++i) {
+      job(i);
+    }
+  }
+  glBindTexture(GL_TEXTURE_2D_ARRAY, heights);
+  for (uint32_t i = 0; i < count; ++i) {
+    Chunk chunk;
+    chunk.coord = requests[i].second;
+    chunk.slot = free_slots.back();
+    free_slots.pop_back();
+    const std::vector<float> &data = upload_heights[i];
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, chunk.slot, layer_size(), layer_size(), 1, GL_RED, GL_FLOAT,
+                    data.data());
+    auto [low, high] = std::minmax_element(data.begin(), data.end());
+    glm::vec2 origin = chunk_origin(chunk.coord);
+    chunk.bounds.min = glm::vec3(origin.x, *low, origin.y);
+    chunk.bounds.max = glm::vec3(origin.x + config.chunk_size, *high, origin.y + config.chunk_size);
+    chunks.emplace(key(chunk.coord), chunk);
+    ++stats.loaded;
+  }
+  glBindTexture(GL_TEXTURE_2D_ARRAY, GL_ZERO);
+
+  // 距离在 lod_distance 内为第 0 级，之后每翻一倍降一级
+  for (auto &[_, chunk] : chunks) {
+    glm::vec3 offset = glm::max(glm::max(chunk.bounds.min - camera->position, camera->position - chunk.bounds.max),
+                                glm::vec3(0));
+    float distance = glm::length(offset);
+    chunk.lod = 0;
+    if (distance > config.lod_distance) {
+      chunk.lod = std::min(uint32_t(std::log2(distance / config.lod_distance)) + 1, max_lod);
+    }
+  }
+  stats.resident = chunks.size();
+}
+
+float Terrain::stitch_step(const Chunk &chunk, const glm::ivec2 &offset) const noexcept {
+  auto it = chunks.find(key(chunk.coord + offset));
+  if (it == chunks.end() || it->second.lod <= chunk.lod) {
+    return 1;
+  }
+  return float(1u << it->second.lod);
+}
+
+void Terrain::draw(ShaderProgram::Ptr shader, Camera::Ptr camera) noexcept {
+  stats.drawn = 0;
+  stats.triangles = 0;
+  if (chunks.empty()) {
+    return;
+  }
+  glm::mat4 view = camera->getViewMatrix();
+  glm::mat4 projection = camera->getProjectionMatrix();
+  glm::vec4 planes[6];
+  frustum_planes(projection * view, planes);
+
+  shader->use();
+  shader->set_uniform("view", view);
+  shader->set_uniform("projection", projection);
+  shader->set_uniform("terrainSpacing", spacing());
+  shader->set_uniform("terrainResolution", GLint(config.chunk_resolution));
+  shader->set_uniform("terrainTexScale", config.texture_scale);
+  Mesh::bind_textures(shader, textures);
+  glActiveTexture(GL_TEXTURE0 + HEIGHTS_UNIT);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, heights);
+  shader->set_uniform("terrainHeights", HEIGHTS_UNIT);
+  glActiveTexture(GL_TEXTURE0);
+
+  glBindVertexArray(vao);
+  for (const auto &[_, chunk] : chunks) {
+    if (outside_frustum(planes, chunk.bounds)) {
+      continue;
+    }
+    shader->set_uniform("terrainLayer", GLint(chunk.slot));
+    shader->set_uniform("terrainOrigin", chunk_origin(chunk.coord));
+    shader->set_uniform("terrainStitch", glm::vec4(stitch_step(chunk, {-1, 0}), stitch_step(chunk, {1, 0}),
+                                                   stitch_step(chunk, {0, -1}), stitch_step(chunk, {0, 1})));
+    glDrawElements(GL_TRIANGLES, lod_count[chunk.lod], GL_UNSIGNED_INT,
+                   reinterpret_cast<const void *>(lod_first[chunk.lod] * sizeof(GLuint)));
+    ++stats.drawn;
+    stats.triangles += lod_count[chunk.lod] / 3;
+  }
+  glBindVertexArray(GL_ZERO);
+}
+
+void Terrain::deform(ShaderProgram::Ptr stamp_prog, Mesh::Ptr screen, const glm::vec3 &bottom, float radius) noexcept {
+  // 块四周多出的一圈纹素也要写入，范围向外扩一格
+  glm::vec2 center(bottom.x, bottom.z);
+  glm::vec2 extent(radius + spacing());
+  glm::ivec2 first = glm::ivec2(glm::floor((center - extent) / config.chunk_size));
+  glm::ivec2 last = glm::ivec2(glm::floor((center + extent) / config.chunk_size));
+
+  glBindFramebuffer(GL_FRAMEBUFFER, stamp_fbo);
+  glViewport(0, 0, layer_size(), layer_size());
+  glDisable(GL_DEPTH_TEST);
+  // 与原有高度取较小值，雪只会被压低
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_ONE, GL_ONE);
+  glBlendEquation(GL_MIN);
+  stamp_prog->use();
+  stamp_prog->set_uniform("terrainSpacing", spacing());
+  stamp_prog->set_uniform("stampBottom", bottom);
+  stamp_prog->set_uniform("stampRadius", radius);
+  for (int32_t z = first.y; z <= last.y; ++z) {
+    for (int32_t x = first.x; x <= last.x; ++x) {
+      auto it = chunks.find(key({x, z}));
+      if (it == chunks.end()) {
+        continue;
+      }
+      Chunk &chunk = it->second;
+      glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, heights, 0, chunk.slot);
+      stamp_prog->set_uniform("terrainOrigin", chunk_origin(chunk.coord));
+      screen->draw(stamp_prog);
+      chunk.bounds.min.y = std::min(chunk.bounds.min.y, bottom.y);
+    }
+  }
+  glBlendEquation(GL_FUNC_ADD);
+  glDisable(GL_BLEND);
+  glEnable(GL_DEPTH_TEST);
+  glBindFramebuffer(GL_FRAMEBUFFER, GL_ZERO);
+}
+
+Mesh::Ptr Terrain::build_collision_mesh(float radius, float spacing) const {
+  Mesh::Ptr mesh = std::make_shared<Mesh>();
+  uint32_t n = std::max<uint32_t>(std::ceil(2 * radius / spacing), 1);
+  mesh->vertices.reserve((n + 1) * (n + 1));
+  for (uint32_t j = 0; j <= n; ++j) {
+    for (uint32_t i = 0; i <= n; ++i) {
+      float x = -radius + i * spacing;
+      float z = -radius + j * spacing;
+      mesh->vertices.push_back(Vertex(glm::vec3(x, height_at(x, z), z), glm::vec3(0, 1, 0)));
+    }
+  }
+  mesh->indices.reserve(n * n * 6);
+  for (uint32_t j = 0; j < n; ++j) {
+    for (uint32_t i = 0; i < n; ++i) {
+      GLuint a = j * (n + 1) + i;
+      GLuint c = a + n + 1;
+      mesh->indices.insert(mesh->indices.end(), {a, c, a + 1, a + 1, c, c + 1});
+    }
+  }
+  mesh->build_bvh();
+  return mesh;
+}
@@ -0,0 +1,135 @@
+#ifndef __TERRAIN_H__
+#define __TERRAIN_H__
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bvh.h"
+#include "camera.h"
+#include "mesh.h"
+#include "shader.h"
+#include "worker_pool.h"
+
+// 地形参数，长度单位均为世界空间
+struct TerrainConfig {
+  float size = 4096;              // 地形边长，以原点为中心
+  float chunk_size = 32;          // 每块的边长
+  uint32_t chunk_resolution = 64; // 每块每边的格数，须为 2 的幂
+  float lod_distance = 24;        // 该距离内使用最细的网格，距离每翻一倍降低一级
+  float view_distance = 150;      // 常驻块的半径，超出后卸载
+  uint32_t max_uploads = 4;       // 每帧最多载入的块数
+  // 高度 = 起伏 * 平坦区遮罩 + 积雪厚度；|x|、|z| 都不超过 flat_extent 的方形区域保持平坦，
+  // 与冰屋所在的岛屿 (±90) 重合，场景中的物体都摆在那里，向外经过 flat_blend 过渡到起伏的山地
+  float height_scale = 12;
+  float flat_extent = 90;
+  float flat_blend = 40;
+  float snow_depth = 0.3f;
+  float texture_scale = 0.25f;    // 纹理坐标 = 世界坐标 xz * texture_scale
+  // 灰度高度图，覆盖整个地形；为空或载入失败时使用程序化的分形噪声
+  std::string heightmap;
+};
+
+/** 分块的高度场地形
+ * 地形按 chunk_size 分块，只有相机周围 view_distance 内的块常驻：每帧按距离由近到远最多载入 max_uploads 块，
+ * 远离的块归还槽位，因此每帧的开销只与视距有关，与地形总面积无关。
+ * 常驻块的高度保存在一张 R32F 纹理数组中，每块一层，四周各多一个纹素用于求法线；
+ * 所有块共用一份 (N+1)² 的网格顶点，各级 LOD 只是同一组顶点上步长不同的索引区间。
+ * 顶点着色器 (TERRAIN 变体) 按层号取出高度并求法线；与更粗的相邻块共边的顶点，
+ * 高度取粗网格上两端顶点的线性插值，恰好落在相邻块的边上，不会产生裂缝。
+ * 高度纹理可以直接渲染修改 (deform)，例如雪人走过时压出的雪痕
+ */
+class Terrain {
+public:
+  typedef std::shared_ptr<Terrain> Ptr;
+
+  static constexpr GLint HEIGHTS_UNIT = 19;
+
+  struct Stats {
+    uint32_t resident = 0;   // 常驻的块数
+    uint32_t drawn = 0;      // 最近一次 draw 通过视锥剔除的块数
+    uint32_t triangles = 0;  // 最近一次 draw 提交的三角形数
+    uint32_t loaded = 0;     // 累计载入的块数
+  };
+
+  explicit Terrain(const TerrainConfig &config = TerrainConfig(), WorkerPool::Ptr worker_pool = nullptr);
+  Terrain(const Terrain &oth) = delete;
+  Terrain &operator=(const Terrain &oth) = delete;
+  ~Terrain();
+
+  // 每帧调用一次：卸载远处的块、载入近处的块，并按到 camera 的距离选择各块的 LOD
+  void update(Camera::Ptr camera);
+  // 以 TERRAIN 变体的程序绘制，按 camera 的视锥剔除；LOD 沿用 update 的结果，阴影通道与主视图一致
+  void draw(ShaderProgram::Ptr shader, Camera::Ptr camera) noexcept;
+  /** 把半径为 radius、最低点在 bottom 的球压入地形，高度只降低不升高
+   * 只修改 GPU 上的高度纹理；块被卸载后再次载入时恢复原始高度
+   */
+  void deform(ShaderProgram::Ptr stamp_prog, Mesh::Ptr screen, const glm::vec3 &bottom, float radius) noexcept;
+
+  // 未形变的地表高度，只依赖配置，可以在任意线程调用
+  float height_at(float x, float z) const noexcept;
+  // 以 spacing 为间距、覆盖 [-radius, radius]² 的地表网格，用于碰撞场景
+  Mesh::Ptr build_collision_mesh(float radius, float spacing) const;
+
+  // 漫反射、镜面反射与阴影纹理，命名规则同 Mesh
+  void add_texture(Texture::Ptr texture) noexcept { textures.push_back(texture); }
+
+  const TerrainConfig &get_config() const noexcept { return config; }
+  const Stats &get_stats() const noexcept { return stats; }
+
+private:
+  struct Chunk {
+    glm::ivec2 coord;
+    uint32_t slot;
+    uint32_t lod = 0;
+    Bvh::Aabb bounds;
+  };
+
+  static int64_t key(const glm::ivec2 &coord) noexcept { return (int64_t(coord.x) << 32) ^ uint32_t(coord.y); }
+  glm::vec2 chunk_origin(const glm::ivec2 &coord) const noexcept { return glm::vec2(coord) * config.chunk_size; }
+  float spacing() const noexcept { return config.chunk_size / config.chunk_resolution; }
+  // 每层纹理的边长，含四周各一个纹素
+  GLsizei layer_size() const noexcept { return config.chunk_resolution + 3; }
+  // 块在 xz 平面上到 point 的距离
+  float chunk_distance(const glm::ivec2 &coord, const glm::vec2 &point) const noexcept;
+  // 相邻块比当前块粗时，该方向上粗网格的步长（以最细网格的格数计），否则为 1
+  float stitch_step(const Chunk &chunk, const glm::ivec2 &offset) const noexcept;
+  void generate(const glm::ivec2 &coord, std::vector<float> &data) const noexcept;
+  bool load_heightmap(const std::string &path);
+  void build_grid();
+
+private:
+  TerrainConfig config;
+  WorkerPool::Ptr worker_pool;
+  std::vector<Texture::Ptr> textures;
+  Stats stats;
+
+  // 高度图，宽 heightmap_width，高 heightmap_height，取值 [0, 1]
+  std::vector<float> heightmap;
+  int32_t heightmap_width = 0;
+  int32_t heightmap_height = 0;
+
+  uint32_t max_lod = 0;
+  std::vector<GLsizei> lod_first;  // 各级 LOD 在索引缓冲中的起点与个数
+  std::vector<GLsizei> lod_count;
+
+  std::unordered_map<int64_t, Chunk> chunks;
+  std::vector<uint32_t> free_slots;
+  // 本帧待载入的块，按距离排序后取前 max_uploads 个
+  std::vector<std::pair<float, glm::ivec2>> requests;
+  std::vector<std::vector<float>> upload_heights;
+
+  GLuint heights = GL_ZERO;  // GL_TEXTURE_2D_ARRAY，R32F
+  GLuint vao = GL_ZERO;
+  GLuint vbo = GL_ZERO;
+  GLuint ebo = GL_ZERO;
+  GLuint stamp_fbo = GL_ZERO;
+};
+
+#endif  // !__TERRAIN_H__
@@ -0,0 +1,419 @@
+#include "texture_container.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+// 容器中的像素格式：vk_format 为 KTX2 的 VkFormat，dxgi_format 为 DDS DX10 头的 DXGI_FORMAT，0 表示没有对应
+// bytes 对压缩格式为每 4×4 块的字节数，对未压缩格式为每像素的字节数。
+// 管线不做伽马校正，stb_image 加载的图像也以 GL_RGB / GL_RGBA 直接使用存储的值，
+// 因此 sRGB 格式按对应的线性格式上传，采样结果与同一张图像经 stb_image 加载时一致
+struct FormatInfo {
+  uint32_t vk_format;
+  uint32_t dxgi_format;
+  GLenum internal_format;
+  GLenum format;
+  GLenum type;
+  uint32_t bytes;
+  bool compressed;
+};
+
+constexpr FormatInfo FORMATS[] = {
+  {9, 61, GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1, false},
+  {16, 49, GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2, false},
+  {23, 0, GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, 3, false},
+  {29, 0, GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, 3, false},
+  {30, 0, GL_RGB8, GL_BGR, GL_UNSIGNED_BYTE, 3, false},
+  {37, 28, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, false},
+  {43, 29, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, false},
+  {44, 87, GL_RGBA8, GL_BGRA, GL_UNSIGNED_BYTE, 4, false},
+  {50, 91, GL_RGBA8, GL_BGRA, GL_UNSIGNED_BYTE, 4, false},
+  {97, 10, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8, false},
+  {131, 0, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_NONE, GL_NONE, 8, true},
+  {132, 0, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_NONE, GL_NONE, 8, true},
+  {133, 71, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_NONE, GL_NONE, 8, true},
+  {134, 72, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_NONE, GL_NONE, 8, true},
+  {135, 74, GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, GL_NONE, GL_NONE, 16, true},
+  {136, 75, GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, GL_NONE, GL_NONE, 16, true},
+  {137, 77, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_NONE, GL_NONE, 16, true},
+  {138, 78, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_NONE, GL_NONE, 16, true},
+  {139, 80, GL_COMPRESSED_RED_RGTC1, GL_NONE, GL_NONE, 8, true},
+  {140, 81, GL_COMPRESSED_SIGNED_RED_RGTC1, GL_NONE, GL_NONE, 8, true},
+  {141, 83, GL_COMPRESSED_RG_RGTC2, GL_NONE, GL_NONE, 16, true},
+  {142, 84, GL_COMPRESSED_SIGNED_RG_RGTC2, GL_NONE, GL_NONE, 16, true},
+  {143, 95, GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, GL_NONE, GL_NONE, 16, true},
+  {144, 96, GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT, GL_NONE, GL_NONE, 16, true},
+  {145, 98, GL_COMPRESSED_RGBA_BPTC_UNORM, GL_NONE, GL_NONE, 16, true},
+  {146, 99, GL_COMPRESSED_RGBA_BPTC_UNORM, GL_NONE, GL_NONE, 16, true},
+};
+
+constexpr uint32_t VK_FORMAT_B8G8R8_UNORM = 30;
+
+const FormatInfo *find_format(uint32_t FormatInfo::*field, uint32_t value) noexcept {
+  if (value == 0) {
+    return nullptr;
+  }
+  for (const auto &info : FORMATS) {
+    if (info.*field == value) {
+      return &info;
+    }
+  }
+  return nullptr;
+}
+
+constexpr uint32_t fourcc(const char (&code)[5]) noexcept {
+  return uint32_t(uint8_t(code[0])) | uint32_t(uint8_t(code[1])) << 8 | uint32_t(uint8_t(code[2])) << 16 |
+         uint32_t(uint8_t(code[3])) << 24;
+}
+
+// 文件中的整数均为小端序，按字节拷贝避免未对齐访问
+template <typename T>
+T read(const uint8_t *data, size_t offset) noexcept {
+  T value;
+  std::memcpy(&value, data + offset, sizeof(T));
+  return value;
+}
+
+// 翻转 4×4 块中的前 rows 行：BC1 颜色块的 4 行索引各占 1 字节
+void flip_color_block(uint8_t *block, uint32_t rows) noexcept { std::reverse(block + 4, block + 4 + rows); }
+
+// BC2 的显式 alpha 每行 2 字节
+void flip_explicit_alpha_block(uint8_t *block, uint32_t rows) noexcept {
+  for (uint32_t r = 0; r < rows / 2; ++r) {
+    std::swap_ranges(block + r * 2, block + r * 2 + 2, block + (rows - 1 - r) * 2);
+  }
+}
+
+// BC3 的 alpha 与 BC4 / BC5 的通道：2 字节端点之后是 48 位小端的 3 位索引，每行 12 位
+void flip_interpolated_block(uint8_t *block, uint32_t rows) noexcept {
+  uint64_t bits = 0;
+  std::memcpy(&bits, block + 2, 6);
+  uint64_t flipped = bits;
+  for (uint32_t r = 0; r < rows; ++r) {
+    uint64_t row = (bits >> (12 * (rows - 1 - r))) & 0xFFF;
+    flipped = (flipped & ~(0xFFFull << (12 * r))) | row << (12 * r);
+  }
+  std::memcpy(block + 2, &flipped, 6);
+}
+
+std::string lower_extension(const std::string &file_path) noexcept {
+  std::string extension = std::filesystem::path(file_path).extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+  return extension;
+}
+
+}  // namespace
+
+bool TextureContainer::is_container(const std::string &file_path) noexcept {
+  std::string extension = lower_extension(file_path);
+  return extension == ".ktx2" || extension == ".dds";
+}
+
+std::string TextureContainer::find_sibling(const std::string &image_path) noexcept {
+  std::error_code ec;
+  for (const char *extension : {".ktx2", ".dds"}) {
+    std::filesystem::path candidate = std::filesystem::path(image_path).replace_extension(extension);
+    if (std::filesystem::is_regular_file(candidate, ec)) {
+      return candidate.string();
+    }
+  }
+  return std::string();
+}
+
+TextureContainer::TextureContainer(const std::string &file_path) noexcept : path(file_path), file(file_path) {
+  if (file.get_data() == nullptr) {
+    std::cout << "[ERROR::TextureContainer] Failed to map file: " << path << std::endl;
+    return;
+  }
+  valid = lower_extension(path) == ".dds" ? parse_dds() : parse_ktx2();
+}
+
+bool TextureContainer::add_level(uint32_t width, uint32_t height, size_t offset, size_t size) noexcept {
+  if (offset > file.get_size() || size > file.get_size() - offset) {
+    std::cout << "[ERROR::TextureContainer] Level " << levels.size() << " is out of range: " << path << std::endl;
+    return false;
+  }
+  levels.push_back({width, height, file.get_data() + offset, size});
+  return true;
+}
+
+size_t TextureContainer::level_size(uint32_t width, uint32_t height) const noexcept {
+  if (compressed) {
+    return size_t((width + 3) / 4) * ((height + 3) / 4) * block_bytes;
+  }
+  return size_t(width) * height * block_bytes;
+}
+
+bool TextureContainer::add_levels(size_t offset, uint32_t width, uint32_t height, uint32_t count) noexcept {
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t w = std::max(width >> i, 1u);
+    uint32_t h = std::max(height >> i, 1u);
+    size_t size = level_size(w, h);
+    if (!add_level(w, h, offset, size)) {
+      return false;
+    }
+    offset += size;
+  }
+  return true;
+}
+
+bool TextureContainer::parse_ktx2() noexcept {
+  static constexpr uint8_t IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+  static constexpr size_t HEADER_SIZE = 80;  // 标识、头与索引
+  static constexpr size_t LEVEL_INDEX_SIZE = 24;
+  const uint8_t *data = file.get_data();
+  if (file.get_size() < HEADER_SIZE || std::memcmp(data, IDENTIFIER, sizeof(IDENTIFIER)) != 0) {
+    std::cout << "[ERROR::TextureContainer] Not a KTX2 file: " << path << std::endl;
+    return false;
+  }
+  uint32_t vk_format = read<uint32_t>(data, 12);
+  uint32_t width = read<uint32_t>(data, 20);
+  uint32_t height = read<uint32_t>(data, 24);
+  uint32_t depth = read<uint32_t>(data, 28);
+  uint32_t layers = read<uint32_t>(data, 32);
+  uint32_t faces = read<uint32_t>(data, 36);
+  uint32_t level_count = std::max(read<uint32_t>(data, 40), 1u);
+  uint32_t supercompression = read<uint32_t>(data, 44);
+  if (width == 0 || height == 0 || depth > 1 || layers > 1 || faces != 1 || supercompression != 0) {
+    std::cout << "[ERROR::TextureContainer] Only uncompressed-stream 2D KTX2 textures are supported: " << path
+              << std::endl;
+    return false;
+  }
+  const FormatInfo *info = find_format(&FormatInfo::vk_format, vk_format);
+  if (info == nullptr) {
+    std::cout << "[ERROR::TextureContainer] Unsupported VkFormat " << vk_format << ": " << path << std::endl;
+    return false;
+  }
+  internal_format = info->internal_format;
+  format = info->format;
+  type = info->type;
+  block_bytes = info->bytes;
+  compressed = info->compressed;
+  if (file.get_size() < HEADER_SIZE + level_count * LEVEL_INDEX_SIZE) {
+    std::cout << "[ERROR::TextureContainer] Truncated level index: " << path << std::endl;
+    return false;
+  }
+  // 各级在文件中的位置由索引给出，索引从第 0 级开始
+  for (uint32_t i = 0; i < level_count; ++i) {
+    size_t entry = HEADER_SIZE + i * LEVEL_INDEX_SIZE;
+    uint32_t w = std::max(width >> i, 1u);
+    uint32_t h = std::max(height >> i, 1u);
+    if (read<uint64_t>(data, entry + 8) < level_size(w, h)) {
+      std::cout << "[ERROR::TextureContainer] Level " << i << " is too small: " << path << std::endl;
+      return false;
+    }
+    if (!add_level(w, h, read<uint64_t>(data, entry), level_size(w, h))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TextureContainer::parse_dds() noexcept {
+  static constexpr size_t HEADER_SIZE = 128;  // 魔数与 DDS_HEADER
+  static constexpr size_t DX10_HEADER_SIZE = 20;
+  static constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+  static constexpr uint32_t DDPF_FOURCC = 0x4;
+  static constexpr uint32_t DDPF_RGB = 0x40;
+  static constexpr uint32_t DDPF_LUMINANCE = 0x20000;
+  static constexpr uint32_t DDSCAPS2_CUBEMAP = 0x200;
+  static constexpr uint32_t DDSCAPS2_VOLUME = 0x200000;
+  static constexpr uint32_t D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+  const uint8_t *data = file.get_data();
+  if (file.get_size() < HEADER_SIZE || read<uint32_t>(data, 0) != fourcc("DDS ")) {
+    std::cout << "[ERROR::TextureContainer] Not a DDS file: " << path << std::endl;
+    return false;
+  }
+  uint32_t flags = read<uint32_t>(data, 8);
+  uint32_t height = read<uint32_t>(data, 12);
+  uint32_t width = read<uint32_t>(data, 16);
+  uint32_t level_count = flags & DDSD_MIPMAPCOUNT ? std::max(read<uint32_t>(data, 28), 1u) : 1;
+  uint32_t pixel_flags = read<uint32_t>(data, 80);
+  uint32_t code = read<uint32_t>(data, 84);
+  uint32_t bit_count = read<uint32_t>(data, 88);
+  uint32_t red_mask = read<uint32_t>(data, 92);
+  uint32_t caps2 = read<uint32_t>(data, 112);
+  if (width == 0 || height == 0 || caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)) {
+    std::cout << "[ERROR::TextureContainer] Only 2D DDS textures are supported: " << path << std::endl;
+    return false;
+  }
+
+  size_t offset = HEADER_SIZE;
+  const FormatInfo *info = nullptr;
+  if (pixel_flags & DDPF_FOURCC && code == fourcc("DX10")) {
+    if (file.get_size() < HEADER_SIZE + DX10_HEADER_SIZE || read<uint32_t>(data, 132) != D3D10_RESOURCE_DIMENSION_TEXTURE2D ||
+        read<uint32_t>(data, 136) & 0x4 || read<uint32_t>(data, 140) > 1) {
+      std::cout << "[ERROR::TextureContainer] Only 2D DDS textures are supported: " << path << std::endl;
+      return false;
+    }
+    info = find_format(&FormatInfo::dxgi_format, read<uint32_t>(data, 128));
+    offset += DX10_HEADER_SIZE;
+  } else if (pixel_flags & DDPF_FOURCC) {
+    // 旧式 FourCC 只有 BC1 ~ BC5
+    const std::pair<uint32_t, uint32_t> LEGACY[] = {
+      {fourcc("DXT1"), 71}, {fourcc("DXT2"), 74}, {fourcc("DXT3"), 74}, {fourcc("DXT4"), 77}, {fourcc("DXT5"), 77},
+      {fourcc("ATI1"), 80}, {fourcc("BC4U"), 80}, {fourcc("BC4S"), 81}, {fourcc("ATI2"), 83}, {fourcc("BC5U"), 83},
+      {fourcc("BC5S"), 84},
+    };
+    for (const auto &[legacy, dxgi_format] : LEGACY) {
+      if (legacy == code) {
+        info = find_format(&FormatInfo::dxgi_format, dxgi_format);
+      }
+    }
+  } else if (pixel_flags & DDPF_RGB && bit_count == 32) {
+    info = find_format(&FormatInfo::dxgi_format, red_mask == 0x000000FF ? 28 : 87);
+  } else if (pixel_flags & DDPF_RGB && bit_count == 24 && red_mask == 0x00FF0000) {
+    info = find_format(&FormatInfo::vk_format, VK_FORMAT_B8G8R8_UNORM);
+  } else if (pixel_flags & DDPF_LUMINANCE && bit_count == 8) {
+    info = find_format(&FormatInfo::dxgi_format, 61);
+  }
+  if (info == nullptr) {
+    std::cout << "[ERROR::TextureContainer] Unsupported DDS pixel format: " << path << std::endl;
+    return false;
+  }
+  internal_format = info->internal_format;
+  format = info->format;
+  type = info->type;
+  block_bytes = info->bytes;
+  compressed = info->compressed;
+  // DDS 的各级紧密排列在头之后
+  return add_levels(offset, width, height, level_count);
+}
+
+bool TextureContainer::is_supported() const noexcept {
+  switch (internal_format) {
+  case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+  case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+  case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+  case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    return GLAD_GL_EXT_texture_compression_s3tc;
+  case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+  case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+  case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    return GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_compression_bptc;
+  default:
+    // 未压缩格式与 RGTC 是 GL 3.0 的核心功能
+    return true;
+  }
+}
+
+bool TextureContainer::can_flip() const noexcept {
+  if (!compressed) {
+    return true;
+  }
+  switch (internal_format) {
+  case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+  case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+  case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    // BC6H / BC7 的分区与端点按块内位置编码，无法只重排索引
+    return false;
+  default:
+    break;
+  }
+  // 块行整体交换只在高度为 4 的倍数时对齐，不足 4 行的级别只有一行块
+  for (const auto &level : levels) {
+    if (level.height > 4 && level.height % 4 != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void TextureContainer::flip_level(const Level &level, uint8_t *dst) const noexcept {
+  if (!compressed) {
+    size_t row_bytes = size_t(level.width) * block_bytes;
+    for (uint32_t y = 0; y < level.height; ++y) {
+      std::memcpy(dst + (level.height - 1 - y) * row_bytes, level.data + y * row_bytes, row_bytes);
+    }
+    return;
+  }
+  size_t row_bytes = size_t((level.width + 3) / 4) * block_bytes;
+  uint32_t block_rows = (level.height + 3) / 4;
+  for (uint32_t y = 0; y < block_rows; ++y) {
+    std::memcpy(dst + (block_rows - 1 - y) * row_bytes, level.data + y * row_bytes, row_bytes);
+  }
+  uint32_t rows = std::min(level.height, 4u);
+  for (uint8_t *block = dst; block < dst + level.size; block += block_bytes) {
+    switch (internal_format) {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+      flip_color_block(block, rows);
+      break;
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+      flip_explicit_alpha_block(block, rows);
+      flip_color_block(block + 8, rows);
+      break;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+      flip_interpolated_block(block, rows);
+      flip_color_block(block + 8, rows);
+      break;
+    case GL_COMPRESSED_RED_RGTC1:
+    case GL_COMPRESSED_SIGNED_RED_RGTC1:
+      flip_interpolated_block(block, rows);
+      break;
+    case GL_COMPRESSED_RG_RGTC2:
+    case GL_COMPRESSED_SIGNED_RG_RGTC2:
+      flip_interpolated_block(block, rows);
+      flip_interpolated_block(block + 8, rows);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+GLuint TextureContainer::upload(GLenum wrapMode, GLenum magFilterMode, GLenum minFilterMode, bool vFlip) const noexcept {
+  if (!valid) {
+    return GL_ZERO;
+  }
+  if (vFlip && !can_flip()) {
+    std::cout << "[WARN::TextureContainer] Format 0x" << std::hex << internal_format << std::dec
+              << " cannot be flipped vertically, uploaded as stored: " << path << std::endl;
+    vFlip = false;
+  }
+  if (!is_supported()) {
+    std::cout << "[ERROR::TextureContainer] Compressed format 0x" << std::hex << internal_format << std::dec
+              << " is not supported by the driver: " << path << std::endl;
+    return GL_ZERO;
+  }
+  GLuint texture_id = GL_ZERO;
+  glGenTextures(1, &texture_id);
+  glBindTexture(GL_TEXTURE_2D, texture_id);
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilterMode);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilterMode);
+
+  // 各级数据直接来自映射的文件，行之间没有填充；需要翻转时先在内存中逐级翻转
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  std::vector<uint8_t> flipped;
+  for (uint32_t i = 0; i < levels.size(); ++i) {
+    const Level &level = levels[i];
+    const uint8_t *data = level.data;
+    if (vFlip) {
+      flipped.resize(level.size);
+      flip_level(level, flipped.data());
+      data = flipped.data();
+    }
+    if (compressed) {
+      glCompressedTexImage2D(GL_TEXTURE_2D, i, internal_format, level.width, level.height, 0, GLsizei(level.size), data);
+    } else {
+      glTexImage2D(GL_TEXTURE_2D, i, internal_format, level.width, level.height, 0, format, type, data);
+    }
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  if (levels.size() == 1 && !compressed) {
+    glGenerateMipmap(GL_TEXTURE_2D);
+  } else {
+    // 文件中的 mip 链可能不到 1×1，限制最高级使纹理完整
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels.size() - 1);
+  }
+  glBindTexture(GL_TEXTURE_2D, GL_ZERO);
+  return texture_id;
+}
@@ -0,0 +1,73 @@
+#ifndef __TEXTURE_CONTAINER_H__
+#define __TEXTURE_CONTAINER_H__
+
+#include <glad/glad.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+
+/** GPU 可直接使用的纹理容器 (KTX2 / DDS)
+ * 解析文件头与各级 mip 在文件中的位置，像素数据不经解码，由 upload 逐级交给 glTexImage2D /
+ * glCompressedTexImage2D。只支持单层、单面的二维纹理与无超压缩 (supercompression) 的 KTX2，
+ * 格式覆盖 8 位 R / RG / RGB / RGBA (含 sRGB 与 BGRA)、RGBA16F 以及 BC1 ~ BC7 块压缩格式。
+ * 与 stb_image 加载的图像保持一致：sRGB 格式按对应的线性格式上传 (管线不做伽马校正)，
+ * 文件中的行序与图像文件相同 (首行在上)，需要翻转时由 upload 的 vFlip 指定
+ */
+class TextureContainer {
+public:
+  struct Level {
+    uint32_t width;
+    uint32_t height;
+    const uint8_t *data;  // 指向映射的文件
+    size_t size;
+  };
+
+  // 路径扩展名为 .ktx2 或 .dds (不区分大小写)
+  static bool is_container(const std::string &file_path) noexcept;
+  // 图像文件旁同名的 .ktx2 或 .dds，优先 .ktx2，都不存在时返回空串
+  static std::string find_sibling(const std::string &image_path) noexcept;
+
+  explicit TextureContainer(const std::string &file_path) noexcept;
+  TextureContainer(const TextureContainer &oth) = delete;
+  TextureContainer &operator=(const TextureContainer &oth) = delete;
+
+  bool is_valid() const noexcept { return valid; }
+  bool is_compressed() const noexcept { return compressed; }
+  GLenum get_internal_format() const noexcept { return internal_format; }
+  const std::vector<Level> &get_levels() const noexcept { return levels; }
+
+  // 创建纹理并上传全部 mip；文件只有一级时未压缩格式由 glGenerateMipmap 补全，
+  // 压缩格式只使用这一级。vFlip 与 stbi_set_flip_vertically_on_load 相同：未压缩格式与 BC1 ~ BC5 逐级翻转，
+  // BC6H / BC7 以及高度大于 4 且不是 4 的倍数的压缩级别无法翻转，给出警告后按原样上传。失败时返回 GL_ZERO
+  GLuint upload(GLenum wrapMode, GLenum magFilterMode, GLenum minFilterMode, bool vFlip = false) const noexcept;
+
+private:
+  bool parse_ktx2() noexcept;
+  bool parse_dds() noexcept;
+  // 由 internal_format 与尺寸计算每级大小，从 offset 起依次排列
+  bool add_levels(size_t offset, uint32_t width, uint32_t height, uint32_t count) noexcept;
+  bool add_level(uint32_t width, uint32_t height, size_t offset, size_t size) noexcept;
+  size_t level_size(uint32_t width, uint32_t height) const noexcept;
+  bool is_supported() const noexcept;
+  bool can_flip() const noexcept;
+  // 把 level 上下翻转后写入 dst (level.size 字节)，压缩格式交换块行并翻转块内的索引
+  void flip_level(const Level &level, uint8_t *dst) const noexcept;
+
+private:
+  std::string path;
+  MappedFile file;
+  bool valid = false;
+  bool compressed = false;
+  GLenum internal_format = GL_NONE;
+  GLenum format = GL_NONE;
+  GLenum type = GL_NONE;
+  uint32_t block_bytes = 0;  // 压缩格式每 4×4 块的字节数，未压缩格式每像素的字节数
+  std::vector<Level> levels;
+};
+
+#endif  // !__TEXTURE_CONTAINER_H__
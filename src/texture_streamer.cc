@@ -0,0 +1,331 @@
+#include "texture_streamer.h"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "utils.h"
+
+namespace {
+
+GLenum pixel_format(int32_t channels) noexcept {
+  switch (channels) {
+  case 1:
+    return GL_RED;
+  case 3:
+    return GL_RGB;
+  default:
+    return GL_RGBA;
+  }
+}
+
+GLenum internal_format(int32_t channels) noexcept {
+  switch (channels) {
+  case 1:
+    return GL_R8;
+  case 3:
+    return GL_RGB8;
+  default:
+    return GL_RGBA8;
+  }
+}
+
+}  // namespace
+
+TextureStreamer::TextureStreamer() {
+  pbo = std::make_shared<StreamBuffer>(GL_PIXEL_UNPACK_BUFFER, UPLOAD_BUDGET);
+  thread = std::thread([this]() { decode_loop(); });
+}
+
+TextureStreamer::~TextureStreamer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  thread.join();
+}
+
+void TextureStreamer::load(Texture::Ptr texture, const std::string &path, GLenum wrapMode) {
+  int32_t width, height, channels;
+  if (!stbi_info(path.c_str(), &width, &height, &channels)) {
+    texture->id = Texture2DFromFile(path, wrapMode);
+    return;
+  }
+  Entry entry;
+  entry.texture = texture;
+  entry.path = path;
+  entry.width = width;
+  entry.height = height;
+  // 双通道图像与 Texture2DFromFile 一样按 RGBA 处理
+  entry.channels = channels == 2 ? 4 : channels;
+  entry.levels = int32_t(std::floor(std::log2(std::max(width, height)))) + 1;
+  entry.tail_level = 0;
+  while (std::max(width >> entry.tail_level, height >> entry.tail_level) > TAIL_SIZE) {
+    ++entry.tail_level;
+  }
+  entry.resident = entry.levels - 1;
+  entry.desired = entry.tail_level;
+
+  glGenTextures(1, &entry.id);
+  glBindTexture(GL_TEXTURE_2D, entry.id);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  // 解码完成前以中灰色的最小一级占位
+  const uint8_t placeholder[4] = {128, 128, 128, 255};
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, entry.resident, internal_format(entry.channels), 1, 1, 0, pixel_format(entry.channels),
+               GL_UNSIGNED_BYTE, placeholder);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry.resident);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, entry.levels - 1);
+  glBindTexture(GL_TEXTURE_2D, GL_ZERO);
+  texture->id = entry.id;
+
+  // 尾部对所有纹理都需要，加载时即排队解码
+  entry.decoding = true;
+  uint32_t index = entries.size();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back({index, path, entry.channels, 0.0f});
+  }
+  wake.notify_one();
+  entry_of[entry.id] = index;
+  entries.push_back(std::move(entry));
+  ++stats.textures;
+  stats.resident_bytes += level_bytes(entries.back(), entries.back().resident);
+}
+
+void TextureStreamer::request(const Texture::Ptr &texture, float pixels) noexcept {
+  auto it = entry_of.find(texture->id);
+  if (it == entry_of.end()) {
+    return;
+  }
+  Entry &entry = entries[it->second];
+  // 覆盖 pixels 像素时纹理约需要边长为 pixels 的一级
+  float ratio = std::max(entry.width, entry.height) / std::max(pixels, 1.0f);
+  int32_t level = ratio <= 1.0f ? 0 : int32_t(std::floor(std::log2(ratio)));
+  entry.desired = std::min(entry.desired, std::min(level, entry.tail_level));
+  entry.priority = std::max(entry.priority, pixels);
+}
+
+uint64_t TextureStreamer::level_bytes(const Entry &entry, int32_t level) const noexcept {
+  return uint64_t(std::max(entry.width >> level, 1)) * std::max(entry.height >> level, 1) * entry.channels;
+}
+
+void TextureStreamer::set_base_level(Entry &entry, int32_t level) noexcept {
+  entry.resident = level;
+  glBindTexture(GL_TEXTURE_2D, entry.id);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+  glBindTexture(GL_TEXTURE_2D, GL_ZERO);
+}
+
+void TextureStreamer::upload_level(Entry &entry, int32_t level, bool use_pbo) noexcept {
+  const Level &data = (*entry.decoded)[level];
+  GLsizeiptr size = data.pixels.size();
+  const void *pixels = data.pixels.data();
+  StreamBuffer::Allocation allocation;
+  if (use_pbo) {
+    allocation = pbo->allocate(size);
+  }
+  if (allocation.data != nullptr) {
+    std::copy(data.pixels.begin(), data.pixels.end(), static_cast<uint8_t *>(allocation.data));
+    pbo->commit(allocation);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo->get_id());
+    pixels = reinterpret_cast<const void *>(allocation.offset);
+  }
+  glBindTexture(GL_TEXTURE_2D, entry.id);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, level, internal_format(entry.channels), data.width, data.height, 0,
+               pixel_format(entry.channels), GL_UNSIGNED_BYTE, pixels);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindTexture(GL_TEXTURE_2D, GL_ZERO);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, GL_ZERO);
+  frame_uploaded += size;
+}
+
+void TextureStreamer::update() noexcept {
+  ++frame;
+  pbo->begin_frame();
+  frame_uploaded = 0;
+
+  std::vector<std::pair<uint32_t, Decoded>> results;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    results.swap(finished);
+  }
+  for (auto &[index, decoded] : results) {
+    Entry &entry = entries[index];
+    entry.decoding = false;
+    if (entry.texture.expired()) {
+      continue;
+    }
+    if (decoded == nullptr) {
+      entry.failed = true;
+      std::cout << "[ERROR::TextureStreamer] Failed to decode texture: " << entry.path << std::endl;
+      continue;
+    }
+    entry.decoded = decoded;
+    if (!entry.tail_loaded) {
+      // 尾部很小，不占用每帧的预算，直接整体上传
+      stats.resident_bytes -= level_bytes(entry, entry.resident);
+      for (int32_t level = entry.levels - 1; level >= entry.tail_level; --level) {
+        upload_level(entry, level, false);
+        stats.resident_bytes += level_bytes(entry, level);
+      }
+      set_base_level(entry, entry.tail_level);
+      entry.tail_loaded = true;
+      entry.top_needed = frame;
+    }
+  }
+
+  candidates.clear();
+  std::vector<Job> new_jobs;
+  for (uint32_t i = 0; i < entries.size(); ++i) {
+    Entry &entry = entries[i];
+    if (entry.texture.expired() && !entry.released) {
+      // Texture 析构时已删除纹理对象，名字可能被之后创建的纹理复用
+      auto it = entry_of.find(entry.id);
+      if (it != entry_of.end() && it->second == i) {
+        entry_of.erase(it);
+      }
+      entry.released = true;
+      entry.decoded = nullptr;
+      --stats.textures;
+      for (int32_t level = entry.resident; level < entry.levels; ++level) {
+        stats.resident_bytes -= level_bytes(entry, level);
+      }
+    }
+    if (entry.released || !entry.tail_loaded) {
+      continue;
+    }
+    if (entry.desired <= entry.resident) {
+      entry.top_needed = frame;
+    } else if (frame - entry.top_needed > EVICT_FRAMES) {
+      // 顶层长时间不被需要，重新指定为 0×0 释放显存
+      glBindTexture(GL_TEXTURE_2D, entry.id);
+      glTexImage2D(GL_TEXTURE_2D, entry.resident, internal_format(entry.channels), 0, 0, 0, pixel_format(entry.channels),
+                   GL_UNSIGNED_BYTE, nullptr);
+      glBindTexture(GL_TEXTURE_2D, GL_ZERO);
+      stats.resident_bytes -= level_bytes(entry, entry.resident);
+      set_base_level(entry, entry.resident + 1);
+      ++stats.evicted_levels;
+      entry.top_needed = frame;
+    }
+
+    if (entry.desired < entry.resident) {
+      if (entry.decoded != nullptr) {
+        candidates.emplace_back(entry.priority, i);
+      } else if (!entry.decoding && !entry.failed) {
+        // 解码结果已释放，重新从文件解码
+        entry.decoding = true;
+        new_jobs.push_back({i, entry.path, entry.channels, entry.priority});
+      }
+    } else {
+      entry.decoded = nullptr;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    // 排队中的解码任务按本帧的覆盖范围更新优先级
+    for (auto &job : jobs) {
+      job.priority = entries[job.entry].priority;
+    }
+    jobs.insert(jobs.end(), new_jobs.begin(), new_jobs.end());
+    stats.pending_decodes = jobs.size();
+  }
+  if (!new_jobs.empty()) {
+    wake.notify_one();
+  }
+
+  // 覆盖范围大的优先，每个纹理一次提升一级，直到用完本帧的预算
+  std::sort(candidates.begin(), candidates.end(), std::greater<>());
+  bool progress = true;
+  while (progress) {
+    progress = false;
+    for (auto [priority, index] : candidates) {
+      Entry &entry = entries[index];
+      if (entry.desired >= entry.resident) {
+        continue;
+      }
+      int32_t level = entry.resident - 1;
+      GLsizeiptr size = level_bytes(entry, level);
+      // 超过整帧预算的一级只能在本帧还没有上传时直接从内存上传，否则留到下一帧
+      bool fits = frame_uploaded + size + 16 <= UPLOAD_BUDGET;
+      if (!fits && frame_uploaded > 0) {
+        continue;
+      }
+      upload_level(entry, level, fits);
+      set_base_level(entry, level);
+      stats.resident_bytes += size;
+      entry.top_needed = frame;
+      progress = true;
+    }
+  }
+
+  for (auto &entry : entries) {
+    entry.desired = entry.tail_level;
+    entry.priority = 0;
+  }
+  stats.uploaded_bytes = frame_uploaded;
+  pbo->end_frame();
+}
+
+void TextureStreamer::decode_loop() noexcept {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+    if (stopping) {
+      return;
+    }
+    auto next = std::max_element(
+      jobs.begin(), jobs.end(), [](const Job &a, const Job &b) { return a.priority < b.priority; });
+    Job job = *next;
+    jobs.erase(next);
+    lock.unlock();
+    Decoded decoded = decode(job.path, job.channels);
+    lock.lock();
+    finished.emplace_back(job.entry, decoded);
+  }
+}
+
+TextureStreamer::Decoded TextureStreamer::decode(const std::string &path, int32_t channels) noexcept {
+  int32_t width, height, file_channels;
+  unsigned char *data = stbi_load(path.c_str(), &width, &height, &file_channels, channels);
+  if (data == nullptr) {
+    return nullptr;
+  }
+  Decoded levels = std::make_shared<std::vector<Level>>();
+  levels->push_back({width, height, std::vector<uint8_t>(data, data + size_t(width) * height * channels)});
+  stbi_image_free(data);
+
+  // 2×2 盒式滤波逐级缩小，奇数边长时最后一行 / 列重复使用
+  while (width > 1 || height > 1) {
+    const Level &src = levels->back();
+    int32_t w = std::max(width >> 1, 1);
+    int32_t h = std::max(height >> 1, 1);
+    Level dst{w, h, std::vector<uint8_t>(size_t(w) * h * channels)};
+    for (int32_t y = 0; y < h; ++y) {
+      int32_t y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+      for (int32_t x = 0; x < w; ++x) {
+        int32_t x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+        for (int32_t c = 0; c < channels; ++c) {
+          uint32_t sum = src.pixels[(size_t(y0) * width + x0) * channels + c] +
+                         src.pixels[(size_t(y0) * width + x1) * channels + c] +
+                         src.pixels[(size_t(y1) * width + x0) * channels + c] +
+                         src.pixels[(size_t(y1) * width + x1) * channels + c];
+          dst.pixels[(size_t(y) * w + x) * channels + c] = (sum + 2) / 4;
+        }
+      }
+    }
+    levels->push_back(std::move(dst));
+    width = w;
+    height = h;
+  }
+  return levels;
+}
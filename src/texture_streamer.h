@@ -0,0 +1,117 @@
+#ifndef __TEXTURE_STREAMER_H__
+#define __TEXTURE_STREAMER_H__
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "mesh.h"
+#include "stream_buffer.h"
+
+/** 渐进式纹理流送
+ * load 只读取文件头，立即创建纹理并放入 1×1 的占位 mip，解码与生成 mip 链在后台线程进行；
+ * 解码完成后先整体上传边长不超过 TAIL_SIZE 的 mip 尾部，更高的 mip 只在被需要时
+ * 按优先级经 PBO (StreamBuffer) 逐级上传，每帧不超过 UPLOAD_BUDGET 字节。
+ * 常驻的 mip 范围以 GL_TEXTURE_BASE_LEVEL / GL_TEXTURE_MAX_LEVEL 限制，纹理始终是完整的。
+ * 每帧由 request 按物体在屏幕上的覆盖范围给出需要的最高 mip 与优先级；
+ * 顶层 mip 连续 EVICT_FRAMES 帧不被需要时重新指定为 0×0 释放，尾部始终常驻。
+ * load、request、update 都须在持有 GL 上下文的线程上调用
+ */
+class TextureStreamer {
+public:
+  typedef std::shared_ptr<TextureStreamer> Ptr;
+
+  static constexpr int32_t TAIL_SIZE = 64;
+  static constexpr GLsizeiptr UPLOAD_BUDGET = 4 * 1024 * 1024;
+  static constexpr uint64_t EVICT_FRAMES = 300;
+
+  struct Stats {
+    uint32_t textures = 0;         // 流送管理的纹理数
+    uint32_t pending_decodes = 0;  // 排队与正在解码的纹理数
+    uint64_t resident_bytes = 0;   // 常驻 mip 占用的显存
+    uint64_t uploaded_bytes = 0;   // 最近一帧上传的字节数
+    uint64_t evicted_levels = 0;   // 累计释放的 mip 层数
+  };
+
+  TextureStreamer();
+  TextureStreamer(const TextureStreamer &oth) = delete;
+  TextureStreamer &operator=(const TextureStreamer &oth) = delete;
+  ~TextureStreamer();
+
+  // 创建纹理并写入 texture->id；无法读取文件头时退回 Texture2DFromFile 同步加载
+  void load(Texture::Ptr texture, const std::string &path, GLenum wrapMode = GL_REPEAT);
+  // 使用 texture 的物体本帧在屏幕上约覆盖 pixels 像素（直径），不由流送管理的纹理被忽略
+  void request(const Texture::Ptr &texture, float pixels) noexcept;
+  // 每帧调用一次：接收解码结果、上传需要的 mip、释放长时间不需要的顶层 mip
+  void update() noexcept;
+
+  const Stats &get_stats() const noexcept { return stats; }
+
+private:
+  struct Level {
+    int32_t width;
+    int32_t height;
+    std::vector<uint8_t> pixels;
+  };
+  typedef std::shared_ptr<std::vector<Level>> Decoded;
+
+  struct Entry {
+    std::weak_ptr<Texture> texture;
+    GLuint id;
+    std::string path;
+    int32_t width;
+    int32_t height;
+    int32_t channels;
+    int32_t levels;
+    int32_t tail_level;      // 边长不超过 TAIL_SIZE 的第一级
+    int32_t resident;        // 当前的 GL_TEXTURE_BASE_LEVEL
+    int32_t desired;         // 本帧需要的最高一级，未被请求时为 tail_level
+    float priority = 0;      // 本帧请求中最大的覆盖像素数
+    uint64_t top_needed = 0; // 最近一次需要 resident 这一级的帧
+    bool tail_loaded = false;
+    bool decoding = false;
+    bool failed = false;
+    bool released = false;   // Texture 已析构
+    Decoded decoded;         // 解码后的完整 mip 链，不再需要上传时释放
+  };
+
+  struct Job {
+    uint32_t entry;
+    std::string path;
+    int32_t channels;
+    float priority;
+  };
+
+  void decode_loop() noexcept;
+  static Decoded decode(const std::string &path, int32_t channels) noexcept;
+  void upload_level(Entry &entry, int32_t level, bool use_pbo) noexcept;
+  void set_base_level(Entry &entry, int32_t level) noexcept;
+  uint64_t level_bytes(const Entry &entry, int32_t level) const noexcept;
+
+private:
+  std::vector<Entry> entries;
+  std::unordered_map<GLuint, uint32_t> entry_of;
+  StreamBuffer::Ptr pbo;
+  GLsizeiptr frame_uploaded = 0;
+  uint64_t frame = 0;
+  Stats stats;
+  std::vector<std::pair<float, uint32_t>> candidates;
+
+  // 后台解码线程
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::vector<Job> jobs;
+  std::vector<std::pair<uint32_t, Decoded>> finished;
+  bool stopping = false;
+};
+
+#endif  // !__TEXTURE_STREAMER_H__
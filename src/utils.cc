@@ -7,12 +7,22 @@
 
 #include <stb_image.h>
 
-GLuint Texture2DFromFile(const std::string &file_path, GLenum wrapMode, GLenum magFilterMode, GLenum minFilterMode) noexcept {
+#include "texture_container.h"
+
+GLuint Texture2DFromFile(
+  const std::string &file_path, GLenum wrapMode, GLenum magFilterMode, GLenum minFilterMode, bool vFlip) noexcept {
+  // KTX2 / DDS 已含 GPU 格式的 mip 链，映射后逐级直接上传，不经 stb_image 解码
+  if (TextureContainer::is_container(file_path)) {
+    TextureContainer container(file_path);
+    return container.upload(wrapMode, magFilterMode, minFilterMode, vFlip);
+  }
+
   GLuint texture_id = GL_ZERO;
 
   int32_t width, height, nrChannels;
-  //  stbi_set_flip_vertically_on_load(true);
+  stbi_set_flip_vertically_on_load_thread(vFlip);
   unsigned char *data = stbi_load(file_path.c_str(), &width, &height, &nrChannels, 0);
+  stbi_set_flip_vertically_on_load_thread(false);
 
   if (data != nullptr) {
     GLenum format;
@@ -168,28 +178,16 @@ GLuint Texture2DFromUChar(const unsigned char data[],
 }
 
 
-GLuint Texture2DForShadowMap(
-  GLuint width, GLuint height, GLenum wrapMode, GLenum magFilterMode, GLenum minFilterMode, GLfloat *borderColor) noexcept {
+GLuint Texture2DForAttachment(
+  GLint internalFormat, GLenum format, GLenum type, GLuint width, GLuint height, GLenum filterMode) noexcept {
   GLuint texture_id = GL_ZERO;
   glGenTextures(1, &texture_id);
   glBindTexture(GL_TEXTURE_2D, texture_id);
-
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
-
-  if (wrapMode == GL_CLAMP_TO_BORDER) {
-    GLfloat default_border_color[] = {1.0, 1.0, 1.0, 1.0};
-    if (borderColor == nullptr) {
-      borderColor = default_border_color;
-    }
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-  }
-
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilterMode);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilterMode);
-
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-
+  glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filterMode);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filterMode);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   glBindTexture(GL_TEXTURE_2D, GL_ZERO);
   return texture_id;
 }
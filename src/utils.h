@@ -8,11 +8,12 @@
 #include <string>
 #include <vector>
 
-// 从给定的绝对路径中导入材质
+// 从给定的绝对路径中导入材质，.ktx2 / .dds 文件不经解码直接上传其中的 mip 链；vFlip 为 true 时上下翻转
 GLuint Texture2DFromFile(const std::string &file_path,
                          GLenum wrapMode = GL_REPEAT,
                          GLenum magFilterMode = GL_LINEAR,
-                         GLenum minFilterMode = GL_LINEAR_MIPMAP_LINEAR) noexcept;
+                         GLenum minFilterMode = GL_LINEAR_MIPMAP_LINEAR,
+                         bool vFlip = false) noexcept;
 
 GLuint Texture2DFromAssimp(const aiTexture *ai_texture,
                            GLenum wrapMode = GL_REPEAT,
@@ -27,12 +28,13 @@ GLuint Texture2DFromUChar(const unsigned char data[],
                           GLenum magFilterMode = GL_LINEAR,
                           GLenum minFilterMode = GL_LINEAR_MIPMAP_LINEAR) noexcept;
 
-GLuint Texture2DForShadowMap(GLuint width,
-                             GLuint height,
-                             GLenum wrapMode = GL_CLAMP_TO_EDGE,
-                             GLenum magFilterMode = GL_NEAREST,
-                             GLenum minFilterMode = GL_NEAREST,
-                             GLfloat *borderColor = nullptr) noexcept;
+// 帧缓冲附件使用的空纹理，默认不可过滤且边缘截断
+GLuint Texture2DForAttachment(GLint internalFormat,
+                              GLenum format,
+                              GLenum type,
+                              GLuint width,
+                              GLuint height,
+                              GLenum filterMode = GL_NEAREST) noexcept;
 
 GLuint CubeMapFromFile(const std::vector<std::string> &file_paths,
                        GLenum wrapMode = GL_CLAMP_TO_EDGE,
@@ -0,0 +1,96 @@
+#include "variance_shadow_map.h"
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <iostream>
+
+#include "utils.h"
+
+static GLuint create_framebuffer(GLuint color, GLuint depth) {
+  GLuint fbo = GL_ZERO;
+  glGenFramebuffers(1, &fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+  if (depth != GL_ZERO) {
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+  }
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    std::cout << "[ERROR::VarianceShadowMap] Framebuffer is not complete" << std::endl;
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, GL_ZERO);
+  return fbo;
+}
+
+VarianceShadowMap::VarianceShadowMap(int32_t resolution) : resolution(resolution) {
+  moments = Texture2DForAttachment(GL_RGBA16F, GL_RGBA, GL_FLOAT, resolution, resolution, GL_LINEAR);
+  blur_temp = Texture2DForAttachment(GL_RGBA16F, GL_RGBA, GL_FLOAT, resolution, resolution, GL_LINEAR);
+  // 模糊后的矩做三线性过滤
+  glBindTexture(GL_TEXTURE_2D, moments);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glGenerateMipmap(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, GL_ZERO);
+
+  glGenRenderbuffers(1, &depth);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, resolution, resolution);
+  glBindRenderbuffer(GL_RENDERBUFFER, GL_ZERO);
+
+  fbo = create_framebuffer(moments, depth);
+  blur_fbo = create_framebuffer(blur_temp, GL_ZERO);
+}
+
+VarianceShadowMap::~VarianceShadowMap() {
+  GLuint framebuffers[] = {fbo, blur_fbo};
+  glDeleteFramebuffers(2, framebuffers);
+  GLuint textures[] = {moments, blur_temp};
+  glDeleteTextures(2, textures);
+  glDeleteRenderbuffers(1, &depth);
+}
+
+void VarianceShadowMap::begin() const noexcept {
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glViewport(0, 0, resolution, resolution);
+  // 深度 1 (映射到 [-1, 1] 后为 1) 对应的矩
+  float pos = std::exp(POSITIVE_EXPONENT);
+  float neg = -std::exp(-NEGATIVE_EXPONENT);
+  glClearColor(pos, pos * pos, neg, neg * neg);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void VarianceShadowMap::blur(ShaderProgram::Ptr blur_prog, Mesh::Ptr screen) const noexcept {
+  glDisable(GL_DEPTH_TEST);
+  blur_prog->use();
+  blur_prog->set_uniform("source", MOMENTS_UNIT);
+
+  // 水平: moments -> blur_temp，只读取第 0 级
+  // Mesh::draw 结束时会切回 0 号纹理单元，每次绑定前都需重新选择单元
+  glBindFramebuffer(GL_FRAMEBUFFER, blur_fbo);
+  glActiveTexture(GL_TEXTURE0 + MOMENTS_UNIT);
+  glBindTexture(GL_TEXTURE_2D, moments);
+  blur_prog->set_uniform("direction", glm::vec2(1.0f / resolution, 0.0f));
+  screen->draw(blur_prog);
+
+  // 竖直: blur_temp -> moments
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glActiveTexture(GL_TEXTURE0 + MOMENTS_UNIT);
+  glBindTexture(GL_TEXTURE_2D, blur_temp);
+  blur_prog->set_uniform("direction", glm::vec2(0.0f, 1.0f / resolution));
+  screen->draw(blur_prog);
+
+  glActiveTexture(GL_TEXTURE0 + MOMENTS_UNIT);
+  glBindTexture(GL_TEXTURE_2D, moments);
+  glGenerateMipmap(GL_TEXTURE_2D);
+  glActiveTexture(GL_TEXTURE0);
+  glBindFramebuffer(GL_FRAMEBUFFER, GL_ZERO);
+  glEnable(GL_DEPTH_TEST);
+}
+
+void VarianceShadowMap::bind(ShaderProgram::Ptr shader) const noexcept {
+  glActiveTexture(GL_TEXTURE0 + MOMENTS_UNIT);
+  glBindTexture(GL_TEXTURE_2D, moments);
+  glActiveTexture(GL_TEXTURE0);
+  shader->set_uniform("shadowMoments", MOMENTS_UNIT);
+  shader->set_uniform("evsmExponents", glm::vec2(POSITIVE_EXPONENT, NEGATIVE_EXPONENT));
+  shader->set_uniform("evsmBleedReduction", bleed_reduction);
+}
@@ -0,0 +1,54 @@
+#ifndef __VARIANCE_SHADOW_MAP_H__
+#define __VARIANCE_SHADOW_MAP_H__
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+
+#include <memory>
+
+#include "mesh.h"
+#include "shader.h"
+
+/** 指数方差阴影 (EVSM)
+ * 阴影阶段把深度 d 变换为 pos = exp(c+ · d), neg = -exp(-c- · d)，
+ * 写入 RGBA16F 目标 (pos, pos², neg, neg²)，之后做可分离的高斯模糊并生成 mipmap，
+ * 着色时一次三线性采样即可用切比雪夫不等式求出被照亮比例的上界，
+ * 因此阴影可以直接过滤，每像素的代价与模糊半径无关
+ * 16 位浮点最大约 65504，exp(2c) 不能溢出，指数取 5
+ */
+class VarianceShadowMap {
+public:
+  typedef std::shared_ptr<VarianceShadowMap> Ptr;
+
+  static constexpr GLint MOMENTS_UNIT = 31;
+  static constexpr float POSITIVE_EXPONENT = 5.0f;
+  static constexpr float NEGATIVE_EXPONENT = 5.0f;
+
+  explicit VarianceShadowMap(int32_t resolution = 2048);
+  VarianceShadowMap(const VarianceShadowMap &oth) = delete;
+  VarianceShadowMap &operator=(const VarianceShadowMap &oth) = delete;
+  ~VarianceShadowMap();
+
+  // 绑定并清空为最远深度，之后用 moments 程序绘制投射阴影的物体
+  void begin() const noexcept;
+  // 水平、竖直两次模糊后生成 mipmap
+  void blur(ShaderProgram::Ptr blur_prog, Mesh::Ptr screen) const noexcept;
+  void bind(ShaderProgram::Ptr shader) const noexcept;
+
+  constexpr int32_t get_resolution() const noexcept { return this->resolution; }
+
+public:
+  // 漏光抑制，切比雪夫上界低于该值的部分视为完全在阴影中
+  float bleed_reduction = 0.3f;
+
+private:
+  int32_t resolution;
+  GLuint moments = GL_ZERO;
+  GLuint blur_temp = GL_ZERO;
+  GLuint depth = GL_ZERO;
+  GLuint fbo = GL_ZERO;
+  GLuint blur_fbo = GL_ZERO;
+};
+
+#endif  // !__VARIANCE_SHADOW_MAP_H__
@@ -0,0 +1,132 @@
+#include "vertex_format.h"
+
+#include <glm/glm.hpp>
+
+#include <string>
+
+#include "mesh.h"
+
+void VertexFormat::bind_attrib_locations(GLuint program) noexcept {
+  glBindAttribLocation(program, AttribLocation::POSITION, shader_postion_in.c_str());
+  glBindAttribLocation(program, AttribLocation::NORMAL, shader_normal_in.c_str());
+  for (GLuint i = 0; i < AttribLocation::MAX_TEXCOORDS; ++i) {
+    std::string name = shader_texcoord_prefix_in + std::to_string(i);
+    glBindAttribLocation(program, AttribLocation::TEXCOORD + i, name.c_str());
+  }
+  // 矩阵属性绑定到第一列的位置，其余列依次顺延
+  glBindAttribLocation(program, AttribLocation::INSTANCE_MODEL, shader_instance_model_in.c_str());
+  glBindAttribLocation(program, AttribLocation::BONE_INDICES, shader_bone_indices_in.c_str());
+  glBindAttribLocation(program, AttribLocation::BONE_WEIGHTS, shader_bone_weights_in.c_str());
+}
+
+uint64_t VertexFormat::layout_version() noexcept {
+  return (uint64_t)AttribLocation::TEXCOORD << 8 | (uint64_t)AttribLocation::INSTANCE_MODEL << 16 |
+         (uint64_t)AttribLocation::BONE_INDICES << 24 | (uint64_t)AttribLocation::END << 32 | 2;
+}
+
+GLuint VertexFormat::skin_offset(GLuint format) noexcept {
+  return sizeof(glm::vec3) * 2 + sizeof(glm::vec2) * (format & LAYERS_MASK);
+}
+
+GLuint VertexFormat::vertex_size(GLuint format) noexcept {
+  // 骨骼下标与权重各 4 个 uint16
+  return skin_offset(format) + ((format & SKINNED) ? sizeof(uint16_t) * 8 : 0);
+}
+
+VertexFormat &VertexFormat::instance() noexcept {
+  // 有意不析构：全局的 Model 在所有函数内静态对象之后析构，届时仍会调用 forget；
+  // VAO 由 shutdown 在 GL 线程上删除，静态析构中不做任何 GL 调用
+  static VertexFormat *registry = new VertexFormat;
+  return *registry;
+}
+
+void VertexFormat::shutdown() noexcept {
+  auto &formats = instance().formats;
+  for (auto &[layers, entry] : formats) {
+    glDeleteVertexArrays(1, &entry.vao);
+  }
+  formats.clear();
+}
+
+bool VertexFormat::attrib_binding_supported() noexcept {
+  return GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_vertex_attrib_binding;
+}
+
+VertexFormat::Entry &VertexFormat::get(GLuint format) noexcept {
+  auto &entry = formats[format];
+  if (entry.vao != GL_ZERO) {
+    return entry;
+  }
+  GLuint texcoords_layers = format & LAYERS_MASK;
+  bool skinned = format & SKINNED;
+  glGenVertexArrays(1, &entry.vao);
+  glBindVertexArray(entry.vao);
+  glEnableVertexAttribArray(AttribLocation::POSITION);
+  glEnableVertexAttribArray(AttribLocation::NORMAL);
+  for (GLuint i = 0; i < texcoords_layers && i < AttribLocation::MAX_TEXCOORDS; ++i) {
+    glEnableVertexAttribArray(AttribLocation::TEXCOORD + i);
+  }
+  if (skinned) {
+    glEnableVertexAttribArray(AttribLocation::BONE_INDICES);
+    glEnableVertexAttribArray(AttribLocation::BONE_WEIGHTS);
+  }
+  if (attrib_binding_supported()) {
+    // 属性格式只设定一次，全部取自绑定点 0
+    glVertexAttribFormat(AttribLocation::POSITION, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexAttribBinding(AttribLocation::POSITION, 0);
+    glVertexAttribFormat(AttribLocation::NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3));
+    glVertexAttribBinding(AttribLocation::NORMAL, 0);
+    for (GLuint i = 0; i < texcoords_layers && i < AttribLocation::MAX_TEXCOORDS; ++i) {
+      glVertexAttribFormat(AttribLocation::TEXCOORD + i, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec3) * 2 + sizeof(glm::vec2) * i);
+      glVertexAttribBinding(AttribLocation::TEXCOORD + i, 0);
+    }
+    if (skinned) {
+      GLuint offset = skin_offset(format);
+      glVertexAttribIFormat(AttribLocation::BONE_INDICES, 4, GL_UNSIGNED_SHORT, offset);
+      glVertexAttribBinding(AttribLocation::BONE_INDICES, 0);
+      glVertexAttribFormat(AttribLocation::BONE_WEIGHTS, 4, GL_UNSIGNED_SHORT, GL_TRUE, offset + sizeof(uint16_t) * 4);
+      glVertexAttribBinding(AttribLocation::BONE_WEIGHTS, 0);
+    }
+  }
+  return entry;
+}
+
+void VertexFormat::bind(GLuint format, GLuint vbo, GLuint ebo) noexcept {
+  Entry &entry = instance().get(format);
+  glBindVertexArray(entry.vao);
+  if (entry.vbo == vbo && entry.ebo == ebo) {
+    return;
+  }
+  entry.vbo = vbo;
+  entry.ebo = ebo;
+  GLuint texcoords_layers = format & LAYERS_MASK;
+  GLsizei stride = vertex_size(format);
+  if (attrib_binding_supported()) {
+    glBindVertexBuffer(0, vbo, 0, stride);
+  } else {
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(AttribLocation::POSITION, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid *)0);
+    glVertexAttribPointer(AttribLocation::NORMAL, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid *)sizeof(glm::vec3));
+    for (GLuint i = 0; i < texcoords_layers && i < AttribLocation::MAX_TEXCOORDS; ++i) {
+      glVertexAttribPointer(AttribLocation::TEXCOORD + i, 2, GL_FLOAT, GL_FALSE, stride,
+                            (GLvoid *)(sizeof(glm::vec3) * 2 + sizeof(glm::vec2) * i));
+    }
+    if (format & SKINNED) {
+      uintptr_t offset = skin_offset(format);
+      glVertexAttribIPointer(AttribLocation::BONE_INDICES, 4, GL_UNSIGNED_SHORT, stride, (GLvoid *)offset);
+      glVertexAttribPointer(AttribLocation::BONE_WEIGHTS, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+                            (GLvoid *)(offset + sizeof(uint16_t) * 4));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, GL_ZERO);
+  }
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+}
+
+void VertexFormat::forget(GLuint format, GLuint vbo) noexcept {
+  auto &formats = instance().formats;
+  auto found = formats.find(format);
+  if (found != formats.end() && found->second.vbo == vbo) {
+    found->second.vbo = GL_ZERO;
+    found->second.ebo = GL_ZERO;
+  }
+}
@@ -0,0 +1,72 @@
+#ifndef __VERTEX_FORMAT_H__
+#define __VERTEX_FORMAT_H__
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+
+#include <unordered_map>
+
+/** 固定的顶点属性位置
+ * 所有着色器程序在链接前以 glBindAttribLocation 绑定到同一组位置，
+ * 因此同一顶点格式的 VAO 可以被任意程序共用，不再需要按程序查询属性位置
+ */
+namespace AttribLocation {
+constexpr GLuint POSITION = 0;
+constexpr GLuint NORMAL = 1;
+constexpr GLuint TEXCOORD = 2;  // texcoordN 位于 TEXCOORD + N
+constexpr GLuint MAX_TEXCOORDS = 8;
+constexpr GLuint INSTANCE_MODEL = TEXCOORD + MAX_TEXCOORDS;  // mat4 占用连续 4 个位置
+constexpr GLuint BONE_INDICES = INSTANCE_MODEL + 4;           // 蒙皮网格的 4 个骨骼下标
+constexpr GLuint BONE_WEIGHTS = BONE_INDICES + 1;             // 与之对应的权重
+constexpr GLuint END = BONE_WEIGHTS + 1;
+}  // namespace AttribLocation
+
+/** 按顶点格式共享的 VAO
+ * 顶点格式以纹理坐标层数表示，蒙皮网格再加上 SKINNED 位：其顶点在各层纹理坐标之后
+ * 依次是 4 个 uint16 骨骼下标与 4 个归一化 uint16 权重。
+ * 每种格式只有一个 VAO，属性格式在创建时设定一次；
+ * 绑定时若上次使用的缓冲与本次不同，只重新指向新的 VBO / EBO。
+ * 支持 GL 4.3 / ARB_vertex_attrib_binding 时换缓冲只需 glBindVertexBuffer，
+ * 否则重新调用 glVertexAttribPointer
+ */
+class VertexFormat {
+public:
+  static constexpr GLuint SKINNED = 0x100;
+  static constexpr GLuint LAYERS_MASK = SKINNED - 1;
+
+  // 在 glLinkProgram 之前调用，绑定所有约定的属性名
+  static void bind_attrib_locations(GLuint program) noexcept;
+  // 参与程序二进制缓存键的计算，位置约定改变时旧缓存自动失效
+  static uint64_t layout_version() noexcept;
+
+  // 绑定该格式的 VAO 并指向给定的缓冲
+  static void bind(GLuint format, GLuint vbo, GLuint ebo) noexcept;
+  // 缓冲被删除前调用，避免名字被复用后误判为已绑定；shutdown 之后什么也不做
+  static void forget(GLuint format, GLuint vbo) noexcept;
+  // 删除所有 VAO，在持有 GL 上下文的线程上、GeometryPool::shutdown 之后调用
+  static void shutdown() noexcept;
+
+  static GLuint vertex_size(GLuint format) noexcept;
+  // 蒙皮数据在顶点中的字节偏移
+  static GLuint skin_offset(GLuint format) noexcept;
+
+private:
+  struct Entry {
+    GLuint vao = GL_ZERO;
+    GLuint vbo = GL_ZERO;
+    GLuint ebo = GL_ZERO;
+  };
+
+  VertexFormat() = default;
+  ~VertexFormat() = default;
+  static VertexFormat &instance() noexcept;
+
+  Entry &get(GLuint format) noexcept;
+  static bool attrib_binding_supported() noexcept;
+
+private:
+  std::unordered_map<GLuint, Entry> formats;
+};
+
+#endif  // !__VERTEX_FORMAT_H__
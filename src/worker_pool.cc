@@ -0,0 +1,66 @@
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool(uint32_t thread_count) {
+  if (thread_count == 0) {
+    uint32_t cores = std::thread::hardware_concurrency();
+    thread_count = cores > 1 ? cores - 1 : 0;
+  }
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    workers.emplace_back(&WorkerPool::work, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+void WorkerPool::run(uint32_t count, const std::function<void(uint32_t)> &job) {
+  if (count == 0) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  this->job = &job;
+  this->count = count;
+  next = 0;
+  remaining = count;
+  uint64_t current = ++round;
+  wake.notify_all();
+
+  drain(lock, current);
+  finished.wait(lock, [&] { return remaining == 0; });
+  this->job = nullptr;
+}
+
+void WorkerPool::drain(std::unique_lock<std::mutex> &lock, uint64_t current) noexcept {
+  // 轮次不同说明本轮已经结束，不能再用旧的 job 领取新一轮的下标
+  while (round == current && next < count) {
+    uint32_t index = next++;
+    const auto *task = job;
+    lock.unlock();
+    (*task)(index);
+    lock.lock();
+    if (--remaining == 0) {
+      finished.notify_all();
+    }
+  }
+}
+
+void WorkerPool::work() noexcept {
+  std::unique_lock<std::mutex> lock(mutex);
+  uint64_t seen = round;
+  while (true) {
+    wake.wait(lock, [&] { return stopping || round != seen; });
+    if (stopping) {
+      return;
+    }
+    seen = round;
+    drain(lock, seen);
+  }
+}
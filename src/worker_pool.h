@@ -0,0 +1,50 @@
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** 常驻的工作线程池
+ * run(count, job) 把 job(0) ... job(count - 1) 分给工作线程与调用线程共同执行，全部完成后返回。
+ * 任务按下标逐个领取，适合粒度较粗、数量与线程数相当的任务；同一时间只能有一个调用者
+ */
+class WorkerPool {
+public:
+  typedef std::shared_ptr<WorkerPool> Ptr;
+
+  // thread_count 为工作线程数（不含调用线程），0 表示 CPU 核数 - 1
+  explicit WorkerPool(uint32_t thread_count = 0);
+  WorkerPool(const WorkerPool &oth) = delete;
+  WorkerPool &operator=(const WorkerPool &oth) = delete;
+  ~WorkerPool();
+
+  void run(uint32_t count, const std::function<void(uint32_t)> &job);
+
+  // 参与执行的线程数，含调用线程
+  uint32_t get_concurrency() const noexcept { return workers.size() + 1; }
+
+private:
+  void work() noexcept;
+  // 领取并执行本轮的任务直到领完，返回时已持有锁
+  void drain(std::unique_lock<std::mutex> &lock, uint64_t round) noexcept;
+
+private:
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable finished;
+  const std::function<void(uint32_t)> *job = nullptr;
+  uint64_t round = 0;
+  uint32_t count = 0;
+  uint32_t next = 0;
+  uint32_t remaining = 0;
+  bool stopping = false;
+};
+
+#endif  // !__WORKER_POOL_H__